@@ -44,6 +44,9 @@
 #include "Board.h"
 #include "ExtFlash.h"
 #include "string.h"
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
 #include <ti/drivers/spi/SPICC26XXDMA.h>
 #include <ti/drivers/dma/UDMACC26XX.h>
 #include <ti/devices/DeviceFamily.h>
@@ -58,11 +61,26 @@
  * Implementation for JEDEC compatible Flash
  *
  */
-#define SPI_BIT_RATE              4000000
+#define SPI_BIT_RATE              12000000 /**< Max SSI master rate, 48MHz / 4 */
+
+/* SPI instance the flash is on, a board that uses SPI0 for another link
+ * defines Board_SPI_FLASH in its Board.h */
+#ifndef Board_SPI_FLASH
+#define Board_SPI_FLASH           Board_SPI0
+#endif
+
+/* Longest single SPI transfer. The SPI driver moves transfers longer than
+ * minDmaTransferSize (board file) by uDMA, which takes up to 1024 bytes. */
+#define SPI_MAX_TRANSFER          1024
+
+/* Interval at which the status register is read while a program or erase
+ * operation is in progress. Other tasks run in between. */
+#define BUSY_POLL_INTERVAL_US     100
 
 /* Instruction codes */
 #define BLS_CODE_PROGRAM          0x02 /**< Page Program */
 #define BLS_CODE_READ             0x03 /**< Read Data */
+#define BLS_CODE_FAST_READ        0x0B /**< Fast Read Data, one dummy byte */
 #define BLS_CODE_READ_STATUS      0x05 /**< Read Status Register */
 #define BLS_CODE_WRITE_ENABLE     0x06 /**< Write Enable */
 #define BLS_CODE_SECTOR_ERASE     0x20 /**< Sector Erase */
@@ -103,7 +121,9 @@ static void Spi_flash(void);
 static int Spi_read(uint8_t *buf, size_t length);
 static int Spi_write(const uint8_t *buf, size_t length);
 static int ExtFlash_waitReady(void);
+static bool extFlashFlush(void);
 static int ExtFlash_powerDown(void);
+static uint32_t extFlashRate(size_t length, uint32_t ticks);
 
 /* -----------------------------------------------------------------------------
 *  Local variables
@@ -157,6 +177,15 @@ static uint8_t infoBuf[2];
 static SPI_Handle spiHandle = NULL;
 static SPI_Params spiParams;
 
+// Write combining: bytes written in order are held until their program page
+// is full, read back, or followed by a write elsewhere
+static uint8_t wcBuf[BLS_PROGRAM_PAGE_SIZE];
+static size_t wcOffset;
+static size_t wcLength = 0;
+
+// Set while an erase or program operation may be in progress
+static bool busy = false;
+
 /* -----------------------------------------------------------------------------
 *  Functions
 * ------------------------------------------------------------------------------
@@ -314,6 +343,12 @@ static int ExtFlash_waitReady(void)
     const uint8_t wbuf[1] = { BLS_CODE_READ_STATUS };
     int ret;
 
+    if (!busy)
+    {
+        /* Nothing issued since the part was last ready */
+        return 0;
+    }
+
     /* Throw away all garbage */
     extFlashSelect();
     Spi_flash();
@@ -336,8 +371,17 @@ static int ExtFlash_waitReady(void)
         if (!(buf & BLS_STATUS_BIT_BUSY))
         {
             /* Now ready */
+            busy = false;
             break;
         }
+
+        /* Give the CPU to other tasks, e.g. radio or UART reception, instead
+        * of spinning on the status register. Erase takes tens of ms. */
+        if (BIOS_getThreadType() == BIOS_ThreadType_Task)
+        {
+            uint32_t ticks = BUSY_POLL_INTERVAL_US / Clock_tickPeriod;
+            Task_sleep(ticks > 0 ? ticks : 1);
+        }
     }
 
     return 0;
@@ -402,6 +446,10 @@ bool ExtFlash_open(void)
     /* Make sure SPI is available */
     f = Spi_open(SPI_BIT_RATE);
 
+    /* State of the part is unknown until it has been polled */
+    busy = true;
+    wcLength = 0;
+
     if (f)
     {
         /* Put the part is standby mode */
@@ -423,10 +471,16 @@ bool ExtFlash_open(void)
 }
 
 /* See ExtFlash.h file for description */
-void ExtFlash_close(void)
+bool ExtFlash_close(void)
 {
+    bool ret = true;
+
     if (hFlashPin != NULL)
     {
+        // Complete pending writes before the part is powered down
+        ret = extFlashFlush();
+        ret = (ExtFlash_waitReady() == 0) && ret;
+
         // Put the part in low power mode
         extFlashPowerDown();
         if (pFlashInfo->manfId == MF_WINBOND)
@@ -440,12 +494,24 @@ void ExtFlash_close(void)
         PIN_close(hFlashPin);
         hFlashPin = NULL;
     }
+
+    return ret;
 }
 
 /* See ExtFlash.h file for description */
 bool ExtFlash_read(size_t offset, size_t length, uint8_t *buf)
 {
-    uint8_t wbuf[4];
+    uint8_t wbuf[5];
+
+    /* Bytes still held for programming are written out first */
+    if ((wcLength > 0) && (offset < wcOffset + wcLength) &&
+        (offset + length > wcOffset))
+    {
+        if (!extFlashFlush())
+        {
+            return false;
+        }
+    }
 
     /* Wait till previous erase/program operation completes */
     int ret = ExtFlash_waitReady();
@@ -454,13 +520,13 @@ bool ExtFlash_read(size_t offset, size_t length, uint8_t *buf)
         return false;
     }
 
-    /* SPI is driven with very low frequency (1MHz < 33MHz fR spec)
-    * in this temporary implementation.
-    * and hence it is not necessary to use fast read. */
-    wbuf[0] = BLS_CODE_READ;
+    /* Fast read is rated for the full clock of all supported parts,
+    * the dummy byte costs less than a microsecond per read. */
+    wbuf[0] = BLS_CODE_FAST_READ;
     wbuf[1] = (offset >> 16) & 0xff;
     wbuf[2] = (offset >> 8) & 0xff;
     wbuf[3] = offset & 0xff;
+    wbuf[4] = 0xFF;
 
     extFlashSelect();
 
@@ -481,61 +547,45 @@ bool ExtFlash_read(size_t offset, size_t length, uint8_t *buf)
 /* See ExtFlash.h file for description */
 bool ExtFlash_write(size_t offset, size_t length, const uint8_t *buf)
 {
-    uint8_t wbuf[4];
-
     while (length > 0)
     {
-        /* Wait till previous erase/program operation completes */
-        int ret = ExtFlash_waitReady();
-        if (ret)
+        size_t ilen; /* interim length per program page */
+
+        ilen = BLS_PROGRAM_PAGE_SIZE - (offset % BLS_PROGRAM_PAGE_SIZE);
+        if (length < ilen)
         {
-            return false;
+            ilen = length;
         }
 
-        ret = ExtFlash_writeEnable();
-        if (ret)
+        /* Only bytes following on from the held ones are combined */
+        if ((wcLength > 0) && (offset != wcOffset + wcLength))
         {
-            return false;
+            if (!extFlashFlush())
+            {
+                return false;
+            }
         }
 
-        size_t ilen; /* interim length per instruction */
-
-        ilen = BLS_PROGRAM_PAGE_SIZE - (offset % BLS_PROGRAM_PAGE_SIZE);
-        if (length < ilen)
+        if (wcLength == 0)
         {
-            ilen = length;
+            wcOffset = offset;
         }
 
-        wbuf[0] = BLS_CODE_PROGRAM;
-        wbuf[1] = (offset >> 16) & 0xff;
-        wbuf[2] = (offset >> 8) & 0xff;
-        wbuf[3] = offset & 0xff;
+        memcpy(&wcBuf[wcLength], buf, ilen);
+        wcLength += ilen;
 
         offset += ilen;
         length -= ilen;
+        buf += ilen;
 
-        /* Up to 100ns CS hold time (which is not clear
-        * whether it's application only in between reads)
-        * is not imposed here since above instructions
-        * should be enough to delay
-        * as much. */
-        extFlashSelect();
-
-        if (Spi_write(wbuf, sizeof(wbuf)))
-        {
-            /* failure */
-            extFlashDeselect();
-            return false;
-        }
-
-        if (Spi_write(buf,ilen))
+        /* Program the page as soon as it is complete */
+        if ((offset % BLS_PROGRAM_PAGE_SIZE) == 0)
         {
-            /* failure */
-            extFlashDeselect();
-            return false;
+            if (!extFlashFlush())
+            {
+                return false;
+            }
         }
-        buf += ilen;
-        extFlashDeselect();
     }
 
     return true;
@@ -552,6 +602,12 @@ bool ExtFlash_erase(size_t offset, size_t length)
 
     wbuf[0] = BLS_CODE_SECTOR_ERASE;
 
+    /* Held bytes are programmed in the order they were written */
+    if (!extFlashFlush())
+    {
+        return false;
+    }
+
     {
         size_t endoffset = offset + length - 1;
         offset = (offset / BLS_ERASE_SECTOR_SIZE) * BLS_ERASE_SECTOR_SIZE;
@@ -588,12 +644,73 @@ bool ExtFlash_erase(size_t offset, size_t length)
         }
         extFlashDeselect();
 
+        /* Completion is polled by the next operation */
+        busy = true;
+
         offset += BLS_ERASE_SECTOR_SIZE;
     }
 
     return true;
 }
 
+/*******************************************************************************
+* @fn          extFlashFlush
+*
+* @brief       Program the bytes held by the write combining buffer. The
+*              function returns once the program instruction is issued.
+*
+* @param       none
+*
+* @return      true if success
+*/
+static bool extFlashFlush(void)
+{
+    uint8_t wbuf[4];
+    size_t length = wcLength;
+
+    if (length == 0)
+    {
+        return true;
+    }
+    wcLength = 0;
+
+    /* Wait till previous erase/program operation completes */
+    if (ExtFlash_waitReady() != 0)
+    {
+        return false;
+    }
+
+    if (ExtFlash_writeEnable() != 0)
+    {
+        return false;
+    }
+
+    wbuf[0] = BLS_CODE_PROGRAM;
+    wbuf[1] = (wcOffset >> 16) & 0xff;
+    wbuf[2] = (wcOffset >> 8) & 0xff;
+    wbuf[3] = wcOffset & 0xff;
+
+    /* Up to 100ns CS hold time (which is not clear
+    * whether it's application only in between reads)
+    * is not imposed here since above instructions
+    * should be enough to delay
+    * as much. */
+    extFlashSelect();
+
+    if (Spi_write(wbuf, sizeof(wbuf)) || Spi_write(wcBuf, length))
+    {
+        /* failure */
+        extFlashDeselect();
+        return false;
+    }
+    extFlashDeselect();
+
+    /* Completion is polled by the next operation */
+    busy = true;
+
+    return true;
+}
+
 /* See ExtFlash.h file for description */
 bool ExtFlash_test(void)
 {
@@ -608,6 +725,88 @@ bool ExtFlash_test(void)
     return ret;
 }
 
+/* See ExtFlash.h file for description */
+bool ExtFlash_benchmark(size_t offset, size_t length, ExtFlashBenchmark_t *pResult)
+{
+    uint8_t buf[BLS_PROGRAM_PAGE_SIZE];
+    uint32_t ticks[4];
+    size_t pos;
+    size_t idx;
+    bool ret;
+
+    memset(pResult, 0, sizeof(ExtFlashBenchmark_t));
+
+    ret = ExtFlash_open();
+    if (!ret)
+    {
+        return false;
+    }
+
+    ticks[0] = Clock_getTicks();
+    ret = ExtFlash_erase(offset, length);
+
+    /* Erase ends when the part is ready again */
+    ret = ret && (ExtFlash_waitReady() == 0);
+    ticks[1] = Clock_getTicks();
+
+    for (idx = 0; idx < sizeof(buf); idx++)
+    {
+        buf[idx] = (uint8_t)idx;
+    }
+
+    for (pos = 0; ret && (pos < length); pos += sizeof(buf))
+    {
+        ret = ExtFlash_write(offset + pos, sizeof(buf), buf);
+    }
+    ret = ret && extFlashFlush() && (ExtFlash_waitReady() == 0);
+    ticks[2] = Clock_getTicks();
+
+    for (pos = 0; ret && (pos < length); pos += sizeof(buf))
+    {
+        ret = ExtFlash_read(offset + pos, sizeof(buf), buf);
+    }
+    ticks[3] = Clock_getTicks();
+
+    /* Check the last page read back */
+    for (idx = 0; ret && (idx < sizeof(buf)); idx++)
+    {
+        ret = (buf[idx] == (uint8_t)idx);
+    }
+
+    ExtFlash_close();
+
+    if (ret)
+    {
+        pResult->eraseBytesPerSec = extFlashRate(length, ticks[1] - ticks[0]);
+        pResult->writeBytesPerSec = extFlashRate(length, ticks[2] - ticks[1]);
+        pResult->readBytesPerSec = extFlashRate(length, ticks[3] - ticks[2]);
+    }
+
+    return ret;
+}
+
+/*******************************************************************************
+* @fn          extFlashRate
+*
+* @brief       Convert a transfer time to a rate
+*
+* @param       length - bytes transferred
+* @param       ticks - Clock ticks taken
+*
+* @return      bytes per second
+*/
+static uint32_t extFlashRate(size_t length, uint32_t ticks)
+{
+    uint64_t us = (uint64_t)ticks * Clock_tickPeriod;
+
+    if (us == 0)
+    {
+        us = 1;
+    }
+
+    return (uint32_t)(((uint64_t)length * 1000000) / us);
+}
+
 /*******************************************************************************
 *
 *   SPI interface
@@ -628,12 +827,24 @@ static int Spi_write(const uint8_t *buf, size_t len)
 {
     SPI_Transaction masterTransaction;
 
-    masterTransaction.count  = len;
-    masterTransaction.txBuf  = (void*)buf;
-    masterTransaction.arg    = NULL;
-    masterTransaction.rxBuf  = NULL;
+    /* Split bulk transfers so that they all go by DMA */
+    while (len > 0)
+    {
+        masterTransaction.count  = (len > SPI_MAX_TRANSFER) ? SPI_MAX_TRANSFER : len;
+        masterTransaction.txBuf  = (void*)buf;
+        masterTransaction.arg    = NULL;
+        masterTransaction.rxBuf  = NULL;
 
-    return SPI_transfer(spiHandle, &masterTransaction) ? 0 : -1;
+        if (!SPI_transfer(spiHandle, &masterTransaction))
+        {
+            return -1;
+        }
+
+        buf += masterTransaction.count;
+        len -= masterTransaction.count;
+    }
+
+    return 0;
 }
 
 
@@ -651,12 +862,24 @@ static int Spi_read(uint8_t *buf, size_t len)
 {
     SPI_Transaction masterTransaction;
 
-    masterTransaction.count = len;
-    masterTransaction.txBuf = NULL;
-    masterTransaction.arg = NULL;
-    masterTransaction.rxBuf = buf;
+    /* Split bulk transfers so that they all go by DMA */
+    while (len > 0)
+    {
+        masterTransaction.count = (len > SPI_MAX_TRANSFER) ? SPI_MAX_TRANSFER : len;
+        masterTransaction.txBuf = NULL;
+        masterTransaction.arg = NULL;
+        masterTransaction.rxBuf = buf;
 
-    return SPI_transfer(spiHandle, &masterTransaction) ? 0 : -1;
+        if (!SPI_transfer(spiHandle, &masterTransaction))
+        {
+            return -1;
+        }
+
+        buf += masterTransaction.count;
+        len -= masterTransaction.count;
+    }
+
+    return 0;
 }
 
 
@@ -678,7 +901,7 @@ static bool Spi_open(uint32_t bitRate)
     spiParams.transferMode = SPI_MODE_BLOCKING;
 
     /* Attempt to open SPI. */
-    spiHandle = SPI_open(Board_SPI0, &spiParams);
+    spiHandle = SPI_open(Board_SPI_FLASH, &spiParams);
 
     return spiHandle != NULL;
 }
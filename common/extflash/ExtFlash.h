@@ -65,6 +65,13 @@ typedef struct
     uint8_t devId;       // device ID
 } ExtFlashInfo_t;
 
+typedef struct
+{
+    uint32_t eraseBytesPerSec; // sector erase rate
+    uint32_t writeBytesPerSec; // page program rate
+    uint32_t readBytesPerSec;  // read rate
+} ExtFlashBenchmark_t;
+
 /**
 * Initialize storage driver.
 *
@@ -73,9 +80,12 @@ typedef struct
 extern bool ExtFlash_open(void);
 
 /**
-* Close the storage driver
+* Close the storage driver. Bytes written but not yet programmed are
+* programmed first.
+*
+* @return True when the pending bytes were programmed.
 */
-extern void ExtFlash_close(void);
+extern bool ExtFlash_close(void);
 
 /**
 * Get flash information
@@ -83,21 +93,26 @@ extern void ExtFlash_close(void);
 extern ExtFlashInfo_t *ExtFlash_info(void);
 
 /**
-* Read storage content
+* Read storage content. Bytes written but not yet programmed are programmed
+* first.
 *
 * @return True when successful.
 */
 extern bool ExtFlash_read(size_t offset, size_t length, uint8_t *buf);
 
 /**
-* Erase storage sectors corresponding to the range.
+* Erase storage sectors corresponding to the range. Returns once the erase
+* is issued, the next operation waits for it to complete.
 *
 * @return True when successful.
 */
 extern bool ExtFlash_erase(size_t offset, size_t length);
 
 /**
-* Write to storage sectors.
+* Write to storage sectors. Bytes written in order are combined into program
+* pages of 256 bytes, a page is programmed when it is complete, when it is
+* read, or when a write elsewhere, an erase or ExtFlash_close() follows.
+* Returns once the program is issued.
 *
 * @return True when successful.
 */
@@ -110,6 +125,14 @@ extern bool ExtFlash_write(size_t offset, size_t length, const uint8_t *buf);
 */
 extern bool ExtFlash_test(void);
 
+/**
+* Benchmark the flash, erasing, writing and reading back a range.
+* The content of the range is lost.
+*
+* @return True when successful.
+*/
+extern bool ExtFlash_benchmark(size_t offset, size_t length, ExtFlashBenchmark_t *pResult);
+
 #ifdef __cplusplus
 }
 #endif
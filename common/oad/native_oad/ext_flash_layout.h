@@ -59,6 +59,11 @@
 #define EFL_ADDR_IMAGE_BLE          0x20000
 #define EFL_SIZE_IMAGE_BLE          0x20000
 
+// Fountain symbols of a broadcast download, nodes have no Stack image and
+// do not store the remote application image
+#define EFL_ADDR_FOUNTAIN_SYMBOLS   EFL_ADDR_IMAGE_BLE
+#define EFL_SIZE_FOUNTAIN_SYMBOLS   EFL_SIZE_IMAGE_BLE
+
 // Recovery region (factory reset)
 #define EFL_ADDR_RECOVERY           0x40000
 #define EFL_SIZE_RECOVERY           0x20000
@@ -67,6 +72,20 @@
 #define EFL_ADDR_IMAGE_REMOTE_APP   0x30000
 #define EFL_SIZE_IMAGE_REMOTE_APP   0x20000
 
+// Compressed remote application image, kept next to the uncompressed one
+// for the nodes that reject it
+#define EFL_ADDR_IMAGE_COMPRESSED   0x50000
+#define EFL_SIZE_IMAGE_COMPRESSED   0x10000
+
+// Delta patch from an older node image to the remote application image, a
+// node keeps the patch or compressed image it receives here
+#define EFL_ADDR_IMAGE_DELTA        0x60000
+#define EFL_SIZE_IMAGE_DELTA        0x10000
+
+// Scratch region, free for tests
+#define EFL_ADDR_SCRATCH            0x70000
+#define EFL_SIZE_SCRATCH            0x08000
+
 // Image information (meta-data)
 #define EFL_ADDR_META               0x78000
 #define EFL_SIZE_META               0x08000
@@ -75,6 +94,12 @@
 #define EFL_IMAGE_INFO_ADDR_BLE        ( EFL_ADDR_META + EFL_PAGE_SIZE )
 #define EFL_IMAGE_INFO_ADDR_FACTORY    ( EFL_ADDR_META + EFL_PAGE_SIZE*2 )
 #define EFL_IMAGE_INFO_ADDR_REMOTE_APP ( EFL_ADDR_META + EFL_PAGE_SIZE*3 )
+#define EFL_IMAGE_INFO_ADDR_DELTA      ( EFL_ADDR_META + EFL_PAGE_SIZE*4 )
+
+// Record of the download in progress, resumed after an interruption
+#define EFL_DL_RECORD_ADDR             ( EFL_ADDR_META + EFL_PAGE_SIZE*5 )
+
+#define EFL_IMAGE_INFO_ADDR_COMPRESSED ( EFL_ADDR_META + EFL_PAGE_SIZE*6 )
 
 // Image types
 #define EFL_OAD_IMG_TYPE_APP        1
@@ -82,6 +107,8 @@
 #define EFL_OAD_IMG_TYPE_NP         3
 #define EFL_OAD_IMG_TYPE_FACTORY    4
 #define EFL_OAD_IMG_TYPE_REMOTE_APP 5
+#define EFL_OAD_IMG_TYPE_DELTA      6
+#define EFL_OAD_IMG_TYPE_COMPRESSED 7
 
 // Address/length resolution
 #define EFL_OAD_ADDR_RESOLUTION     4
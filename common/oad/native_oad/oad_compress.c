@@ -0,0 +1,485 @@
+/******************************************************************************
+
+ @file oad_compress.c
+
+ @brief OAD Compressed Image Decompressor
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "oad/native_oad/oad_compress.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define RANGE_TOP           (1UL << 24)
+#define RANGE_INIT_LEN      5
+#define PROB_INIT           (1 << (OADCompress_PROB_BITS - 1))
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static OADCompress_Status_t parseHeader(OADCompress_Decompressor_t *pDecomp);
+static OADCompress_Status_t decodeSymbol(OADCompress_Decompressor_t *pDecomp);
+static uint8_t inByte(OADCompress_Decompressor_t *pDecomp);
+static uint8_t decodeBit(OADCompress_Decompressor_t *pDecomp, uint16_t *pProb);
+static uint16_t decodeTree(OADCompress_Decompressor_t *pDecomp, uint16_t probs, uint8_t numBits);
+static uint16_t decodeDirect(OADCompress_Decompressor_t *pDecomp, uint8_t numBits);
+static void putByte(OADCompress_Decompressor_t *pDecomp, uint8_t byte);
+static bool flushBlock(OADCompress_Decompressor_t *pDecomp);
+
+/*********************************************************************
+ * @fn      OADCompress_isCompressed
+ *
+ * @brief   Check whether the first block of an image holds a compressed
+ *          image.
+ *
+ * @param   pBlock      - first OAD_BLOCK_SIZE bytes of the image
+ *
+ * @return  true if the image is compressed
+ */
+bool OADCompress_isCompressed(uint8_t *pBlock)
+{
+    uint32_t magic = (uint32_t)pBlock[OADCompress_MAGIC_OSET] |
+                     ((uint32_t)pBlock[OADCompress_MAGIC_OSET + 1] << 8) |
+                     ((uint32_t)pBlock[OADCompress_MAGIC_OSET + 2] << 16) |
+                     ((uint32_t)pBlock[OADCompress_MAGIC_OSET + 3] << 24);
+
+    return (magic == OADCompress_MAGIC);
+}
+
+/*********************************************************************
+ * @fn      OADCompress_decompressorInit
+ *
+ * @brief   Initialise a decompressor.
+ *
+ * @param   pDecomp       - decompressor state
+ * @param   pfnWriteBlock - function writing a block of the image
+ *
+ * @return  none
+ */
+void OADCompress_decompressorInit(OADCompress_Decompressor_t *pDecomp,
+                                  OADCompress_writeBlock_t pfnWriteBlock)
+{
+    uint16_t idx;
+
+    memset(pDecomp, 0, sizeof(OADCompress_Decompressor_t));
+
+    for(idx = 0; idx < OADCompress_NUM_PROBS; idx++)
+    {
+        pDecomp->probs[idx] = PROB_INIT;
+    }
+
+    pDecomp->status = OADCompress_Status_InProgress;
+    pDecomp->range = 0xFFFFFFFF;
+    pDecomp->pfnWriteBlock = pfnWriteBlock;
+}
+
+/*********************************************************************
+ * @fn      OADCompress_decompressorPush
+ *
+ * @brief   Decompress the next bytes of the compressed image, in order.
+ *
+ * @param   pDecomp     - decompressor state
+ * @param   pData       - compressed image data
+ * @param   len         - length of compressed image data
+ *
+ * @return  OADCompress_Status_t
+ */
+OADCompress_Status_t OADCompress_decompressorPush(OADCompress_Decompressor_t *pDecomp,
+                                                  uint8_t *pData, uint16_t len)
+{
+    while(pDecomp->status == OADCompress_Status_InProgress)
+    {
+        uint32_t count;
+
+        // The image is complete, the rest of the data is padding.
+        if((pDecomp->offset >= OADCompress_STREAM_OSET) && (pDecomp->produced == pDecomp->imgLen))
+        {
+            pDecomp->status = flushBlock(pDecomp) ? OADCompress_Status_Complete : OADCompress_Status_Error;
+            break;
+        }
+
+        if(pDecomp->matchRemaining > 0)
+        {
+            // A match needs no compressed data.
+            count = OAD_BLOCK_SIZE - pDecomp->blockFill;
+            if(count > pDecomp->matchRemaining)
+            {
+                count = pDecomp->matchRemaining;
+            }
+
+            pDecomp->matchRemaining -= count;
+
+            while(count--)
+            {
+                putByte(pDecomp, pDecomp->window[(pDecomp->produced - pDecomp->rep) &
+                                                 (OADCompress_WINDOW_SIZE - 1)]);
+            }
+        }
+        else if(pDecomp->offset < OADCompress_STREAM_OSET)
+        {
+            if(len == 0)
+            {
+                break;
+            }
+
+            // Collect the header.
+            pDecomp->hdr[pDecomp->offset++] = *pData++;
+            len--;
+
+            if(pDecomp->offset == OADCompress_STREAM_OSET)
+            {
+                pDecomp->status = parseHeader(pDecomp);
+            }
+        }
+        else
+        {
+            // Top up the input buffer, ignoring padding after the stream.
+            count = OADCompress_IN_BUF_SIZE - pDecomp->inCount;
+            if(count > len)
+            {
+                count = len;
+            }
+            if(count > pDecomp->streamLen - pDecomp->offset)
+            {
+                count = pDecomp->streamLen - pDecomp->offset;
+            }
+
+            pDecomp->offset += count;
+            len -= count;
+
+            while(count--)
+            {
+                pDecomp->in[(pDecomp->inHead + pDecomp->inCount++) & (OADCompress_IN_BUF_SIZE - 1)] = *pData++;
+            }
+
+            // Only decode when the next symbol is sure to be buffered.
+            if((pDecomp->inCount < OADCompress_MAX_SYMBOL_LEN) &&
+               (pDecomp->offset < pDecomp->streamLen))
+            {
+                if(len == 0)
+                {
+                    break;
+                }
+            }
+            else if(pDecomp->codeLen < RANGE_INIT_LEN)
+            {
+                pDecomp->code = (pDecomp->code << 8) | inByte(pDecomp);
+                pDecomp->codeLen++;
+            }
+            else
+            {
+                pDecomp->status = decodeSymbol(pDecomp);
+            }
+        }
+
+        if((pDecomp->blockFill == OAD_BLOCK_SIZE) && !flushBlock(pDecomp))
+        {
+            pDecomp->status = OADCompress_Status_Error;
+        }
+    }
+
+    return pDecomp->status;
+}
+
+/*********************************************************************
+ * @fn      parseHeader
+ *
+ * @brief   Check the header of the compressed image.
+ *
+ * @param   pDecomp     - decompressor state
+ *
+ * @return  OADCompress_Status_t
+ */
+static OADCompress_Status_t parseHeader(OADCompress_Decompressor_t *pDecomp)
+{
+    uint8_t *pImgInfo = &pDecomp->hdr[OADCompress_IMG_INFO_OSET];
+
+    if(!OADCompress_isCompressed(pDecomp->hdr))
+    {
+        return OADCompress_Status_Error;
+    }
+
+    pDecomp->streamLen = (uint32_t)OADTarget_BUILD_UINT16(pDecomp->hdr[OADCompress_IMG_INFO_LEN_OSET],
+                                                          pDecomp->hdr[OADCompress_IMG_INFO_LEN_OSET + 1]) * 4;
+    pDecomp->imgLen = (uint32_t)OADTarget_BUILD_UINT16(pImgInfo[OADCompress_IMG_INFO_LEN_OSET],
+                                                       pImgInfo[OADCompress_IMG_INFO_LEN_OSET + 1]) * 4;
+
+    if((pDecomp->imgLen == 0) ||
+       (pDecomp->streamLen < OADCompress_STREAM_OSET + RANGE_INIT_LEN))
+    {
+        return OADCompress_Status_Error;
+    }
+
+    return OADCompress_Status_InProgress;
+}
+
+/*********************************************************************
+ * @fn      decodeSymbol
+ *
+ * @brief   Decode a literal or the start of a match.
+ *
+ * @param   pDecomp     - decompressor state
+ *
+ * @return  OADCompress_Status_t
+ */
+static OADCompress_Status_t decodeSymbol(OADCompress_Decompressor_t *pDecomp)
+{
+    uint8_t ctx = pDecomp->prevMatch ? 1 : 0;
+    uint16_t matchLen;
+    uint8_t distBits;
+    uint8_t isRep;
+
+    if(!decodeBit(pDecomp, &pDecomp->probs[OADCompress_PROB_IS_MATCH + ctx]))
+    {
+        putByte(pDecomp, (uint8_t)decodeTree(pDecomp, OADCompress_PROB_LITERAL, 8));
+        pDecomp->prevMatch = false;
+
+        return OADCompress_Status_InProgress;
+    }
+
+    isRep = decodeBit(pDecomp, &pDecomp->probs[OADCompress_PROB_IS_REP + ctx]);
+    matchLen = decodeTree(pDecomp, OADCompress_PROB_LEN, OADCompress_LEN_BITS) + OADCompress_MIN_MATCH;
+
+    // A new distance, otherwise the last one is repeated.
+    if(!isRep)
+    {
+        distBits = (uint8_t)decodeTree(pDecomp, OADCompress_PROB_DIST_SLOT, OADCompress_DIST_SLOT_BITS);
+
+        if((distBits == 0) || (distBits > 16))
+        {
+            return OADCompress_Status_Error;
+        }
+
+        pDecomp->rep = (1 << (distBits - 1)) | decodeDirect(pDecomp, distBits - 1);
+    }
+
+    if((pDecomp->rep == 0) || (pDecomp->rep > OADCompress_WINDOW_SIZE) ||
+       (pDecomp->rep > pDecomp->produced) ||
+       (pDecomp->produced + matchLen > pDecomp->imgLen))
+    {
+        return OADCompress_Status_Error;
+    }
+
+    pDecomp->matchRemaining = matchLen;
+    pDecomp->prevMatch = true;
+
+    return OADCompress_Status_InProgress;
+}
+
+/*********************************************************************
+ * @fn      inByte
+ *
+ * @brief   Take the next byte from the input buffer, 0 past the end of a
+ *          malformed stream.
+ *
+ * @param   pDecomp     - decompressor state
+ *
+ * @return  byte
+ */
+static uint8_t inByte(OADCompress_Decompressor_t *pDecomp)
+{
+    uint8_t byte;
+
+    if(pDecomp->inCount == 0)
+    {
+        return 0;
+    }
+
+    byte = pDecomp->in[pDecomp->inHead];
+    pDecomp->inHead = (pDecomp->inHead + 1) & (OADCompress_IN_BUF_SIZE - 1);
+    pDecomp->inCount--;
+
+    return byte;
+}
+
+/*********************************************************************
+ * @fn      decodeBit
+ *
+ * @brief   Decode a bit and adapt its probability.
+ *
+ * @param   pDecomp     - decompressor state
+ * @param   pProb       - probability of a 0 bit
+ *
+ * @return  bit
+ */
+static uint8_t decodeBit(OADCompress_Decompressor_t *pDecomp, uint16_t *pProb)
+{
+    uint32_t bound = (pDecomp->range >> OADCompress_PROB_BITS) * *pProb;
+    uint8_t bit;
+
+    if(pDecomp->code < bound)
+    {
+        pDecomp->range = bound;
+        *pProb += ((1 << OADCompress_PROB_BITS) - *pProb) >> OADCompress_PROB_MOVE_BITS;
+        bit = 0;
+    }
+    else
+    {
+        pDecomp->range -= bound;
+        pDecomp->code -= bound;
+        *pProb -= *pProb >> OADCompress_PROB_MOVE_BITS;
+        bit = 1;
+    }
+
+    // A bit never takes more than one byte, see OADCompress_MAX_SYMBOL_LEN.
+    if(pDecomp->range < RANGE_TOP)
+    {
+        pDecomp->range <<= 8;
+        pDecomp->code = (pDecomp->code << 8) | inByte(pDecomp);
+    }
+
+    return bit;
+}
+
+/*********************************************************************
+ * @fn      decodeTree
+ *
+ * @brief   Decode a value MSB first, each bit with a probability depending
+ *          on the bits above it.
+ *
+ * @param   pDecomp     - decompressor state
+ * @param   probs       - index of the bit tree probabilities
+ * @param   numBits     - bits in the value
+ *
+ * @return  value
+ */
+static uint16_t decodeTree(OADCompress_Decompressor_t *pDecomp, uint16_t probs, uint8_t numBits)
+{
+    uint16_t node = 1;
+    uint8_t idx;
+
+    for(idx = 0; idx < numBits; idx++)
+    {
+        node = (node << 1) | decodeBit(pDecomp, &pDecomp->probs[probs + node]);
+    }
+
+    return node - (1 << numBits);
+}
+
+/*********************************************************************
+ * @fn      decodeDirect
+ *
+ * @brief   Decode a value MSB first, with fixed 1/2 bit probabilities.
+ *
+ * @param   pDecomp     - decompressor state
+ * @param   numBits     - bits in the value
+ *
+ * @return  value
+ */
+static uint16_t decodeDirect(OADCompress_Decompressor_t *pDecomp, uint8_t numBits)
+{
+    uint16_t value = 0;
+
+    while(numBits--)
+    {
+        pDecomp->range >>= 1;
+        value <<= 1;
+
+        if(pDecomp->code >= pDecomp->range)
+        {
+            pDecomp->code -= pDecomp->range;
+            value |= 1;
+        }
+
+        if(pDecomp->range < RANGE_TOP)
+        {
+            pDecomp->range <<= 8;
+            pDecomp->code = (pDecomp->code << 8) | inByte(pDecomp);
+        }
+    }
+
+    return value;
+}
+
+/*********************************************************************
+ * @fn      putByte
+ *
+ * @brief   Add a byte to the image.
+ *
+ * @param   pDecomp     - decompressor state
+ * @param   byte        - image byte
+ *
+ * @return  none
+ */
+static void putByte(OADCompress_Decompressor_t *pDecomp, uint8_t byte)
+{
+    pDecomp->window[pDecomp->produced & (OADCompress_WINDOW_SIZE - 1)] = byte;
+    pDecomp->block[pDecomp->blockFill++] = byte;
+    pDecomp->produced++;
+}
+
+/*********************************************************************
+ * @fn      flushBlock
+ *
+ * @brief   Write the block being built, padding a partial last block.
+ *
+ * @param   pDecomp     - decompressor state
+ *
+ * @return  false on a storage error
+ */
+static bool flushBlock(OADCompress_Decompressor_t *pDecomp)
+{
+    if(pDecomp->blockFill == 0)
+    {
+        return true;
+    }
+
+    memset(&pDecomp->block[pDecomp->blockFill], 0xFF, OAD_BLOCK_SIZE - pDecomp->blockFill);
+
+    if(!pDecomp->pfnWriteBlock(pDecomp->blockNum, pDecomp->block))
+    {
+        return false;
+    }
+
+    pDecomp->blockNum++;
+    pDecomp->blockFill = 0;
+
+    return true;
+}
+
+/*********************************************************************
+*********************************************************************/
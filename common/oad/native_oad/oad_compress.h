@@ -0,0 +1,204 @@
+/******************************************************************************
+
+ @file oad_compress.h
+
+ @brief OAD Compressed Image Header
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+#ifndef OADCompress_H
+#define OADCompress_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "oad/native_oad/oad_target.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*
+ * A compressed image is stored and transferred like any other image, its
+ * first 16 bytes being its own image header so that the existing CRC check
+ * covers the compressed data. Its image type is EFL_OAD_IMG_TYPE_COMPRESSED,
+ * it keeps the version of the image it holds:
+ *
+ *  Offset  Size  Field
+ *  0       16    Compressed image header
+ *  16      16    Header of the image, sent in the image identify
+ *  32      4     OADCompress_MAGIC
+ *  36      ...   Compressed stream
+ *
+ * The stream holds the image from its first byte, including its own header,
+ * so the CRC check of the download slot validates the result.
+ *
+ * The stream is LZ77 coded with matches of up to OADCompress_WINDOW_SIZE
+ * bytes back, the literals, match lengths and distances being coded with an
+ * adaptive binary range coder. Decompressing needs the window and about 1kB
+ * of bit probabilities in RAM, the image is written a block at a time.
+ */
+#define OADCompress_IMG_INFO_OSET       16  ///< Offset to image header
+#define OADCompress_MAGIC_OSET          32  ///< Offset to 32B magic
+#define OADCompress_STREAM_OSET         36  ///< Offset to the compressed stream
+
+#define OADCompress_IMG_INFO_LEN_OSET   6   ///< Offset to 16B length in an image header
+
+#define OADCompress_MAGIC               0x43525A4C ///< "LZRC"
+
+#define OADCompress_WINDOW_SIZE         2048 ///< Max match distance, power of 2
+#define OADCompress_MIN_MATCH           2    ///< Shortest match
+#define OADCompress_LEN_BITS            8    ///< Match length - OADCompress_MIN_MATCH
+#define OADCompress_DIST_SLOT_BITS      5    ///< Number of bits in the match distance
+
+#define OADCompress_PROB_BITS           11   ///< Bit probability resolution
+#define OADCompress_PROB_MOVE_BITS      5    ///< Bit probability adaption rate
+
+/// Stream bytes a single literal or match can take
+#define OADCompress_MAX_SYMBOL_LEN      32
+/// Stream input buffer, power of 2
+#define OADCompress_IN_BUF_SIZE         64
+
+/// Bit probabilities, bit trees are indexed from 1
+#define OADCompress_PROB_IS_MATCH       0
+#define OADCompress_PROB_IS_REP         2
+#define OADCompress_PROB_LITERAL        4
+#define OADCompress_PROB_LEN            (OADCompress_PROB_LITERAL + 0x100)
+#define OADCompress_PROB_DIST_SLOT      (OADCompress_PROB_LEN + (1 << OADCompress_LEN_BITS))
+#define OADCompress_NUM_PROBS           (OADCompress_PROB_DIST_SLOT + (1 << OADCompress_DIST_SLOT_BITS))
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/// OADCompress_Status_t status codes
+typedef enum {
+    OADCompress_Status_InProgress,  ///< More compressed data needed
+    OADCompress_Status_Complete,    ///< Image fully written
+    OADCompress_Status_Error,       ///< Malformed stream or storage error
+} OADCompress_Status_t;
+
+/// Write a block of the image, returns false on a storage error
+typedef bool (*OADCompress_writeBlock_t)(uint16_t blockNum, uint8_t *pBlock);
+
+/// Streaming decompressor state
+typedef struct {
+    OADCompress_Status_t status;        ///< Current status
+    uint32_t streamLen;                 ///< Compressed image length in bytes
+    uint32_t imgLen;                    ///< Image length in bytes
+    uint32_t offset;                    ///< Compressed bytes received
+    uint32_t produced;                  ///< Image bytes produced
+    uint32_t range;                     ///< Range decoder range
+    uint32_t code;                      ///< Range decoder code
+    uint8_t codeLen;                    ///< Range decoder bytes loaded
+    bool prevMatch;                     ///< Last symbol was a match
+    uint16_t rep;                       ///< Distance of the last match
+    uint16_t matchRemaining;            ///< Bytes left in the current match
+    uint16_t probs[OADCompress_NUM_PROBS]; ///< Bit probabilities
+    uint8_t in[OADCompress_IN_BUF_SIZE]; ///< Compressed bytes not decoded yet
+    uint8_t inHead;                     ///< Next byte in in
+    uint8_t inCount;                    ///< Bytes in in
+    uint8_t hdr[OADCompress_STREAM_OSET]; ///< Compressed image header
+    uint8_t window[OADCompress_WINDOW_SIZE]; ///< Last image bytes produced
+    uint8_t block[OAD_BLOCK_SIZE];      ///< Image block being built
+    uint16_t blockFill;                 ///< Bytes in block
+    uint16_t blockNum;                  ///< Number of block
+    OADCompress_writeBlock_t pfnWriteBlock; ///< Write the image
+} OADCompress_Decompressor_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      OADCompress_isCompressed
+ *
+ * @brief   Check whether the first block of an image holds a compressed
+ *          image.
+ *
+ * @param   pBlock      - first OAD_BLOCK_SIZE bytes of the image
+ *
+ * @return  true if the image is compressed
+ */
+extern bool OADCompress_isCompressed(uint8_t *pBlock);
+
+/*********************************************************************
+ * @fn      OADCompress_decompressorInit
+ *
+ * @brief   Initialise a decompressor.
+ *
+ * @param   pDecomp       - decompressor state
+ * @param   pfnWriteBlock - function writing a block of the image
+ *
+ * @return  none
+ */
+extern void OADCompress_decompressorInit(OADCompress_Decompressor_t *pDecomp,
+                                         OADCompress_writeBlock_t pfnWriteBlock);
+
+/*********************************************************************
+ * @fn      OADCompress_decompressorPush
+ *
+ * @brief   Decompress the next bytes of the compressed image, in order.
+ *
+ * @param   pDecomp     - decompressor state
+ * @param   pData       - compressed image data
+ * @param   len         - length of compressed image data
+ *
+ * @return  OADCompress_Status_t
+ */
+extern OADCompress_Status_t OADCompress_decompressorPush(OADCompress_Decompressor_t *pDecomp,
+                                                         uint8_t *pData, uint16_t len);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OADCompress_H */
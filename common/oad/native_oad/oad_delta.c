@@ -0,0 +1,351 @@
+/******************************************************************************
+
+ @file oad_delta.c
+
+ @brief OAD Delta Patch
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "oad/native_oad/oad_delta.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define COPY_ARG_LEN        5
+#define COPY_NEXT_ARG_LEN   2
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static OADDelta_Status_t parseHeader(OADDelta_Patcher_t *pPatcher);
+static OADDelta_Status_t startOp(OADDelta_Patcher_t *pPatcher, uint8_t op);
+static OADDelta_Status_t parseArgs(OADDelta_Patcher_t *pPatcher);
+static bool flushBlock(OADDelta_Patcher_t *pPatcher);
+
+/*********************************************************************
+ * @fn      OADDelta_patcherInit
+ *
+ * @brief   Initialise a patcher.
+ *
+ * @param   pPatcher      - patcher state
+ * @param   baseVer       - version of the running image
+ * @param   pfnReadBase   - function reading the running image
+ * @param   pfnWriteBlock - function writing a block of the new image
+ *
+ * @return  none
+ */
+void OADDelta_patcherInit(OADDelta_Patcher_t *pPatcher, uint16_t baseVer,
+                          OADDelta_readBase_t pfnReadBase,
+                          OADDelta_writeBlock_t pfnWriteBlock)
+{
+    memset(pPatcher, 0, sizeof(OADDelta_Patcher_t));
+
+    pPatcher->status = OADDelta_Status_InProgress;
+    pPatcher->baseVer = baseVer;
+    pPatcher->pfnReadBase = pfnReadBase;
+    pPatcher->pfnWriteBlock = pfnWriteBlock;
+}
+
+/*********************************************************************
+ * @fn      OADDelta_patcherPush
+ *
+ * @brief   Apply the next bytes of the patch, in order.
+ *
+ * @param   pPatcher    - patcher state
+ * @param   pData       - patch data
+ * @param   len         - length of patch data
+ *
+ * @return  OADDelta_Status_t
+ */
+OADDelta_Status_t OADDelta_patcherPush(OADDelta_Patcher_t *pPatcher, uint8_t *pData, uint16_t len)
+{
+    while(pPatcher->status == OADDelta_Status_InProgress)
+    {
+        uint32_t count;
+
+        // The new image is complete, the rest of the patch is padding.
+        if((pPatcher->patchOffset >= OADDelta_OPS_OSET) && (pPatcher->produced == pPatcher->newLen))
+        {
+            pPatcher->status = flushBlock(pPatcher) ? OADDelta_Status_Complete : OADDelta_Status_Error;
+            break;
+        }
+
+        // A copy needs no patch data.
+        if(pPatcher->opActive && (pPatcher->op > OADDelta_OP_LITERAL_MAX) &&
+           (pPatcher->argLen == pPatcher->argNeeded))
+        {
+            count = OAD_BLOCK_SIZE - pPatcher->blockFill;
+            if(count > pPatcher->opRemaining)
+            {
+                count = pPatcher->opRemaining;
+            }
+
+            if(!pPatcher->pfnReadBase(pPatcher->copyOffset, &pPatcher->block[pPatcher->blockFill], count))
+            {
+                pPatcher->status = OADDelta_Status_Error;
+                break;
+            }
+
+            pPatcher->copyOffset += count;
+            pPatcher->produced += count;
+            pPatcher->blockFill += count;
+            pPatcher->opRemaining -= count;
+        }
+        else
+        {
+            if(len == 0)
+            {
+                break;
+            }
+
+            if(pPatcher->patchOffset < OADDelta_OPS_OSET)
+            {
+                // Collect the patch header.
+                pPatcher->hdr[pPatcher->patchOffset] = *pData;
+                count = 1;
+
+                if(pPatcher->patchOffset == OADDelta_OPS_OSET - 1)
+                {
+                    pPatcher->status = parseHeader(pPatcher);
+                }
+            }
+            else if(!pPatcher->opActive)
+            {
+                // Start the next op.
+                pPatcher->status = startOp(pPatcher, *pData);
+                count = 1;
+            }
+            else if(pPatcher->argLen < pPatcher->argNeeded)
+            {
+                // Collect the op arguments.
+                pPatcher->arg[pPatcher->argLen++] = *pData;
+                count = 1;
+
+                if(pPatcher->argLen == pPatcher->argNeeded)
+                {
+                    pPatcher->status = parseArgs(pPatcher);
+                }
+            }
+            else
+            {
+                // Copy literal bytes.
+                count = OAD_BLOCK_SIZE - pPatcher->blockFill;
+                if(count > pPatcher->opRemaining)
+                {
+                    count = pPatcher->opRemaining;
+                }
+                if(count > len)
+                {
+                    count = len;
+                }
+
+                memcpy(&pPatcher->block[pPatcher->blockFill], pData, count);
+
+                pPatcher->produced += count;
+                pPatcher->blockFill += count;
+                pPatcher->opRemaining -= count;
+            }
+
+            pPatcher->patchOffset += count;
+            pData += count;
+            len -= count;
+        }
+
+        if(pPatcher->opActive && (pPatcher->argLen == pPatcher->argNeeded) &&
+           (pPatcher->opRemaining == 0))
+        {
+            pPatcher->opActive = false;
+        }
+
+        if((pPatcher->blockFill == OAD_BLOCK_SIZE) && !flushBlock(pPatcher))
+        {
+            pPatcher->status = OADDelta_Status_Error;
+        }
+    }
+
+    return pPatcher->status;
+}
+
+/*********************************************************************
+ * @fn      parseHeader
+ *
+ * @brief   Check the patch header against the running image.
+ *
+ * @param   pPatcher    - patcher state
+ *
+ * @return  OADDelta_Status_t
+ */
+static OADDelta_Status_t parseHeader(OADDelta_Patcher_t *pPatcher)
+{
+    uint8_t *pNewInfo = &pPatcher->hdr[OADDelta_NEW_IMG_INFO_OSET];
+
+    if(OADTarget_BUILD_UINT16(pPatcher->hdr[OADDelta_BASE_VER_OSET],
+                              pPatcher->hdr[OADDelta_BASE_VER_OSET + 1]) != pPatcher->baseVer)
+    {
+        return OADDelta_Status_BaseMismatch;
+    }
+
+    pPatcher->baseLen = (uint32_t)OADTarget_BUILD_UINT16(pPatcher->hdr[OADDelta_BASE_LEN_OSET],
+                                                         pPatcher->hdr[OADDelta_BASE_LEN_OSET + 1]) * 4;
+    pPatcher->newLen = (uint32_t)OADTarget_BUILD_UINT16(pNewInfo[OADDelta_IMG_INFO_LEN_OSET],
+                                                        pNewInfo[OADDelta_IMG_INFO_LEN_OSET + 1]) * 4;
+
+    if(pPatcher->newLen == 0)
+    {
+        return OADDelta_Status_Error;
+    }
+
+    return OADDelta_Status_InProgress;
+}
+
+/*********************************************************************
+ * @fn      startOp
+ *
+ * @brief   Decode an op code.
+ *
+ * @param   pPatcher    - patcher state
+ * @param   op          - op code
+ *
+ * @return  OADDelta_Status_t
+ */
+static OADDelta_Status_t startOp(OADDelta_Patcher_t *pPatcher, uint8_t op)
+{
+    pPatcher->op = op;
+    pPatcher->argLen = 0;
+    pPatcher->opActive = true;
+
+    if(op <= OADDelta_OP_LITERAL_MAX)
+    {
+        pPatcher->argNeeded = 0;
+        pPatcher->opRemaining = op + 1;
+    }
+    else if(op == OADDelta_OP_COPY)
+    {
+        pPatcher->argNeeded = COPY_ARG_LEN;
+    }
+    else if(op == OADDelta_OP_COPY_NEXT)
+    {
+        pPatcher->argNeeded = COPY_NEXT_ARG_LEN;
+    }
+    else
+    {
+        // End of ops before the new image is complete, or unknown op.
+        return OADDelta_Status_Error;
+    }
+
+    if((pPatcher->argNeeded == 0) &&
+       (pPatcher->produced + pPatcher->opRemaining > pPatcher->newLen))
+    {
+        return OADDelta_Status_Error;
+    }
+
+    return OADDelta_Status_InProgress;
+}
+
+/*********************************************************************
+ * @fn      parseArgs
+ *
+ * @brief   Decode the arguments of a copy op.
+ *
+ * @param   pPatcher    - patcher state
+ *
+ * @return  OADDelta_Status_t
+ */
+static OADDelta_Status_t parseArgs(OADDelta_Patcher_t *pPatcher)
+{
+    uint8_t *pLen = pPatcher->arg;
+
+    if(pPatcher->op == OADDelta_OP_COPY)
+    {
+        pPatcher->copyOffset = (uint32_t)pPatcher->arg[0] |
+                               ((uint32_t)pPatcher->arg[1] << 8) |
+                               ((uint32_t)pPatcher->arg[2] << 16);
+        pLen = &pPatcher->arg[3];
+    }
+
+    pPatcher->opRemaining = OADTarget_BUILD_UINT16(pLen[0], pLen[1]);
+
+    if((pPatcher->opRemaining == 0) ||
+       (pPatcher->copyOffset + pPatcher->opRemaining > pPatcher->baseLen) ||
+       (pPatcher->produced + pPatcher->opRemaining > pPatcher->newLen))
+    {
+        return OADDelta_Status_Error;
+    }
+
+    return OADDelta_Status_InProgress;
+}
+
+/*********************************************************************
+ * @fn      flushBlock
+ *
+ * @brief   Write the block being built, padding a partial last block.
+ *
+ * @param   pPatcher    - patcher state
+ *
+ * @return  false on a storage error
+ */
+static bool flushBlock(OADDelta_Patcher_t *pPatcher)
+{
+    if(pPatcher->blockFill == 0)
+    {
+        return true;
+    }
+
+    memset(&pPatcher->block[pPatcher->blockFill], 0xFF, OAD_BLOCK_SIZE - pPatcher->blockFill);
+
+    if(!pPatcher->pfnWriteBlock(pPatcher->blockNum, pPatcher->block))
+    {
+        return false;
+    }
+
+    pPatcher->blockNum++;
+    pPatcher->blockFill = 0;
+
+    return true;
+}
+
+/*********************************************************************
+*********************************************************************/
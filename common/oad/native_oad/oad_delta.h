@@ -0,0 +1,176 @@
+/******************************************************************************
+
+ @file oad_delta.h
+
+ @brief OAD Delta Patch Header
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+#ifndef OADDelta_H
+#define OADDelta_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "oad/native_oad/oad_target.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*
+ * A delta patch rebuilds a new image from the image running on a node. It is
+ * stored and transferred like any other image, its first 16 bytes being its
+ * own image header (image type EFL_OAD_IMG_TYPE_DELTA) so that the existing
+ * CRC check covers the patch. The patch header and op stream follow:
+ *
+ *  Offset  Size  Field
+ *  0       16    Patch image header
+ *  16      16    Header of the new image, sent in the image identify
+ *  32      2     Version of the image the patch applies to
+ *  34      2     Length of that image in 4-byte words
+ *  36      ...   Op stream
+ *
+ * The ops build the new image from its first byte, including its own header,
+ * so the CRC check of the download slot validates the result. Multi byte
+ * fields are little endian.
+ */
+#define OADDelta_NEW_IMG_INFO_OSET      16  ///< Offset to new image header
+#define OADDelta_BASE_VER_OSET          32  ///< Offset to 16B base image version
+#define OADDelta_BASE_LEN_OSET          34  ///< Offset to 16B base image length
+#define OADDelta_OPS_OSET               36  ///< Offset to the op stream
+
+#define OADDelta_IMG_INFO_LEN_OSET      6   ///< Offset to 16B length in an image header
+
+#define OADDelta_OP_LITERAL_MAX         0x7F ///< 0x00-0x7F: (op + 1) literal bytes follow
+#define OADDelta_OP_COPY                0x80 ///< 24B base offset and 16B length follow
+#define OADDelta_OP_COPY_NEXT           0x81 ///< 16B length follows, copy from the end of the last copy
+#define OADDelta_OP_END                 0xFF ///< End of op stream
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/// OADDelta_Status_t status codes
+typedef enum {
+    OADDelta_Status_InProgress,     ///< More patch data needed
+    OADDelta_Status_Complete,       ///< New image fully written
+    OADDelta_Status_BaseMismatch,   ///< Patch is for another base image
+    OADDelta_Status_Error,          ///< Malformed patch or storage error
+} OADDelta_Status_t;
+
+/// Read from the base image, returns false on a storage error
+typedef bool (*OADDelta_readBase_t)(uint32_t offset, uint8_t *pBuf, uint16_t len);
+
+/// Write a block of the new image, returns false on a storage error
+typedef bool (*OADDelta_writeBlock_t)(uint16_t blockNum, uint8_t *pBlock);
+
+/// Streaming patcher state
+typedef struct {
+    OADDelta_Status_t status;           ///< Current status
+    uint16_t baseVer;                   ///< Version of the running image
+    uint32_t baseLen;                   ///< Base image length in bytes
+    uint32_t newLen;                    ///< New image length in bytes
+    uint32_t patchOffset;               ///< Patch bytes consumed
+    uint32_t produced;                  ///< New image bytes produced
+    uint32_t copyOffset;                ///< Base offset of the next copy
+    bool opActive;                      ///< An op is being decoded
+    uint8_t op;                         ///< Op being decoded
+    uint8_t argLen;                     ///< Op argument bytes collected
+    uint8_t argNeeded;                  ///< Op argument bytes expected
+    uint8_t arg[5];                     ///< Op arguments
+    uint16_t opRemaining;               ///< Bytes left in the current op
+    uint8_t hdr[OADDelta_OPS_OSET];     ///< Patch header
+    uint8_t block[OAD_BLOCK_SIZE];      ///< New image block being built
+    uint16_t blockFill;                 ///< Bytes in block
+    uint16_t blockNum;                  ///< Number of block
+    OADDelta_readBase_t pfnReadBase;    ///< Read the base image
+    OADDelta_writeBlock_t pfnWriteBlock; ///< Write the new image
+} OADDelta_Patcher_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      OADDelta_patcherInit
+ *
+ * @brief   Initialise a patcher.
+ *
+ * @param   pPatcher      - patcher state
+ * @param   baseVer       - version of the running image
+ * @param   pfnReadBase   - function reading the running image
+ * @param   pfnWriteBlock - function writing a block of the new image
+ *
+ * @return  none
+ */
+extern void OADDelta_patcherInit(OADDelta_Patcher_t *pPatcher, uint16_t baseVer,
+                                 OADDelta_readBase_t pfnReadBase,
+                                 OADDelta_writeBlock_t pfnWriteBlock);
+
+/*********************************************************************
+ * @fn      OADDelta_patcherPush
+ *
+ * @brief   Apply the next bytes of the patch, in order.
+ *
+ * @param   pPatcher    - patcher state
+ * @param   pData       - patch data
+ * @param   len         - length of patch data
+ *
+ * @return  OADDelta_Status_t
+ */
+extern OADDelta_Status_t OADDelta_patcherPush(OADDelta_Patcher_t *pPatcher, uint8_t *pData, uint16_t len);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OADDelta_H */
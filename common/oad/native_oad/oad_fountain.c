@@ -0,0 +1,461 @@
+/******************************************************************************
+
+ @file oad_fountain.c
+
+ @brief OAD Fountain (LT) Code
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "oad/native_oad/oad_fountain.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*
+ * Robust soliton degree distribution (c = 0.05, delta = 0.5) for an image of
+ * about 1000 blocks, truncated at OADFountain_MAX_DEGREE with the tail folded
+ * into the last entry. Entry d - 1 is P(degree <= d) scaled to 65535.
+ */
+static const uint16_t degreeCdf[OADFountain_MAX_DEGREE] =
+{
+      770, 30978, 41166, 46319, 49446, 51555, 53078, 54233,
+    55141, 55876, 56483, 56995, 57432, 57811, 58143, 58436,
+    58698, 58932, 59144, 59337, 59513, 59675, 59823, 59961,
+    60089, 60208, 60320, 60424, 60522, 60615, 60702, 60784,
+    60862, 60936, 61007, 61074, 61138, 61199, 61258, 61314,
+    61368, 61419, 61469, 61516, 61562, 61607, 61650, 61691,
+    61731, 61769, 61807, 61843, 61878, 61912, 61945, 61977,
+    62008, 62039, 62068, 62097, 62125, 62152, 62179, 65535
+};
+
+/*********************************************************************
+ * MACROS
+ */
+#define IS_DECODED(pDec, blk)   ((pDec)->pDecoded[(blk) >> 3] & (1 << ((blk) & 7)))
+#define SET_DECODED(pDec, blk)  ((pDec)->pDecoded[(blk) >> 3] |= (1 << ((blk) & 7)))
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint32_t nextRandom(uint32_t *pState);
+static bool symbolHasBlock(uint16_t symbolId, uint16_t numBlocks, uint16_t blockNum);
+static bool reduceSymbol(OADFountain_Decoder_t *pDecoder, uint16_t symbolId, uint8_t *pData,
+                         uint16_t *pBlockNum, uint8_t *pRemaining);
+static void decodeBlock(OADFountain_Decoder_t *pDecoder, uint16_t blockNum, uint8_t *pData);
+static void xorBlock(uint8_t *pDst, uint8_t *pSrc);
+
+/*********************************************************************
+ * @fn      OADFountain_getNeighbours
+ *
+ * @brief   Get the image blocks XORed into a symbol.
+ *
+ * @param   symbolId    - symbol ID
+ * @param   numBlocks   - blocks in the image
+ * @param   pNeighbours - buffer for OADFountain_MAX_DEGREE block numbers
+ *
+ * @return  Number of neighbours (symbol degree)
+ */
+uint8_t OADFountain_getNeighbours(uint16_t symbolId, uint16_t numBlocks, uint16_t *pNeighbours)
+{
+    uint32_t state;
+    uint16_t sample;
+    uint8_t degree = 0;
+    uint8_t idx;
+
+    if(numBlocks == 0)
+    {
+        return 0;
+    }
+
+    // Seed from symbol ID and image size only, so both ends agree.
+    state = ((uint32_t)(symbolId + 1) * 2654435761u) ^ ((uint32_t)numBlocks << 16);
+    if(state == 0)
+    {
+        state = 1;
+    }
+
+    // Draw the degree from the distribution.
+    sample = nextRandom(&state) >> 16;
+    while((degree < (OADFountain_MAX_DEGREE - 1)) && (sample > degreeCdf[degree]))
+    {
+        degree++;
+    }
+    degree++;
+
+    // Small images, spread the tail over the possible degrees.
+    if(degree > numBlocks)
+    {
+        degree = 1 + (nextRandom(&state) % numBlocks);
+    }
+
+    // Draw distinct neighbours.
+    for(idx = 0; idx < degree; idx++)
+    {
+        uint16_t blockNum;
+        uint8_t prev;
+
+        do
+        {
+            blockNum = nextRandom(&state) % numBlocks;
+            for(prev = 0; prev < idx; prev++)
+            {
+                if(pNeighbours[prev] == blockNum)
+                {
+                    break;
+                }
+            }
+        } while(prev != idx);
+
+        pNeighbours[idx] = blockNum;
+    }
+
+    return degree;
+}
+
+/*********************************************************************
+ * @fn      OADFountain_encode
+ *
+ * @brief   Build an encoded symbol from the image blocks.
+ *
+ * @param   symbolId    - symbol ID
+ * @param   numBlocks   - blocks in the image
+ * @param   pfnReadBlock - function reading an image block
+ * @param   pSymbol     - buffer for OAD_BLOCK_SIZE bytes of symbol data
+ *
+ * @return  true if all blocks could be read
+ */
+bool OADFountain_encode(uint16_t symbolId, uint16_t numBlocks,
+                        OADFountain_blockAccess_t pfnReadBlock, uint8_t *pSymbol)
+{
+    uint16_t neighbours[OADFountain_MAX_DEGREE];
+    uint8_t block[OAD_BLOCK_SIZE];
+    uint8_t degree;
+    uint8_t idx;
+
+    degree = OADFountain_getNeighbours(symbolId, numBlocks, neighbours);
+
+    memset(pSymbol, 0, OAD_BLOCK_SIZE);
+
+    for(idx = 0; idx < degree; idx++)
+    {
+        if(!pfnReadBlock(neighbours[idx], block))
+        {
+            return false;
+        }
+        xorBlock(pSymbol, block);
+    }
+
+    return true;
+}
+
+/*********************************************************************
+ * @fn      OADFountain_decoderInit
+ *
+ * @brief   Initialise a decoder.
+ *
+ * @param   pDecoder     - decoder state
+ * @param   numBlocks    - blocks in the image
+ * @param   pDecoded     - bitmap buffer of (numBlocks + 7) / 8 bytes
+ * @param   pSymbols     - buffer for stored symbols
+ * @param   maxSymbols   - size of pSymbols, symbols that do not fit are dropped
+ * @param   pfnReadBlock - function reading a decoded block
+ * @param   pfnWriteBlock - function writing a decoded block
+ * @param   pfnReadSymbol - function reading a stored symbol
+ * @param   pfnWriteSymbol - function storing a symbol, each slot is written once
+ *
+ * @return  none
+ */
+void OADFountain_decoderInit(OADFountain_Decoder_t *pDecoder, uint16_t numBlocks,
+                             uint8_t *pDecoded, OADFountain_Symbol_t *pSymbols, uint16_t maxSymbols,
+                             OADFountain_blockAccess_t pfnReadBlock,
+                             OADFountain_blockAccess_t pfnWriteBlock,
+                             OADFountain_blockAccess_t pfnReadSymbol,
+                             OADFountain_blockAccess_t pfnWriteSymbol)
+{
+    pDecoder->numBlocks = numBlocks;
+    pDecoder->decodedBlocks = 0;
+    pDecoder->receivedSymbols = 0;
+    pDecoder->pDecoded = pDecoded;
+    pDecoder->pSymbols = pSymbols;
+    pDecoder->maxSymbols = maxSymbols;
+    pDecoder->numSymbols = 0;
+    pDecoder->pfnReadBlock = pfnReadBlock;
+    pDecoder->pfnWriteBlock = pfnWriteBlock;
+    pDecoder->pfnReadSymbol = pfnReadSymbol;
+    pDecoder->pfnWriteSymbol = pfnWriteSymbol;
+
+    memset(pDecoded, 0, (numBlocks + 7) / 8);
+}
+
+/*********************************************************************
+ * @fn      OADFountain_decoderAddSymbol
+ *
+ * @brief   Add a received symbol and decode all blocks it releases.
+ *
+ * @param   pDecoder    - decoder state
+ * @param   symbolId    - symbol ID
+ * @param   pData       - OAD_BLOCK_SIZE bytes of symbol data
+ *
+ * @return  true once all blocks are decoded
+ */
+bool OADFountain_decoderAddSymbol(OADFountain_Decoder_t *pDecoder, uint16_t symbolId, uint8_t *pData)
+{
+    uint8_t symbol[OAD_BLOCK_SIZE];
+    uint16_t blockNum;
+    uint8_t remaining;
+
+    if(pDecoder->decodedBlocks == pDecoder->numBlocks)
+    {
+        return true;
+    }
+
+    pDecoder->receivedSymbols++;
+
+    memcpy(symbol, pData, OAD_BLOCK_SIZE);
+
+    if(!reduceSymbol(pDecoder, symbolId, symbol, &blockNum, &remaining))
+    {
+        return false;
+    }
+
+    if(remaining == 1)
+    {
+        decodeBlock(pDecoder, blockNum, symbol);
+    }
+    else if((remaining > 1) && (pDecoder->numSymbols < pDecoder->maxSymbols))
+    {
+        // Store it as received, it is reduced again when released.
+        if(pDecoder->pfnWriteSymbol(pDecoder->numSymbols, pData))
+        {
+            pDecoder->pSymbols[pDecoder->numSymbols].symbolId = symbolId;
+            pDecoder->pSymbols[pDecoder->numSymbols].remaining = remaining;
+            pDecoder->numSymbols++;
+        }
+    }
+
+    return (pDecoder->decodedBlocks == pDecoder->numBlocks);
+}
+
+/*********************************************************************
+ * @fn      nextRandom
+ *
+ * @brief   xorshift32 pseudo random generator.
+ *
+ * @param   pState - generator state, must not be 0
+ *
+ * @return  next random value
+ */
+static uint32_t nextRandom(uint32_t *pState)
+{
+    uint32_t x = *pState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *pState = x;
+
+    return x;
+}
+
+/*********************************************************************
+ * @fn      symbolHasBlock
+ *
+ * @brief   Check if a block is a neighbour of a symbol.
+ *
+ * @param   symbolId    - symbol ID
+ * @param   numBlocks   - blocks in the image
+ * @param   blockNum    - block to look for
+ *
+ * @return  true if blockNum is XORed into the symbol
+ */
+static bool symbolHasBlock(uint16_t symbolId, uint16_t numBlocks, uint16_t blockNum)
+{
+    uint16_t neighbours[OADFountain_MAX_DEGREE];
+    uint8_t degree;
+    uint8_t idx;
+
+    degree = OADFountain_getNeighbours(symbolId, numBlocks, neighbours);
+
+    for(idx = 0; idx < degree; idx++)
+    {
+        if(neighbours[idx] == blockNum)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*********************************************************************
+ * @fn      reduceSymbol
+ *
+ * @brief   XOR the decoded neighbours out of a symbol.
+ *
+ * @param   pDecoder    - decoder state
+ * @param   symbolId    - symbol ID
+ * @param   pData       - symbol data, reduced in place
+ * @param   pBlockNum   - set to an undecoded neighbour
+ * @param   pRemaining  - set to the number of undecoded neighbours
+ *
+ * @return  false on a storage error
+ */
+static bool reduceSymbol(OADFountain_Decoder_t *pDecoder, uint16_t symbolId, uint8_t *pData,
+                         uint16_t *pBlockNum, uint8_t *pRemaining)
+{
+    uint16_t neighbours[OADFountain_MAX_DEGREE];
+    uint8_t block[OAD_BLOCK_SIZE];
+    uint8_t degree;
+    uint8_t idx;
+
+    degree = OADFountain_getNeighbours(symbolId, pDecoder->numBlocks, neighbours);
+    *pRemaining = 0;
+
+    for(idx = 0; idx < degree; idx++)
+    {
+        if(IS_DECODED(pDecoder, neighbours[idx]))
+        {
+            if(!pDecoder->pfnReadBlock(neighbours[idx], block))
+            {
+                return false;
+            }
+            xorBlock(pData, block);
+        }
+        else
+        {
+            *pBlockNum = neighbours[idx];
+            (*pRemaining)++;
+        }
+    }
+
+    return true;
+}
+
+/*********************************************************************
+ * @fn      decodeBlock
+ *
+ * @brief   Store a decoded block and release every stored symbol that is
+ *          left with a single undecoded neighbour.
+ *
+ * @param   pDecoder    - decoder state
+ * @param   blockNum    - decoded block number
+ * @param   pData       - decoded block data, used as work buffer
+ *
+ * @return  none
+ */
+static void decodeBlock(OADFountain_Decoder_t *pDecoder, uint16_t blockNum, uint8_t *pData)
+{
+    bool released = true;
+
+    while(released)
+    {
+        uint16_t symbolIdx;
+        uint8_t remaining;
+
+        released = false;
+
+        if(!pDecoder->pfnWriteBlock(blockNum, pData))
+        {
+            return;
+        }
+        SET_DECODED(pDecoder, blockNum);
+        pDecoder->decodedBlocks++;
+
+        for(symbolIdx = 0; symbolIdx < pDecoder->numSymbols; symbolIdx++)
+        {
+            OADFountain_Symbol_t *pSymbol = &pDecoder->pSymbols[symbolIdx];
+
+            if((pSymbol->remaining != 0) &&
+               symbolHasBlock(pSymbol->symbolId, pDecoder->numBlocks, blockNum))
+            {
+                pSymbol->remaining--;
+            }
+        }
+
+        // Release the first symbol left with one undecoded neighbour.
+        for(symbolIdx = 0; symbolIdx < pDecoder->numSymbols; symbolIdx++)
+        {
+            OADFountain_Symbol_t *pSymbol = &pDecoder->pSymbols[symbolIdx];
+
+            if(pSymbol->remaining == 1)
+            {
+                pSymbol->remaining = 0;
+
+                if(pDecoder->pfnReadSymbol(symbolIdx, pData) &&
+                   reduceSymbol(pDecoder, pSymbol->symbolId, pData, &blockNum, &remaining) &&
+                   (remaining == 1))
+                {
+                    released = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      xorBlock
+ *
+ * @brief   XOR a block into another.
+ *
+ * @param   pDst - block to XOR into
+ * @param   pSrc - block to XOR
+ *
+ * @return  none
+ */
+static void xorBlock(uint8_t *pDst, uint8_t *pSrc)
+{
+    uint16_t idx;
+
+    for(idx = 0; idx < OAD_BLOCK_SIZE; idx++)
+    {
+        pDst[idx] ^= pSrc[idx];
+    }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,183 @@
+/******************************************************************************
+
+ @file oad_fountain.h
+
+ @brief OAD Fountain (LT) Code Header
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+
+
+ *****************************************************************************/
+#ifndef OADFountain_H
+#define OADFountain_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "oad/native_oad/oad_target.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*
+ * Each encoded symbol is the XOR of a set of image blocks (its neighbours).
+ * The set is derived from the symbol ID alone, so server and nodes agree on
+ * it without sending it over the air. Any set of slightly more than numBlocks
+ * symbols decodes the image, whichever symbols were lost.
+ *
+ * Received symbols are written once to symbol storage (external flash on a
+ * node) and never modified, only their ID and undecoded neighbour count are
+ * kept in RAM. The decoder needs storage for about 10% more symbols than
+ * image blocks.
+ */
+#define OADFountain_MAX_DEGREE         64   ///< Max number of blocks in one symbol
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/// Block or symbol access function, returns false on a storage error
+typedef bool (*OADFountain_blockAccess_t)(uint16_t blockNum, uint8_t *pBlock);
+
+/// Stored symbol, the data is in symbol storage slot of the same index
+typedef struct {
+    uint16_t symbolId;              ///< Symbol ID the neighbours are derived from
+    uint8_t remaining;              ///< Neighbours not decoded yet, 0 once used
+} OADFountain_Symbol_t;
+
+/// Peeling decoder state
+typedef struct {
+    uint16_t numBlocks;                     ///< Blocks in the image
+    uint16_t decodedBlocks;                 ///< Blocks decoded so far
+    uint16_t receivedSymbols;               ///< Symbols received so far
+    uint8_t *pDecoded;                      ///< Bitmap of decoded blocks, (numBlocks + 7) / 8 bytes
+    OADFountain_Symbol_t *pSymbols;         ///< Stored symbols
+    uint16_t maxSymbols;                    ///< Size of pSymbols and symbol storage
+    uint16_t numSymbols;                    ///< Symbols stored so far
+    OADFountain_blockAccess_t pfnReadBlock;  ///< Read a decoded block
+    OADFountain_blockAccess_t pfnWriteBlock; ///< Write a decoded block
+    OADFountain_blockAccess_t pfnReadSymbol; ///< Read a stored symbol
+    OADFountain_blockAccess_t pfnWriteSymbol; ///< Store a symbol
+} OADFountain_Decoder_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      OADFountain_getNeighbours
+ *
+ * @brief   Get the image blocks XORed into a symbol.
+ *
+ * @param   symbolId    - symbol ID
+ * @param   numBlocks   - blocks in the image
+ * @param   pNeighbours - buffer for OADFountain_MAX_DEGREE block numbers
+ *
+ * @return  Number of neighbours (symbol degree)
+ */
+extern uint8_t OADFountain_getNeighbours(uint16_t symbolId, uint16_t numBlocks, uint16_t *pNeighbours);
+
+/*********************************************************************
+ * @fn      OADFountain_encode
+ *
+ * @brief   Build an encoded symbol from the image blocks.
+ *
+ * @param   symbolId    - symbol ID
+ * @param   numBlocks   - blocks in the image
+ * @param   pfnReadBlock - function reading an image block
+ * @param   pSymbol     - buffer for OAD_BLOCK_SIZE bytes of symbol data
+ *
+ * @return  true if all blocks could be read
+ */
+extern bool OADFountain_encode(uint16_t symbolId, uint16_t numBlocks,
+                               OADFountain_blockAccess_t pfnReadBlock, uint8_t *pSymbol);
+
+/*********************************************************************
+ * @fn      OADFountain_decoderInit
+ *
+ * @brief   Initialise a decoder.
+ *
+ * @param   pDecoder     - decoder state
+ * @param   numBlocks    - blocks in the image
+ * @param   pDecoded     - bitmap buffer of (numBlocks + 7) / 8 bytes
+ * @param   pSymbols     - buffer for stored symbols
+ * @param   maxSymbols   - size of pSymbols, symbols that do not fit are dropped
+ * @param   pfnReadBlock - function reading a decoded block
+ * @param   pfnWriteBlock - function writing a decoded block
+ * @param   pfnReadSymbol - function reading a stored symbol
+ * @param   pfnWriteSymbol - function storing a symbol, each slot is written once
+ *
+ * @return  none
+ */
+extern void OADFountain_decoderInit(OADFountain_Decoder_t *pDecoder, uint16_t numBlocks,
+                                    uint8_t *pDecoded, OADFountain_Symbol_t *pSymbols, uint16_t maxSymbols,
+                                    OADFountain_blockAccess_t pfnReadBlock,
+                                    OADFountain_blockAccess_t pfnWriteBlock,
+                                    OADFountain_blockAccess_t pfnReadSymbol,
+                                    OADFountain_blockAccess_t pfnWriteSymbol);
+
+/*********************************************************************
+ * @fn      OADFountain_decoderAddSymbol
+ *
+ * @brief   Add a received symbol and decode all blocks it releases.
+ *
+ * @param   pDecoder    - decoder state
+ * @param   symbolId    - symbol ID
+ * @param   pData       - OAD_BLOCK_SIZE bytes of symbol data
+ *
+ * @return  true once all blocks are decoded
+ */
+extern bool OADFountain_decoderAddSymbol(OADFountain_Decoder_t *pDecoder, uint16_t symbolId, uint8_t *pData);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OADFountain_H */
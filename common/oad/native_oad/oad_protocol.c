@@ -65,6 +65,10 @@ static OADProtocol_Status_t processOadImgIdentifyReq(void* pSrcAddress, uint8_t
 static OADProtocol_Status_t processOadImgIdentifyRsp(void* pSrcAddress, uint8_t *pIncomingPacket);
 static OADProtocol_Status_t processOadImgBlockReq(void* pSrcAddr, uint8_t *pIncomingPacket);
 static OADProtocol_Status_t processOadImgBlockRsp(void* pSrcAddress, uint8_t *pIncomingPacket);
+static OADProtocol_Status_t processOadImgMultiBlockReq(void* pSrcAddr, uint8_t *pIncomingPacket);
+static OADProtocol_Status_t processOadFountainSymbol(void* pSrcAddr, uint8_t *pIncomingPacket);
+static OADProtocol_Status_t processOadFountainStatus(void* pSrcAddr, uint8_t *pIncomingPacket);
+static OADProtocol_Status_t processOadPushAck(void* pSrcAddr, uint8_t *pIncomingPacket);
 
 static incomingPacketProcess_t incomingPacketProcessTable[] =
 {
@@ -74,6 +78,10 @@ static incomingPacketProcess_t incomingPacketProcessTable[] =
     {OADProtocol_PACKET_TYPE_OAD_IMG_IDENTIFY_RSP, processOadImgIdentifyRsp},
     {OADProtocol_PACKET_TYPE_OAD_BLOCK_REQ,        processOadImgBlockReq},
     {OADProtocol_PACKET_TYPE_OAD_BLOCK_RSP,        processOadImgBlockRsp},
+    {OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ,  processOadImgMultiBlockReq},
+    {OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_SYMBOL,  processOadFountainSymbol},
+    {OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_STATUS,  processOadFountainStatus},
+    {OADProtocol_PACKET_TYPE_OAD_PUSH_ACK,         processOadPushAck},
 };
 
 /***** Variable declarations *****/
@@ -217,7 +225,7 @@ OADProtocol_Status_t OADProtocol_sendImgIdentifyReq(void* pDstAddress, uint8_t i
     return status;
 }
 
-OADProtocol_Status_t OADProtocol_sendOadIdentifyImgRsp(void* pDstAddress, uint8_t rspStatus)
+OADProtocol_Status_t OADProtocol_sendOadIdentifyImgRsp(void* pDstAddress, uint8_t imgId, uint8_t rspStatus, uint16_t resumeBlock)
 {
     uint8_t* pOadImgIdentifyRspPacket = NULL;
     OADProtocol_Status_t status = OADProtocol_Failed;
@@ -236,6 +244,9 @@ OADProtocol_Status_t OADProtocol_sendOadIdentifyImgRsp(void* pDstAddress, uint8_
 
     pOadImgIdentifyRspPacket[OADProtocol_PKT_CMDID_OFFSET] = OADProtocol_PACKET_TYPE_OAD_IMG_IDENTIFY_RSP;
     pOadImgIdentifyRspPacket[OADProtocol_IMG_IDENTIFY_RSP_STATUS_OFFSET] = rspStatus;
+    pOadImgIdentifyRspPacket[OADProtocol_IMG_IDENTIFY_RSP_RESUME_BLOCK_OFFSET] = resumeBlock & 0xFF;
+    pOadImgIdentifyRspPacket[OADProtocol_IMG_IDENTIFY_RSP_RESUME_BLOCK_OFFSET + 1] = (resumeBlock >> 8) & 0xFF;
+    pOadImgIdentifyRspPacket[OADProtocol_IMG_IDENTIFY_RSP_IMG_ID_OFFSET] = imgId;
 
     if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend)
     {
@@ -321,6 +332,159 @@ OADProtocol_Status_t OADProtocol_sendOadImgBlockRsp(void* pDstAddress, uint8_t i
     return status;
 }
 
+OADProtocol_Status_t OADProtocol_sendOadImgMultiBlockReq(void* pDstAddress, uint8_t imgId, uint16_t blockNum, uint16_t multiBlockSize, uint16_t blockBitmap)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+    uint8_t* pOadMultiBlockReqPacket = NULL;
+
+    //Allocate the buffer
+    if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessAllocMsg)
+    {
+        pOadMultiBlockReqPacket = OADProtocol_params.pRadioAccessFxns->pfnRadioAccessAllocMsg(
+                                        OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ_LEN);
+    }
+
+    if(pOadMultiBlockReqPacket == NULL)
+    {
+        return status;
+    }
+
+    pOadMultiBlockReqPacket[OADProtocol_PKT_CMDID_OFFSET] = OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ;
+
+    pOadMultiBlockReqPacket[OADProtocol_MULTI_BLOCK_REQ_IMG_ID_OFFSET] = imgId;
+
+    pOadMultiBlockReqPacket[OADProtocol_MULTI_BLOCK_REQ_BLOCK_NUM_OFFSET]  = blockNum & 0xFF;
+    pOadMultiBlockReqPacket[OADProtocol_MULTI_BLOCK_REQ_BLOCK_NUM_OFFSET + 1]  = (blockNum >> 8) & 0xFF;
+
+    pOadMultiBlockReqPacket[OADProtocol_MULTI_BLOCK_REQ_MULTI_BLOCK_SIZE_OFFSET]  = multiBlockSize & 0xFF;
+    pOadMultiBlockReqPacket[OADProtocol_MULTI_BLOCK_REQ_MULTI_BLOCK_SIZE_OFFSET + 1]  = (multiBlockSize >> 8) & 0xFF;
+
+    pOadMultiBlockReqPacket[OADProtocol_MULTI_BLOCK_REQ_BITMAP_OFFSET]  = blockBitmap & 0xFF;
+    pOadMultiBlockReqPacket[OADProtocol_MULTI_BLOCK_REQ_BITMAP_OFFSET + 1]  = (blockBitmap >> 8) & 0xFF;
+
+    if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend)
+    {
+        status = OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend(pDstAddress,
+                                        pOadMultiBlockReqPacket,
+                                        OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ_LEN);
+    }
+
+    return status;
+}
+
+OADProtocol_Status_t OADProtocol_sendOadFountainSymbol(void* pDstAddress, uint8_t imgId, uint16_t symbolId, uint8_t *symbol)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+    uint8_t* pOadFountainSymbolPacket = NULL;
+
+    //Allocate the buffer
+    if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessAllocMsg)
+    {
+        pOadFountainSymbolPacket = OADProtocol_params.pRadioAccessFxns->pfnRadioAccessAllocMsg(
+                                        OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_SYMBOL_LEN);
+    }
+
+    if(pOadFountainSymbolPacket == NULL)
+    {
+        return status;
+    }
+
+    pOadFountainSymbolPacket[OADProtocol_PKT_CMDID_OFFSET] = OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_SYMBOL;
+
+    pOadFountainSymbolPacket[OADProtocol_FOUNTAIN_SYMBOL_IMG_ID_OFFSET] = imgId;
+
+    pOadFountainSymbolPacket[OADProtocol_FOUNTAIN_SYMBOL_SYMBOL_ID_OFFSET]  = symbolId & 0xFF;
+    pOadFountainSymbolPacket[OADProtocol_FOUNTAIN_SYMBOL_SYMBOL_ID_OFFSET + 1]  = (symbolId >> 8) & 0xFF;
+
+    memcpy(&(pOadFountainSymbolPacket[OADProtocol_FOUNTAIN_SYMBOL_DATA_OFFSET]), symbol, OAD_BLOCK_SIZE);
+
+    if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend)
+    {
+        status = OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend(pDstAddress,
+                                        pOadFountainSymbolPacket,
+                                        OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_SYMBOL_LEN);
+    }
+
+    return status;
+}
+
+OADProtocol_Status_t OADProtocol_sendOadFountainStatus(void* pDstAddress, uint8_t imgId, uint8_t rspStatus, uint16_t decodedBlocks, uint16_t receivedSymbols)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+    uint8_t* pOadFountainStatusPacket = NULL;
+
+    //Allocate the buffer
+    if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessAllocMsg)
+    {
+        pOadFountainStatusPacket = OADProtocol_params.pRadioAccessFxns->pfnRadioAccessAllocMsg(
+                                        OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_STATUS_LEN);
+    }
+
+    if(pOadFountainStatusPacket == NULL)
+    {
+        return status;
+    }
+
+    pOadFountainStatusPacket[OADProtocol_PKT_CMDID_OFFSET] = OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_STATUS;
+
+    pOadFountainStatusPacket[OADProtocol_FOUNTAIN_STATUS_IMG_ID_OFFSET] = imgId;
+    pOadFountainStatusPacket[OADProtocol_FOUNTAIN_STATUS_STATUS_OFFSET] = rspStatus;
+
+    pOadFountainStatusPacket[OADProtocol_FOUNTAIN_STATUS_DECODED_OFFSET]  = decodedBlocks & 0xFF;
+    pOadFountainStatusPacket[OADProtocol_FOUNTAIN_STATUS_DECODED_OFFSET + 1]  = (decodedBlocks >> 8) & 0xFF;
+
+    pOadFountainStatusPacket[OADProtocol_FOUNTAIN_STATUS_RECEIVED_OFFSET]  = receivedSymbols & 0xFF;
+    pOadFountainStatusPacket[OADProtocol_FOUNTAIN_STATUS_RECEIVED_OFFSET + 1]  = (receivedSymbols >> 8) & 0xFF;
+
+    if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend)
+    {
+        status = OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend(pDstAddress,
+                                        pOadFountainStatusPacket,
+                                        OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_STATUS_LEN);
+    }
+
+    return status;
+}
+
+OADProtocol_Status_t OADProtocol_sendOadPushAck(void* pDstAddress, uint8_t imgId, uint16_t blockNum, uint32_t blockBitmap)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+    uint8_t* pOadPushAckPacket = NULL;
+
+    //Allocate the buffer
+    if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessAllocMsg)
+    {
+        pOadPushAckPacket = OADProtocol_params.pRadioAccessFxns->pfnRadioAccessAllocMsg(
+                                        OADProtocol_PACKET_TYPE_OAD_PUSH_ACK_LEN);
+    }
+
+    if(pOadPushAckPacket == NULL)
+    {
+        return status;
+    }
+
+    pOadPushAckPacket[OADProtocol_PKT_CMDID_OFFSET] = OADProtocol_PACKET_TYPE_OAD_PUSH_ACK;
+
+    pOadPushAckPacket[OADProtocol_PUSH_ACK_IMG_ID_OFFSET] = imgId;
+
+    pOadPushAckPacket[OADProtocol_PUSH_ACK_BLOCK_NUM_OFFSET]  = blockNum & 0xFF;
+    pOadPushAckPacket[OADProtocol_PUSH_ACK_BLOCK_NUM_OFFSET + 1]  = (blockNum >> 8) & 0xFF;
+
+    pOadPushAckPacket[OADProtocol_PUSH_ACK_BITMAP_OFFSET]  = blockBitmap & 0xFF;
+    pOadPushAckPacket[OADProtocol_PUSH_ACK_BITMAP_OFFSET + 1]  = (blockBitmap >> 8) & 0xFF;
+    pOadPushAckPacket[OADProtocol_PUSH_ACK_BITMAP_OFFSET + 2]  = (blockBitmap >> 16) & 0xFF;
+    pOadPushAckPacket[OADProtocol_PUSH_ACK_BITMAP_OFFSET + 3]  = (blockBitmap >> 24) & 0xFF;
+
+    if(OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend)
+    {
+        status = OADProtocol_params.pRadioAccessFxns->pfnRadioAccessPacketSend(pDstAddress,
+                                        pOadPushAckPacket,
+                                        OADProtocol_PACKET_TYPE_OAD_PUSH_ACK_LEN);
+    }
+
+    return status;
+}
+
 static OADProtocol_Status_t processFwVersioReq(void* pSrcAddress, uint8_t* pIncomingPacket)
 {
     OADProtocol_Status_t status = OADProtocol_Failed;
@@ -374,12 +538,15 @@ static OADProtocol_Status_t processOadImgIdentifyReq(void* pSrcAddress, uint8_t
 static OADProtocol_Status_t processOadImgIdentifyRsp(void* pSrcAddress, uint8_t *pIncomingPacket)
 {
     OADProtocol_Status_t status = OADProtocol_Failed;
+    uint16_t resumeBlock = ( pIncomingPacket[OADProtocol_IMG_IDENTIFY_RSP_RESUME_BLOCK_OFFSET] & 0xFF) |
+                           ((pIncomingPacket[OADProtocol_IMG_IDENTIFY_RSP_RESUME_BLOCK_OFFSET + 1] & 0xFF) << 8);
 
     //call application callback
     if(OADProtocol_params.pProtocolMsgCallbacks->pfnOadImgIdentifyRspCb != NULL)
     {
         OADProtocol_params.pProtocolMsgCallbacks->pfnOadImgIdentifyRspCb(pSrcAddress,
-                 pIncomingPacket[OADProtocol_IMG_IDENTIFY_RSP_STATUS_OFFSET]);
+                 pIncomingPacket[OADProtocol_IMG_IDENTIFY_RSP_IMG_ID_OFFSET],
+                 pIncomingPacket[OADProtocol_IMG_IDENTIFY_RSP_STATUS_OFFSET], resumeBlock);
     }
 
     //TODO: process packet and send response if needed
@@ -435,3 +602,101 @@ static OADProtocol_Status_t processOadImgBlockRsp(void* pSrcAddress, uint8_t *pI
 
     return status;
 }
+
+static OADProtocol_Status_t processOadImgMultiBlockReq(void* pSrcAddr, uint8_t *pIncomingPacket)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+
+    uint8_t imgHdr = pIncomingPacket[OADProtocol_MULTI_BLOCK_REQ_IMG_ID_OFFSET];
+
+    uint16_t blockNum = ( pIncomingPacket[OADProtocol_MULTI_BLOCK_REQ_BLOCK_NUM_OFFSET] & 0xFF) |
+                        ((pIncomingPacket[OADProtocol_MULTI_BLOCK_REQ_BLOCK_NUM_OFFSET + 1] & 0xFF) << 8);
+
+    uint16_t multiBlockSize = ( pIncomingPacket[OADProtocol_MULTI_BLOCK_REQ_MULTI_BLOCK_SIZE_OFFSET] & 0xFF) |
+                             ((pIncomingPacket[OADProtocol_MULTI_BLOCK_REQ_MULTI_BLOCK_SIZE_OFFSET + 1] & 0xFF) << 8);
+
+    uint16_t blockBitmap = ( pIncomingPacket[OADProtocol_MULTI_BLOCK_REQ_BITMAP_OFFSET] & 0xFF) |
+                          ((pIncomingPacket[OADProtocol_MULTI_BLOCK_REQ_BITMAP_OFFSET + 1] & 0xFF) << 8);
+
+    //call application callback
+    if(OADProtocol_params.pProtocolMsgCallbacks->pfnOadMultiBlockReqCb != NULL)
+    {
+        OADProtocol_params.pProtocolMsgCallbacks->pfnOadMultiBlockReqCb(pSrcAddr, imgHdr, blockNum, multiBlockSize, blockBitmap);
+    }
+
+    status = OADProtocol_Status_Success;
+
+    return status;
+}
+
+static OADProtocol_Status_t processOadFountainSymbol(void* pSrcAddr, uint8_t *pIncomingPacket)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+
+    uint8_t imgHdr = pIncomingPacket[OADProtocol_FOUNTAIN_SYMBOL_IMG_ID_OFFSET];
+
+    uint16_t symbolId = ( pIncomingPacket[OADProtocol_FOUNTAIN_SYMBOL_SYMBOL_ID_OFFSET] & 0xFF) |
+                        ((pIncomingPacket[OADProtocol_FOUNTAIN_SYMBOL_SYMBOL_ID_OFFSET + 1] & 0xFF) << 8);
+
+    //call application callback
+    if(OADProtocol_params.pProtocolMsgCallbacks->pfnOadFountainSymbolCb != NULL)
+    {
+        OADProtocol_params.pProtocolMsgCallbacks->pfnOadFountainSymbolCb(pSrcAddr,
+                  imgHdr,
+                  symbolId,
+                  &(pIncomingPacket[OADProtocol_FOUNTAIN_SYMBOL_DATA_OFFSET]));
+    }
+
+    status = OADProtocol_Status_Success;
+
+    return status;
+}
+
+static OADProtocol_Status_t processOadFountainStatus(void* pSrcAddr, uint8_t *pIncomingPacket)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+
+    uint8_t imgHdr = pIncomingPacket[OADProtocol_FOUNTAIN_STATUS_IMG_ID_OFFSET];
+    uint8_t fountainStatus = pIncomingPacket[OADProtocol_FOUNTAIN_STATUS_STATUS_OFFSET];
+
+    uint16_t decodedBlocks = ( pIncomingPacket[OADProtocol_FOUNTAIN_STATUS_DECODED_OFFSET] & 0xFF) |
+                             ((pIncomingPacket[OADProtocol_FOUNTAIN_STATUS_DECODED_OFFSET + 1] & 0xFF) << 8);
+
+    uint16_t receivedSymbols = ( pIncomingPacket[OADProtocol_FOUNTAIN_STATUS_RECEIVED_OFFSET] & 0xFF) |
+                               ((pIncomingPacket[OADProtocol_FOUNTAIN_STATUS_RECEIVED_OFFSET + 1] & 0xFF) << 8);
+
+    //call application callback
+    if(OADProtocol_params.pProtocolMsgCallbacks->pfnOadFountainStatusCb != NULL)
+    {
+        OADProtocol_params.pProtocolMsgCallbacks->pfnOadFountainStatusCb(pSrcAddr, imgHdr, fountainStatus, decodedBlocks, receivedSymbols);
+    }
+
+    status = OADProtocol_Status_Success;
+
+    return status;
+}
+
+static OADProtocol_Status_t processOadPushAck(void* pSrcAddr, uint8_t *pIncomingPacket)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+
+    uint8_t imgHdr = pIncomingPacket[OADProtocol_PUSH_ACK_IMG_ID_OFFSET];
+
+    uint16_t blockNum = ( pIncomingPacket[OADProtocol_PUSH_ACK_BLOCK_NUM_OFFSET] & 0xFF) |
+                        ((pIncomingPacket[OADProtocol_PUSH_ACK_BLOCK_NUM_OFFSET + 1] & 0xFF) << 8);
+
+    uint32_t blockBitmap = ( (uint32_t) pIncomingPacket[OADProtocol_PUSH_ACK_BITMAP_OFFSET] & 0xFF) |
+                           (((uint32_t) pIncomingPacket[OADProtocol_PUSH_ACK_BITMAP_OFFSET + 1] & 0xFF) << 8) |
+                           (((uint32_t) pIncomingPacket[OADProtocol_PUSH_ACK_BITMAP_OFFSET + 2] & 0xFF) << 16) |
+                           (((uint32_t) pIncomingPacket[OADProtocol_PUSH_ACK_BITMAP_OFFSET + 3] & 0xFF) << 24);
+
+    //call application callback
+    if(OADProtocol_params.pProtocolMsgCallbacks->pfnOadPushAckCb != NULL)
+    {
+        OADProtocol_params.pProtocolMsgCallbacks->pfnOadPushAckCb(pSrcAddr, imgHdr, blockNum, blockBitmap);
+    }
+
+    status = OADProtocol_Status_Success;
+
+    return status;
+}
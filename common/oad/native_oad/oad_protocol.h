@@ -87,6 +87,7 @@
  *    NULL,              //Incoming Image Identify Rsp
  *    NULL,              //Incoming OAD Block Req
  *    NULL,              //Incoming OAD Block Rsp
+ *    NULL,              //Incoming OAD Multi Block Req
  *  };
  *
  * static void fwVersionRspCb(void* pSrcAddr, char *fwVersionStr)
@@ -165,6 +166,95 @@
  *       <-------------------------- OAD_BLOCK_REQ(block=n)
  *   OAD_BLOCK_RSP(Block n) --------------->
  *
+ *  A client that stored part of the image before a download was interrupted
+ *  resumes it. The OAD_IMG_IDENTIFY_RSP then holds the first block it has not
+ *  stored and it requests the blocks it is missing from there on.
+ *
+ *  A client can instead request a window of blocks with
+ *  OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ. The server streams every block
+ *  of the window that is not marked as received in the bitmap, so the bitmap
+ *  of the next request acknowledges the previous window. The client moves the
+ *  window to its first missing block and ends the transfer with a request for
+ *  the block past the end of the image. Bit n of the bitmap stands for block
+ *  block+n of the window.
+ *
+ *  Server                           Client
+ *
+ *       <-------------------------- OAD_MULTI_BLOCK_REQ(block=0, size=8, bitmap=0x00)
+ *   OAD_BLOCK_RSP(Block 0..7) ------------>   (block 5 lost)
+ *       <-------------------------- OAD_MULTI_BLOCK_REQ(block=5, size=8, bitmap=0x06)
+ *   OAD_BLOCK_RSP(Block 5, 8..12) -------->
+ *         ...
+ *       <-------------------------- OAD_MULTI_BLOCK_REQ(block=n+1, size=8, bitmap=0x00)
+ *
+ *  When the server holds a delta patch from the FW version a client reported
+ *  in its FW_VERSION_RSP, the OAD_IMG_IDENTIFY_REQ carries
+ *  OADProtocol_IMG_ID_DELTA and the header of the new image. The blocks the
+ *  client then requests are those of the patch, which the client applies to
+ *  its running image to rebuild the new image in its download area. The
+ *  usual CRC check validates the result. A client that rejects the patch,
+ *  or whose rebuilt image fails the CRC check, responds with status 0 and
+ *  is sent the OAD_IMG_IDENTIFY_REQ of the full image.
+ *
+ *  When the server also holds the image compressed, the OAD_IMG_IDENTIFY_REQ
+ *  carries OADProtocol_IMG_ID_COMPRESSED and the header of the image. The
+ *  blocks are those of the compressed image, which the client decompresses
+ *  into its download area as they arrive. A client that rejects the
+ *  compressed image, or whose decompressed image fails the CRC check,
+ *  responds with status 0 and is sent the OAD_IMG_IDENTIFY_REQ of the
+ *  uncompressed image. A fountain coded broadcast always sends the
+ *  uncompressed image.
+ *
+ *  The OAD_IMG_IDENTIFY_RSP holds the image ID it answers. A client sends a
+ *  rejection again while it is not acknowledged, the server ignores the
+ *  rejection of an image it no longer sends.
+ *
+ *  To update many nodes at once the server broadcasts the image as fountain
+ *  coded symbols (see oad_fountain.h) with
+ *  OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_SYMBOL. The broadcast is announced by
+ *  an OADProtocol_PACKET_TYPE_OAD_IMG_IDENTIFY_REQ with
+ *  OADProtocol_IMG_ID_FOUNTAIN set in the image ID, repeated during the
+ *  broadcast. The packets go to the broadcast address, one in each
+ *  broadcast slot of the concentrator, and the server also sends the
+ *  OAD_IMG_IDENTIFY_REQ to each node that has not reported yet after its
+ *  next uplink. A client that accepts the image listens in the broadcast
+ *  slots, collects the symbols it receives into its symbol storage and
+ *  decodes once it has received enough of them, whichever ones were lost.
+ *  It reports its progress with OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_STATUS
+ *  every OADProtocol_FOUNTAIN_STATUS_PERIOD ms and once decoded.
+ *
+ *  Server                           Client(s)
+ *
+ *   OAD_IMG_IDENTIFY_REQ(imgId=0x80) ----->
+ *   OAD_FOUNTAIN_SYMBOL(symbol=1) -------->
+ *   OAD_FOUNTAIN_SYMBOL(symbol=2) -------->   (lost)
+ *         ...
+ *       <-------------------------- OAD_FOUNTAIN_STATUS(status=in progress)
+ *         ...
+ *   OAD_FOUNTAIN_SYMBOL(symbol=m) -------->
+ *       <-------------------------- OAD_FOUNTAIN_STATUS(status=complete)
+ *
+ *  In push mode the client does not request blocks. After the
+ *  OAD_IMG_IDENTIFY_RSP it sends an OADProtocol_PACKET_TYPE_OAD_PUSH_ACK
+ *  holding its first missing block and a bitmap of the
+ *  OADProtocol_PUSH_ACK_BITMAP_SIZE blocks from there, a bit set for each
+ *  block received. On each ack the server resends the blocks below the ones
+ *  already pushed that the bitmap reports missing, then pushes new blocks
+ *  back to back. The number of blocks pushed per ack is paced by the airtime
+ *  budget of the server and shrinks when the ack reports blocks lost. The
+ *  client acks after the last block of a burst is received, or every
+ *  OADProtocol_PUSH_ACK_INTERVAL ms when no block arrives, and ends the
+ *  transfer with an ack for the block past the end of the image.
+ *
+ *  Server                           Client
+ *
+ *       <-------------------------- OAD_PUSH_ACK(block=0, bitmap=0x00000000)
+ *   OAD_BLOCK_RSP(Block 0..11) ----------->   (block 5 lost)
+ *       <-------------------------- OAD_PUSH_ACK(block=5, bitmap=0x0000007E)
+ *   OAD_BLOCK_RSP(Block 5, 12..16) ------->
+ *         ...
+ *       <-------------------------- OAD_PUSH_ACK(block=n+1, bitmap=0x00000000)
+ *
  *
  *******************************************************************************
  */
@@ -183,6 +273,15 @@
 #define OADProtocol_BLOCK_REQ_RATE          160  ///< Block request rate
 #define OADProtocol_BLOCK_REQ_POLL_DELAY    80   ///< Block response poll delay
 #define OADProtocol_MAX_RETRIES             3    ///< Max retires before abort
+#define OADProtocol_MULTI_BLOCK_MAX_SIZE    8    ///< Max blocks streamed per multi block request
+#define OADProtocol_PUSH_ACK_INTERVAL       250  ///< Push mode ack interval when no block is received
+#define OADProtocol_PUSH_ACK_BITMAP_SIZE    32   ///< Blocks acknowledged per push mode ack
+#define OADProtocol_PUSH_MAX_IDLE_ACKS      8    ///< Push mode acks without a new block before the client aborts
+#define OADProtocol_FOUNTAIN_STATUS_PERIOD  3000 ///< Fountain status interval of a client during a broadcast
+#define OADProtocol_FOUNTAIN_MAX_IDLE       5    ///< Fountain status intervals without a new symbol before the client aborts
+#define OADProtocol_IMG_ID_FOUNTAIN         0x80 ///< Image ID flag announcing a fountain coded broadcast
+#define OADProtocol_IMG_ID_DELTA            0x40 ///< Image ID flag, blocks are a delta patch (see oad_delta.h)
+#define OADProtocol_IMG_ID_COMPRESSED       0x20 ///< Image ID flag, blocks are a compressed image (see oad_compress.h)
 
 #define OADProtocol_FW_VERSION_STR_LEN                 32 ///< Max Length of the FW version string
 
@@ -209,8 +308,10 @@
 #define OADProtocol_IMG_IDENTIFY_REQ_IMG_HDR_OFFSET   2   ///< Offset to status in Image Identify Response
 
 #define OADProtocol_PACKET_TYPE_OAD_IMG_IDENTIFY_RSP                0x03 ///< OAD update image identify response
-#define OADProtocol_PACKET_TYPE_OAD_IMG_IDENTIFY_RSP_LEN            1 + 1 ///< OAD update image identify response
+#define OADProtocol_PACKET_TYPE_OAD_IMG_IDENTIFY_RSP_LEN            1 + 1 + 2 + 1 ///< OAD update image identify response
 #define OADProtocol_IMG_IDENTIFY_RSP_STATUS_OFFSET   1   ///< Offset to status in Image Identify Response
+#define OADProtocol_IMG_IDENTIFY_RSP_RESUME_BLOCK_OFFSET   2   ///< Offset to 16B first block missing in Image Identify Response
+#define OADProtocol_IMG_IDENTIFY_RSP_IMG_ID_OFFSET   4   ///< Offset to image ID answered in Image Identify Response
 
 #define OADProtocol_PACKET_TYPE_OAD_BLOCK_REQ         0x04 ///< OAD update image block request
 #define OADProtocol_PACKET_TYPE_OAD_BLOCK_REQ_LEN     1 + 1 + 2 + 2 ///< OAD update image block request
@@ -224,6 +325,36 @@
 #define OADProtocol_BLOCK_RSP_BLOCK_NUM_OFFSET        2   ///< Offset to 16B block num in Block Request
 #define OADProtocol_BLOCK_RSP_BLOCK_DATA_OFFSET       4   ///< Offset to block data in Block Response
 
+#define OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ         0x06 ///< OAD update image multi block request
+#define OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ_LEN     1 + 1 + 2 + 2 + 2 ///< OAD update image multi block request
+#define OADProtocol_MULTI_BLOCK_REQ_IMG_ID_OFFSET           1   ///< Offset to image ID in Multi Block Request
+#define OADProtocol_MULTI_BLOCK_REQ_BLOCK_NUM_OFFSET        2   ///< Offset to 16B first block num in Multi Block Request
+#define OADProtocol_MULTI_BLOCK_REQ_MULTI_BLOCK_SIZE_OFFSET 4   ///< Offset to 16B window size in Multi Block Request
+#define OADProtocol_MULTI_BLOCK_REQ_BITMAP_OFFSET           6   ///< Offset to 16B received block bitmap in Multi Block Request
+
+#define OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_SYMBOL         0x07 ///< OAD update image fountain coded symbol
+#define OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_SYMBOL_LEN     1 + 1 + 2 + OAD_BLOCK_SIZE ///< OAD update image fountain coded symbol
+#define OADProtocol_FOUNTAIN_SYMBOL_IMG_ID_OFFSET           1   ///< Offset to image ID in Fountain Symbol
+#define OADProtocol_FOUNTAIN_SYMBOL_SYMBOL_ID_OFFSET        2   ///< Offset to 16B symbol ID in Fountain Symbol
+#define OADProtocol_FOUNTAIN_SYMBOL_DATA_OFFSET             4   ///< Offset to symbol data in Fountain Symbol
+
+#define OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_STATUS         0x08 ///< OAD fountain decode status
+#define OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_STATUS_LEN     1 + 1 + 1 + 2 + 2 ///< OAD fountain decode status
+#define OADProtocol_FOUNTAIN_STATUS_IMG_ID_OFFSET           1   ///< Offset to image ID in Fountain Status
+#define OADProtocol_FOUNTAIN_STATUS_STATUS_OFFSET           2   ///< Offset to status in Fountain Status
+#define OADProtocol_FOUNTAIN_STATUS_DECODED_OFFSET          3   ///< Offset to 16B decoded blocks in Fountain Status
+#define OADProtocol_FOUNTAIN_STATUS_RECEIVED_OFFSET         5   ///< Offset to 16B received symbols in Fountain Status
+
+#define OADProtocol_PACKET_TYPE_OAD_PUSH_ACK                0x09 ///< OAD push mode block acknowledge
+#define OADProtocol_PACKET_TYPE_OAD_PUSH_ACK_LEN            1 + 1 + 2 + 4 ///< OAD push mode block acknowledge
+#define OADProtocol_PUSH_ACK_IMG_ID_OFFSET                  1   ///< Offset to image ID in Push Ack
+#define OADProtocol_PUSH_ACK_BLOCK_NUM_OFFSET               2   ///< Offset to 16B first missing block in Push Ack
+#define OADProtocol_PUSH_ACK_BITMAP_OFFSET                  4   ///< Offset to 32B received block bitmap in Push Ack
+
+#define OADProtocol_FOUNTAIN_STATUS_IN_PROGRESS             1   ///< Decoding, not all blocks known yet
+#define OADProtocol_FOUNTAIN_STATUS_COMPLETE                2   ///< Image decoded and verified
+#define OADProtocol_FOUNTAIN_STATUS_FAILED                  3   ///< Image rejected or storage error
+
 
 /** @}*/
 
@@ -253,7 +384,7 @@ typedef void (*oadImgIdentifyReqCb_t)(void* pSrcAddr, uint8_t imgId, uint8_t *im
 /** @brief OAD image identify response packet callback function type
  *
  */
-typedef void (*oadImgIdentifyRspCb_t)(void* pSrcAddr, uint8_t status);
+typedef void (*oadImgIdentifyRspCb_t)(void* pSrcAddr, uint8_t imgId, uint8_t status, uint16_t resumeBlock);
 
 /** @brief OAD image block request packet callback function type
  *
@@ -265,6 +396,26 @@ typedef void (*oadBlockReqCb_t)(void* pSrcAddr, uint8_t imgId, uint16_t blockNum
  */
 typedef void (*oadBlockRspCb_t)(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint8_t *blkData);
 
+/** @brief OAD image multi block request packet callback function type
+ *
+ */
+typedef void (*oadMultiBlockReqCb_t)(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint16_t multiBlockSize, uint16_t blockBitmap);
+
+/** @brief  OAD fountain symbol callback function type
+ *
+ */
+typedef void (*oadFountainSymbolCb_t)(void* pSrcAddr, uint8_t imgId, uint16_t symbolId, uint8_t *symbolData);
+
+/** @brief  OAD fountain status callback function type
+ *
+ */
+typedef void (*oadFountainStatusCb_t)(void* pSrcAddr, uint8_t imgId, uint8_t status, uint16_t decodedBlocks, uint16_t receivedSymbols);
+
+/** @brief  OAD push mode ack callback function type
+ *
+ */
+typedef void (*oadPushAckCb_t)(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint32_t blockBitmap);
+
 /** @brief OADProtocol callback table
  *
  */
@@ -276,6 +427,10 @@ typedef struct
     oadImgIdentifyRspCb_t pfnOadImgIdentifyRspCb; ///< Incoming Image Identify Rsp
     oadBlockReqCb_t       pfnOadBlockReqCb; ///< Incoming OAD Block Req
     oadBlockRspCb_t       pfnOadBlockRspCb; ///< Incoming OAD Block Rsp
+    oadMultiBlockReqCb_t  pfnOadMultiBlockReqCb; ///< Incoming OAD Multi Block Req
+    oadFountainSymbolCb_t pfnOadFountainSymbolCb; ///< Incoming OAD Fountain Symbol
+    oadFountainStatusCb_t pfnOadFountainStatusCb; ///< Incoming OAD Fountain Status
+    oadPushAckCb_t        pfnOadPushAckCb; ///< Incoming OAD Push Ack
 } OADProtocol_MsgCBs_t;
 
 /** @brief function definition for sending message over the radio
@@ -365,11 +520,14 @@ extern OADProtocol_Status_t OADProtocol_sendImgIdentifyReq(void* pDstAddress, ui
 /** @brief  Function to send an OAD image identify request packet
  *
  *  @param  pDstAddress         Address to send the response to
+ *  @param  imgId               Image ID of the identify request answered
  *  @param  status              status to send
+ *  @param  resumeBlock         First block the client has not stored, 0 unless
+ *                              an interrupted download of the image resumes
  *
  *  @return                     Status
  */
-extern OADProtocol_Status_t OADProtocol_sendOadIdentifyImgRsp(void* pDstAddress, uint8_t status);
+extern OADProtocol_Status_t OADProtocol_sendOadIdentifyImgRsp(void* pDstAddress, uint8_t imgId, uint8_t status, uint16_t resumeBlock);
 
 /** @brief  Function to send an OAD block request packet
  *
@@ -395,4 +553,54 @@ extern OADProtocol_Status_t OADProtocol_sendOadImgBlockReq(void* pDstAddress, ui
  */
 extern OADProtocol_Status_t OADProtocol_sendOadImgBlockRsp(void* pDstAddress, uint8_t imgId, uint16_t blockNum, uint8_t *block);
 
+/** @brief  Function to send an OAD multi block request packet
+ *
+ *  @param  pDstAddress         Address to send the request to
+ *  @param  imgId               image ID of image blocks
+ *  @param  blockNum            First block of the window
+ *  @param  multiBlockSize      Number of blocks in the window (max OADProtocol_MULTI_BLOCK_MAX_SIZE)
+ *  @param  blockBitmap         Bit n set if block blockNum + n was already received
+ *
+ *  @return                     Status
+ *
+ */
+extern OADProtocol_Status_t OADProtocol_sendOadImgMultiBlockReq(void* pDstAddress, uint8_t imgId, uint16_t blockNum, uint16_t multiBlockSize, uint16_t blockBitmap);
+
+/** @brief  Function to send an OAD fountain coded symbol
+ *
+ *  @param  pDstAddress         Address to send the symbol to, normally the broadcast address
+ *  @param  imgId               image ID of image
+ *  @param  symbolId            Symbol ID the coded blocks are derived from
+ *  @param  symbol              OAD_BLOCK_SIZE bytes of symbol data
+ *
+ *  @return                     Status
+ *
+ */
+extern OADProtocol_Status_t OADProtocol_sendOadFountainSymbol(void* pDstAddress, uint8_t imgId, uint16_t symbolId, uint8_t *symbol);
+
+/** @brief  Function to send an OAD fountain status packet
+ *
+ *  @param  pDstAddress         Address to send the status to
+ *  @param  imgId               image ID of image
+ *  @param  status              OADProtocol_FOUNTAIN_STATUS_ value
+ *  @param  decodedBlocks       Number of image blocks decoded
+ *  @param  receivedSymbols     Number of symbols received
+ *
+ *  @return                     Status
+ *
+ */
+extern OADProtocol_Status_t OADProtocol_sendOadFountainStatus(void* pDstAddress, uint8_t imgId, uint8_t status, uint16_t decodedBlocks, uint16_t receivedSymbols);
+
+/** @brief  Function to send an OAD push mode ack packet
+ *
+ *  @param  pDstAddress         Address to send the ack to
+ *  @param  imgId               image ID of image blocks
+ *  @param  blockNum            First block not received
+ *  @param  blockBitmap         Bit n set if block blockNum + n was received
+ *
+ *  @return                     Status
+ *
+ */
+extern OADProtocol_Status_t OADProtocol_sendOadPushAck(void* pDstAddress, uint8_t imgId, uint16_t blockNum, uint32_t blockBitmap);
+
 #endif /* OADProtocol_H_ */
@@ -62,6 +62,23 @@
 
 #define HAL_FLASH_WORD_SIZE  4
 
+// Pages of an image tracked as erased, 128 KB of 4 KB pages
+#define ERASED_PAGES_MAX     32
+
+// Size of the read-ahead cache of image blocks
+#ifndef OAD_READ_CACHE_SIZE
+#define OAD_READ_CACHE_SIZE  1024
+#endif
+
+#define READ_CACHE_BLOCKS    (OAD_READ_CACHE_SIZE / OAD_BLOCK_SIZE)
+#define READ_CACHE_INVALID   0xFFFF
+
+// Blocks of an image tracked in the download record
+#define DL_RECORD_BLOCKS     (ERASED_PAGES_MAX * 4096 / OAD_BLOCK_SIZE)
+
+// Blocks recorded at once, once their program page is complete
+#define DL_RECORD_PAGE_BLOCKS (OAD_FLASH_PROGRAM_SIZE / OAD_BLOCK_SIZE)
+
 /*********************************************************************
  * MACROS
  */
@@ -80,9 +97,30 @@ static uint32_t imageAddress;
 static uint16_t imagePage;
 static uint32_t flashPageSize;
 
+// Pages of the image erased during this download
+static uint32_t erasedPages = 0;
+
+// Read-ahead cache holding consecutive blocks of the image, from
+// readCacheBlock on. Hit and miss counts are kept for OADStorage_getReadCacheStats.
+static uint8_t readCache[READ_CACHE_BLOCKS * OAD_BLOCK_SIZE];
+static uint16_t readCacheBlock = READ_CACHE_INVALID;
+static uint32_t readCacheHits = 0;
+static uint32_t readCacheMisses = 0;
+
+// Blocks of the image stored, written during this download or found in the
+// download record of an interrupted download of the same image.
+static uint8_t dlBitmap[DL_RECORD_BLOCKS / 8];
+
 #ifndef FEATURE_OAD_ONCHIP
 // Used to keep track of images written.
 static uint8_t flagRecord = 0;
+
+// Running CRC of the blocks written in order so far. Blocks are read back
+// once their program page is complete.
+static uint16_t crcRunning = 0;
+static uint16_t crcNextBlock = 0;
+static uint16_t crcReadBlock = 0;
+static bool crcInOrder = false;
 #endif //FEATURE_OAD_ONCHIP
 
 static uint8_t OADStorage_imageIdLen = 0;
@@ -94,9 +132,15 @@ static uint8_t OADStorage_imageIdLen = 0;
  * LOCAL FUNCTIONS
  */
 
+static void imgPageErase(uint16_t page, bool pageStart);
+static bool readCacheHas(uint16_t blockNum);
+static void dlRecordOpen(uint8_t *pValue);
+static void dlRecordBlock(uint16_t blockNum);
+
 #if !defined FEATURE_OAD_ONCHIP
 static uint8_t checkDL(void);
 static uint16_t crcCalcDL(void);
+static void crcCalcBlock(uint16_t blockNum);
 static uint16_t crc16(uint16_t crc, uint8_t val);
 #endif  // !FEATURE_OAD_ONCHIP
 
@@ -138,6 +182,9 @@ uint16_t OADStorage_imgIdentifyRead(uint8_t imageType, OADTarget_ImgHdr_t* pImgH
     {
         OADTarget_open();
 
+        // Cached blocks may be of another image.
+        readCacheBlock = READ_CACHE_INVALID;
+
         // Determine where image will be read from.
         imageAddress = OADTarget_imageAddress((uint8_t*)pImgHdr);
         imagePage = imageAddress / FlashSectorSizeGet();
@@ -202,8 +249,16 @@ uint16_t OADStorage_imgIdentifyWrite(uint8_t *pValue)
 
 #ifndef FEATURE_OAD_ONCHIP
     flagRecord = 0;
+
+    crcRunning = 0;
+    crcNextBlock = 0;
+    crcReadBlock = 0;
+    crcInOrder = true;
 #endif
 
+    erasedPages = 0;
+    readCacheBlock = READ_CACHE_INVALID;
+
     /* Requirements to begin OAD:
      * 1) LSB of image version cannot be the same, this would imply a code overlap
      *    between currently running image and new image.
@@ -223,6 +278,11 @@ uint16_t OADStorage_imgIdentifyWrite(uint8_t *pValue)
         {
             oadBlkTot = 0;
         }
+        else
+        {
+            // Resume an interrupted download of the same image.
+            dlRecordOpen(pValue);
+        }
     }
     else
     {
@@ -244,18 +304,58 @@ uint16_t OADStorage_imgIdentifyWrite(uint8_t *pValue)
  */
 void OADStorage_imgBlockWrite(uint16_t blockNum, uint8_t *pBlockData)
 {
-    // Calculate address to write as (start of OAD range) + (offset into range)
-    uint32_t addr = imageAddress + (blockNum * OAD_BLOCK_SIZE);
+    // Calculate offset to write into the OAD range
+    uint32_t offset = blockNum * OAD_BLOCK_SIZE;
+    uint16_t page = offset / flashPageSize;
 
-    // If address starts a new page, erase that page first.
-    if ((addr % flashPageSize) == 0)
+    // Blocks retried or stored before an interruption are not written again.
+    if (OADStorage_imgBlockPresent(blockNum))
     {
-      OADTarget_eraseFlash(addr / flashPageSize);
+        return;
     }
 
+    // Erase the page of the block first, unless it was erased ahead.
+    imgPageErase(page, (offset % flashPageSize) == 0);
+
     // Write a 16 byte block to Flash.
-    OADTarget_writeFlash(imagePage, (blockNum * OAD_BLOCK_SIZE), pBlockData,
-                         OAD_BLOCK_SIZE);
+    OADTarget_writeFlash(imagePage, offset, pBlockData, OAD_BLOCK_SIZE);
+
+    // Image is being replaced, drop the cached blocks.
+    readCacheBlock = READ_CACHE_INVALID;
+
+    dlRecordBlock(blockNum);
+
+    // Once the last block of a page is written, erase the next page. The
+    // erase then runs while the next blocks are received instead of
+    // delaying the write of the first one.
+    if ((((offset + OAD_BLOCK_SIZE) % flashPageSize) == 0) &&
+        ((blockNum + 1) < oadBlkTot) && ((page + 1) < ERASED_PAGES_MAX))
+    {
+        imgPageErase(page + 1, true);
+    }
+
+#if !defined FEATURE_OAD_ONCHIP
+    // Keep the image CRC up to date while blocks arrive in order, otherwise
+    // the whole image is read back when it is finalised. Reading back a
+    // program page only once it is complete keeps the blocks combined.
+    if (crcInOrder && (blockNum == crcNextBlock))
+    {
+        crcNextBlock++;
+
+        if ((((crcNextBlock * OAD_BLOCK_SIZE) % OAD_FLASH_PROGRAM_SIZE) == 0) ||
+            (crcNextBlock == oadBlkTot))
+        {
+            while (crcReadBlock < crcNextBlock)
+            {
+                crcCalcBlock(crcReadBlock++);
+            }
+        }
+    }
+    else
+    {
+        crcInOrder = false;
+    }
+#endif //!FEATURE_OAD_ONCHIP
 }
 
 /*********************************************************************
@@ -270,9 +370,104 @@ void OADStorage_imgBlockWrite(uint16_t blockNum, uint8_t *pBlockData)
  */
 void OADStorage_imgBlockRead(uint16_t blockNum, uint8_t *pBlockData)
 {
-    // Read a block from Flash.
-    OADTarget_readFlash(imagePage, (blockNum * OAD_BLOCK_SIZE), pBlockData,
-                         OAD_BLOCK_SIZE);
+    if (readCacheHas(blockNum))
+    {
+        memcpy(pBlockData, &readCache[(blockNum - readCacheBlock) * OAD_BLOCK_SIZE],
+               OAD_BLOCK_SIZE);
+        readCacheHits++;
+    }
+    else
+    {
+        // Read a block from Flash. Blocks out of sequence, as read by the
+        // fountain broadcast, do not replace the cached ones.
+        OADTarget_readFlash(imagePage, (blockNum * OAD_BLOCK_SIZE), pBlockData,
+                             OAD_BLOCK_SIZE);
+        readCacheMisses++;
+    }
+}
+
+/*********************************************************************
+ * @fn      OADStorage_imgBlockPrefetch
+ *
+ * @brief   Read ahead the blocks from blockNum on, unless the blocks
+ *          expected are already cached. The block before blockNum is kept
+ *          so that a retried request is served from the cache.
+ *
+ * @param   blockNum   - next block expected to be read
+ * @param   numBlocks  - number of blocks expected from blockNum on
+ *
+ * @return  none
+ */
+void OADStorage_imgBlockPrefetch(uint16_t blockNum, uint16_t numBlocks)
+{
+    if ((numBlocks == 0) || (numBlocks >= READ_CACHE_BLOCKS))
+    {
+        numBlocks = 1;
+    }
+
+    if (!readCacheHas(blockNum) || !readCacheHas(blockNum + numBlocks - 1))
+    {
+        readCacheBlock = (blockNum > 0) ? (blockNum - 1) : 0;
+
+        // One read of the whole cache costs a single command and address.
+        OADTarget_readFlash(imagePage, (readCacheBlock * OAD_BLOCK_SIZE),
+                            readCache, sizeof(readCache));
+    }
+}
+
+/*********************************************************************
+ * @fn      OADStorage_getReadCacheStats
+ *
+ * @brief   Get the read-ahead cache hit and miss counts.
+ *
+ * @param   pHits   - pointer for the number of blocks read from the cache
+ * @param   pMisses - pointer for the number of blocks read from flash
+ *
+ * @return  none
+ */
+void OADStorage_getReadCacheStats(uint32_t *pHits, uint32_t *pMisses)
+{
+    *pHits = readCacheHits;
+    *pMisses = readCacheMisses;
+}
+
+/*********************************************************************
+ * @fn      OADStorage_imgBlockPresent
+ *
+ * @brief   Check if a block of the image being written is already stored.
+ *
+ * @param   blockNum   - block number
+ *
+ * @return  true if the block is stored
+ */
+bool OADStorage_imgBlockPresent(uint16_t blockNum)
+{
+    if (blockNum >= DL_RECORD_BLOCKS)
+    {
+        return false;
+    }
+
+    return (dlBitmap[blockNum / 8] & (1 << (blockNum % 8))) ? true : false;
+}
+
+/*********************************************************************
+ * @fn      OADStorage_imgResumeBlock
+ *
+ * @brief   Get the first block of the image being written that is not
+ *          stored yet.
+ *
+ * @return  first block not stored
+ */
+uint16_t OADStorage_imgResumeBlock(void)
+{
+    uint16_t blockNum = 0;
+
+    while ((blockNum < oadBlkTot) && OADStorage_imgBlockPresent(blockNum))
+    {
+        blockNum++;
+    }
+
+    return blockNum;
 }
 
 /*********************************************************************
@@ -323,12 +518,44 @@ OADStorage_Status_t OADStorage_imgFinalise(void)
         status = OADStorage_CrcError;
     }
     flagRecord = 0;
+    crcInOrder = false;
 #endif //!FEATURE_OAD_ONCHIP
-    OADTarget_close();
+
+    // A complete or failed image is not resumed.
+    OADTarget_clearDownloadRecord();
+    memset(dlBitmap, 0, sizeof(dlBitmap));
+
+    // The image information is the last write, programmed by the close.
+    if (!OADTarget_close() && (status == OADStorage_Status_Success))
+    {
+        status = OADStorage_FlashError;
+    }
 
     return status;
 }
 
+/*********************************************************************
+ * @fn      OADStorage_imgDiscard
+ *
+ * @brief   Stop writing the image and forget the blocks stored.
+ *
+ * @param  none
+ *
+ * @return none
+ */
+void OADStorage_imgDiscard(void)
+{
+#if !defined FEATURE_OAD_ONCHIP
+    flagRecord = 0;
+    crcInOrder = false;
+#endif //!FEATURE_OAD_ONCHIP
+
+    OADTarget_clearDownloadRecord();
+    memset(dlBitmap, 0, sizeof(dlBitmap));
+
+    OADStorage_close();
+}
+
 /*********************************************************************
  * @fn      OADStorage_imgFinalise
  *
@@ -340,9 +567,139 @@ OADStorage_Status_t OADStorage_imgFinalise(void)
  */
 void OADStorage_close(void)
 {
+    readCacheBlock = READ_CACHE_INVALID;
     OADTarget_close();
 }
 
+/*********************************************************************
+ * @fn      readCacheHas
+ *
+ * @brief   Check if a block is held by the read-ahead cache.
+ *
+ * @param   blockNum - block number
+ *
+ * @return  true if the block is cached
+ */
+static bool readCacheHas(uint16_t blockNum)
+{
+    return ((readCacheBlock != READ_CACHE_INVALID) &&
+            (blockNum >= readCacheBlock) &&
+            (blockNum < readCacheBlock + READ_CACHE_BLOCKS));
+}
+
+/*********************************************************************
+ * @fn      imgPageErase
+ *
+ * @brief   Erase a page of the image unless it was already erased during
+ *          this download.
+ *
+ * @param   page      - page to erase, relative to the start of the image
+ * @param   pageStart - true if the page is about to be written from its
+ *                      start, used for pages beyond the erase record
+ *
+ * @return  None
+ */
+static void imgPageErase(uint16_t page, bool pageStart)
+{
+    if (page < ERASED_PAGES_MAX)
+    {
+        if (!(erasedPages & (1UL << page)))
+        {
+            erasedPages |= (1UL << page);
+            OADTarget_eraseFlash(imagePage + page);
+        }
+    }
+    else if (pageStart)
+    {
+        OADTarget_eraseFlash(imagePage + page);
+    }
+}
+
+/*********************************************************************
+ * @fn      dlRecordOpen
+ *
+ * @brief   Load the blocks stored of an interrupted download of the
+ *          image, or start the record of a new download.
+ *
+ * @param   pValue - pointer to the image header
+ *
+ * @return  None
+ */
+static void dlRecordOpen(uint8_t *pValue)
+{
+    uint16_t blockNum;
+    bool resumed = false;
+
+    if (OADTarget_readDownloadRecord(pValue, dlBitmap, sizeof(dlBitmap)))
+    {
+        for (blockNum = 0; (blockNum < oadBlkTot) && (blockNum < DL_RECORD_BLOCKS); blockNum++)
+        {
+            if (OADStorage_imgBlockPresent(blockNum))
+            {
+                // Pages holding stored blocks must not be erased again.
+                erasedPages |= (1UL << ((blockNum * OAD_BLOCK_SIZE) / flashPageSize));
+                resumed = true;
+            }
+        }
+    }
+    else
+    {
+        memset(dlBitmap, 0, sizeof(dlBitmap));
+        OADTarget_startDownloadRecord(pValue);
+    }
+
+#if !defined FEATURE_OAD_ONCHIP
+    // The CRC of a resumed image is calculated once it is complete.
+    if (resumed)
+    {
+        crcInOrder = false;
+    }
+#endif //!FEATURE_OAD_ONCHIP
+}
+
+/*********************************************************************
+ * @fn      dlRecordBlock
+ *
+ * @brief   Mark a block as stored. The blocks of a program page are
+ *          recorded once the page is complete, the record write then
+ *          follows the program of the page and does not split it.
+ *
+ * @param   blockNum - block number written
+ *
+ * @return  None
+ */
+static void dlRecordBlock(uint16_t blockNum)
+{
+    uint16_t firstBlock = blockNum - (blockNum % DL_RECORD_PAGE_BLOCKS);
+    uint16_t lastBlock = firstBlock + DL_RECORD_PAGE_BLOCKS - 1;
+    uint16_t idx;
+
+    if (blockNum >= DL_RECORD_BLOCKS)
+    {
+        return;
+    }
+
+    dlBitmap[blockNum / 8] |= (1 << (blockNum % 8));
+
+    if (lastBlock >= oadBlkTot)
+    {
+        lastBlock = oadBlkTot - 1;
+    }
+
+    for (idx = firstBlock; idx <= lastBlock; idx++)
+    {
+        if (!OADStorage_imgBlockPresent(idx))
+        {
+            return;
+        }
+    }
+
+    for (idx = firstBlock / 8; idx <= lastBlock / 8; idx++)
+    {
+        OADTarget_writeDownloadRecord(idx, dlBitmap[idx]);
+    }
+}
+
 #if !defined FEATURE_OAD_ONCHIP
 /*********************************************************************
  * @fn      crcCalcDL
@@ -410,6 +767,44 @@ static uint16_t crcCalcDL(void)
   return imageCRC;
 }
 
+/*********************************************************************
+ * @fn      crcCalcBlock
+ *
+ * @brief   Add a block just written to the running CRC. The block is read
+ *          back so that the CRC covers what is in flash, as crcCalcDL does.
+ *
+ * @param   blockNum - block number written
+ *
+ * @return  None
+ */
+static void crcCalcBlock(uint16_t blockNum)
+{
+  uint8_t buf[OAD_BLOCK_SIZE];
+  uint16_t start = 0;
+  uint16_t end = OAD_BLOCK_SIZE;
+  uint16_t idx;
+
+  OADTarget_readFlash(imagePage, (blockNum * OAD_BLOCK_SIZE), buf,
+                      OAD_BLOCK_SIZE);
+
+  // Exclude the CRC section of the first block and all bytes after the
+  // remainder bytes of the last block.
+  if (blockNum == 0)
+  {
+    start = HAL_FLASH_WORD_SIZE;
+  }
+
+  if ((blockNum == oadBlkTot - 1) && (oadRemianingBytes != 0))
+  {
+    end = oadRemianingBytes;
+  }
+
+  for (idx = start; idx < end; idx++)
+  {
+    crcRunning = crc16(crcRunning, buf[idx]);
+  }
+}
+
 /*********************************************************************
  * @fn      checkDL
  *
@@ -430,8 +825,18 @@ static uint8_t checkDL(void)
     return false;
   }
 
-  // Calculate CRC of downloaded image.
-  crc[1] = crcCalcDL();
+  // Calculate CRC of downloaded image, unless it was calculated as the
+  // blocks were written.
+  if (crcInOrder && (crcNextBlock == oadBlkTot))
+  {
+    // IAR note explains that poly must be run with value zero for each byte
+    // of the crc.
+    crc[1] = crc16(crc16(crcRunning, 0), 0);
+  }
+  else
+  {
+    crc[1] = crcCalcDL();
+  }
 
   if (crc[1] == crc[0])
   {
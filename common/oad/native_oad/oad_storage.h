@@ -136,6 +136,54 @@ extern uint16_t OADStorage_imgIdentifyWrite(uint8_t *pValue);
  */
 extern void OADStorage_imgBlockRead(uint16_t blockNum, uint8_t *pBlockData);
 
+/*********************************************************************
+ * @fn      OADStorage_imgBlockPrefetch
+ *
+ * @brief   Read ahead Image Blocks into the read cache, so that they are
+ *          served by OADStorage_imgBlockRead without a flash access.
+ *
+ * @param   blockNum   - next block expected to be read
+ * @param   numBlocks  - number of blocks expected from blockNum on
+ *
+ * @return  none
+ */
+extern void OADStorage_imgBlockPrefetch(uint16_t blockNum, uint16_t numBlocks);
+
+/*********************************************************************
+ * @fn      OADStorage_getReadCacheStats
+ *
+ * @brief   Get the read cache hit and miss counts since power up.
+ *
+ * @param   pHits   - pointer for the number of blocks read from the cache
+ * @param   pMisses - pointer for the number of blocks read from flash
+ *
+ * @return  none
+ */
+extern void OADStorage_getReadCacheStats(uint32_t *pHits, uint32_t *pMisses);
+
+/*********************************************************************
+ * @fn      OADStorage_imgBlockPresent
+ *
+ * @brief   Check if a block of the image being written is already stored,
+ *          written since OADStorage_imgIdentifyWrite or before an
+ *          interruption of the download of the same image.
+ *
+ * @param   blockNum   - block number
+ *
+ * @return  true if the block is stored
+ */
+extern bool OADStorage_imgBlockPresent(uint16_t blockNum);
+
+/*********************************************************************
+ * @fn      OADStorage_imgResumeBlock
+ *
+ * @brief   Get the first block of the image being written that is not
+ *          stored yet, where an interrupted download resumes.
+ *
+ * @return  first block not stored
+ */
+extern uint16_t OADStorage_imgResumeBlock(void);
+
 /*********************************************************************
  * @fn      OADStorage_imgInfoRead
  *
@@ -170,6 +218,18 @@ extern void OADStorage_imgBlockWrite(uint16_t blockNum, uint8_t *pBlockData);
  */
 extern OADStorage_Status_t OADStorage_imgFinalise(void);
 
+/*********************************************************************
+ * @fn      OADStorage_imgDiscard
+ *
+ * @brief   Stop writing the image and forget the blocks stored, a later
+ *          download of the same image is not resumed on them.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+extern void OADStorage_imgDiscard(void);
+
 /*********************************************************************
  * @fn      OADStorage_close
  *
@@ -79,6 +79,10 @@ extern "C"
 #define OAD_BLOCK_SIZE         128
 #endif //OAD_BLOCK_SIZE
 
+// External flash is programmed in pages of this size, consecutive blocks are
+// combined until their program page is complete.
+#define OAD_FLASH_PROGRAM_SIZE 256
+
 #define OAD_BLOCKS_PER_PAGE    (HAL_FLASH_PAGE_SIZE / OAD_BLOCK_SIZE)
 #define OAD_BLOCK_MAX          (OAD_BLOCKS_PER_PAGE * OAD_IMG_D_AREA)
 
@@ -194,6 +198,15 @@ extern "C"
 #define OADTarget_HI_UINT16(a) (((a) >> 8) & 0xFF)
 #define OADTarget_LO_UINT16(a) ((a) & 0xFF)
 
+#define OADTarget_BUILD_UINT32(byte0, byte1, byte2, byte3) \
+          ((uint32_t)((uint32_t)((byte0) & 0x00FF) + \
+                     ((uint32_t)((byte1) & 0x00FF) << 8) + \
+                     ((uint32_t)((byte2) & 0x00FF) << 16) + \
+                     ((uint32_t)((byte3) & 0x00FF) << 24)))
+
+#define OADTarget_BREAK_UINT32(var, byteNum) \
+          (uint8_t)((uint32_t)(((var) >> ((byteNum) * 8)) & 0x00FF))
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -236,9 +249,9 @@ extern uint8_t OADTarget_open(void);
  *
  * @param   None.
  *
- * @return  None.
+ * @return  TRUE if the data written was completely programmed
  */
-extern void OADTarget_close(void);
+extern uint8_t OADTarget_close(void);
 
 /*********************************************************************
  * @fn      OADTarget_hasExternalFlash
@@ -407,6 +420,53 @@ extern void saveImageInfo(void);
  */
 extern uint8_t getImageFlag(void);
 
+/*******************************************************************************
+ * @fn      OADTarget_readDownloadRecord
+ *
+ * @brief   Read the blocks already stored of an interrupted download.
+ *
+ * @param   pValue  - pointer to the 16 byte image header of the download
+ * @param   pBitmap - pointer for the bitmap of blocks stored, bit set if stored
+ * @param   len     - length of the bitmap in bytes
+ *
+ * @return  TRUE if the record is of a download of this image
+ */
+extern uint8_t OADTarget_readDownloadRecord(uint8_t *pValue, uint8_t *pBitmap,
+                                            uint16_t len);
+
+/*******************************************************************************
+ * @fn      OADTarget_startDownloadRecord
+ *
+ * @brief   Start the record of a download with no blocks stored.
+ *
+ * @param   pValue - pointer to the 16 byte image header of the download
+ *
+ * @return  None.
+ */
+extern void OADTarget_startDownloadRecord(uint8_t *pValue);
+
+/*******************************************************************************
+ * @fn      OADTarget_writeDownloadRecord
+ *
+ * @brief   Record blocks as stored. Bits can only be set until the record
+ *          is started again.
+ *
+ * @param   offset - offset of the byte in the bitmap
+ * @param   bits   - bitmap byte, bit set if stored
+ *
+ * @return  None.
+ */
+extern void OADTarget_writeDownloadRecord(uint16_t offset, uint8_t bits);
+
+/*******************************************************************************
+ * @fn      OADTarget_clearDownloadRecord
+ *
+ * @brief   Clear the record once the download is complete.
+ *
+ * @return  None.
+ */
+extern void OADTarget_clearDownloadRecord(void);
+
 
 /*********************************************************************
 *********************************************************************/
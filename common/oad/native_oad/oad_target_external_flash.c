@@ -71,6 +71,13 @@
 
 #define MAX_BLOCKS                (EFL_SIZE_IMAGE_APP / OAD_BLOCK_SIZE)
 
+// Download record: image header, then the magic once the header is
+// written, then the bitmap of blocks stored with a bit cleared per block.
+#define DL_RECORD_MAGIC           0x5244414F  // "OADR"
+#define DL_RECORD_HDR_SIZE        16
+#define DL_RECORD_MAGIC_OSET      16
+#define DL_RECORD_BITMAP_OSET     32
+
 /*******************************************************************************
  * PRIVATE VARIABLES
  */
@@ -112,15 +119,19 @@ uint8_t OADTarget_open(void)
  *
  * @param   none
  *
- * @return  none
+ * @return  true if the data written was completely programmed
  */
-void OADTarget_close(void)
+uint8_t OADTarget_close(void)
 {
+  uint8_t ret = true;
+
   if (isOpen)
   {
     isOpen = false;
-    ExtFlash_close();
+    ret = ExtFlash_close() ? true : false;
   }
+
+  return ret;
 }
 
 /*******************************************************************************
@@ -210,6 +221,14 @@ uint16_t OADTarget_getImageHeader(uint8_t imageType, OADTarget_ImgHdr_t *pHdr)
   {
       metaDataAddr = EFL_IMAGE_INFO_ADDR_REMOTE_APP;
   }
+  else if(imageType == EFL_OAD_IMG_TYPE_DELTA)
+  {
+      metaDataAddr = EFL_IMAGE_INFO_ADDR_DELTA;
+  }
+  else if(imageType == EFL_OAD_IMG_TYPE_COMPRESSED)
+  {
+      metaDataAddr = EFL_IMAGE_INFO_ADDR_COMPRESSED;
+  }
   else // Assume imageType == EFL_OAD_IMG_TYPE_APP
   {
       metaDataAddr = EFL_IMAGE_INFO_ADDR_APP;
@@ -283,6 +302,20 @@ uint8_t OADTarget_validateNewImage(uint8_t *pValue, OADTarget_ImgHdr_t *pCur,
     return false;
   }
 
+  // A delta patch must fit its smaller region
+  if (imgType == EFL_OAD_IMG_TYPE_DELTA
+      && blkTot > (EFL_SIZE_IMAGE_DELTA / OAD_BLOCK_SIZE))
+  {
+    return false;
+  }
+
+  // So must a compressed image
+  if (imgType == EFL_OAD_IMG_TYPE_COMPRESSED
+      && blkTot > (EFL_SIZE_IMAGE_COMPRESSED / OAD_BLOCK_SIZE))
+  {
+    return false;
+  }
+
   // Check if current header is invalid
   if (pCur->ver == 0xFFFF || pCur->ver == 0x0000)
   {
@@ -361,6 +394,16 @@ uint32_t OADTarget_imageAddress(uint8_t *pValue)
       extAddr = EFL_ADDR_IMAGE_REMOTE_APP;
       break;
 
+    // Delta patch for the Remote Application image.
+    case EFL_OAD_IMG_TYPE_DELTA:
+      extAddr = EFL_ADDR_IMAGE_DELTA;
+      break;
+
+    // Compressed Remote Application image.
+    case EFL_OAD_IMG_TYPE_COMPRESSED:
+      extAddr = EFL_ADDR_IMAGE_COMPRESSED;
+      break;
+
     // All other images are placed into the next available image slot.
     default:
       extAddr = EFL_ADDR_IMAGE_BLE;
@@ -500,6 +543,14 @@ void saveImageInfo(void)
   {
     addr = EFL_IMAGE_INFO_ADDR_REMOTE_APP;
   }
+  else if (imgInfo.imgType == EFL_OAD_IMG_TYPE_DELTA)
+  {
+    addr = EFL_IMAGE_INFO_ADDR_DELTA;
+  }
+  else if (imgInfo.imgType == EFL_OAD_IMG_TYPE_COMPRESSED)
+  {
+    addr = EFL_IMAGE_INFO_ADDR_COMPRESSED;
+  }
   else
   {
     addr = EFL_IMAGE_INFO_ADDR_BLE;
@@ -516,6 +567,100 @@ void saveImageInfo(void)
                 (uint8_t*)&imgInfo);
 }
 
+/*******************************************************************************
+ * @fn      OADTarget_readDownloadRecord
+ *
+ * @brief   Read the blocks already stored of an interrupted download.
+ *
+ * @param   pValue  - pointer to the 16 byte image header of the download
+ * @param   pBitmap - pointer for the bitmap of blocks stored, bit set if stored
+ * @param   len     - length of the bitmap in bytes
+ *
+ * @return  TRUE if the record is of a download of this image
+ */
+uint8_t OADTarget_readDownloadRecord(uint8_t *pValue, uint8_t *pBitmap,
+                                     uint16_t len)
+{
+  uint8_t record[DL_RECORD_BITMAP_OSET];
+  uint16_t idx;
+
+  ExtFlash_read(EFL_DL_RECORD_ADDR, sizeof(record), record);
+
+  if ((OADTarget_BUILD_UINT32(record[DL_RECORD_MAGIC_OSET],
+                              record[DL_RECORD_MAGIC_OSET + 1],
+                              record[DL_RECORD_MAGIC_OSET + 2],
+                              record[DL_RECORD_MAGIC_OSET + 3]) != DL_RECORD_MAGIC) ||
+      (memcmp(record, pValue, DL_RECORD_HDR_SIZE) != 0))
+  {
+    return false;
+  }
+
+  ExtFlash_read(EFL_DL_RECORD_ADDR + DL_RECORD_BITMAP_OSET, len, pBitmap);
+
+  // Erased bits are blocks not stored.
+  for (idx = 0; idx < len; idx++)
+  {
+    pBitmap[idx] = ~pBitmap[idx];
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+ * @fn      OADTarget_startDownloadRecord
+ *
+ * @brief   Start the record of a download with no blocks stored.
+ *
+ * @param   pValue - pointer to the 16 byte image header of the download
+ *
+ * @return  none
+ */
+void OADTarget_startDownloadRecord(uint8_t *pValue)
+{
+  uint8_t magic[4] = {
+    OADTarget_BREAK_UINT32(DL_RECORD_MAGIC, 0),
+    OADTarget_BREAK_UINT32(DL_RECORD_MAGIC, 1),
+    OADTarget_BREAK_UINT32(DL_RECORD_MAGIC, 2),
+    OADTarget_BREAK_UINT32(DL_RECORD_MAGIC, 3)
+  };
+
+  ExtFlash_erase(EFL_DL_RECORD_ADDR, FlashSectorSizeGet());
+
+  // The record is only valid once the header is written.
+  ExtFlash_write(EFL_DL_RECORD_ADDR, DL_RECORD_HDR_SIZE, pValue);
+  ExtFlash_write(EFL_DL_RECORD_ADDR + DL_RECORD_MAGIC_OSET, sizeof(magic), magic);
+}
+
+/*******************************************************************************
+ * @fn      OADTarget_writeDownloadRecord
+ *
+ * @brief   Record blocks as stored. Bits can only be set until the record
+ *          is started again.
+ *
+ * @param   offset - offset of the byte in the bitmap
+ * @param   bits   - bitmap byte, bit set if stored
+ *
+ * @return  none
+ */
+void OADTarget_writeDownloadRecord(uint16_t offset, uint8_t bits)
+{
+  uint8_t value = ~bits;
+
+  ExtFlash_write(EFL_DL_RECORD_ADDR + DL_RECORD_BITMAP_OSET + offset, 1, &value);
+}
+
+/*******************************************************************************
+ * @fn      OADTarget_clearDownloadRecord
+ *
+ * @brief   Clear the record once the download is complete.
+ *
+ * @return  none
+ */
+void OADTarget_clearDownloadRecord(void)
+{
+  ExtFlash_erase(EFL_DL_RECORD_ADDR, FlashSectorSizeGet());
+}
+
 /*******************************************************************************
  * @fn      getImageFlag
  *
@@ -31,6 +31,9 @@
  */
 
 /***** Includes *****/
+/* Standard C Libraries */
+#include <string.h>
+
 /* XDCtools Header files */ 
 #include <xdc/std.h>
 #include <xdc/runtime/System.h>
@@ -43,6 +46,7 @@
 #include <ti/sysbios/knl/Task.h>
 #include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/knl/Event.h>
+#include <ti/sysbios/knl/Clock.h>
 
 /* TI-RTOS Header files */ 
 #include <ti/drivers/rf/RF.h>
@@ -62,10 +66,25 @@
 #define RADIO_EVENT_ALL                      0xFFFFFFFF
 #define RADIO_EVENT_VALID_PACKET_RECEIVED    (uint32_t)(1 << 0)
 #define RADIO_EVENT_INVALID_PACKET_RECEIVED  (uint32_t)(1 << 1)
+#define RADIO_EVENT_BROADCAST_SLOT           (uint32_t)(1 << 2)
 
 #define CONCENTRATORRADIO_MAX_RETRIES 2
 #define CONCENTRATORRADIO_FRAMEPENDING_DELAY_TIME_MS (5)
 
+/* Node messages that can be queued, enough for a full OAD multi block window.
+ * Must divide 256, the queue indexes run freely over a uint8_t. */
+#define CONCENTRATORRADIO_TX_QUEUE_SIZE  8
+/* TX packets in the message pool, the queued node messages, a broadcast and
+ * one being built */
+#define CONCENTRATORRADIO_MSG_POOL_SIZE  (CONCENTRATORRADIO_TX_QUEUE_SIZE + 2)
+/* Abort requests the radio task has not processed yet */
+#define CONCENTRATORRADIO_ABORT_QUEUE_SIZE  4
+/* Gap between back-to-back frames so the node can re-enter RX, in us */
+#define CONCENTRATORRADIO_FRAME_GAP_US   500
+/* Time the radio task leaves RX before a broadcast slot to set up the
+ * transmission, in us. A slot closer than this is skipped. */
+#define CONCENTRATORRADIO_BROADCAST_LEAD_US  2000
+
 
 #define CONCENTRATOR_ACTIVITY_LED Board_PIN_LED0
 
@@ -84,8 +103,30 @@ static Event_Handle radioOperationEventHandle;
 
 static ConcentratorRadio_PacketReceivedCallback packetReceivedCallback;
 static union ConcentratorPacket latestRxPacket;
-static EasyLink_TxPacket txRequest;
-static bool txRequestPending;
+/* Messages are built in place in TX packets of the pool and sent without a
+ * copy. Both the concentrator task and the radio task, from the OAD
+ * callbacks, take packets and queue them, so taking a packet, queueing and
+ * requesting an abort are done with the task scheduler disabled. A packet is
+ * returned by the radio task once sent, or by its owner before it is queued. */
+static EasyLink_TxPacket msgPool[CONCENTRATORRADIO_MSG_POOL_SIZE];
+static volatile bool msgPoolInUse[CONCENTRATORRADIO_MSG_POOL_SIZE];
+static EasyLink_TxPacket *txRequest[CONCENTRATORRADIO_TX_QUEUE_SIZE];
+static volatile uint8_t txRequestHead;      /* advanced by the radio task only */
+static volatile uint8_t txRequestTail;      /* advanced by the sending task only */
+/* Messages for the node that is listening are taken from anywhere in the
+ * queue, the radio task clears their slot and the head skips cleared slots.
+ * Aborts are requests to the radio task for the same reason. */
+static volatile uint8_t abortRequestAddr[CONCENTRATORRADIO_ABORT_QUEUE_SIZE];
+static volatile uint8_t abortRequestTail[CONCENTRATORRADIO_ABORT_QUEUE_SIZE];
+static volatile uint8_t abortRequestHead;   /* advanced by the radio task only */
+static volatile uint8_t abortRequestNext;   /* advanced by the sending task only */
+static EasyLink_TxPacket * volatile txBroadcast;
+/* Start of the next broadcast slot on the radio timer, the slots are kept
+ * on this grid so that the nodes following a broadcast can find them */
+static uint32_t broadcastSlotTime;
+static volatile bool rxAborted;
+Clock_Struct broadcastClock;       /* not static so you can see in ROV */
+static Clock_Handle broadcastClockHandle;
 static uint8_t concentratorAddress;
 static int8_t latestRssi;
 
@@ -95,6 +136,14 @@ static void concentratorRadioTaskFunction(UArg arg0, UArg arg1);
 static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status);
 static void notifyPacketReceived(union ConcentratorPacket* latestRxPacket);
 static void sendAck(uint8_t latestSourceAddress);
+static void sendPendingNodeMsgs(uint8_t latestSourceAddress);
+static void sendBroadcast(void);
+static void broadcastClockCallback(UArg arg0);
+static EasyLink_TxPacket* findNodeMsg(uint8_t address, uint8_t *pIdx);
+static bool moreNodeMsgs(uint8_t address, uint8_t idx);
+static void removeNodeMsg(uint8_t idx);
+static void processAbortRequests(void);
+static void setMsgHeader(EasyLink_TxPacket *pMsg, uint8_t msgLen);
 
 /* Pin driver handle */
 static PIN_Handle ledPinHandle;
@@ -125,6 +174,14 @@ void ConcentratorRadioTask_init(void) {
     Event_construct(&radioOperationEvent, &eventParam);
     radioOperationEventHandle = Event_handle(&radioOperationEvent);
 
+    /* Create clock object which wakes the radio task before a broadcast slot */
+    Clock_Params clkParams;
+    Clock_Params_init(&clkParams);
+    clkParams.period = 0;
+    clkParams.startFlag = FALSE;
+    Clock_construct(&broadcastClock, broadcastClockCallback, 1, &clkParams);
+    broadcastClockHandle = Clock_handle(&broadcastClock);
+
     /* Create the concentrator radio protocol task */
     Task_Params_init(&concentratorRadioTaskParams);
     concentratorRadioTaskParams.stackSize = CONCENTRATORRADIO_TASK_STACK_SIZE;
@@ -137,22 +194,156 @@ void ConcentratorRadioTask_registerPacketReceivedCallback(ConcentratorRadio_Pack
     packetReceivedCallback = callback;
 }
 
+EasyLink_TxPacket* ConcentratorRadioTask_allocMsg(void)
+{
+    EasyLink_TxPacket *pMsg = NULL;
+    UInt key;
+    uint8_t idx;
+
+    key = Task_disable();
+    for (idx = 0; idx < CONCENTRATORRADIO_MSG_POOL_SIZE; idx++)
+    {
+        if (!msgPoolInUse[idx])
+        {
+            msgPoolInUse[idx] = true;
+            pMsg = &msgPool[idx];
+            break;
+        }
+    }
+    Task_restore(key);
+
+    return pMsg;
+}
+
+void ConcentratorRadioTask_freeMsg(EasyLink_TxPacket *pMsg)
+{
+    msgPoolInUse[pMsg - msgPool] = false;
+}
+
+bool ConcentratorRadioTask_queueNodeMsg(uint8_t *pAddress, EasyLink_TxPacket *pMsg, uint8_t msgLen)
+{
+    UInt key;
+
+    pMsg->absTime = 0;
+    pMsg->dstAddr[0] = *pAddress;
+    setMsgHeader(pMsg, msgLen);
+
+    key = Task_disable();
+    if( ((uint8_t)(txRequestTail - txRequestHead) >= CONCENTRATORRADIO_TX_QUEUE_SIZE) ||
+        (msgLen >= (EASYLINK_MAX_DATA_LENGTH -1)) || (msgLen < RADIO_PACKET_PAYLOAD_OFFSET) )
+    {
+        Task_restore(key);
+        ConcentratorRadioTask_freeMsg(pMsg);
+        return false;
+    }
+
+    /* Hand the message over to the radio task */
+    txRequest[txRequestTail % CONCENTRATORRADIO_TX_QUEUE_SIZE] = pMsg;
+    txRequestTail++;
+    Task_restore(key);
+
+    return true;
+}
+
 void ConcentratorRadioTask_sendNodeMsg(uint8_t *pAddress, uint8_t *msg, uint8_t msgLen)
 {
-    if( (!txRequestPending) && msgLen < (EASYLINK_MAX_DATA_LENGTH -1) )
+    EasyLink_TxPacket *pMsg;
+
+    if (msgLen < (EASYLINK_MAX_DATA_LENGTH -1))
+    {
+        pMsg = ConcentratorRadioTask_allocMsg();
+        if (pMsg != NULL)
+        {
+            memcpy(pMsg->payload, msg, msgLen);
+            ConcentratorRadioTask_queueNodeMsg(pAddress, pMsg, msgLen);
+        }
+    }
+}
+
+bool ConcentratorRadioTask_abortNodeMsg(void)
+{
+    return ConcentratorRadioTask_abortNodeMsgFor(RADIO_BROADCAST_ADDRESS);
+}
+
+bool ConcentratorRadioTask_abortNodeMsgFor(uint8_t address)
+{
+    UInt key;
+    uint8_t slot;
+
+    key = Task_disable();
+    if ((uint8_t)(abortRequestNext - abortRequestHead) >= CONCENTRATORRADIO_ABORT_QUEUE_SIZE)
+    {
+        Task_restore(key);
+        return false;
+    }
+
+    /* The radio task returns the messages queued so far to the pool */
+    slot = abortRequestNext % CONCENTRATORRADIO_ABORT_QUEUE_SIZE;
+    abortRequestAddr[slot] = address;
+    abortRequestTail[slot] = txRequestTail;
+    abortRequestNext++;
+    Task_restore(key);
+
+    return true;
+}
+
+bool ConcentratorRadioTask_queueBroadcastMsg(EasyLink_TxPacket *pMsg, uint8_t msgLen)
+{
+    UInt key;
+
+    pMsg->absTime = 0;
+    pMsg->dstAddr[0] = RADIO_BROADCAST_ADDRESS;
+    setMsgHeader(pMsg, msgLen);
+
+    key = Task_disable();
+    if( (txBroadcast != NULL) || (msgLen >= (EASYLINK_MAX_DATA_LENGTH -1)) ||
+        (msgLen < RADIO_PACKET_PAYLOAD_OFFSET) )
+    {
+        Task_restore(key);
+        ConcentratorRadioTask_freeMsg(pMsg);
+        return false;
+    }
+    txBroadcast = pMsg;
+    Task_restore(key);
+
+    /* The radio task sends it in the next broadcast slot */
+    Event_post(radioOperationEventHandle, RADIO_EVENT_BROADCAST_SLOT);
+
+    return true;
+}
+
+bool ConcentratorRadioTask_broadcastPending(void)
+{
+    return (txBroadcast != NULL);
+}
+
+bool ConcentratorRadioTask_sendBroadcastMsg(uint8_t *msg, uint8_t msgLen)
+{
+    EasyLink_TxPacket *pMsg;
+
+    if( (txBroadcast != NULL) || (msgLen >= (EASYLINK_MAX_DATA_LENGTH -1)) )
+    {
+        return false;
+    }
+
+    pMsg = ConcentratorRadioTask_allocMsg();
+    if (pMsg == NULL)
     {
-        memcpy(txRequest.payload, msg, msgLen);
-        txRequest.absTime = 0;
-		txRequest.dstAddr[0] = *pAddress;
-        txRequest.payload[RADIO_PACKET_SRCADDR_OFFSET] = concentratorAddress;
-        txRequest.len = msgLen;
-        txRequestPending = true;
+        return false;
     }
+
+    memcpy(pMsg->payload, msg, msgLen);
+
+    return ConcentratorRadioTask_queueBroadcastMsg(pMsg, msgLen);
 }
 
-void ConcentratorRadioTask_abortNodeMsg(void)
+static void setMsgHeader(EasyLink_TxPacket *pMsg, uint8_t msgLen)
 {
-    txRequestPending = false;
+    /* The builder has set the packet type, FRAME_PENDING is set when sent */
+    pMsg->payload[RADIO_PACKET_SRCADDR_OFFSET] = concentratorAddress;
+    pMsg->payload[RADIO_PACKET_OPTIONS_OFFSET] = 0;
+    pMsg->payload[RADIO_PACKET_LENGTH_OFFSET] = msgLen - RADIO_PACKET_PAYLOAD_OFFSET;
+    pMsg->len = msgLen;
 }
 
 static void concentratorRadioTaskFunction(UArg arg0, UArg arg1)
@@ -197,17 +388,11 @@ static void concentratorRadioTaskFunction(UArg arg0, UArg arg1)
         if (events & RADIO_EVENT_VALID_PACKET_RECEIVED)
         {
 
-            /* Send ack packet */
+            /* Send ack packet, this also carries the first pending node message if it fits */
             sendAck(latestRxPacket.header.sourceAddress);
 
-            if(txRequestPending)
-            {
-                if (EasyLink_transmit(&txRequest) != EasyLink_Status_Success)
-                {
-                    System_abort("EasyLink_transmit failed");
-                }
-                txRequestPending = false;
-            }
+            /* Send the remaining node messages back-to-back */
+            sendPendingNodeMsgs(latestRxPacket.header.sourceAddress);
 
             /* Call packet received callback */
             notifyPacketReceived(&latestRxPacket);
@@ -231,24 +416,59 @@ static void concentratorRadioTaskFunction(UArg arg0, UArg arg1)
                 System_abort("EasyLink_receiveAsync failed");
             }
         }
+
+        /* If a broadcast waits for its slot */
+        if (events & RADIO_EVENT_BROADCAST_SLOT)
+        {
+            sendBroadcast();
+        }
     }
 }
 
 static void sendAck(uint8_t latestSourceAddress)
 {
     EasyLink_TxPacket txAck;
+    EasyLink_TxPacket *pMsg;
+    uint8_t idx;
+    uint8_t downlinkLength;
 
     /* Set destinationAdress, but use EasyLink layers destination address capability */
     txAck.dstAddr[0] = latestSourceAddress;
 
     /* Copy ACK packet to payload, skipping the destination address byte.
      * Note that the EasyLink API will implicitly both add the length byte and the destination address byte. */
-    //set source address
-    txAck.payload[0] = concentratorAddress;
-    txAck.payload[1] = RADIO_PACKET_TYPE_ACK_PACKET;
-    txAck.payload[2] = txRequestPending;
-    txAck.len = 3;
-    
+    txAck.payload[RADIO_PACKET_SRCADDR_OFFSET] = concentratorAddress;
+    txAck.payload[RADIO_PACKET_PKTTYPE_OFFSET] = RADIO_PACKET_TYPE_ACK_PACKET;
+    txAck.payload[RADIO_PACKET_OPTIONS_OFFSET] = RADIO_PACKET_OPTIONS_RSSI;
+    txAck.payload[RADIO_PACKET_LENGTH_OFFSET] = 1;
+    txAck.payload[RADIO_PACKET_PAYLOAD_OFFSET] = (uint8_t)latestRssi;
+    txAck.len = RADIO_PACKET_PAYLOAD_OFFSET + 1;
+
+    pMsg = findNodeMsg(latestSourceAddress, &idx);
+    if (pMsg != NULL)
+    {
+#ifdef RADIO_ACK_EMBED_DOWNLINK
+        downlinkLength = pMsg->payload[RADIO_PACKET_LENGTH_OFFSET];
+        if ((pMsg->payload[RADIO_PACKET_PKTTYPE_OFFSET] == RADIO_PACKET_TYPE_OAD_PACKET) &&
+            (downlinkLength < RADIO_ACK_DOWNLINK_MAX_LENGTH))
+        {
+            /* Piggy-back the OAD message on the ACK as a downlink, saving a TX setup and preamble */
+            txAck.payload[txAck.len++] = RADIO_DOWNLINK_TYPE_OAD;
+            memcpy(&txAck.payload[txAck.len], &pMsg->payload[RADIO_PACKET_PAYLOAD_OFFSET], downlinkLength);
+            txAck.len += downlinkLength;
+            txAck.payload[RADIO_PACKET_LENGTH_OFFSET] = txAck.len - RADIO_PACKET_PAYLOAD_OFFSET;
+
+            removeNodeMsg(idx);
+            pMsg = findNodeMsg(latestSourceAddress, &idx);
+        }
+#endif
+        if (pMsg != NULL)
+        {
+            txAck.payload[RADIO_PACKET_OPTIONS_OFFSET] |= RADIO_PACKET_OPTIONS_FRAME_PENDING;
+        }
+    }
+
+
     /* Transmit immediately */
     txAck.absTime = 0;
 
@@ -259,6 +479,188 @@ static void sendAck(uint8_t latestSourceAddress)
     }
 }
 
+static void sendPendingNodeMsgs(uint8_t latestSourceAddress)
+{
+    EasyLink_TxPacket *pMsg;
+    uint32_t absTime;
+    uint8_t idx;
+
+    /* Only send to the node that is listening after our ACK, messages
+     * queued for other nodes do not hold it back */
+    while ((pMsg = findNodeMsg(latestSourceAddress, &idx)) != NULL)
+    {
+        /* Keep the node in RX while more frames follow */
+        if (moreNodeMsgs(latestSourceAddress, idx))
+        {
+            pMsg->payload[RADIO_PACKET_OPTIONS_OFFSET] |= RADIO_PACKET_OPTIONS_FRAME_PENDING;
+        }
+
+        if (EasyLink_getAbsTime(&absTime) != EasyLink_Status_Success)
+        {
+            pMsg->absTime = 0;
+        }
+        else
+        {
+            pMsg->absTime = absTime + EasyLink_us_To_RadioTime(CONCENTRATORRADIO_FRAME_GAP_US);
+        }
+
+        /* The pool packet is the TX packet, no copy is made */
+        if (EasyLink_transmit(pMsg) != EasyLink_Status_Success)
+        {
+            System_abort("EasyLink_transmit failed");
+        }
+
+        removeNodeMsg(idx);
+    }
+}
+
+static EasyLink_TxPacket* findNodeMsg(uint8_t address, uint8_t *pIdx)
+{
+    uint8_t tail = txRequestTail;
+    uint8_t idx;
+    EasyLink_TxPacket *pMsg;
+
+    /* Return aborted messages to the pool first */
+    processAbortRequests();
+
+    /* First queued message for the node */
+    for (idx = txRequestHead; idx != tail; idx++)
+    {
+        pMsg = txRequest[idx % CONCENTRATORRADIO_TX_QUEUE_SIZE];
+        if ((pMsg != NULL) && (pMsg->dstAddr[0] == address))
+        {
+            *pIdx = idx;
+            return pMsg;
+        }
+    }
+
+    return NULL;
+}
+
+static bool moreNodeMsgs(uint8_t address, uint8_t idx)
+{
+    uint8_t tail = txRequestTail;
+    EasyLink_TxPacket *pMsg;
+
+    /* Any message for the node queued after the one at idx */
+    for (idx++; idx != tail; idx++)
+    {
+        pMsg = txRequest[idx % CONCENTRATORRADIO_TX_QUEUE_SIZE];
+        if ((pMsg != NULL) && (pMsg->dstAddr[0] == address))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void removeNodeMsg(uint8_t idx)
+{
+    ConcentratorRadioTask_freeMsg(txRequest[idx % CONCENTRATORRADIO_TX_QUEUE_SIZE]);
+    txRequest[idx % CONCENTRATORRADIO_TX_QUEUE_SIZE] = NULL;
+
+    /* Free the slots up to the next message still queued */
+    while ((txRequestHead != txRequestTail) &&
+           (txRequest[txRequestHead % CONCENTRATORRADIO_TX_QUEUE_SIZE] == NULL))
+    {
+        txRequestHead++;
+    }
+}
+
+static void processAbortRequests(void)
+{
+    uint8_t slot;
+    uint8_t tail;
+    uint8_t idx;
+    EasyLink_TxPacket *pMsg;
+
+    while (abortRequestHead != abortRequestNext)
+    {
+        slot = abortRequestHead % CONCENTRATORRADIO_ABORT_QUEUE_SIZE;
+        tail = abortRequestTail[slot];
+
+        /* Nothing to do if the messages were all sent since */
+        if ((uint8_t)(tail - txRequestHead) <= CONCENTRATORRADIO_TX_QUEUE_SIZE)
+        {
+            for (idx = txRequestHead; idx != tail; idx++)
+            {
+                pMsg = txRequest[idx % CONCENTRATORRADIO_TX_QUEUE_SIZE];
+                if ((pMsg != NULL) &&
+                    ((abortRequestAddr[slot] == RADIO_BROADCAST_ADDRESS) ||
+                     (pMsg->dstAddr[0] == abortRequestAddr[slot])))
+                {
+                    removeNodeMsg(idx);
+                }
+            }
+        }
+
+        abortRequestHead++;
+    }
+}
+
+/*
+ * Send the waiting broadcast at the start of the next broadcast slot, or
+ * wake up before that slot. The radio leaves RX for the transmission, a
+ * packet that ends before it is still handled by the packet events.
+ */
+static void sendBroadcast(void)
+{
+    EasyLink_TxPacket *pMsg = txBroadcast;
+    uint32_t slotTime = EasyLink_ms_To_RadioTime(RADIO_BROADCAST_SLOT_MS);
+    uint32_t leadTime = EasyLink_us_To_RadioTime(CONCENTRATORRADIO_BROADCAST_LEAD_US);
+    uint32_t absTime;
+    uint32_t untilSlot;
+
+    if ((pMsg == NULL) || (EasyLink_getAbsTime(&absTime) != EasyLink_Status_Success))
+    {
+        return;
+    }
+
+    /* Next slot on the grid that leaves the time to set up the transmission */
+    if ((uint32_t)(broadcastSlotTime - absTime - leadTime) >= slotTime)
+    {
+        broadcastSlotTime += ((uint32_t)(absTime + leadTime - broadcastSlotTime) / slotTime + 1) * slotTime;
+    }
+
+    untilSlot = broadcastSlotTime - absTime;
+    if (untilSlot > 2 * leadTime)
+    {
+        Clock_stop(broadcastClockHandle);
+        Clock_setTimeout(broadcastClockHandle,
+                         (untilSlot - 2 * leadTime) / EasyLink_us_To_RadioTime(Clock_tickPeriod) + 1);
+        Clock_start(broadcastClockHandle);
+        return;
+    }
+
+    rxAborted = false;
+    EasyLink_abort();
+
+    pMsg->absTime = broadcastSlotTime;
+    if (EasyLink_transmit(pMsg) != EasyLink_Status_Success)
+    {
+        System_abort("EasyLink_transmit failed");
+    }
+
+    txBroadcast = NULL;
+    ConcentratorRadioTask_freeMsg(pMsg);
+    broadcastSlotTime += slotTime;
+
+    /* Back to the RX that was aborted */
+    if (rxAborted)
+    {
+        if (EasyLink_receiveAsync(rxDoneCallback, 0) != EasyLink_Status_Success)
+        {
+            System_abort("EasyLink_receiveAsync failed");
+        }
+    }
+}
+
+static void broadcastClockCallback(UArg arg0)
+{
+    Event_post(radioOperationEventHandle, RADIO_EVENT_BROADCAST_SLOT);
+}
+
 static void notifyPacketReceived(union ConcentratorPacket* latestRxPacket)
 {
     if (packetReceivedCallback)
@@ -280,43 +682,26 @@ static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status)
         /* Check that this is a valid packet */
         tmpRxPacket = (union ConcentratorPacket*)(rxPacket->payload);
 
-        /* If this is a known packet */
-        if (tmpRxPacket->header.packetType == RADIO_PACKET_TYPE_ADC_SENSOR_PACKET)
-        {
-            /* Save packet */
-            latestRxPacket.header.sourceAddress = rxPacket->payload[0];
-            latestRxPacket.header.packetType = rxPacket->payload[1];
-            latestRxPacket.adcSensorPacket.adcValue = (rxPacket->payload[2] << 8) | rxPacket->payload[3];
-
-            /* Signal packet received */
-            Event_post(radioOperationEventHandle, RADIO_EVENT_VALID_PACKET_RECEIVED);
-        }
-        else if (tmpRxPacket->header.packetType == RADIO_PACKET_TYPE_DM_SENSOR_PACKET)
+        /* If this is a known packet of the length in its header. The
+         * application CRC of raw data is not checked, the radio CRC covers
+         * the frame. */
+        if (((tmpRxPacket->header.packetType == RADIO_PACKET_TYPE_RAW_DATA_PACKET) ||
+             (tmpRxPacket->header.packetType == RADIO_PACKET_TYPE_TEST_RESET) ||
+             (tmpRxPacket->header.packetType == RADIO_PACKET_TYPE_OAD_PACKET)) &&
+            (rxPacket->len >= sizeof(struct PacketHeader) + tmpRxPacket->header.length) &&
+            (rxPacket->len <= sizeof(latestRxPacket)))
         {
             /* Save packet */
-            latestRxPacket.header.sourceAddress = rxPacket->payload[0];
-            latestRxPacket.header.packetType = rxPacket->payload[1];
-            latestRxPacket.dmSensorPacket.adcValue = (rxPacket->payload[2] << 8) | rxPacket->payload[3];
-            latestRxPacket.dmSensorPacket.batt = (rxPacket->payload[4] << 8) | rxPacket->payload[5];
-            latestRxPacket.dmSensorPacket.time100MiliSec = (rxPacket->payload[6] << 24) |
-                                                           (rxPacket->payload[7] << 16) |
-                                                           (rxPacket->payload[8] << 8) |
-                                                            rxPacket->payload[9];
-            latestRxPacket.dmSensorPacket.button = rxPacket->payload[10];
+            memcpy(&latestRxPacket, rxPacket->payload, rxPacket->len);
 
             /* Signal packet received */
             Event_post(radioOperationEventHandle, RADIO_EVENT_VALID_PACKET_RECEIVED);
         }
-        else if (tmpRxPacket->header.packetType == RADIO_PACKET_TYPE_OAD_PACKET)
+        else if ((tmpRxPacket->header.packetType == RADIO_PACKET_TYPE_ENERGY_REPORT) &&
+                 (rxPacket->len == sizeof(struct EnergyReportPacket)))
         {
             /* Save packet */
-            latestRxPacket.header.sourceAddress = rxPacket->payload[0];
-            latestRxPacket.header.packetType = rxPacket->payload[1];
-#if defined(Board_CC1312R1_LAUNCHXL) || defined(Board_CC1352R1_LAUNCHXL)
-            memcpy(&latestRxPacket.oadPacket.oadPayload, &rxPacket->payload[2], (OADStorage_BLOCK_SIZE + 2));
-#else 
-			memcpy(&latestRxPacket.oadPacket.oadPayload, &rxPacket->payload[2], (OAD_BLOCK_SIZE + 2 + 2));
-#endif
+            memcpy(&latestRxPacket.energyReportPacket, rxPacket->payload, sizeof(struct EnergyReportPacket));
 
             /* Signal packet received */
             Event_post(radioOperationEventHandle, RADIO_EVENT_VALID_PACKET_RECEIVED);
@@ -327,6 +712,11 @@ static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status)
             Event_post(radioOperationEventHandle, RADIO_EVENT_INVALID_PACKET_RECEIVED);
         }
     }
+    /* Left for a broadcast, the radio task goes back to RX itself */
+    else if (status == EasyLink_Status_Aborted)
+    {
+        rxAborted = true;
+    }
     else
     {
         /* Signal invalid packet received */
@@ -34,6 +34,7 @@
 #define TASKS_CONCENTRATORRADIOTASKTASK_H_
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "RadioProtocol.h"
 
 
@@ -45,8 +46,8 @@ enum ConcentratorRadioOperationStatus {
 
 union ConcentratorPacket {
     struct PacketHeader header;
-    struct AdcSensorPacket adcSensorPacket;
-    struct DualModeSensorPacket dmSensorPacket;
+    struct RawDataPacket rawDataPacket;
+    struct EnergyReportPacket energyReportPacket;
     struct OadPacket oadPacket;
 };
 
@@ -58,10 +59,38 @@ void ConcentratorRadioTask_init(void);
 /* Register the packet received callback */
 void ConcentratorRadioTask_registerPacketReceivedCallback(ConcentratorRadio_PacketReceivedCallback callback);
 
-/* Send OAD Packet */
+/* Take a TX packet from the message pool, returns NULL if none is free. The message
+ * is built in its payload, the packet type at RADIO_PACKET_PKTTYPE_OFFSET and the
+ * message from RADIO_PACKET_PAYLOAD_OFFSET on, and queued without a copy. The rest
+ * of the header is filled in when queued. Any task may take packets, they are
+ * claimed with the scheduler disabled. */
+EasyLink_TxPacket* ConcentratorRadioTask_allocMsg(void);
+
+/* Return a TX packet that is not going to be queued to the message pool */
+void ConcentratorRadioTask_freeMsg(EasyLink_TxPacket *pMsg);
+
+/* Queue a pool TX packet for a node, it returns to the pool once sent or if it cannot be queued.
+ * msgLen includes the header. */
+bool ConcentratorRadioTask_queueNodeMsg(uint8_t *pAddress, EasyLink_TxPacket *pMsg, uint8_t msgLen);
+
+/* Queue a message for a node, sent with the ACK of the next packet from that node */
 void ConcentratorRadioTask_sendNodeMsg(uint8_t *pAddress, uint8_t *oadMsg, uint8_t msgLen);
 
-/* Abort Node Message from pending message */
-void ConcentratorRadioTask_abortNodeMsg(void);
+/* Abort Node Message from pending message, returns false if too many aborts are pending */
+bool ConcentratorRadioTask_abortNodeMsg(void);
+
+/* Return the messages queued so far for a node to the pool, RADIO_BROADCAST_ADDRESS for all nodes.
+ * Returns false if too many aborts are pending, the messages are then still sent. */
+bool ConcentratorRadioTask_abortNodeMsgFor(uint8_t address);
+
+/* Broadcast a pool TX packet to RADIO_BROADCAST_ADDRESS at the start of the next broadcast slot.
+ * It returns to the pool once sent or if one is still pending */
+bool ConcentratorRadioTask_queueBroadcastMsg(EasyLink_TxPacket *pMsg, uint8_t msgLen);
+
+/* Broadcast a message in the next broadcast slot, returns false if one is still pending */
+bool ConcentratorRadioTask_sendBroadcastMsg(uint8_t *msg, uint8_t msgLen);
+
+/* Check if a broadcast waits for its slot */
+bool ConcentratorRadioTask_broadcastPending(void);
 
 #endif /* TASKS_CONCENTRATORRADIOTASKTASK_H_ */
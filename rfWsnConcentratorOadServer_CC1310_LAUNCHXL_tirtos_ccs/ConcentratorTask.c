@@ -68,6 +68,10 @@
 #include "oad/native_oad/ext_flash_layout.h"
 #endif
 
+#ifdef EXT_FLASH_BENCHMARK
+#include <extflash/ExtFlash.h>
+#endif
+
 /* Application Header files */ 
 #include "ConcentratorRadioTask.h"
 #include "ConcentratorTask.h"
@@ -81,6 +85,11 @@
 #define CONCENTRATOR_EVENT_ACTION                 (uint32_t)(1 << 1)
 #define CONCENTRATOR_EVENT_UPDATE_DISPLAY         (uint32_t)(1 << 2)
 #define CONCENTRATOR_EVENT_OAD_MSG                (uint32_t)(1 << 3)
+#define CONCENTRATOR_EVENT_OAD_PACKET             (uint32_t)(1 << 4)
+
+/* OAD packets waiting to be parsed, a FW version response is the longest a node sends */
+#define CONCENTRATOR_OAD_QUEUE_SIZE               8
+#define CONCENTRATOR_OAD_PAYLOAD_LENGTH           (OADProtocol_PACKET_TYPE_FW_VERSION_RSP_LEN)
 
 #define CONCENTRATOR_MAX_NODES 7
 
@@ -90,12 +99,15 @@
 struct AdcSensorNode
 {
     uint8_t address;
-    uint16_t latestAdcValue;
-    uint8_t button;
+    uint16_t packets;           /* data and energy report packets received */
+    uint8_t latestLength;       /* payload length of the latest one */
     int8_t latestRssi;
     char fwVersion[OADProtocol_FW_VERSION_STR_LEN];
     uint16_t oadBlock;
     uint16_t oadTotalBlocks;
+    ConcentratorTask_NodeOadStatus_t oadStatus;
+    uint8_t oadBroadcastStatus;
+    uint16_t oadBroadcastBlocks;
 };
 
 /// \brief UI actions
@@ -105,6 +117,7 @@ typedef enum
     Concentrator_Actions_UpdateAvailableFw = 0,
     Concentrator_Actions_FwVerReq,
     Concentrator_Actions_UpdateNodeFw,
+    Concentrator_Actions_BroadcastNodeFw,
     Concentrator_Actions_End
 } Concentrator_Actions_t;
 
@@ -113,6 +126,7 @@ static char* selectedActionStr[] =
     "Update available FW",
     "Send FW Ver Req",
     "Update node FW",
+    "Broadcast node FW",
 };
 
 Concentrator_Actions_t selectedAction = Concentrator_Actions_Start;
@@ -121,6 +135,7 @@ char availableFwVersion[OADProtocol_FW_VERSION_STR_LEN] = "unknown";
 
 static bool availableFwUpdateInProgress = false;
 static ConcentratorTask_NodeOadStatus_t nodeFwOadStatus = ConcentratorTask_NodeOadStatus_None;
+static uint16_t broadcastTotalBlocks = 0;
 
 /*
  * Application button pin configuration table:
@@ -147,9 +162,20 @@ static Display_Handle hDisplaySerial;
 static PIN_Handle buttonPinHandle;
 static PIN_State buttonPinState;
 
+/* OAD packets received, written by the radio task and parsed by the concentrator task */
+static struct
+{
+    uint8_t sourceAddress;
+    uint8_t payload[CONCENTRATOR_OAD_PAYLOAD_LENGTH];
+} oadRxQueue[CONCENTRATOR_OAD_QUEUE_SIZE];
+static volatile uint8_t oadRxQueueHead = 0;
+static volatile uint8_t oadRxQueueTail = 0;
+
 /***** Prototypes *****/
 static void concentratorTaskFunction(UArg arg0, UArg arg1);
 static void packetReceivedCallback(union ConcentratorPacket* packet, int8_t rssi);
+static void queueOadPacket(struct OadPacket* packet);
+static void parseOadPackets(void);
 static void updateLcd(void);
 static void addNewNode(struct AdcSensorNode* node);
 static void updateNode(struct AdcSensorNode* node);
@@ -226,12 +252,18 @@ void ConcentratorTask_updateAvailableFWVer(bool success)
         OADStorage_close();
 #else 
         OADTarget_ImgHdr_t remoteAppImageHdr;
+        OADTarget_ImgHdr_t deltaImageHdr;
+        OADTarget_ImgHdr_t compressedImageHdr;
 
         /* get Available FW version*/
         OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_REMOTE_APP, &remoteAppImageHdr);
+        OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_DELTA, &deltaImageHdr);
+        OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_COMPRESSED, &compressedImageHdr);
         if ((remoteAppImageHdr.ver != 0xFFFF) || (remoteAppImageHdr.ver == 0))
         {
-            System_sprintf((xdc_Char*)availableFwVersion,"rfWsnNode v%02d.%02d.00", ((remoteAppImageHdr.ver & 0xFF00)>>8), (remoteAppImageHdr.ver & 0xFF));
+            System_sprintf((xdc_Char*)availableFwVersion,"rfWsnNode v%02d.%02d.00%s%s", ((remoteAppImageHdr.ver & 0xFF00)>>8), (remoteAppImageHdr.ver & 0xFF),
+                           (deltaImageHdr.ver == remoteAppImageHdr.ver) ? " +delta" : "",
+                           (compressedImageHdr.ver == remoteAppImageHdr.ver) ? " +lz" : "");
         }
 #endif 
     }
@@ -247,9 +279,21 @@ void ConcentratorTask_updateAvailableFWVer(bool success)
     Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_UPDATE_DISPLAY);
 }
 
-void ConcentratorTask_updateNodeOadStatus(ConcentratorTask_NodeOadStatus_t status)
+void ConcentratorTask_updateNodeOadStatus(uint8_t addr, ConcentratorTask_NodeOadStatus_t status)
 {
     static ConcentratorTask_NodeOadStatus_t prevStatus = ConcentratorTask_NodeOadStatus_None;
+    uint8_t nodeIdx = getNodeIdx(addr);
+
+    if (nodeIdx < CONCENTRATOR_MAX_NODES)
+    {
+        knownSensorNodes[nodeIdx].oadStatus = status;
+    }
+
+    /* the ext flash keeps the SPI until the last node is updated */
+    if (OADServer_getNumSessions() != 0)
+    {
+        status = ConcentratorTask_NodeOadStatus_InProgress;
+    }
 
     if( (status == ConcentratorTask_NodeOadStatus_InProgress) &&
         (prevStatus != ConcentratorTask_NodeOadStatus_InProgress) )
@@ -281,12 +325,45 @@ void ConcentratorTask_updateNodeOadBlock(uint8_t addr, uint16_t block)
         /* Save the values */
         knownSensorNodes[nodeIdx].oadBlock = block;
         Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_UPDATE_DISPLAY);
+    }
+}
+
+void ConcentratorTask_updateNodeOadTotalBlocks(uint8_t addr, uint16_t totalBlocks)
+{
+    uint8_t nodeIdx = getNodeIdx(addr);
+
+    if (nodeIdx < CONCENTRATOR_MAX_NODES)
+    {
+        /* Save the values */
+        knownSensorNodes[nodeIdx].oadTotalBlocks = totalBlocks;
+        Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_UPDATE_DISPLAY);
+    }
+}
 
-        if(knownSensorNodes[nodeIdx].oadBlock == knownSensorNodes[nodeIdx].oadTotalBlocks - 1)
+void ConcentratorTask_updateNodeOadBroadcast(uint8_t addr, uint8_t status, uint16_t decodedBlocks)
+{
+    uint8_t nodeIdx = getNodeIdx(addr);
+    uint8_t i;
+
+    if (nodeIdx < CONCENTRATOR_MAX_NODES)
+    {
+        /* Save the values */
+        knownSensorNodes[nodeIdx].oadBroadcastStatus = status;
+        knownSensorNodes[nodeIdx].oadBroadcastBlocks = decodedBlocks;
+        Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_UPDATE_DISPLAY);
+
+        /* stop broadcasting once every known node has finished */
+        for (i = 0; i < CONCENTRATOR_MAX_NODES; i++)
         {
-            /* Re-enable LCD */
-            Display_control(hDisplayLcd, DISPLAY_CMD_TRANSPORT_OPEN, NULL);
+            if ((knownSensorNodes[i].address != 0) &&
+                (knownSensorNodes[i].oadBroadcastStatus != OADProtocol_FOUNTAIN_STATUS_COMPLETE) &&
+                (knownSensorNodes[i].oadBroadcastStatus != OADProtocol_FOUNTAIN_STATUS_FAILED))
+            {
+                return;
+            }
         }
+
+        OADServer_stopBroadcastNodeFw();
     }
 }
 
@@ -311,12 +388,18 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
     OADStorage_close();
 #else 
         OADTarget_ImgHdr_t remoteAppImageHdr;
+    OADTarget_ImgHdr_t deltaImageHdr;
+    OADTarget_ImgHdr_t compressedImageHdr;
 
     /* get Available FW version*/
     OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_REMOTE_APP, &remoteAppImageHdr);
+    OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_DELTA, &deltaImageHdr);
+    OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_COMPRESSED, &compressedImageHdr);
     if ((remoteAppImageHdr.ver != 0xFFFF) || (remoteAppImageHdr.ver == 0))
     {
-        System_sprintf((xdc_Char*)availableFwVersion,"rfWsnNode v%02d.%02d.00", ((remoteAppImageHdr.ver & 0xFF00)>>8), (remoteAppImageHdr.ver & 0xFF));
+        System_sprintf((xdc_Char*)availableFwVersion,"rfWsnNode v%02d.%02d.00%s%s", ((remoteAppImageHdr.ver & 0xFF00)>>8), (remoteAppImageHdr.ver & 0xFF),
+                       (deltaImageHdr.ver == remoteAppImageHdr.ver) ? " +delta" : "",
+                       (compressedImageHdr.ver == remoteAppImageHdr.ver) ? " +lz" : "");
     }
 #endif
 
@@ -337,6 +420,24 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
     hDisplayLcd = Display_open(Display_Type_LCD, &params);
     hDisplaySerial = Display_open(Display_Type_UART, &params);
 
+#ifdef EXT_FLASH_BENCHMARK
+    {
+        ExtFlashBenchmark_t benchmark;
+
+        /* Report external flash throughput, the scratch region is erased */
+        if(ExtFlash_benchmark(EFL_ADDR_SCRATCH, EFL_SIZE_SCRATCH, &benchmark))
+        {
+            Display_printf(hDisplaySerial, 0, 0, "ExtFlash kB/s: read %d write %d erase %d",
+                           benchmark.readBytesPerSec / 1024, benchmark.writeBytesPerSec / 1024,
+                           benchmark.eraseBytesPerSec / 1024);
+        }
+        else
+        {
+            Display_printf(hDisplaySerial, 0, 0, "ExtFlash benchmark failed");
+        }
+    }
+#endif
+
     buttonPinHandle = PIN_open(&buttonPinState, buttonPinTable);
     if(!buttonPinHandle)
     {
@@ -371,6 +472,12 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
             if (isKnownNodeAddress(latestActiveAdcSensorNode.address))
             {
                 updateNode(&latestActiveAdcSensorNode);
+
+                /* the node is listening after its next packet, invite it to a running broadcast */
+                if(knownSensorNodes[getNodeIdx(latestActiveAdcSensorNode.address)].oadBroadcastStatus == 0)
+                {
+                    OADServer_inviteNodeFw(latestActiveAdcSensorNode.address);
+                }
             }
             else
             {
@@ -412,23 +519,22 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
 
             case Concentrator_Actions_FwVerReq:
                 /* get FW version of selected node */
-                if(knownSensorNodes[selectedNode].address != 0)
+                /* abort any other message to the node, the action is refused while aborts are pending */
+                if( (knownSensorNodes[selectedNode].address != 0) &&
+                    ConcentratorRadioTask_abortNodeMsgFor(knownSensorNodes[selectedNode].address) )
                 {
-                    /* abort any other message */
-                    ConcentratorRadioTask_abortNodeMsg();
-
                     OADServer_getFwVer(knownSensorNodes[selectedNode].address);
                 }
                 break;
 
             case Concentrator_Actions_UpdateNodeFw:
+                /* other nodes may be updating */
                 if( (knownSensorNodes[selectedNode].address != 0) &&
-                    (nodeFwOadStatus != ConcentratorTask_NodeOadStatus_InProgress) &&
-                                            !availableFwUpdateInProgress)
+                    (knownSensorNodes[selectedNode].oadStatus != ConcentratorTask_NodeOadStatus_InProgress) &&
+                                            !availableFwUpdateInProgress &&
+                    /* abort any other message to the node */
+                    ConcentratorRadioTask_abortNodeMsgFor(knownSensorNodes[selectedNode].address))
                     {
-                    /* abort any other message */
-                    ConcentratorRadioTask_abortNodeMsg();
-
                     /* update FW on selected node */
                     totalBlocks = OADServer_updateNodeFw(knownSensorNodes[selectedNode].address);
 
@@ -439,6 +545,26 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
                     ConcentratorTask_updateNodeOadBlock(knownSensorNodes[selectedNode].address, 0);
                 }
                 break;
+
+            case Concentrator_Actions_BroadcastNodeFw:
+                if( (nodeFwOadStatus != ConcentratorTask_NodeOadStatus_InProgress) &&
+                    !availableFwUpdateInProgress &&
+                    /* abort any other message */
+                    ConcentratorRadioTask_abortNodeMsg())
+                {
+                    uint8_t i;
+
+                    /* clear the status of the previous broadcast */
+                    for (i = 0; i < CONCENTRATOR_MAX_NODES; i++)
+                    {
+                        knownSensorNodes[i].oadBroadcastStatus = 0;
+                        knownSensorNodes[i].oadBroadcastBlocks = 0;
+                    }
+
+                    /* update FW on all nodes */
+                    broadcastTotalBlocks = OADServer_broadcastNodeFw();
+                }
+                break;
             default:
                 break;
             }
@@ -458,39 +584,59 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
             /* service OAD event */
             OADServer_processEvent(&events);
         }
+        /* If OAD packets were received */
+        if (events & CONCENTRATOR_EVENT_OAD_PACKET)
+        {
+            parseOadPackets();
+        }
     }
 }
 
 static void packetReceivedCallback(union ConcentratorPacket* packet, int8_t rssi)
 {
-    /* If we received an ADC sensor packet, for backward compatibility */
-    if (packet->header.packetType == RADIO_PACKET_TYPE_ADC_SENSOR_PACKET)
+    /* If we received a data packet or an energy report of a node */
+    if ((packet->header.packetType == RADIO_PACKET_TYPE_RAW_DATA_PACKET) ||
+        (packet->header.packetType == RADIO_PACKET_TYPE_ENERGY_REPORT))
     {
         /* Save the values */
         latestActiveAdcSensorNode.address = packet->header.sourceAddress;
-        latestActiveAdcSensorNode.latestAdcValue = packet->adcSensorPacket.adcValue;
-        latestActiveAdcSensorNode.button = 0; //no button value in ADC packet
+        latestActiveAdcSensorNode.packets = 1;
+        latestActiveAdcSensorNode.latestLength = packet->header.length;
         latestActiveAdcSensorNode.latestRssi = rssi;
 
         Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_UPDATE_SENSOR_VALUE);
     }
-    /* If we received an DualMode ADC sensor packet*/
-    else if(packet->header.packetType == RADIO_PACKET_TYPE_DM_SENSOR_PACKET)
+    /* If we received an OAD packet*/
+    else if(packet->header.packetType == RADIO_PACKET_TYPE_OAD_PACKET)
     {
+        /* the OAD server uses the storage, parse it in the concentrator task */
+        queueOadPacket(&packet->oadPacket);
+    }
+}
 
-        /* Save the values */
-        latestActiveAdcSensorNode.address = packet->header.sourceAddress;
-        latestActiveAdcSensorNode.latestAdcValue = packet->dmSensorPacket.adcValue;
-        latestActiveAdcSensorNode.button = packet->dmSensorPacket.button;
-        latestActiveAdcSensorNode.latestRssi = rssi;
+static void queueOadPacket(struct OadPacket* packet)
+{
+    uint8_t next = (oadRxQueueHead + 1) % CONCENTRATOR_OAD_QUEUE_SIZE;
 
-        Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_UPDATE_SENSOR_VALUE);
+    /* Drop the packet when the queue is full, the node sends it again */
+    if ((next == oadRxQueueTail) || (packet->header.length > CONCENTRATOR_OAD_PAYLOAD_LENGTH))
+    {
+        return;
     }
-    /* If we received an OAD packet*/
-    else if(packet->header.packetType == RADIO_PACKET_TYPE_OAD_PACKET)
+
+    oadRxQueue[oadRxQueueHead].sourceAddress = packet->header.sourceAddress;
+    memcpy(oadRxQueue[oadRxQueueHead].payload, packet->oadPayload, packet->header.length);
+    oadRxQueueHead = next;
+
+    Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_OAD_PACKET);
+}
+
+static void parseOadPackets(void)
+{
+    while (oadRxQueueTail != oadRxQueueHead)
     {
-        uint8_t srcAddr = packet->header.sourceAddress;
-        OADProtocol_ParseIncoming(&srcAddr, packet->oadPacket.oadPayload);
+        OADServer_parseIncoming(oadRxQueue[oadRxQueueTail].sourceAddress, oadRxQueue[oadRxQueueTail].payload);
+        oadRxQueueTail = (oadRxQueueTail + 1) % CONCENTRATOR_OAD_QUEUE_SIZE;
     }
 }
 
@@ -534,9 +680,9 @@ static void updateNode(struct AdcSensorNode* node)
     {
         if (knownSensorNodes[i].address == node->address)
         {
-            knownSensorNodes[i].latestAdcValue = node->latestAdcValue;
+            knownSensorNodes[i].packets++;
+            knownSensorNodes[i].latestLength = node->latestLength;
             knownSensorNodes[i].latestRssi = node->latestRssi;
-            knownSensorNodes[i].button = node->button;
            break;
         }
     }
@@ -614,11 +760,11 @@ static void updateLcd(void)
         {
             /* Clear the display and write header on first line */
             Display_clear(hDisplayLcd);
-            Display_printf(hDisplayLcd, 0, 0, "Nodes Value SW  RSSI");
+            Display_printf(hDisplayLcd, 0, 0, "Nodes Pkts Len RSSI");
         }
 
         //clear screen, put curser to beginning of terminal and print the header
-        Display_printf(hDisplaySerial, 0, 0, "\033[2J \033[0;0HNodes   Value   SW    RSSI");
+        Display_printf(hDisplaySerial, 0, 0, "\033[2J \033[0;0HNodes   Pkts    Len   RSSI");
 
         /* Start on the second line */
         currentLcdLine = 1;
@@ -640,14 +786,14 @@ static void updateLcd(void)
             if(nodeFwOadStatus != ConcentratorTask_NodeOadStatus_InProgress)
             {
                 /* print to LCD */
-                Display_printf(hDisplayLcd, currentLcdLine, 0, "%c0x%02x  %04d  %d   %04d", selectedChar,
-                    nodePointer->address, nodePointer->latestAdcValue, nodePointer->button,
+                Display_printf(hDisplayLcd, currentLcdLine, 0, "%c0x%02x  %04d %03d %04d", selectedChar,
+                    nodePointer->address, nodePointer->packets, nodePointer->latestLength,
                     nodePointer->latestRssi);
             }
 
             /* print to UART */
-            Display_printf(hDisplaySerial, 0, 0, "%c0x%02x    %04d    %d    %04d", selectedChar,
-                    nodePointer->address, nodePointer->latestAdcValue, nodePointer->button,
+            Display_printf(hDisplaySerial, 0, 0, "%c0x%02x    %04d    %03d   %04d", selectedChar,
+                    nodePointer->address, nodePointer->packets, nodePointer->latestLength,
                     nodePointer->latestRssi);
 
             nodePointer++;
@@ -715,24 +861,48 @@ static void updateLcd(void)
 
             break;
         case Concentrator_Actions_UpdateNodeFw:
-            if(nodeFwOadStatus == ConcentratorTask_NodeOadStatus_InProgress)
+            if(knownSensorNodes[selectedNode].oadStatus == ConcentratorTask_NodeOadStatus_InProgress)
             {
                 /* print to UART */
-                Display_printf(hDisplaySerial, 0, 0, "Info: OAD Block %d of %d",
+                Display_printf(hDisplaySerial, 0, 0, "Info: OAD Block %d of %d, %d nodes updating",
                            knownSensorNodes[selectedNode].oadBlock,
-                           knownSensorNodes[selectedNode].oadTotalBlocks);
+                           knownSensorNodes[selectedNode].oadTotalBlocks,
+                           OADServer_getNumSessions());
             }
-            else if(nodeFwOadStatus == ConcentratorTask_NodeOadStatus_Completed)
+            else if(knownSensorNodes[selectedNode].oadStatus == ConcentratorTask_NodeOadStatus_Completed)
             {
+                uint32_t cacheHits, cacheMisses;
+                OADStorage_getReadCacheStats(&cacheHits, &cacheMisses);
+
                 /* print to UART */
-                Display_printf(hDisplaySerial, 0, 0, "Info: OAD Complete");
+                Display_printf(hDisplaySerial, 0, 0, "Info: OAD Complete, blocks cached %d read %d",
+                           cacheHits, cacheMisses);
             }
-            else if(nodeFwOadStatus == ConcentratorTask_NodeOadStatus_Aborted)
+            else if(knownSensorNodes[selectedNode].oadStatus == ConcentratorTask_NodeOadStatus_Aborted)
             {
                 /* print to UART */
                 Display_printf(hDisplaySerial, 0, 0, "Info: OAD Aborted");
             }
 
+            break;
+        case Concentrator_Actions_BroadcastNodeFw:
+            if(nodeFwOadStatus == ConcentratorTask_NodeOadStatus_InProgress)
+            {
+                /* print to UART */
+                Display_printf(hDisplaySerial, 0, 0, "Info: Node 0x%02x decoded %d of %d",
+                           knownSensorNodes[selectedNode].address,
+                           knownSensorNodes[selectedNode].oadBroadcastBlocks,
+                           broadcastTotalBlocks);
+            }
+            else if(nodeFwOadStatus == ConcentratorTask_NodeOadStatus_Completed)
+            {
+                /* print to UART */
+                Display_printf(hDisplaySerial, 0, 0, "Info: Broadcast done, node 0x%02x %s",
+                           knownSensorNodes[selectedNode].address,
+                           (knownSensorNodes[selectedNode].oadBroadcastStatus == OADProtocol_FOUNTAIN_STATUS_COMPLETE) ?
+                           "updated" : "not updated");
+            }
+
             break;
         default:
             break;
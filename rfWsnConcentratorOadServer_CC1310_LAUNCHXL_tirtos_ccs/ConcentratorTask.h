@@ -47,8 +47,8 @@ void ConcentratorTask_init(void);
 /* Update nodes current FW version for display */
 void ConcentratorTask_updateNodeFWVer(uint8_t addr, char* fwVerStr);
 
-/* Update available OAD status for display */
-void ConcentratorTask_updateNodeOadStatus(ConcentratorTask_NodeOadStatus_t status);
+/* Update OAD status of a node for display, RADIO_BROADCAST_ADDRESS for a broadcast OAD */
+void ConcentratorTask_updateNodeOadStatus(uint8_t addr, ConcentratorTask_NodeOadStatus_t status);
 
 /* Update available FW version for display */
 void ConcentratorTask_updateAvailableFWVer(bool success);
@@ -56,4 +56,10 @@ void ConcentratorTask_updateAvailableFWVer(bool success);
 /* Update nodes OAD block during OAD for display */
 void ConcentratorTask_updateNodeOadBlock(uint8_t addr, uint16_t block);
 
+/* Update nodes OAD image size when the node is sent another image */
+void ConcentratorTask_updateNodeOadTotalBlocks(uint8_t addr, uint16_t totalBlocks);
+
+/* Update nodes broadcast OAD status, stops the broadcast once all nodes are done */
+void ConcentratorTask_updateNodeOadBroadcast(uint8_t addr, uint8_t status, uint16_t decodedBlocks);
+
 #endif /* TASKS_CONCENTRATORTASK_H_ */
@@ -54,6 +54,18 @@
 #endif
 
 #define RADIO_CONCENTRATOR_ADDRESS     0x00
+/* Destination address of frames for every node that is listening */
+#define RADIO_BROADCAST_ADDRESS        0xFF
+
+/*
+ * Broadcast frames of the concentrator start at a broadcast slot, every
+ * RADIO_BROADCAST_SLOT_MS on its radio timer. A node that follows a
+ * broadcast finds the slots from the first broadcast frame it receives and
+ * then listens from RADIO_BROADCAST_GUARD_US before each slot to as long
+ * after it.
+ */
+#define RADIO_BROADCAST_SLOT_MS        100
+#define RADIO_BROADCAST_GUARD_US       2000
 
 /*
  * Uncomment to change the modulation away from the default found in the 
@@ -69,41 +81,90 @@
  *#endif
 */
 
-#define RADIO_PACKET_TYPE_ACK_PACKET             0
-#define RADIO_PACKET_TYPE_ADC_SENSOR_PACKET      1
-#define RADIO_PACKET_TYPE_DM_SENSOR_PACKET       2
-#define RADIO_PACKET_TYPE_OAD_PACKET             3
+/*
+ * The nodes of the network use the frame format of the rfWsnNode: a header of
+ * source address, packet type, options and payload length, then the payload.
+ * OAD messages of the server follow the header of an OAD packet.
+ */
+#define RADIO_PACKET_TYPE_ACK_PACKET            0
+#define RADIO_PACKET_TYPE_RAW_DATA_PACKET       1
+#define RADIO_PACKET_TYPE_TEST_RESET            2
+#define RADIO_PACKET_TYPE_OAD_PACKET            3
+#define RADIO_PACKET_TYPE_ENERGY_REPORT         4
+
+#define RADIO_PACKET_SRCADDR_OFFSET             0
+#define RADIO_PACKET_PKTTYPE_OFFSET             1
+#define RADIO_PACKET_OPTIONS_OFFSET             2
+#define RADIO_PACKET_LENGTH_OFFSET              3
+#define RADIO_PACKET_PAYLOAD_OFFSET             4
 
-#define RADIO_PACKET_SRCADDR_OFFSET              0
-#define RADIO_PACKET_PKTTYPE_OFFSET              1
-#define RADIO_PACKET_PAYLOAD_OFFSET              2
+#define RADIO_PACKET_OPTIONS_CRC                (1 << 0)
+
+/*
+ * Set in the options of an ACK or OAD packet from the concentrator when
+ * another frame for the node follows it, the node stays in RX for it.
+ */
+#define RADIO_PACKET_OPTIONS_FRAME_PENDING      (1 << 1)
+
+/*
+ * Set in the options of an ACK when its first byte is the RSSI of the
+ * acknowledged packet, the downlink follows it.
+ */
+#define RADIO_PACKET_OPTIONS_RSSI               (1 << 2)
+
+/* TX power backoff of the node, not used by the OAD server */
+#define RADIO_PACKET_OPTIONS_POWER_BACKOFF_MASK 0xF0
+
+/*
+ * Short downlink messages are carried inside the ACK frame so they cost no
+ * extra TX/RX turnaround. The ACK header length field holds the number of
+ * bytes after the header, the RSSI byte and the downlink bytes, the first
+ * of which is the downlink type.
+ */
+#define RADIO_ACK_DOWNLINK_MAX_LENGTH           16
+
+#define RADIO_DOWNLINK_TYPE_CONFIG              1   /* type, frequency[4] (big endian) */
+#define RADIO_DOWNLINK_TYPE_TIME_SYNC           2   /* type, concentrator time in ms[4] (big endian) */
+#define RADIO_DOWNLINK_TYPE_PHY                 3   /* type, PHY, concentrator time in ms[4] (big endian) */
+#define RADIO_DOWNLINK_TYPE_OAD                 4   /* type, OAD message */
+
+/*
+ * Comment out when serving nodes that only understand OAD messages sent as
+ * a separate frame after the ACK
+ */
+#define RADIO_ACK_EMBED_DOWNLINK
 
 struct PacketHeader {
     uint8_t sourceAddress;
     uint8_t packetType;
+    uint8_t options;
+    uint8_t length;
 };
 
-struct AdcSensorPacket {
+struct RawDataPacket {
     struct PacketHeader header;
-    uint16_t adcValue;
+    uint16_t crc;
+    uint8_t data[EASYLINK_MAX_DATA_LENGTH - sizeof(struct PacketHeader) - sizeof(uint16_t)];
 };
 
-struct DualModeSensorPacket {
+/* Radio energy report of a node, see RadioProtocol.h of the rfWsnNode */
+#define RADIO_ENERGY_REPORT_LENGTH              24
+
+struct EnergyReportPacket {
     struct PacketHeader header;
-    uint16_t adcValue;
-    uint32_t time100MiliSec;
-    uint16_t batt;
-    uint8_t button;
+    uint8_t report[RADIO_ENERGY_REPORT_LENGTH];
 };
 
+/* OAD protocol message (oad/native_oad/oad_protocol.h), length in the header */
 struct OadPacket {
     struct PacketHeader header;
-    uint8_t oadPayload[OAD_BLOCK_SIZE + 2 + 2]; //buffer for mac oad packet side
+    uint8_t oadPayload[EASYLINK_MAX_DATA_LENGTH - sizeof(struct PacketHeader)];
 };
 
 struct AckPacket {
     struct PacketHeader header;
-    uint8_t framePending;
+    int8_t  rssi;
+    uint8_t downlink[RADIO_ACK_DOWNLINK_MAX_LENGTH];
 };
 
 #endif /* RADIOPROTOCOL_H_ */
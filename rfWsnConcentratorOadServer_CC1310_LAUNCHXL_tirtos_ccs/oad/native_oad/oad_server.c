@@ -49,9 +49,12 @@
  *****************************************************************************/
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdlib.h>
 
+#include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
 
 #include <ti/devices/DeviceFamily.h>
 #include DeviceFamily_constructPath(driverlib/flash.h)
@@ -59,6 +62,9 @@
 #include "oad/native_oad/oad_server.h"
 #include "oad/native_oad/oad_protocol.h"
 #include "oad/native_oad/oad_storage.h"
+#include "oad/native_oad/oad_fountain.h"
+#include "oad/native_oad/oad_delta.h"
+#include "oad/native_oad/oad_compress.h"
 #include "oad/native_oad/ext_flash_layout.h"
 
 #include "RadioProtocol.h"
@@ -78,9 +84,59 @@
 
 #define FW_VERSION "v1.0"
 
+/*!
+ Broadcast OAD pacing and limits.
+ */
+#define OADServer_BROADCAST_SYMBOL_PERIOD_MS    50   ///< Time between checks whether the last broadcast packet was sent
+#define OADServer_BROADCAST_IDENTIFY_INTERVAL   32   ///< Packets between repeated image identify
+#define OADServer_BROADCAST_MAX_OVERHEAD_PCT    300  ///< Symbols sent before giving up, in % of image blocks
+
+/*!
+ Nodes whose reported FW version is remembered for delta updates.
+ */
+#define OADServer_MAX_NODE_FW_VERSIONS          8
+
+/*!
+ Nodes that can be updated at the same time.
+ */
+#define OADServer_MAX_SESSIONS                  4
+
+/*!
+ A node hears the image identify after its next packet, it is queued again
+ every OADServer_IDENTIFY_RETRY_MS until the node responds, at most
+ OADServer_IDENTIFY_MAX_RETRIES times.
+ */
+#define OADServer_IDENTIFY_RETRY_MS             2000
+#define OADServer_IDENTIFY_MAX_RETRIES          60
+
+/*!
+ Time without a block request before a session ends. A node in push mode acks
+ for OADProtocol_PUSH_MAX_IDLE_ACKS intervals without a block before it gives
+ up, the server waits as long.
+ */
+#define OADServer_ABORT_TIMEOUT_MS              (500 + OADProtocol_BLOCK_REQ_RATE * OADProtocol_MAX_RETRIES)
+#define OADServer_PUSH_ABORT_TIMEOUT_MS         (500 + OADProtocol_PUSH_ACK_INTERVAL * (OADProtocol_PUSH_MAX_IDLE_ACKS + 1))
+
+/*!
+ Image OADStorage is not setup to read for a session.
+ */
+#define OADServer_IMG_TYPE_NONE                 0
+
+/*!
+ Push mode pacing. The blocks pushed use at most OADServer_PUSH_BUDGET_PCT of
+ the airtime, credit saved while idle allows bursts of up to
+ OADServer_PUSH_BUDGET_MAX_MS.
+ */
+#define OADServer_PUSH_BUDGET_PCT               25
+#define OADServer_PUSH_BUDGET_MAX_MS            250
+#define OADServer_PUSH_BITRATE_BPS              50000 ///< Data rate of the default PHY
+#define OADServer_PUSH_FRAME_OVERHEAD           16    ///< Preamble, sync word, header and CRC bytes
+#define OADServer_PUSH_BLOCK_AIRTIME_US         ((uint32_t)(OADProtocol_PACKET_TYPE_OAD_BLOCK_RSP_LEN + RADIO_PACKET_PAYLOAD_OFFSET + \
+                                                            OADServer_PUSH_FRAME_OVERHEAD) * 8 * 1000000 / OADServer_PUSH_BITRATE_BPS)
+
 
 /*!
- OAD block variables.
+ OAD block variables, of an available FW update or broadcast.
  */
 /*static*/ uint16_t oadBNumBlocks = 0;
 /*static*/ uint16_t oadBlock = 0;
@@ -89,21 +145,126 @@ OADServer_Params_t oadServerParams;
 static UART_Handle uartHandle;
 
 /*!
- * Clock for OAD abort
+ Windowed UART upload variables.
+ */
+static bool uartIngestWindowed = false;
+static uint32_t uartIngestBaud = 115200;
+static uint16_t uartIngestBase = 0;
+static uint16_t uartIngestBitmap = 0;
+static uint8_t uartIngestBuf[2][OADServer_UART_WINDOW_SIZE * OADServer_UART_FRAME_LEN];
+static uint8_t uartIngestBufIdx = 0;
+static volatile bool uartIngestReadDone = false;
+static volatile bool uartIngestTimedOut = false;
+static volatile size_t uartIngestReadCount = 0;
+
+/*!
+ Broadcast OAD variables.
+ */
+static bool oadBroadcastInProgress = false;
+static volatile bool oadBroadcastStopRequested = false;
+static uint16_t oadBroadcastTick = 0;
+static uint16_t oadBroadcastSymbol = 0;
+static uint16_t oadBroadcastMaxSymbols = 0;
+static uint8_t oadBroadcastImgId = OADProtocol_IMG_ID_FOUNTAIN;
+static uint8_t oadBroadcastImgInfo[16];
+
+/*!
+ FW version last reported by each node, 0 if unknown, and the image formats
+ it rejected.
+ */
+static struct {
+    uint8_t addr;
+    uint16_t ver;
+    uint8_t imgIdRejected;      ///< OADProtocol_IMG_ID_DELTA and OADProtocol_IMG_ID_COMPRESSED flags
+} nodeFwVersions[OADServer_MAX_NODE_FW_VERSIONS];
+static uint8_t nodeFwVersionsNext = 0;
+
+/*!
+ Update of a node, the nodes interleave their block requests.
+ */
+typedef struct {
+    bool inUse;
+    uint8_t addr;
+    uint8_t imgType;            ///< EFL_OAD_IMG_TYPE_REMOTE_APP, _DELTA or _COMPRESSED
+    uint8_t imgId;              ///< Image ID sent in the image identify
+    uint16_t numBlocks;
+    uint16_t pushNext;          ///< First block not pushed yet in push mode
+    uint8_t pushBurst;          ///< Blocks pushed per ack, halved when blocks are lost
+    bool identified;            ///< The node responded to the image identify
+    uint8_t identifyRetries;
+    volatile bool timedOut;     ///< Set by the abort clock, ended in task context
+} OADServer_Session_t;
+
+static OADServer_Session_t oadSessions[OADServer_MAX_SESSIONS];
+static uint8_t oadStorageImgType = OADServer_IMG_TYPE_NONE;
+
+/*!
+ Push mode airtime credit in us, shared by the sessions.
+ */
+static uint32_t oadPushCredit = 0;
+static uint32_t oadPushCreditTicks = 0;
+
+/*!
+ * Clocks for OAD abort, one per session
+ */
+Clock_Struct oadAbortTimeoutClock[OADServer_MAX_SESSIONS];     /* not static so you can see in ROV */
+static Clock_Handle oadAbortTimeoutClockHandle[OADServer_MAX_SESSIONS];
+
+/*!
+ * Clock for pacing broadcast symbols
+ */
+Clock_Struct oadBroadcastClock;     /* not static so you can see in ROV */
+static Clock_Handle oadBroadcastClockHandle;
+
+/*!
+ * Clock for windowed UART upload timeout
  */
-Clock_Struct oadAbortTimeoutClock;     /* not static so you can see in ROV */
-static Clock_Handle oadAbortTimeoutClockHandle;
+Clock_Struct uartIngestTimeoutClock;     /* not static so you can see in ROV */
+static Clock_Handle uartIngestTimeoutClockHandle;
 
 /******************************************************************************
  Local function prototypes
  *****************************************************************************/
 
 static void getNextBlock(uint16_t blkNum, uint8_t* oadBlockBuff);
+static void uartIngestStart(uint8_t *pHello);
+static void uartIngestNext(void);
+static void uartIngestRequestWindow(void);
+static void uartIngestMoveWindow(void);
+static void uartIngestFinish(void);
+static void uartIngestReadCallback(UART_Handle handle, void *buf, size_t count);
 static void fwVersionRspCb(void* pSrcAddr, char *fwVersionStr);
-static void oadImgIdentifyRspCb(void* pSrcAddr, uint8_t status);
+static void oadImgIdentifyRspCb(void* pSrcAddr, uint8_t imgId, uint8_t status, uint16_t resumeBlock);
 static void oadBlockReqCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint16_t multiBlockSize);
+static void oadMultiBlockReqCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint16_t multiBlockSize, uint16_t blockBitmap);
+static void oadFountainStatusCb(void* pSrcAddr, uint8_t imgId, uint8_t status, uint16_t decodedBlocks, uint16_t receivedSymbols);
+static void oadPushAckCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint32_t blockBitmap);
+static void oadPushRefillCredit(void);
+static void oadRestartAbortTimeout(OADServer_Session_t *pSession, uint32_t timeoutMs);
+static void oadStartIdentifyTimeout(OADServer_Session_t *pSession);
+static uint16_t oadSessionStart(uint8_t dstAddr);
+static OADServer_Session_t* oadSessionFind(uint8_t addr);
+static OADServer_Session_t* oadSessionAlloc(uint8_t addr);
+static void oadSessionEnd(OADServer_Session_t *pSession, ConcentratorTask_NodeOadStatus_t status);
+static void oadSessionEndTimedOut(void);
+static void oadSessionSelectImg(OADServer_Session_t *pSession);
+static uint16_t oadSessionIdentifyImg(OADServer_Session_t *pSession);
+static void oadSessionRetryIdentify(OADServer_Session_t *pSession);
+static uint16_t oadSessionWindowSize(uint16_t multiBlockSize);
+static void oadBroadcastNext(void);
+static bool oadBroadcastReadBlock(uint16_t blockNum, uint8_t *pBlock);
 
 static void oadAbortTimeoutCallback(UArg arg0);
+static void oadBroadcastClockCallback(UArg arg0);
+static void uartIngestTimeoutCallback(UArg arg0);
+
+static uint16_t parseFwVersion(char *fwVersionStr);
+static void setNodeFwVersion(uint8_t addr, uint16_t ver);
+static uint16_t getNodeFwVersion(uint8_t addr);
+static void setNodeImgIdRejected(uint8_t addr, uint8_t imgId);
+static uint8_t getNodeImgIdRejected(uint8_t addr);
+static uint16_t deltaImgIdentifyRead(uint16_t nodeVer, uint8_t *pImgInfo);
+static uint16_t compressedImgIdentifyRead(uint8_t *pImgInfo);
 
 void* oadRadioAccessAllocMsg(uint32_t msgLen);
 static OADProtocol_Status_t oadRadioAccessPacketSend(void* pDstAddr, uint8_t *pMsg, uint32_t msgLen);
@@ -132,6 +293,14 @@ static OADProtocol_MsgCBs_t oadMsgCallbacks =
       oadBlockReqCb,
       /*! Incoming OAD Block Rsp */
       NULL,
+      /*! Incoming OAD Multi Block Req */
+      oadMultiBlockReqCb,
+      /*! Incoming OAD Fountain Symbol */
+      NULL,
+      /*! Incoming OAD Fountain Status */
+      oadFountainStatusCb,
+      /*! Incoming OAD Push Ack */
+      oadPushAckCb,
     };
 
 /******************************************************************************
@@ -147,13 +316,31 @@ OADProtocol_Status_t OADServer_open(OADServer_Params_t *params)
 {    
     OADProtocol_Params_t OADProtocol_params;
     OADProtocol_Status_t status = OADProtocol_Failed;
+    uint8_t idx;
     
-    /* Create clock object which is used for fast report timeout */
+    /* Create clock objects which abort a session the node stopped */
     Clock_Params clkParams;
+    Clock_Params_init(&clkParams);
     clkParams.period = 0;
     clkParams.startFlag = FALSE;
-    Clock_construct(&oadAbortTimeoutClock, oadAbortTimeoutCallback, 1, &clkParams);
-    oadAbortTimeoutClockHandle = Clock_handle(&oadAbortTimeoutClock);
+    for(idx = 0; idx < OADServer_MAX_SESSIONS; idx++)
+    {
+        clkParams.arg = idx;
+        Clock_construct(&oadAbortTimeoutClock[idx], oadAbortTimeoutCallback, 1, &clkParams);
+        oadAbortTimeoutClockHandle[idx] = Clock_handle(&oadAbortTimeoutClock[idx]);
+    }
+    clkParams.arg = 0;
+
+    /* Create clock object which paces the broadcast symbols */
+    clkParams.period = OADServer_BROADCAST_SYMBOL_PERIOD_MS * 1000 / Clock_tickPeriod;
+    Clock_construct(&oadBroadcastClock, oadBroadcastClockCallback,
+                    clkParams.period, &clkParams);
+    oadBroadcastClockHandle = Clock_handle(&oadBroadcastClock);
+
+    /* Create clock object which times out windowed UART upload reads */
+    clkParams.period = 0;
+    Clock_construct(&uartIngestTimeoutClock, uartIngestTimeoutCallback, 1, &clkParams);
+    uartIngestTimeoutClockHandle = Clock_handle(&uartIngestTimeoutClock);
 
     memcpy(&oadServerParams, params, sizeof(OADServer_Params_t));
 
@@ -179,8 +366,24 @@ OADProtocol_Status_t OADServer_open(OADServer_Params_t *params)
  */
 void OADServer_processEvent(uint32_t *pEvent)
 {
-    /* Is it time to send the next sensor data message? */
+    /* Has a node stopped requesting blocks? */
     if(*pEvent & oadServerParams.eventBit)
+    {
+        oadSessionEndTimedOut();
+    }
+
+    /* Is it time to send the next broadcast symbol? */
+    if((*pEvent & oadServerParams.eventBit) && oadBroadcastInProgress)
+    {
+        oadBroadcastNext();
+    }
+    /* Has the next window of a windowed UART upload arrived? */
+    else if((*pEvent & oadServerParams.eventBit) && uartIngestWindowed)
+    {
+        uartIngestNext();
+    }
+    /* Is it time to get the next block of the available FW? */
+    else if((*pEvent & oadServerParams.eventBit) && oadInProgress)
     {
         /* allocate buffer for block + block number */
         uint8_t blkData[OAD_BLOCK_SIZE + 2] = {0};
@@ -245,7 +448,7 @@ void OADServer_updateAvailableFwVer(void)
     UART_Params uartParams;
     uint8_t imgMetaData[16];
 
-    if(!oadInProgress)
+    if(!oadInProgress && (OADServer_getNumSessions() == 0))
     {
         /* initialize UART */
         UART_Params_init(&uartParams);
@@ -259,8 +462,17 @@ void OADServer_updateAvailableFwVer(void)
         /* get image header */
         UART_read(uartHandle, imgMetaData, 16);
 
+        /* or the hello of a windowed upload, followed by the header */
+        if(OADTarget_BUILD_UINT32(imgMetaData[0], imgMetaData[1], imgMetaData[2], imgMetaData[3]) ==
+           OADServer_UART_MAGIC)
+        {
+            uartIngestStart(imgMetaData);
+            return;
+        }
+
         oadBNumBlocks = OADStorage_imgIdentifyWrite(imgMetaData);
         oadBlock = 0;
+        oadInProgress = true;
 
         /* set event to get next block */
         Event_post(oadServerParams.eventHandle, oadServerParams.eventBit);
@@ -274,34 +486,110 @@ void OADServer_updateAvailableFwVer(void)
  */
 uint16_t OADServer_updateNodeFw(uint8_t dstAddr)
 {
-    OADTarget_ImgHdr_t remoteImgHdr;
-    uint8_t pImgInfo[16];
-
-    if(!oadInProgress)
+    if(oadInProgress)
     {
-        oadInProgress = true;
+        return 0;
+    }
 
-        /* get num blocks and setup OADStorage to read remote image region */
-        oadBNumBlocks = OADStorage_imgIdentifyRead(EFL_OAD_IMG_TYPE_REMOTE_APP, &remoteImgHdr);
+    return oadSessionStart(dstAddr);
+}
 
-        OADStorage_imgInfoRead(pImgInfo);
+/*!
+ Number of nodes being updated.
 
-        /*
-         * Hard code imgId to 0 - its not used in this
-         * implementation as there is only 1 image available
-         */
-        OADProtocol_sendImgIdentifyReq(&dstAddr, 0, pImgInfo);
+ Public function defined in oad_server.h
+ */
+uint8_t OADServer_getNumSessions(void)
+{
+    uint8_t numSessions = 0;
+    uint8_t idx;
 
-        if(oadBNumBlocks == 0)
+    for(idx = 0; idx < OADServer_MAX_SESSIONS; idx++)
+    {
+        if(oadSessions[idx].inUse)
         {
-            /* issue with image in ext flash */
-            oadInProgress = false;
+            numSessions++;
         }
+    }
+
+    return numSessions;
+}
+
+/*!
+ Start a broadcast OAD of the remote app image to all nodes.
+
+ Public function defined in oad_server.h
+ */
+uint16_t OADServer_broadcastNodeFw(void)
+{
+    OADTarget_ImgHdr_t remoteImgHdr;
 
-        return oadBNumBlocks;
+    if(oadInProgress || (OADServer_getNumSessions() != 0))
+    {
+        return 0;
     }
 
-    return 0;
+    /* get num blocks and setup OADStorage to read remote image region */
+    oadBNumBlocks = OADStorage_imgIdentifyRead(EFL_OAD_IMG_TYPE_REMOTE_APP, &remoteImgHdr);
+
+    if(oadBNumBlocks == 0)
+    {
+        /* issue with image in ext flash */
+        OADStorage_close();
+        return 0;
+    }
+
+    /* the symbols are coded from the uncompressed image, decoded out of order */
+    oadBroadcastImgId = OADProtocol_IMG_ID_FOUNTAIN;
+    OADStorage_imgInfoRead(oadBroadcastImgInfo);
+
+    oadInProgress = true;
+    oadBroadcastInProgress = true;
+    oadBroadcastStopRequested = false;
+    oadBroadcastTick = 0;
+    oadBroadcastSymbol = 0;
+    oadBroadcastMaxSymbols = ((uint32_t)oadBNumBlocks * OADServer_BROADCAST_MAX_OVERHEAD_PCT) / 100;
+
+    ConcentratorTask_updateNodeOadStatus(RADIO_BROADCAST_ADDRESS, ConcentratorTask_NodeOadStatus_InProgress);
+
+    Clock_start(oadBroadcastClockHandle);
+
+    return oadBNumBlocks;
+}
+
+/*!
+ Stop a broadcast OAD.
+
+ Public function defined in oad_server.h
+ */
+void OADServer_stopBroadcastNodeFw(void)
+{
+    /* the broadcast ends on the next symbol event */
+    oadBroadcastStopRequested = true;
+}
+
+/*!
+ Invite a node to a running broadcast OAD.
+
+ Public function defined in oad_server.h
+ */
+void OADServer_inviteNodeFw(uint8_t dstAddr)
+{
+    if(oadBroadcastInProgress)
+    {
+        /* delivered with the ACK of the next packet from the node */
+        OADProtocol_sendImgIdentifyReq(&dstAddr, oadBroadcastImgId, oadBroadcastImgInfo);
+    }
+}
+
+/*!
+ Parse an OAD packet from a node.
+
+ Public function defined in oad_server.h
+ */
+void OADServer_parseIncoming(uint8_t srcAddr, uint8_t *pPayload)
+{
+    OADProtocol_ParseIncoming(&srcAddr, pPayload);
 }
 
 /******************************************************************************
@@ -309,139 +597,1266 @@ uint16_t OADServer_updateNodeFw(uint8_t dstAddr)
  *****************************************************************************/
 
 /*!
- * @brief      OAD abort timer callback
+ * @brief      Start the session of a node and send it the image identify
+ *
+ * @return     blocks in image, 0 if the session could not start
  */
-static void oadAbortTimeoutCallback(UArg arg0)
+static uint16_t oadSessionStart(uint8_t dstAddr)
 {
-    if(oadInProgress)
+    OADServer_Session_t *pSession;
+    uint8_t pImgInfo[16];
+
+    /* start over if the node already has a session */
+    pSession = oadSessionFind(dstAddr);
+    if(pSession != NULL)
     {
-        /* end available fw update */
-        oadInProgress = false;
-        OADStorage_close();
+        oadSessionEnd(pSession, ConcentratorTask_NodeOadStatus_Aborted);
+    }
+
+    pSession = oadSessionAlloc(dstAddr);
+    if(pSession == NULL)
+    {
+        return 0;
+    }
+
+    /* send a patch if there is one from the FW the node runs, and it takes patches */
+    if(!(getNodeImgIdRejected(dstAddr) & OADProtocol_IMG_ID_DELTA))
+    {
+        pSession->numBlocks = deltaImgIdentifyRead(getNodeFwVersion(dstAddr), pImgInfo);
+    }
+
+    if(pSession->numBlocks != 0)
+    {
+        pSession->imgType = EFL_OAD_IMG_TYPE_DELTA;
+        pSession->imgId = OADProtocol_IMG_ID_DELTA;
+        OADProtocol_sendImgIdentifyReq(&dstAddr, pSession->imgId, pImgInfo);
+        oadStartIdentifyTimeout(pSession);
+
+        return pSession->numBlocks;
+    }
 
-        /* abort any pending messages */
-        ConcentratorRadioTask_abortNodeMsg();
+    if(oadSessionIdentifyImg(pSession) == 0)
+    {
+        /* issue with image in ext flash */
+        pSession->inUse = false;
+        if(OADServer_getNumSessions() == 0)
+        {
+            OADStorage_close();
+            oadStorageImgType = OADServer_IMG_TYPE_NONE;
+        }
 
-        ConcentratorTask_updateNodeOadStatus(ConcentratorTask_NodeOadStatus_Aborted);
+        return 0;
     }
+
+    return pSession->numBlocks;
 }
 
+/*!
+ * @brief      Broadcast symbol clock callback
+ */
+static void oadBroadcastClockCallback(UArg arg0)
+{
+    Event_post(oadServerParams.eventHandle, oadServerParams.eventBit);
+}
 
 /*!
- * @brief      Get next block of available FW image from UART
+ * @brief      Send the next broadcast packet, or end the broadcast
  */
-static void getNextBlock(uint16_t blkNum, uint8_t* oadBlockBuff)
+static void oadBroadcastNext(void)
 {
-    uint8_t blkNumLower = blkNum & 0xFF;
-    uint8_t blkNumUpper = (blkNum & 0xFF00) >> 8;
+    uint8_t broadcastAddr = RADIO_BROADCAST_ADDRESS;
+    uint8_t symbol[OAD_BLOCK_SIZE];
 
-    UART_write(uartHandle, &blkNumUpper, 1);
-    UART_write(uartHandle, &blkNumLower, 1);
+    if(oadBroadcastStopRequested || (oadBroadcastSymbol >= oadBroadcastMaxSymbols))
+    {
+        Clock_stop(oadBroadcastClockHandle);
 
-    UART_read(uartHandle, oadBlockBuff, (OAD_BLOCK_SIZE + 2));
+        /* end broadcast */
+        oadBroadcastInProgress = false;
+        oadInProgress = false;
+        OADStorage_close();
+
+        ConcentratorTask_updateNodeOadStatus(RADIO_BROADCAST_ADDRESS, ConcentratorTask_NodeOadStatus_Completed);
+        return;
+    }
+
+    /* the last packet waits for its broadcast slot */
+    if(ConcentratorRadioTask_broadcastPending())
+    {
+        return;
+    }
+
+    /* repeat the image identify for nodes that start listening late */
+    if((oadBroadcastTick % OADServer_BROADCAST_IDENTIFY_INTERVAL) == 0)
+    {
+        if(OADProtocol_sendImgIdentifyReq(&broadcastAddr, oadBroadcastImgId, oadBroadcastImgInfo) == OADProtocol_Status_Success)
+        {
+            oadBroadcastTick++;
+        }
+        return;
+    }
+
+    if(OADFountain_encode(oadBroadcastSymbol, oadBNumBlocks, oadBroadcastReadBlock, symbol) &&
+       (OADProtocol_sendOadFountainSymbol(&broadcastAddr, oadBroadcastImgId, oadBroadcastSymbol, symbol) != OADProtocol_Status_Success))
+    {
+        /* no TX packet, try again on the next event */
+        return;
+    }
+
+    oadBroadcastTick++;
+    oadBroadcastSymbol++;
 }
 
 /*!
- * @brief      FW version response callback from OAD module
+ * @brief      Read an image block for the fountain encoder
  */
-static void fwVersionRspCb(void* pSrcAddr, char *fwVersionStr)
+static bool oadBroadcastReadBlock(uint16_t blockNum, uint8_t *pBlock)
 {
-    ConcentratorTask_updateNodeFWVer((uint8_t) *((uint8_t*) pSrcAddr), fwVersionStr);
+    OADStorage_imgBlockRead(blockNum, pBlock);
+
+    return true;
 }
 
 /*!
- * @brief      Image Identify response callback from OAD module
+ * @brief      OAD abort timer callback, the session ends in task context
  */
-static void oadImgIdentifyRspCb(void* pSrcAddr, uint8_t status)
+static void oadAbortTimeoutCallback(UArg arg0)
 {
-    ConcentratorTask_updateNodeOadStatus(ConcentratorTask_NodeOadStatus_InProgress);
+    oadSessions[arg0].timedOut = true;
+
+    Event_post(oadServerParams.eventHandle, oadServerParams.eventBit);
 }
 
 /*!
- * @brief      Image block request callback from OAD module
+ * @brief      Get the session of a node, NULL if it has none
  */
-static void oadBlockReqCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint16_t multiBlockSize)
+static OADServer_Session_t* oadSessionFind(uint8_t addr)
 {
-    uint8_t blockBuf[OAD_BLOCK_SIZE] = {0};
-    (void) imgId;
+    uint8_t idx;
 
-    if(oadInProgress)
+    for(idx = 0; idx < OADServer_MAX_SESSIONS; idx++)
     {
-        ConcentratorTask_updateNodeOadBlock((uint8_t) *((uint8_t*) pSrcAddr), blockNum);
+        if(oadSessions[idx].inUse && (oadSessions[idx].addr == addr))
+        {
+            return &oadSessions[idx];
+        }
+    }
 
-        /* read a block from Flash */
-        OADStorage_imgBlockRead(blockNum, blockBuf);
+    return NULL;
+}
 
-        /* hard code imgId to 0 - its not used in this
-         * implementation as there is only 1 image available
-         */
-        OADProtocol_sendOadImgBlockRsp(pSrcAddr, 0, blockNum, blockBuf);
+/*!
+ * @brief      Start a session for a node, NULL if all are in use
+ */
+static OADServer_Session_t* oadSessionAlloc(uint8_t addr)
+{
+    uint8_t idx;
 
-        if(blockNum == oadBNumBlocks - 1)
+    for(idx = 0; idx < OADServer_MAX_SESSIONS; idx++)
+    {
+        if(!oadSessions[idx].inUse)
         {
-            /* OAD complete */
-            oadInProgress = false;
-            OADStorage_close();
-
-            ConcentratorTask_updateNodeOadStatus(ConcentratorTask_NodeOadStatus_Completed);
+            oadSessions[idx].inUse = true;
+            oadSessions[idx].addr = addr;
+            oadSessions[idx].imgType = OADServer_IMG_TYPE_NONE;
+            oadSessions[idx].imgId = 0;
+            oadSessions[idx].numBlocks = 0;
+            oadSessions[idx].pushNext = 0;
+            oadSessions[idx].pushBurst = OADProtocol_MULTI_BLOCK_MAX_SIZE;
+            oadSessions[idx].identified = false;
+            oadSessions[idx].identifyRetries = 0;
+            oadSessions[idx].timedOut = false;
+
+            return &oadSessions[idx];
         }
-        else
-        {
-            /* restart timeout in case of abort */
-            Clock_stop(oadAbortTimeoutClockHandle);
+    }
 
-            /* give 500ms grace*/
-            Clock_setTimeout(oadAbortTimeoutClockHandle,
-                    (500 + OADProtocol_BLOCK_REQ_RATE * OADProtocol_MAX_RETRIES) * 1000 / Clock_tickPeriod);
+    return NULL;
+}
 
-            /* start timer */
-            Clock_start(oadAbortTimeoutClockHandle);
-        }
+/*!
+ * @brief      End the session of a node, the storage is closed with the last one
+ */
+static void oadSessionEnd(OADServer_Session_t *pSession, ConcentratorTask_NodeOadStatus_t status)
+{
+    Clock_stop(oadAbortTimeoutClockHandle[pSession - oadSessions]);
+    pSession->inUse = false;
+    pSession->timedOut = false;
+
+    /* abort pending messages to the node, when refused they still go out and
+     * the node drops them, it has no session any more */
+    if(status == ConcentratorTask_NodeOadStatus_Aborted)
+    {
+        (void)ConcentratorRadioTask_abortNodeMsgFor(pSession->addr);
+    }
+
+    if(OADServer_getNumSessions() == 0)
+    {
+        OADStorage_close();
+        oadStorageImgType = OADServer_IMG_TYPE_NONE;
     }
+
+    ConcentratorTask_updateNodeOadStatus(pSession->addr, status);
 }
 
 /*!
- * @brief      Radio access function for OAD module to send messages
+ * @brief      End the sessions whose abort timer expired, or send the image
+ *             identify again to a node that did not respond
  */
-void* oadRadioAccessAllocMsg(uint32_t msgLen)
+static void oadSessionEndTimedOut(void)
 {
-    uint8_t *msgBuffer;
+    uint8_t idx;
 
-    /*
-     * Allocate with 2 byte before the oad msg buffer for
-     * addr and packet ID.
-     */
-    msgBuffer = (uint8_t*) malloc(msgLen + 2);
-    if(msgBuffer == NULL)
+    for(idx = 0; idx < OADServer_MAX_SESSIONS; idx++)
     {
-        return NULL;
+        if(oadSessions[idx].inUse && oadSessions[idx].timedOut)
+        {
+            if(!oadSessions[idx].identified &&
+               (oadSessions[idx].identifyRetries < OADServer_IDENTIFY_MAX_RETRIES))
+            {
+                oadSessions[idx].identifyRetries++;
+                oadSessionRetryIdentify(&oadSessions[idx]);
+            }
+            else
+            {
+                oadSessionEnd(&oadSessions[idx], ConcentratorTask_NodeOadStatus_Aborted);
+            }
+        }
     }
-    memset(msgBuffer, 0, msgLen + 2);
+}
 
-    return msgBuffer + 2;
+/*!
+ * @brief      Setup OADStorage to read the image of a session
+ */
+static void oadSessionSelectImg(OADServer_Session_t *pSession)
+{
+    OADTarget_ImgHdr_t imgHdr;
+
+    if(oadStorageImgType != pSession->imgType)
+    {
+        OADStorage_imgIdentifyRead(pSession->imgType, &imgHdr);
+        oadStorageImgType = pSession->imgType;
+    }
 }
 
 /*!
- * @brief      Radio access function for OAD module to send messages
+ * @brief      Setup OADStorage to read the remote app image for a session and
+ *             send the node its image identify, compressed if there is a
+ *             compressed image and the node did not reject it
+ *
+ * @return     blocks in image, 0 if it can not be read
  */
-static OADProtocol_Status_t oadRadioAccessPacketSend(void* pDstAddr, uint8_t *pMsgPayload, uint32_t msgLen)
+static uint16_t oadSessionIdentifyImg(OADServer_Session_t *pSession)
 {
-    OADProtocol_Status_t status = OADProtocol_Failed;
-    uint8_t* pMsg;
+    OADTarget_ImgHdr_t remoteImgHdr;
+    uint8_t imgInfo[16];
 
-    /*
-     * buffer should have been allocated with oadRadioAccessAllocMsg,
-     * so 2 byte before the oad msg buffer was allocated for the source
-     * addr and Packet ID. Source addr will be filled in by
-     * ConcentratorRadioTask_sendNodeMsg
-     */
-    pMsg = pMsgPayload - 2;
-    pMsg[RADIO_PACKET_PKTTYPE_OFFSET] = RADIO_PACKET_TYPE_OAD_PACKET;
+    pSession->numBlocks = 0;
+
+    if(!(getNodeImgIdRejected(pSession->addr) & OADProtocol_IMG_ID_COMPRESSED))
+    {
+        pSession->numBlocks = compressedImgIdentifyRead(imgInfo);
+    }
 
-    ConcentratorRadioTask_sendNodeMsg( (uint8_t*) pDstAddr, pMsg, msgLen + 2);
+    if(pSession->numBlocks != 0)
+    {
+        pSession->imgType = EFL_OAD_IMG_TYPE_COMPRESSED;
+        pSession->imgId = OADProtocol_IMG_ID_COMPRESSED;
+    }
+    else
+    {
+        /* get num blocks and setup OADStorage to read remote image region */
+        pSession->imgType = EFL_OAD_IMG_TYPE_REMOTE_APP;
+        pSession->imgId = 0;
+        pSession->numBlocks = OADStorage_imgIdentifyRead(EFL_OAD_IMG_TYPE_REMOTE_APP, &remoteImgHdr);
+        oadStorageImgType = EFL_OAD_IMG_TYPE_REMOTE_APP;
+
+        if(pSession->numBlocks == 0)
+        {
+            return 0;
+        }
+
+        OADStorage_imgInfoRead(imgInfo);
+    }
+
+    OADProtocol_sendImgIdentifyReq(&pSession->addr, pSession->imgId, imgInfo);
+    oadStartIdentifyTimeout(pSession);
+
+    return pSession->numBlocks;
+}
+
+/*!
+ * @brief      Queue the image identify of a session again, in place of the
+ *             one the node has not heard yet or whose response was lost
+ */
+static void oadSessionRetryIdentify(OADServer_Session_t *pSession)
+{
+    uint8_t imgInfo[16];
 
-    //free the memory allocated in oadRadioAccessAllocMsg
-    free(pMsg);
+    (void)ConcentratorRadioTask_abortNodeMsgFor(pSession->addr);
+
+    if(pSession->imgType == EFL_OAD_IMG_TYPE_DELTA)
+    {
+        if(deltaImgIdentifyRead(getNodeFwVersion(pSession->addr), imgInfo) != 0)
+        {
+            OADProtocol_sendImgIdentifyReq(&pSession->addr, pSession->imgId, imgInfo);
+            oadStartIdentifyTimeout(pSession);
+            return;
+        }
+    }
+    else if(oadSessionIdentifyImg(pSession) != 0)
+    {
+        return;
+    }
+
+    oadSessionEnd(pSession, ConcentratorTask_NodeOadStatus_Aborted);
+}
+
+/*!
+ * @brief      Share the radio TX queue between the sessions, a node asking
+ *             for a larger window gets the rest of it on its next request
+ */
+static uint16_t oadSessionWindowSize(uint16_t multiBlockSize)
+{
+    uint16_t maxSize = OADProtocol_MULTI_BLOCK_MAX_SIZE / OADServer_getNumSessions();
+
+    if(maxSize == 0)
+    {
+        maxSize = 1;
+    }
+
+    return (multiBlockSize > maxSize) ? maxSize : multiBlockSize;
+}
+
+
+/*!
+ * @brief      Get next block of available FW image from UART
+ */
+static void getNextBlock(uint16_t blkNum, uint8_t* oadBlockBuff)
+{
+    uint8_t blkNumLower = blkNum & 0xFF;
+    uint8_t blkNumUpper = (blkNum & 0xFF00) >> 8;
+
+    UART_write(uartHandle, &blkNumUpper, 1);
+    UART_write(uartHandle, &blkNumLower, 1);
+
+    UART_read(uartHandle, oadBlockBuff, (OAD_BLOCK_SIZE + 2));
+}
+
+/*!
+ * @brief      Answer the hello of a windowed UART upload, switch baud rate
+ *             and request the first window
+ */
+static void uartIngestStart(uint8_t *pHello)
+{
+    UART_Params uartParams;
+    uint8_t imgMetaData[16];
+    uint8_t rsp[12];
+
+    uartIngestBaud = OADTarget_BUILD_UINT32(pHello[4], pHello[5], pHello[6], pHello[7]);
+    if((uartIngestBaud == 0) || (uartIngestBaud > OADServer_UART_MAX_BAUD))
+    {
+        uartIngestBaud = OADServer_UART_MAX_BAUD;
+    }
+
+    /* get image header */
+    UART_read(uartHandle, imgMetaData, 16);
+
+    oadBNumBlocks = OADStorage_imgIdentifyWrite(imgMetaData);
+
+    rsp[0] = OADTarget_BREAK_UINT32(OADServer_UART_MAGIC, 0);
+    rsp[1] = OADTarget_BREAK_UINT32(OADServer_UART_MAGIC, 1);
+    rsp[2] = OADTarget_BREAK_UINT32(OADServer_UART_MAGIC, 2);
+    rsp[3] = OADTarget_BREAK_UINT32(OADServer_UART_MAGIC, 3);
+    rsp[4] = OADTarget_BREAK_UINT32(uartIngestBaud, 0);
+    rsp[5] = OADTarget_BREAK_UINT32(uartIngestBaud, 1);
+    rsp[6] = OADTarget_BREAK_UINT32(uartIngestBaud, 2);
+    rsp[7] = OADTarget_BREAK_UINT32(uartIngestBaud, 3);
+    rsp[8] = OADTarget_LO_UINT16(oadBNumBlocks);
+    rsp[9] = OADTarget_HI_UINT16(oadBNumBlocks);
+    rsp[10] = OADServer_UART_WINDOW_SIZE;
+    rsp[11] = OAD_BLOCK_SIZE;
+    UART_write(uartHandle, rsp, sizeof(rsp));
+
+    /* let the response drain before switching baud rate */
+    Task_sleep(10000 / Clock_tickPeriod);
+    UART_close(uartHandle);
+
+    /* windows are read in the background while the last one is written */
+    UART_Params_init(&uartParams);
+    uartParams.writeDataMode = UART_DATA_BINARY;
+    uartParams.readDataMode = UART_DATA_BINARY;
+    uartParams.readReturnMode = UART_RETURN_FULL;
+    uartParams.readEcho = UART_ECHO_OFF;
+    uartParams.readMode = UART_MODE_CALLBACK;
+    uartParams.readCallback = uartIngestReadCallback;
+    uartParams.baudRate = uartIngestBaud;
+    uartHandle = UART_open(Board_UART0, &uartParams);
+
+    oadInProgress = true;
+    uartIngestWindowed = true;
+    uartIngestBase = 0;
+    uartIngestBitmap = 0;
+
+    /* an interrupted upload of the same image resumes where it stopped */
+    uartIngestMoveWindow();
+
+    if((oadBNumBlocks == 0) || (uartIngestBase >= oadBNumBlocks))
+    {
+        /* issue with image header, or the image is already stored */
+        uartIngestFinish();
+    }
+    else
+    {
+        uartIngestRequestWindow();
+    }
+}
+
+/*!
+ * @brief      Write the window of a windowed UART upload that arrived and
+ *             request the next one
+ */
+static void uartIngestNext(void)
+{
+    uint8_t *pFrames = uartIngestBuf[uartIngestBufIdx];
+    uint16_t accepted = 0;
+    uint16_t numFrames;
+    uint16_t frame;
+
+    if(!uartIngestReadDone)
+    {
+        if(uartIngestTimedOut)
+        {
+            /* calls back with the bytes read so far */
+            uartIngestTimedOut = false;
+            UART_readCancel(uartHandle);
+        }
+        return;
+    }
+
+    Clock_stop(uartIngestTimeoutClockHandle);
+    uartIngestReadDone = false;
+    uartIngestTimedOut = false;
+
+    numFrames = uartIngestReadCount / OADServer_UART_FRAME_LEN;
+
+    for(frame = 0; frame < numFrames; frame++)
+    {
+        uint8_t *pFrame = &pFrames[frame * OADServer_UART_FRAME_LEN];
+        uint16_t blkNum = OADTarget_BUILD_UINT16(pFrame[0], pFrame[1]);
+        uint16_t pageStart = blkNum - (blkNum % (EFL_PAGE_SIZE / OAD_BLOCK_SIZE));
+        uint8_t check = 0;
+        uint8_t idx;
+
+        for(idx = 0; idx < OADServer_UART_FRAME_LEN; idx++)
+        {
+            check ^= pFrame[idx];
+        }
+
+        if((check != 0) || (blkNum < uartIngestBase) || (blkNum >= oadBNumBlocks) ||
+           (blkNum >= uartIngestBase + OADServer_UART_WINDOW_SIZE) ||
+           (uartIngestBitmap & (1 << (blkNum - uartIngestBase))))
+        {
+            continue;
+        }
+
+        /*
+         * Writing the first block of a page erases it, so the other blocks
+         * of the page are only taken once the first one is written.
+         */
+        if((pageStart != blkNum) && (pageStart >= uartIngestBase) &&
+           !(uartIngestBitmap & (1 << (pageStart - uartIngestBase))))
+        {
+            continue;
+        }
+
+        uartIngestBitmap |= 1 << (blkNum - uartIngestBase);
+        accepted |= 1 << frame;
+    }
+
+    /* move the window to the first missing block */
+    uartIngestMoveWindow();
+
+    /* the next window arrives in the other buffer while this one is written */
+    if(uartIngestBase < oadBNumBlocks)
+    {
+        uartIngestBufIdx ^= 1;
+        uartIngestRequestWindow();
+    }
+
+    for(frame = 0; frame < numFrames; frame++)
+    {
+        if(accepted & (1 << frame))
+        {
+            uint8_t *pFrame = &pFrames[frame * OADServer_UART_FRAME_LEN];
+
+            OADStorage_imgBlockWrite(OADTarget_BUILD_UINT16(pFrame[0], pFrame[1]), &pFrame[2]);
+        }
+    }
+
+    if(uartIngestBase >= oadBNumBlocks)
+    {
+        uartIngestFinish();
+    }
+}
+
+/*!
+ * @brief      Move the window of a windowed UART upload to the first block
+ *             missing, blocks stored before an interruption are not requested
+ */
+static void uartIngestMoveWindow(void)
+{
+    bool moved;
+    uint16_t blkNum;
+
+    do
+    {
+        for(blkNum = uartIngestBase;
+            (blkNum < uartIngestBase + OADServer_UART_WINDOW_SIZE) && (blkNum < oadBNumBlocks);
+            blkNum++)
+        {
+            if(OADStorage_imgBlockPresent(blkNum))
+            {
+                uartIngestBitmap |= 1 << (blkNum - uartIngestBase);
+            }
+        }
+
+        moved = false;
+        while((uartIngestBase < oadBNumBlocks) && (uartIngestBitmap & 1))
+        {
+            uartIngestBitmap >>= 1;
+            uartIngestBase++;
+            moved = true;
+        }
+    } while(moved);
+}
+
+/*!
+ * @brief      Start reading the missing blocks of the window and request them
+ */
+static void uartIngestRequestWindow(void)
+{
+    uint16_t missing = 0;
+    uint32_t timeoutMs;
+    uint16_t blkNum;
+    uint8_t req[5];
+
+    for(blkNum = uartIngestBase;
+        (blkNum < uartIngestBase + OADServer_UART_WINDOW_SIZE) && (blkNum < oadBNumBlocks);
+        blkNum++)
+    {
+        if(!(uartIngestBitmap & (1 << (blkNum - uartIngestBase))))
+        {
+            missing++;
+        }
+    }
+
+    UART_read(uartHandle, uartIngestBuf[uartIngestBufIdx], missing * OADServer_UART_FRAME_LEN);
+
+    /* 10 bits per byte on the line */
+    timeoutMs = OADServer_UART_TIMEOUT_MS +
+                (missing * OADServer_UART_FRAME_LEN * 10 * 1000) / uartIngestBaud;
+    Clock_setTimeout(uartIngestTimeoutClockHandle, timeoutMs * 1000 / Clock_tickPeriod);
+    Clock_start(uartIngestTimeoutClockHandle);
+
+    req[0] = OADServer_UART_REQ;
+    req[1] = OADTarget_LO_UINT16(uartIngestBase);
+    req[2] = OADTarget_HI_UINT16(uartIngestBase);
+    req[3] = OADTarget_LO_UINT16(uartIngestBitmap);
+    req[4] = OADTarget_HI_UINT16(uartIngestBitmap);
+    UART_write(uartHandle, req, sizeof(req));
+}
+
+/*!
+ * @brief      Check the uploaded image and end the windowed UART upload
+ */
+static void uartIngestFinish(void)
+{
+    OADStorage_Status_t status = OADStorage_Failed;
+    uint8_t done[5] = {OADServer_UART_DONE, 0, 0, 0, 0};
+
+    /*
+     * Check that CRC is correct and mark the image as new
+     * image to be booted in to by BIM on next reset
+     */
+    if(oadBNumBlocks != 0)
+    {
+        status = OADStorage_imgFinalise();
+    }
+
+    done[1] = (uint8_t)status;
+    UART_write(uartHandle, done, sizeof(done));
+
+    /* Close resources */
+    OADStorage_close();
+    UART_close(uartHandle);
+
+    uartIngestWindowed = false;
+    oadInProgress = false;
+
+    ConcentratorTask_updateAvailableFWVer(status == OADStorage_Status_Success);
+}
+
+/*!
+ * @brief      Windowed UART upload read callback
+ */
+static void uartIngestReadCallback(UART_Handle handle, void *buf, size_t count)
+{
+    uartIngestReadCount = count;
+    uartIngestReadDone = true;
+
+    Event_post(oadServerParams.eventHandle, oadServerParams.eventBit);
+}
+
+/*!
+ * @brief      Windowed UART upload timeout callback
+ */
+static void uartIngestTimeoutCallback(UArg arg0)
+{
+    /* the window may have completed just before */
+    if(!uartIngestReadDone)
+    {
+        uartIngestTimedOut = true;
+
+        Event_post(oadServerParams.eventHandle, oadServerParams.eventBit);
+    }
+}
+
+/*!
+ * @brief      FW version response callback from OAD module
+ */
+static void fwVersionRspCb(void* pSrcAddr, char *fwVersionStr)
+{
+    setNodeFwVersion((uint8_t) *((uint8_t*) pSrcAddr), parseFwVersion(fwVersionStr));
+
+    ConcentratorTask_updateNodeFWVer((uint8_t) *((uint8_t*) pSrcAddr), fwVersionStr);
+}
+
+/*!
+ * @brief      Get the image version from a "rfWsnNode vMM.mm.00" string, 0 if none
+ */
+static uint16_t parseFwVersion(char *fwVersionStr)
+{
+    uint8_t major = 0;
+    uint8_t minor = 0;
+    uint8_t idx = 0;
+
+    /* find the version */
+    while((idx < OADProtocol_FW_VERSION_STR_LEN) && (fwVersionStr[idx] != 'v'))
+    {
+        if(fwVersionStr[idx] == '\0')
+        {
+            return 0;
+        }
+        idx++;
+    }
+
+    for(idx++; (idx < OADProtocol_FW_VERSION_STR_LEN) &&
+               (fwVersionStr[idx] >= '0') && (fwVersionStr[idx] <= '9'); idx++)
+    {
+        major = (major * 10) + (fwVersionStr[idx] - '0');
+    }
+
+    if((idx >= OADProtocol_FW_VERSION_STR_LEN) || (fwVersionStr[idx] != '.'))
+    {
+        return 0;
+    }
+
+    for(idx++; (idx < OADProtocol_FW_VERSION_STR_LEN) &&
+               (fwVersionStr[idx] >= '0') && (fwVersionStr[idx] <= '9'); idx++)
+    {
+        minor = (minor * 10) + (fwVersionStr[idx] - '0');
+    }
+
+    return ((uint16_t)major << 8) | minor;
+}
+
+/*!
+ * @brief      Remember the FW version a node reported
+ */
+static void setNodeFwVersion(uint8_t addr, uint16_t ver)
+{
+    uint8_t idx;
+
+    for(idx = 0; idx < OADServer_MAX_NODE_FW_VERSIONS; idx++)
+    {
+        if(nodeFwVersions[idx].addr == addr)
+        {
+            /* other FW may take other image formats */
+            if(nodeFwVersions[idx].ver != ver)
+            {
+                nodeFwVersions[idx].imgIdRejected = 0;
+            }
+
+            nodeFwVersions[idx].ver = ver;
+            return;
+        }
+    }
+
+    /* replace the oldest entry */
+    nodeFwVersions[nodeFwVersionsNext].addr = addr;
+    nodeFwVersions[nodeFwVersionsNext].ver = ver;
+    nodeFwVersions[nodeFwVersionsNext].imgIdRejected = 0;
+    nodeFwVersionsNext = (nodeFwVersionsNext + 1) % OADServer_MAX_NODE_FW_VERSIONS;
+}
+
+/*!
+ * @brief      Get the FW version a node reported, 0 if unknown
+ */
+static uint16_t getNodeFwVersion(uint8_t addr)
+{
+    uint8_t idx;
+
+    for(idx = 0; idx < OADServer_MAX_NODE_FW_VERSIONS; idx++)
+    {
+        if((nodeFwVersions[idx].addr == addr) && (nodeFwVersions[idx].ver != 0))
+        {
+            return nodeFwVersions[idx].ver;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * @brief      Remember the image formats a node rejected
+ */
+static void setNodeImgIdRejected(uint8_t addr, uint8_t imgId)
+{
+    uint8_t idx;
+
+    imgId &= (OADProtocol_IMG_ID_DELTA | OADProtocol_IMG_ID_COMPRESSED);
+
+    for(idx = 0; idx < OADServer_MAX_NODE_FW_VERSIONS; idx++)
+    {
+        if(nodeFwVersions[idx].addr == addr)
+        {
+            nodeFwVersions[idx].imgIdRejected |= imgId;
+            return;
+        }
+    }
+
+    /* replace the oldest entry, the FW version is not known */
+    nodeFwVersions[nodeFwVersionsNext].addr = addr;
+    nodeFwVersions[nodeFwVersionsNext].ver = 0;
+    nodeFwVersions[nodeFwVersionsNext].imgIdRejected = imgId;
+    nodeFwVersionsNext = (nodeFwVersionsNext + 1) % OADServer_MAX_NODE_FW_VERSIONS;
+}
+
+/*!
+ * @brief      Get the image formats a node rejected
+ */
+static uint8_t getNodeImgIdRejected(uint8_t addr)
+{
+    uint8_t idx;
+
+    for(idx = 0; idx < OADServer_MAX_NODE_FW_VERSIONS; idx++)
+    {
+        if(nodeFwVersions[idx].addr == addr)
+        {
+            return nodeFwVersions[idx].imgIdRejected;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * @brief      Setup OADStorage to read the delta patch if it applies to the
+ *             node FW and builds the available remote app image
+ *
+ * @return     blocks in the patch, 0 if no usable patch
+ */
+static uint16_t deltaImgIdentifyRead(uint16_t nodeVer, uint8_t *pImgInfo)
+{
+    OADTarget_ImgHdr_t remoteImgHdr;
+    OADTarget_ImgHdr_t deltaImgHdr;
+    uint8_t patchHdr[OAD_BLOCK_SIZE];
+    uint16_t numBlocks;
+
+    if(nodeVer == 0)
+    {
+        return 0;
+    }
+
+    /* the patch must build the image that is available */
+    OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_REMOTE_APP, &remoteImgHdr);
+    OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_DELTA, &deltaImgHdr);
+
+    if((deltaImgHdr.len == 0) || (deltaImgHdr.len == 0xFFFF) ||
+       (deltaImgHdr.ver != remoteImgHdr.ver))
+    {
+        return 0;
+    }
+
+    numBlocks = OADStorage_imgIdentifyRead(EFL_OAD_IMG_TYPE_DELTA, &deltaImgHdr);
+
+    if(numBlocks == 0)
+    {
+        return 0;
+    }
+
+    oadStorageImgType = EFL_OAD_IMG_TYPE_DELTA;
+
+    /* patch header is in the first block */
+    OADStorage_imgBlockRead(0, patchHdr);
+
+    /* storage is setup for the full image next, or closed with the session */
+    if(OADTarget_BUILD_UINT16(patchHdr[OADDelta_BASE_VER_OSET],
+                              patchHdr[OADDelta_BASE_VER_OSET + 1]) != nodeVer)
+    {
+        return 0;
+    }
+
+    memcpy(pImgInfo, &patchHdr[OADDelta_NEW_IMG_INFO_OSET], 16);
+
+    return numBlocks;
+}
+
+/*!
+ * @brief      Setup OADStorage to read the compressed image if it holds the
+ *             available remote app image, which stays for the nodes that
+ *             reject it
+ *
+ * @return     blocks in the compressed image, 0 if no usable one
+ */
+static uint16_t compressedImgIdentifyRead(uint8_t *pImgInfo)
+{
+    OADTarget_ImgHdr_t remoteImgHdr;
+    OADTarget_ImgHdr_t compressedImgHdr;
+    uint8_t firstBlock[OAD_BLOCK_SIZE];
+    uint16_t numBlocks;
+
+    OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_REMOTE_APP, &remoteImgHdr);
+    OADTarget_getImageHeader(EFL_OAD_IMG_TYPE_COMPRESSED, &compressedImgHdr);
+
+    if((remoteImgHdr.len == 0) || (remoteImgHdr.len == 0xFFFF) ||
+       (compressedImgHdr.len == 0) || (compressedImgHdr.len == 0xFFFF) ||
+       (compressedImgHdr.ver != remoteImgHdr.ver))
+    {
+        return 0;
+    }
+
+    numBlocks = OADStorage_imgIdentifyRead(EFL_OAD_IMG_TYPE_COMPRESSED, &compressedImgHdr);
+
+    if(numBlocks == 0)
+    {
+        return 0;
+    }
+
+    oadStorageImgType = EFL_OAD_IMG_TYPE_COMPRESSED;
+
+    /* header of the image is in the first block */
+    OADStorage_imgBlockRead(0, firstBlock);
+
+    /* storage is setup for the full image next, or closed with the session */
+    if(!OADCompress_isCompressed(firstBlock))
+    {
+        return 0;
+    }
+
+    memcpy(pImgInfo, &firstBlock[OADCompress_IMG_INFO_OSET], 16);
+
+    return numBlocks;
+}
+
+/*!
+ * @brief      Image Identify response callback from OAD module
+ */
+static void oadImgIdentifyRspCb(void* pSrcAddr, uint8_t imgId, uint8_t status, uint16_t resumeBlock)
+{
+    OADServer_Session_t *pSession = oadSessionFind((uint8_t) *((uint8_t*) pSrcAddr));
+
+    /* a response repeated for an image the session no longer sends is stale */
+    if((pSession == NULL) || (imgId != pSession->imgId))
+    {
+        return;
+    }
+
+    if(!status)
+    {
+        /* the node rejected the image, it is not sent the format again */
+        setNodeImgIdRejected(pSession->addr, pSession->imgId);
+
+        /* a rejected patch or compressed image falls back to the full image,
+         * its blocks still queued are dropped and the node is identified anew */
+        if(pSession->imgId & (OADProtocol_IMG_ID_DELTA | OADProtocol_IMG_ID_COMPRESSED))
+        {
+            (void)ConcentratorRadioTask_abortNodeMsgFor(pSession->addr);
+            pSession->identified = false;
+            pSession->identifyRetries = 0;
+        }
+        if((pSession->imgId & (OADProtocol_IMG_ID_DELTA | OADProtocol_IMG_ID_COMPRESSED)) &&
+           (oadSessionIdentifyImg(pSession) != 0))
+        {
+            ConcentratorTask_updateNodeOadTotalBlocks(pSession->addr, pSession->numBlocks);
+            return;
+        }
+
+        oadSessionEnd(pSession, ConcentratorTask_NodeOadStatus_Aborted);
+        return;
+    }
+
+    oadRestartAbortTimeout(pSession, OADServer_PUSH_ABORT_TIMEOUT_MS);
+
+    ConcentratorTask_updateNodeOadStatus(pSession->addr, ConcentratorTask_NodeOadStatus_InProgress);
+
+    /* an interrupted transfer resumes where it stopped */
+    if((resumeBlock != 0) && (resumeBlock < pSession->numBlocks))
+    {
+        ConcentratorTask_updateNodeOadBlock(pSession->addr, resumeBlock);
+    }
+}
+
+/*!
+ * @brief      Image block request callback from OAD module
+ */
+static void oadBlockReqCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint16_t multiBlockSize)
+{
+    uint8_t blockBuf[OAD_BLOCK_SIZE] = {0};
+    OADServer_Session_t *pSession = oadSessionFind((uint8_t) *((uint8_t*) pSrcAddr));
+    (void) imgId;
+
+    if((pSession != NULL) && (blockNum < pSession->numBlocks))
+    {
+        ConcentratorTask_updateNodeOadBlock(pSession->addr, blockNum);
+
+        /* read a block from Flash */
+        oadSessionSelectImg(pSession);
+        OADStorage_imgBlockRead(blockNum, blockBuf);
+
+        /* the imgId of the identify, the node tells patch blocks by it */
+        OADProtocol_sendOadImgBlockRsp(pSrcAddr, pSession->imgId, blockNum, blockBuf);
+
+        /* read ahead while the block is sent */
+        if(blockNum + 1 < pSession->numBlocks)
+        {
+            OADStorage_imgBlockPrefetch(blockNum + 1, 1);
+        }
+
+        if(blockNum == pSession->numBlocks - 1)
+        {
+            /* OAD complete */
+            oadSessionEnd(pSession, ConcentratorTask_NodeOadStatus_Completed);
+        }
+        else
+        {
+            oadRestartAbortTimeout(pSession, OADServer_ABORT_TIMEOUT_MS);
+        }
+    }
+}
+
+/*!
+ * @brief      Image multi block request callback from OAD module
+ */
+static void oadMultiBlockReqCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint16_t multiBlockSize, uint16_t blockBitmap)
+{
+    uint8_t blockBuf[OAD_BLOCK_SIZE] = {0};
+    OADServer_Session_t *pSession = oadSessionFind((uint8_t) *((uint8_t*) pSrcAddr));
+    uint16_t blockIdx;
+    (void) imgId;
+
+    if(pSession != NULL)
+    {
+        /* a window starting past the last block acknowledges the whole image */
+        if(blockNum >= pSession->numBlocks)
+        {
+            /* OAD complete */
+            ConcentratorTask_updateNodeOadBlock(pSession->addr, pSession->numBlocks - 1);
+            oadSessionEnd(pSession, ConcentratorTask_NodeOadStatus_Completed);
+            return;
+        }
+
+        if(multiBlockSize > OADProtocol_MULTI_BLOCK_MAX_SIZE)
+        {
+            multiBlockSize = OADProtocol_MULTI_BLOCK_MAX_SIZE;
+        }
+
+        /* blocks of the other sessions are queued too */
+        multiBlockSize = oadSessionWindowSize(multiBlockSize);
+
+        ConcentratorTask_updateNodeOadBlock(pSession->addr, blockNum);
+
+        /* read the window from Flash at once, unless it was read ahead */
+        oadSessionSelectImg(pSession);
+        OADStorage_imgBlockPrefetch(blockNum, multiBlockSize);
+
+        /* stream every block of the window the node has not acknowledged */
+        for(blockIdx = 0; (blockIdx < multiBlockSize) && (blockNum + blockIdx < pSession->numBlocks); blockIdx++)
+        {
+            if(blockBitmap & (1 << blockIdx))
+            {
+                continue;
+            }
+
+            /* read a block from Flash */
+            OADStorage_imgBlockRead(blockNum + blockIdx, blockBuf);
+
+            /* the imgId of the identify, the node tells patch blocks by it */
+            OADProtocol_sendOadImgBlockRsp(pSrcAddr, pSession->imgId, blockNum + blockIdx, blockBuf);
+        }
+
+        /* read ahead the next window while this one is sent */
+        if(blockNum + multiBlockSize < pSession->numBlocks)
+        {
+            OADStorage_imgBlockPrefetch(blockNum + multiBlockSize, multiBlockSize);
+        }
+
+        oadRestartAbortTimeout(pSession, OADServer_ABORT_TIMEOUT_MS);
+    }
+}
+
+/*!
+ * @brief      Fountain status callback from OAD module
+ */
+static void oadFountainStatusCb(void* pSrcAddr, uint8_t imgId, uint8_t status, uint16_t decodedBlocks, uint16_t receivedSymbols)
+{
+    (void) imgId;
+    (void) receivedSymbols;
+
+    if(oadBroadcastInProgress)
+    {
+        ConcentratorTask_updateNodeOadBroadcast((uint8_t) *((uint8_t*) pSrcAddr), status, decodedBlocks);
+    }
+}
+
+/*!
+ * @brief      Push mode ack callback from OAD module, resends the blocks the
+ *             ack reports lost and pushes the next ones within the airtime
+ *             credit
+ */
+static void oadPushAckCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint32_t blockBitmap)
+{
+    uint8_t blockBuf[OAD_BLOCK_SIZE] = {0};
+    OADServer_Session_t *pSession = oadSessionFind((uint8_t) *((uint8_t*) pSrcAddr));
+    uint16_t maxBurst;
+    uint16_t blockIdx;
+    uint8_t numSent = 0;
+    bool lost = false;
+    (void) imgId;
+
+    if(pSession == NULL)
+    {
+        return;
+    }
+
+    /* an ack past the last block acknowledges the whole image */
+    if(blockNum >= pSession->numBlocks)
+    {
+        /* OAD complete */
+        ConcentratorTask_updateNodeOadBlock(pSession->addr, pSession->numBlocks - 1);
+        oadSessionEnd(pSession, ConcentratorTask_NodeOadStatus_Completed);
+        return;
+    }
+
+    /*
+     * blocks pushed after the bitmap are pushed again, the node
+     * may also have resumed past the blocks pushed so far
+     */
+    if(pSession->pushNext > blockNum + OADProtocol_PUSH_ACK_BITMAP_SIZE)
+    {
+        pSession->pushNext = blockNum + OADProtocol_PUSH_ACK_BITMAP_SIZE;
+    }
+    else if(pSession->pushNext < blockNum)
+    {
+        pSession->pushNext = blockNum;
+    }
+
+    /* the blocks pushed were sent after the previous ack, a missing one was lost */
+    for(blockIdx = blockNum; blockIdx < pSession->pushNext; blockIdx++)
+    {
+        if(!(blockBitmap & ((uint32_t)1 << (blockIdx - blockNum))))
+        {
+            lost = true;
+            break;
+        }
+    }
+
+    /* blocks of the other sessions are queued too */
+    maxBurst = oadSessionWindowSize(OADProtocol_MULTI_BLOCK_MAX_SIZE);
+
+    if(lost)
+    {
+        pSession->pushBurst = (pSession->pushBurst > 1) ? (pSession->pushBurst / 2) : 1;
+    }
+    else if(pSession->pushBurst < maxBurst)
+    {
+        pSession->pushBurst++;
+    }
+
+    if(pSession->pushBurst > maxBurst)
+    {
+        pSession->pushBurst = maxBurst;
+    }
+
+    ConcentratorTask_updateNodeOadBlock(pSession->addr, blockNum);
+
+    oadPushRefillCredit();
+    oadSessionSelectImg(pSession);
+
+    /* lost blocks first, they are below the ones not pushed yet */
+    for(blockIdx = blockNum; (blockIdx < blockNum + OADProtocol_PUSH_ACK_BITMAP_SIZE) &&
+                             (blockIdx < pSession->numBlocks) &&
+                             (numSent < pSession->pushBurst); blockIdx++)
+    {
+        if(blockBitmap & ((uint32_t)1 << (blockIdx - blockNum)))
+        {
+            continue;
+        }
+
+        if(oadPushCredit < OADServer_PUSH_BLOCK_AIRTIME_US)
+        {
+            /* the next ack pushes the rest */
+            break;
+        }
+
+        /* read a block from Flash */
+        OADStorage_imgBlockRead(blockIdx, blockBuf);
+
+        /* the imgId of the identify, the node tells patch blocks by it */
+        if(OADProtocol_sendOadImgBlockRsp(pSrcAddr, pSession->imgId, blockIdx, blockBuf) != OADProtocol_Status_Success)
+        {
+            /* TX queue full */
+            break;
+        }
+
+        oadPushCredit -= OADServer_PUSH_BLOCK_AIRTIME_US;
+        numSent++;
+
+        if(blockIdx >= pSession->pushNext)
+        {
+            pSession->pushNext = blockIdx + 1;
+        }
+    }
+
+    /* read ahead the next burst while this one is sent */
+    if(pSession->pushNext < pSession->numBlocks)
+    {
+        OADStorage_imgBlockPrefetch(pSession->pushNext, pSession->pushBurst);
+    }
+
+    oadRestartAbortTimeout(pSession, OADServer_PUSH_ABORT_TIMEOUT_MS);
+}
+
+/*!
+ * @brief      Add the airtime credit earned since the last refill
+ */
+static void oadPushRefillCredit(void)
+{
+    uint32_t ticks = Clock_getTicks();
+    uint32_t elapsedTicks = ticks - oadPushCreditTicks;
+
+    oadPushCreditTicks = ticks;
+
+    /* a long idle time fills the credit, and would overflow below */
+    if(elapsedTicks >= (uint32_t)OADServer_PUSH_BUDGET_MAX_MS * 1000 * 100 /
+                       OADServer_PUSH_BUDGET_PCT / Clock_tickPeriod)
+    {
+        oadPushCredit = (uint32_t)OADServer_PUSH_BUDGET_MAX_MS * 1000;
+        return;
+    }
+
+    oadPushCredit += elapsedTicks * Clock_tickPeriod * OADServer_PUSH_BUDGET_PCT / 100;
+
+    if(oadPushCredit > (uint32_t)OADServer_PUSH_BUDGET_MAX_MS * 1000)
+    {
+        oadPushCredit = (uint32_t)OADServer_PUSH_BUDGET_MAX_MS * 1000;
+    }
+}
+
+/*!
+ * @brief      Restart the OAD abort timer of a session after serving a block
+ *             request, the node is identified also when its response was lost
+ */
+static void oadRestartAbortTimeout(OADServer_Session_t *pSession, uint32_t timeoutMs)
+{
+    Clock_Handle clockHandle = oadAbortTimeoutClockHandle[pSession - oadSessions];
+
+    pSession->identified = true;
+
+    /* restart timeout in case of abort */
+    Clock_stop(clockHandle);
+    pSession->timedOut = false;
+
+    Clock_setTimeout(clockHandle, timeoutMs * 1000 / Clock_tickPeriod);
+
+    /* start timer */
+    Clock_start(clockHandle);
+}
+
+/*!
+ * @brief      Start the OAD abort timer of a session for the response to its
+ *             image identify
+ */
+static void oadStartIdentifyTimeout(OADServer_Session_t *pSession)
+{
+    Clock_Handle clockHandle = oadAbortTimeoutClockHandle[pSession - oadSessions];
+
+    Clock_stop(clockHandle);
+    pSession->timedOut = false;
+
+    Clock_setTimeout(clockHandle, OADServer_IDENTIFY_RETRY_MS * 1000 / Clock_tickPeriod);
+    Clock_start(clockHandle);
+}
+
+/*!
+ * @brief      Radio access function for OAD module to send messages
+ */
+void* oadRadioAccessAllocMsg(uint32_t msgLen)
+{
+    EasyLink_TxPacket *pPacket;
+
+    /*
+     * Take a TX packet from the radio message pool, the oad msg
+     * follows the packet header in its payload.
+     */
+    if(msgLen + RADIO_PACKET_PAYLOAD_OFFSET >= EASYLINK_MAX_DATA_LENGTH - 1)
+    {
+        return NULL;
+    }
+
+    pPacket = ConcentratorRadioTask_allocMsg();
+    if(pPacket == NULL)
+    {
+        return NULL;
+    }
+
+    return &pPacket->payload[RADIO_PACKET_PAYLOAD_OFFSET];
+}
+
+/*!
+ * @brief      Radio access function for OAD module to send messages
+ */
+static OADProtocol_Status_t oadRadioAccessPacketSend(void* pDstAddr, uint8_t *pMsgPayload, uint32_t msgLen)
+{
+    OADProtocol_Status_t status = OADProtocol_Failed;
+    EasyLink_TxPacket* pPacket;
+    bool queued;
+
+    /*
+     * buffer should have been allocated with oadRadioAccessAllocMsg,
+     * so it is the payload of a pool TX packet, after the packet
+     * header. The rest of the header will be filled in by
+     * ConcentratorRadioTask_queueNodeMsg
+     */
+    pPacket = (EasyLink_TxPacket*) (pMsgPayload - RADIO_PACKET_PAYLOAD_OFFSET -
+                                    offsetof(EasyLink_TxPacket, payload));
+    pPacket->payload[RADIO_PACKET_PKTTYPE_OFFSET] = RADIO_PACKET_TYPE_OAD_PACKET;
+
+    /* the packet is queued as it is and returns to the pool once sent */
+    if(*((uint8_t*) pDstAddr) == RADIO_BROADCAST_ADDRESS)
+    {
+        queued = ConcentratorRadioTask_queueBroadcastMsg(pPacket, msgLen + RADIO_PACKET_PAYLOAD_OFFSET);
+    }
+    else
+    {
+        queued = ConcentratorRadioTask_queueNodeMsg( (uint8_t*) pDstAddr, pPacket, msgLen + RADIO_PACKET_PAYLOAD_OFFSET);
+    }
+
+    if(queued)
+    {
+        status = OADProtocol_Status_Success;
+    }
 
     return status;
 }
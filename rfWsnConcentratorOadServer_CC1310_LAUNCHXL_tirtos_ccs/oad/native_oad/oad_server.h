@@ -56,6 +56,33 @@ extern "C"
 {
 #endif
 
+/** @brief Windowed UART image upload
+ *
+ *  Instead of the 16 byte image header, an uploader can send a 16 byte hello
+ *  (OADServer_UART_MAGIC, the 32b baud rate it asks for, 8 bytes 0xFF)
+ *  followed by the image header. The server answers at 115200 with
+ *  OADServer_UART_MAGIC, the 32b baud rate it accepted, the 16b number of
+ *  blocks, the window size and the block size, after which both switch to the
+ *  accepted baud rate.
+ *
+ *  The server then sends OADServer_UART_REQ frames holding the first missing
+ *  block and a 16b bitmap of the blocks of the window already received. The
+ *  uploader streams all other blocks of the window, each framed by its 16b
+ *  block number and followed by the XOR of the frame bytes. A request
+ *  repeated after OADServer_UART_TIMEOUT_MS asks again for the blocks that did
+ *  not arrive. Once the image is complete the server sends OADServer_UART_DONE
+ *  with the 8b OADStorage_Status_t of the image check.
+ *
+ *  Multi byte fields are little endian, server frames are 5 bytes.
+ */
+#define OADServer_UART_MAGIC            0x5744414F ///< "OADW"
+#define OADServer_UART_MAX_BAUD         921600  ///< Highest baud rate accepted
+#define OADServer_UART_WINDOW_SIZE      16      ///< Blocks per window, max 16
+#define OADServer_UART_FRAME_LEN        (OAD_BLOCK_SIZE + 3) ///< Block number, block and check byte
+#define OADServer_UART_TIMEOUT_MS       100     ///< Wait for a window on top of its transfer time
+#define OADServer_UART_REQ              0xA5    ///< Server frame requesting a window
+#define OADServer_UART_DONE             0x5A    ///< Server frame ending the upload
+
 /** @brief RF parameter struct
  *  RF parameters are used with the OADServer_open() and OADServer_Params_t() call.
  */
@@ -90,11 +117,43 @@ extern void OADServer_getFwVer(uint8_t dstAddr);
 */
 extern uint16_t OADServer_updateNodeFw(uint8_t dstAddr);
 
+/** @brief  Function to get the number of nodes being updated, several
+*           nodes can be updated at the same time
+*
+*  @return nodes being updated
+*/
+extern uint8_t OADServer_getNumSessions(void);
+
 /** @brief  Function to update available FW image
 *
 */
 void OADServer_updateAvailableFwVer(void);
 
+/** @brief  Function to start a fountain coded broadcast of the node FW
+*
+*  @return blocks in image, 0 if the broadcast could not start
+*/
+extern uint16_t OADServer_broadcastNodeFw(void);
+
+/** @brief  Function to stop the broadcast of the node FW
+*
+*/
+extern void OADServer_stopBroadcastNodeFw(void);
+
+/** @brief  Function to invite a node to the running broadcast
+*
+*  @param  dstAddr      Address of node
+*/
+extern void OADServer_inviteNodeFw(uint8_t dstAddr);
+
+/** @brief  Function to parse an OAD packet from a node, called from the
+*           concentrator task, which is the only one using the OAD storage
+*
+*  @param  srcAddr      Address of node
+*  @param  pPayload     OAD payload of the packet
+*/
+extern void OADServer_parseIncoming(uint8_t srcAddr, uint8_t *pPayload);
+
 /*********************************************************************
 *********************************************************************/
 
@@ -56,6 +56,7 @@
 #include <ti/sysbios/knl/Task.h>
 #include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/knl/Event.h>
+#include <ti/sysbios/knl/Clock.h>
 
 /* Drivers */
 #include <ti/drivers/rf/RF.h>
@@ -78,6 +79,7 @@
 #define RADIO_EVENT_ALL                  0xFFFFFFFF
 #define RADIO_EVENT_VALID_PACKET_RECEIVED      (uint32_t)(1 << 0)
 #define RADIO_EVENT_INVALID_PACKET_RECEIVED (uint32_t)(1 << 1)
+#define RADIO_EVENT_PHY_WINDOW           (uint32_t)(1 << 2)
 
 #define CONCENTRATORRADIO_MAX_RETRIES 2
 
@@ -103,15 +105,34 @@ static ConcentratorRadio_PacketReceivedCallback packetReceivedCallback;
 static union ConcentratorPacket latestRxPacket;
 static EasyLink_TxPacket txPacket;
 static struct AckPacket ackPacket;
+/* Downlink for the next ACK to a node, set by the concentrator task under Task_disable */
+static uint8_t ackDownlinkAddress;
+static uint8_t ackDownlinkLength;
+static uint8_t ackDownlink[RADIO_ACK_DOWNLINK_MAX_LENGTH];
+static bool ackDownlinkPending;
 static uint8_t concentratorAddress;
 static int8_t latestRssi;
 
+/* Clock for the PHY windows of the superframe */
+Clock_Struct phyWindowClock;     /* not static so you can see in ROV */
+static Clock_Handle phyWindowClockHandle;
+
+static const EasyLink_PhyType phyTypes[RADIO_PHY_COUNT] = RADIO_PHY_EASYLINK_TYPES;
+static uint8_t currentPhy = RADIO_PHY_BASE;
+static uint8_t nextPhy = RADIO_PHY_BASE;
+static volatile uint8_t phyMask = (1 << RADIO_PHY_BASE);
+
 
 /***** Prototypes *****/
 static void concentratorRadioTaskFunction(UArg arg0, UArg arg1);
 static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status);
 static void notifyPacketReceived(union ConcentratorPacket* latestRxPacket);
 static void sendAck(uint8_t latestSourceAddress);
+static void startReceive(void);
+static void setPhy(uint8_t phy);
+static uint8_t scheduledPhy(uint32_t* nextWindowMs);
+static uint32_t networkTimeMs(void);
+static void phyWindowClockCallback(UArg arg0);
 
 /* Pin driver handle */
 static PIN_Handle ledPinHandle;
@@ -139,6 +160,13 @@ void ConcentratorRadioTask_init(void) {
     Event_construct(&radioOperationEvent, &eventParam);
     radioOperationEventHandle = Event_handle(&radioOperationEvent);
 
+    /* Create the clock of the PHY windows, started by the task */
+    Clock_Params clkParams;
+    Clock_Params_init(&clkParams);
+    clkParams.startFlag = FALSE;
+    Clock_construct(&phyWindowClock, phyWindowClockCallback, 1, &clkParams);
+    phyWindowClockHandle = Clock_handle(&phyWindowClock);
+
     /* Create the concentrator radio protocol task */
     Task_Params_init(&concentratorRadioTaskParams);
     concentratorRadioTaskParams.stackSize = CONCENTRATORRADIO_TASK_STACK_SIZE;
@@ -151,16 +179,59 @@ void ConcentratorRadioTask_registerPacketReceivedCallback(ConcentratorRadio_Pack
     packetReceivedCallback = callback;
 }
 
+bool ConcentratorRadioTask_setAckDownlink(uint8_t address, uint8_t *data, uint8_t length)
+{
+    UInt key;
+
+    if ((length == 0) || (length > RADIO_ACK_DOWNLINK_MAX_LENGTH))
+    {
+        return false;
+    }
+
+    key = Task_disable();
+    if (ackDownlinkPending)
+    {
+        Task_restore(key);
+        return false;
+    }
+
+    memcpy(ackDownlink, data, length);
+    ackDownlinkAddress = address;
+    ackDownlinkLength = length;
+    ackDownlinkPending = true;
+    Task_restore(key);
+
+    return true;
+}
+
+void ConcentratorRadioTask_abortAckDownlink(void)
+{
+    UInt key;
+
+    key = Task_disable();
+    ackDownlinkPending = false;
+    Task_restore(key);
+}
+
+uint8_t ConcentratorRadioTask_getPhy(void)
+{
+    return currentPhy;
+}
+
+void ConcentratorRadioTask_setPhyMask(uint8_t mask)
+{
+    /* Takes effect at the next PHY window */
+    phyMask = mask | (1 << RADIO_PHY_BASE);
+}
+
 static void concentratorRadioTaskFunction(UArg arg0, UArg arg1)
 {
     // Initialize the EasyLink parameters to their default values
 	EasyLink_Params easyLink_params;
     EasyLink_Params_init(&easyLink_params);
 
-#ifdef DEFINED_RADIO_EASYLINK_MODULATION
-    // Change the modulation from the default found in easylink_config.h
-	easyLink_params.ui32ModType = DEFINED_RADIO_EASYLINK_MODULATION;
-#endif
+    /* Nodes start on the base PHY */
+    easyLink_params.ui32ModType = phyTypes[RADIO_PHY_BASE];
 	
     /* Initialize EasyLink */
 	if(EasyLink_init(&easyLink_params) != EasyLink_Status_Success){ 
@@ -179,15 +250,37 @@ static void concentratorRadioTaskFunction(UArg arg0, UArg arg1)
     /* Set up Ack packet */
     ackPacket.header.sourceAddress = concentratorAddress;
     ackPacket.header.packetType = RADIO_PACKET_TYPE_ACK_PACKET;
+    ackPacket.header.options = RADIO_PACKET_OPTIONS_RSSI;
 
     /* Enter receive */
-    if(EasyLink_receiveAsync(rxDoneCallback, 0) != EasyLink_Status_Success) {
-        System_abort("EasyLink_receiveAsync failed");
-    }
+    startReceive();
+
+    /* Start the PHY schedule */
+    Event_post(radioOperationEventHandle, RADIO_EVENT_PHY_WINDOW);
 
     while (1) {
         uint32_t events = Event_pend(radioOperationEventHandle, 0, RADIO_EVENT_ALL, BIOS_WAIT_FOREVER);
 
+        /* If a PHY window starts or ends */
+        if(events & RADIO_EVENT_PHY_WINDOW) {
+            uint32_t nextWindowMs;
+
+            nextPhy = scheduledPhy(&nextWindowMs);
+            Clock_setTimeout(phyWindowClockHandle, nextWindowMs * 1000 / Clock_tickPeriod);
+            Clock_start(phyWindowClockHandle);
+
+            /* Leave RX, it is restarted on the new PHY below */
+            if((nextPhy != currentPhy) && !(events & (RADIO_EVENT_VALID_PACKET_RECEIVED | RADIO_EVENT_INVALID_PACKET_RECEIVED))) {
+                EasyLink_abort();
+
+                /* The RX callback has run, a packet received meanwhile is still ACKed */
+                events |= Event_pend(radioOperationEventHandle, 0, RADIO_EVENT_VALID_PACKET_RECEIVED | RADIO_EVENT_INVALID_PACKET_RECEIVED, BIOS_NO_WAIT);
+                if(!(events & (RADIO_EVENT_VALID_PACKET_RECEIVED | RADIO_EVENT_INVALID_PACKET_RECEIVED))) {
+                    events |= RADIO_EVENT_INVALID_PACKET_RECEIVED;
+                }
+            }
+        }
+
         /* If valid packet received */
         if(events & RADIO_EVENT_VALID_PACKET_RECEIVED) {
 
@@ -198,9 +291,7 @@ static void concentratorRadioTaskFunction(UArg arg0, UArg arg1)
             notifyPacketReceived(&latestRxPacket);
 
             /* Go back to RX */
-            if(EasyLink_receiveAsync(rxDoneCallback, 0) != EasyLink_Status_Success) {
-                System_abort("EasyLink_receiveAsync failed");
-            }
+            startReceive();
 
 
             /* toggle Activity LED */
@@ -210,23 +301,56 @@ static void concentratorRadioTaskFunction(UArg arg0, UArg arg1)
         /* If invalid packet received */
         if(events & RADIO_EVENT_INVALID_PACKET_RECEIVED) {
             /* Go back to RX */
-            if(EasyLink_receiveAsync(rxDoneCallback, 0) != EasyLink_Status_Success) {
-                System_abort("EasyLink_receiveAsync failed");
-            }
+            startReceive();
         }
     }
 }
 
 static void sendAck(uint8_t latestSourceAddress) {
 	uint32_t absTime;
+    uint8_t downlinkLength = 0;
+    UInt key;
 
     /* Set destinationAdress, but use EasyLink layers destination adress capability */
     txPacket.dstAddr[0] = latestSourceAddress;
 
     /* Copy ACK packet to payload, skipping the destination adress byte.
      * Note that the EasyLink API will implcitily both add the length byte and the destination address byte. */
-    memcpy(txPacket.payload, &ackPacket.header, sizeof(ackPacket));
-    txPacket.len = sizeof(ackPacket);
+    ackPacket.rssi = latestRssi;
+    ackPacket.header.length = sizeof(ackPacket.rssi);
+    key = Task_disable();
+    if (ackDownlinkPending && (ackDownlinkAddress == latestSourceAddress))
+    {
+        /* Piggy-back the pending downlink on this ACK */
+        memcpy(ackPacket.downlink, ackDownlink, ackDownlinkLength);
+        downlinkLength = ackDownlinkLength;
+        ackDownlinkPending = false;
+    }
+    Task_restore(key);
+
+    if ((downlinkLength == 0) && ((currentPhy != RADIO_PHY_BASE) || (phyMask != (1 << RADIO_PHY_BASE))))
+    {
+        /* Keep the node on the window schedule, it drifts from our clock. Base
+         * PHY nodes need it too while windows are in use, to keep off them */
+        ackPacket.downlink[0] = RADIO_DOWNLINK_TYPE_TIME_SYNC;
+        downlinkLength = 5;
+    }
+
+    if (((ackPacket.downlink[0] == RADIO_DOWNLINK_TYPE_TIME_SYNC) && (downlinkLength >= 5)) ||
+        ((ackPacket.downlink[0] == RADIO_DOWNLINK_TYPE_PHY) && (downlinkLength >= 6)))
+    {
+        /* Stamp the time sync as late as possible, it ends the downlink */
+        uint32_t timeMs = networkTimeMs();
+        uint8_t  offset = downlinkLength - 4;
+        ackPacket.downlink[offset++] = (timeMs >> 24) & 0xFF;
+        ackPacket.downlink[offset++] = (timeMs >> 16) & 0xFF;
+        ackPacket.downlink[offset++] = (timeMs >>  8) & 0xFF;
+        ackPacket.downlink[offset++] = (timeMs      ) & 0xFF;
+    }
+    ackPacket.header.length += downlinkLength;
+
+    memcpy(txPacket.payload, &ackPacket.header, sizeof(struct PacketHeader) + ackPacket.header.length);
+    txPacket.len = sizeof(struct PacketHeader) + ackPacket.header.length;
 	
 	if(EasyLink_getAbsTime(&absTime) != EasyLink_Status_Success)
 	{ 
@@ -246,6 +370,97 @@ static void sendAck(uint8_t latestSourceAddress) {
     }
 }
 
+/* Enter RX, on the PHY of the current window */
+static void startReceive(void)
+{
+    if (nextPhy != currentPhy)
+    {
+        setPhy(nextPhy);
+    }
+
+    if(EasyLink_receiveAsync(rxDoneCallback, 0) != EasyLink_Status_Success) {
+        System_abort("EasyLink_receiveAsync failed");
+    }
+}
+
+/* Switch PHY, keeping the frequency and the address filter */
+static void setPhy(uint8_t phy)
+{
+    EasyLink_Params easyLink_params;
+    uint32_t frequency = EasyLink_getFrequency();
+
+    EasyLink_Params_init(&easyLink_params);
+    easyLink_params.ui32ModType = phyTypes[phy];
+    if(EasyLink_init(&easyLink_params) != EasyLink_Status_Success) {
+        System_abort("EasyLink_init failed");
+    }
+
+    EasyLink_setFrequency(frequency);
+    EasyLink_enableRxAddrFilter(&concentratorAddress, 1, 1);
+
+    currentPhy = phy;
+}
+
+/* PHY to listen on now, the fast and long range PHYs only in their window when in use */
+static uint8_t scheduledPhy(uint32_t* nextWindowMs)
+{
+    static const uint32_t boundaries[] = {
+        RADIO_PHY_FAST_WINDOW_START_MS, RADIO_PHY_FAST_WINDOW_START_MS + RADIO_PHY_FAST_WINDOW_MS,
+        RADIO_PHY_LONG_RANGE_WINDOW_START_MS, RADIO_PHY_LONG_RANGE_WINDOW_START_MS + RADIO_PHY_LONG_RANGE_WINDOW_MS
+    };
+    uint32_t position = networkTimeMs() % RADIO_PHY_SUPERFRAME_MS;
+    uint32_t i;
+
+    *nextWindowMs = RADIO_PHY_SUPERFRAME_MS;
+    for (i = 0; i < sizeof(boundaries) / sizeof(boundaries[0]); i++)
+    {
+        uint32_t delay = (boundaries[i] + RADIO_PHY_SUPERFRAME_MS - position) % RADIO_PHY_SUPERFRAME_MS;
+        if ((delay != 0) && (delay < *nextWindowMs))
+        {
+            *nextWindowMs = delay;
+        }
+    }
+
+    if ((phyMask & (1 << RADIO_PHY_FAST)) &&
+        (position >= RADIO_PHY_FAST_WINDOW_START_MS) && (position < RADIO_PHY_FAST_WINDOW_START_MS + RADIO_PHY_FAST_WINDOW_MS))
+    {
+        return RADIO_PHY_FAST;
+    }
+
+    if ((phyMask & (1 << RADIO_PHY_LONG_RANGE)) &&
+        (position >= RADIO_PHY_LONG_RANGE_WINDOW_START_MS) && (position < RADIO_PHY_LONG_RANGE_WINDOW_START_MS + RADIO_PHY_LONG_RANGE_WINDOW_MS))
+    {
+        return RADIO_PHY_LONG_RANGE;
+    }
+
+    return RADIO_PHY_BASE;
+}
+
+/* Network time in ms. The 32-bit tick count wraps after about 11.9 hours, the
+ * wraps are counted here, which the radio task calls at least every superframe */
+static uint32_t networkTimeMs(void)
+{
+    static uint32_t lastTicks = 0;
+    static uint32_t tickWraps = 0;
+    uint32_t ticks = Clock_getTicks();
+    uint64_t timeMs;
+
+    if (ticks < lastTicks)
+    {
+        tickWraps++;
+    }
+    lastTicks = ticks;
+
+    timeMs = ((((uint64_t)tickWraps << 32) | ticks) * Clock_tickPeriod) / 1000;
+
+    return (uint32_t)(timeMs % RADIO_NETWORK_TIME_WRAP_MS);
+}
+
+static void phyWindowClockCallback(UArg arg0)
+{
+    Event_post(radioOperationEventHandle, RADIO_EVENT_PHY_WINDOW);
+}
+
 static void notifyPacketReceived(union ConcentratorPacket* latestRxPacket)
 {
     if (packetReceivedCallback)
@@ -327,6 +542,15 @@ static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status)
             /* Signal packet received */
             Event_post(radioOperationEventHandle, RADIO_EVENT_VALID_PACKET_RECEIVED);
         }
+        else if ((tmpRxPacket->header.packetType == RADIO_PACKET_TYPE_ENERGY_REPORT) &&
+                 (rxPacket->len == sizeof(struct EnergyReportPacket)))
+        {
+            /* Save packet */
+            memcpy(&latestRxPacket.energyReportPacket, rxPacket->payload, sizeof(struct EnergyReportPacket));
+
+            /* Signal packet received */
+            Event_post(radioOperationEventHandle, RADIO_EVENT_VALID_PACKET_RECEIVED);
+        }
         else
         {
             /* Signal invalid packet received */
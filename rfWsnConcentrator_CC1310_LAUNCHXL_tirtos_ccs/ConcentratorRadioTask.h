@@ -48,6 +48,7 @@
 #define TASKS_CONCENTRATORRADIOTASKTASK_H_
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "RadioProtocol.h"
 
 
@@ -61,6 +62,7 @@ union ConcentratorPacket {
     struct PacketHeader header;
     struct RawDataPacket        rawDataPacket;
     struct TestResetPacket      testResetPacket;
+    struct EnergyReportPacket   energyReportPacket;
 };
 
 typedef void (*ConcentratorRadio_PacketReceivedCallback)(union ConcentratorPacket* packet, int8_t rssi);
@@ -71,4 +73,16 @@ void ConcentratorRadioTask_init(void);
 /* Register the packet received callback */
 void ConcentratorRadioTask_registerPacketReceivedCallback(ConcentratorRadio_PacketReceivedCallback callback);
 
+/* Queue a downlink to be carried in the next ACK sent to address, returns false if one is already pending */
+bool ConcentratorRadioTask_setAckDownlink(uint8_t address, uint8_t *data, uint8_t length);
+
+/* Drop the pending ACK downlink */
+void ConcentratorRadioTask_abortAckDownlink(void);
+
+/* PHY the radio listens on, valid in the packet received callback */
+uint8_t ConcentratorRadioTask_getPhy(void);
+
+/* PHYs used by nodes, as (1 << RADIO_PHY_xxx), the base PHY is always listened on */
+void ConcentratorRadioTask_setPhyMask(uint8_t mask);
+
 #endif /* TASKS_CONCENTRATORRADIOTASKTASK_H_ */
@@ -84,6 +84,7 @@
 #define CONCENTRATOR_EVENT_NEW_RAW_DATA             (uint32_t)(1 << 1)
 #define CONCENTRATOR_EVENT_TEST_RESET               (uint32_t)(1 << 2)
 #define CONCENTRATOR_EVENT_ERROR                    (uint32_t)(1 << 3)
+#define CONCENTRATOR_EVENT_ENERGY_REPORT            (uint32_t)(1 << 4)
 
 #define CONCENTRATOR_MAX_NODES 7
 
@@ -95,6 +96,11 @@
 
 #define CONCENTRATOR_IDENTIFY_LED Board_PIN_LED1
 
+#define CONCENTRATOR_PHY_UP_MARGIN_DB               20      /* Margin a faster PHY needs */
+#define CONCENTRATOR_PHY_DOWN_MARGIN_DB             8       /* Below, a slower PHY is used */
+#define CONCENTRATOR_PHY_SAMPLES                    8       /* Packets averaged before a PHY change */
+#define CONCENTRATOR_PHY_FALLBACK_HOLDOFF           64      /* Packets on the base PHY after a node fell back */
+
 /***** Type declarations *****/
 struct AdcSensorNode {
     uint8_t address;
@@ -112,6 +118,30 @@ struct RawDataNode {
     int8_t      latestRssi;
 };
 
+/* Latest energy report of a node */
+struct EnergyNode {
+    uint8_t     address;
+    uint32_t    reports;
+    uint32_t    txTimeMs;
+    uint32_t    rxTimeMs;
+    uint32_t    wakeCount;
+    uint32_t    deliveredBytes;
+    uint32_t    energyUj;
+    uint32_t    energyPerByteNj;
+};
+
+
+/* PHY of a node */
+struct PhyNode {
+    uint8_t     address;
+    bool        used;
+    uint8_t     phy;            /* PHY the node was last heard on */
+    uint8_t     proposedPhy;    /* PHY of the last RADIO_DOWNLINK_TYPE_PHY */
+    int16_t     rssi;           /* Average RSSI at the node maximum TX power since the last PHY change */
+    uint8_t     samples;
+    uint16_t    holdoff;
+};
+
 
 /***** Variable declarations *****/
 static Task_Params concentratorTaskParams;
@@ -121,8 +151,12 @@ Event_Struct concentratorEvent;  /* not static so you can see in ROV */
 static Event_Handle concentratorEventHandle;
 static struct AdcSensorNode latestActiveAdcSensorNode;
 static struct RawDataNode   latestRawDataNode;
+static uint8_t              latestTestResetAddress;
 struct AdcSensorNode knownSensorNodes[CONCENTRATOR_MAX_NODES];
 static struct AdcSensorNode* lastAddedSensorNode = knownSensorNodes;
+static struct EnergyNode    energyNodes[CONCENTRATOR_MAX_NODES];
+static struct EnergyNode*   latestEnergyNode = NULL;
+static struct PhyNode       phyNodes[CONCENTRATOR_MAX_NODES];
 static Display_Handle hDisplaySerial;
 
 static  uint32_t    previousReceivedTime = 0;
@@ -158,6 +192,11 @@ static void addNewNode(struct AdcSensorNode* node);
 static void updateNode(struct AdcSensorNode* node);
 static uint8_t isKnownNodeAddress(uint8_t address);
 static void ledBlinkClockCb(UArg arg0);
+static struct EnergyNode* energyNode(uint8_t address);
+static uint32_t get32(uint8_t* data);
+static void updatePhy(uint8_t address, int16_t rssi);
+static struct PhyNode* phyNode(uint8_t address);
+static uint8_t targetPhy(struct PhyNode* node);
 
 /***** Function definitions *****/
 void ConcentratorTask_init(void)
@@ -276,6 +315,10 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
         }
         else if(events & CONCENTRATOR_EVENT_TEST_RESET)
         {
+            /* Hand the node our time base in the ACK of its next packet */
+            uint8_t timeSync[5] = { RADIO_DOWNLINK_TYPE_TIME_SYNC, 0, 0, 0, 0 };
+            ConcentratorRadioTask_setAckDownlink(latestTestResetAddress, timeSync, sizeof(timeSync));
+
             /* If we knew this node from before, update the value */
             if(isKnownNodeAddress(latestActiveAdcSensorNode.address))
             {
@@ -294,6 +337,12 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
             totalReceivedDataSize = 0;
             totalSuccessfullyReceivedPacket = 0;
         }
+        else if(events & CONCENTRATOR_EVENT_ENERGY_REPORT)
+        {
+            Trace_printf(hDisplaySerial, "Node %02x energy: %d uJ, %d nJ/B, %d B, TX %d ms, RX %d ms, %d wakes",
+                         latestEnergyNode->address, latestEnergyNode->energyUj, latestEnergyNode->energyPerByteNj, latestEnergyNode->deliveredBytes,
+                         latestEnergyNode->txTimeMs, latestEnergyNode->rxTimeMs, latestEnergyNode->wakeCount);
+        }
         else if(events & CONCENTRATOR_EVENT_ERROR)
         {
             receivedPacket++;
@@ -319,6 +368,10 @@ static void concentratorTaskFunction(UArg arg0, UArg arg1)
 
 static void packetReceivedCallback(union ConcentratorPacket* packet, int8_t rssi)
 {
+    /* Every packet tells the PHY and the margin of its node, as if the node sent at its maximum TX power */
+    updatePhy(packet->header.sourceAddress,
+              rssi + ((packet->header.options & RADIO_PACKET_OPTIONS_POWER_BACKOFF_MASK) >> RADIO_PACKET_OPTIONS_POWER_BACKOFF_SHIFT) * RADIO_POWER_BACKOFF_STEP_DB);
+
     /* If we recived an ADC sensor packet, for backward compatibility */
     if(packet->header.packetType == RADIO_PACKET_TYPE_RAW_DATA_PACKET)
     {
@@ -336,14 +389,172 @@ static void packetReceivedCallback(union ConcentratorPacket* packet, int8_t rssi
     else if(packet->header.packetType == RADIO_PACKET_TYPE_TEST_RESET)
     {
         /* Save the values */
+        latestTestResetAddress = packet->header.sourceAddress;
         Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_TEST_RESET);
     }
+    else if(packet->header.packetType == RADIO_PACKET_TYPE_ENERGY_REPORT)
+    {
+        uint8_t*    report = packet->energyReportPacket.report;
+
+        /* Save the values */
+        latestEnergyNode = energyNode(packet->header.sourceAddress);
+        latestEnergyNode->txTimeMs = get32(&report[0]);
+        latestEnergyNode->rxTimeMs = get32(&report[4]);
+        latestEnergyNode->wakeCount = get32(&report[8]);
+        latestEnergyNode->deliveredBytes = get32(&report[12]);
+        latestEnergyNode->energyUj = get32(&report[16]);
+        latestEnergyNode->energyPerByteNj = get32(&report[20]);
+        latestEnergyNode->reports++;
+
+        Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_ENERGY_REPORT);
+    }
     else
     {
         Event_post(concentratorEventHandle, CONCENTRATOR_EVENT_ERROR);
     }
 }
 
+/*
+ * Called from the radio task for each packet received. A node is proposed
+ * a PHY in the next ACK when its average margin allows a faster one or
+ * needs a slower one. It is on the PHY it is heard on, so a lost proposal
+ * is simply made again. A node back on the base PHY without being asked
+ * lost the concentrator on its PHY and stays there for a while.
+ */
+static void updatePhy(uint8_t address, int16_t rssi)
+{
+    struct PhyNode* node = phyNode(address);
+    uint8_t phy = ConcentratorRadioTask_getPhy();
+    uint8_t target;
+    uint8_t mask = 0;
+    uint8_t i;
+
+    if (phy != node->phy)
+    {
+        if ((phy == RADIO_PHY_BASE) && (node->proposedPhy != RADIO_PHY_BASE))
+        {
+            node->holdoff = CONCENTRATOR_PHY_FALLBACK_HOLDOFF;
+        }
+
+        node->phy = phy;
+        node->proposedPhy = phy;
+        node->samples = 0;
+    }
+
+    node->rssi = (node->samples == 0) ? rssi : (3 * node->rssi + rssi) / 4;
+    if (node->samples < 255)
+    {
+        node->samples++;
+    }
+
+    if (node->holdoff != 0)
+    {
+        node->holdoff--;
+    }
+    else if (node->samples >= CONCENTRATOR_PHY_SAMPLES)
+    {
+        target = targetPhy(node);
+        if (target != node->phy)
+        {
+            uint8_t downlink[6] = { RADIO_DOWNLINK_TYPE_PHY, target, 0, 0, 0, 0 };
+
+            if (ConcentratorRadioTask_setAckDownlink(address, downlink, sizeof(downlink)))
+            {
+                node->proposedPhy = target;
+                node->samples = 0;
+            }
+        }
+    }
+
+    /* Listen on the PHYs in use, and on those proposed */
+    for (i = 0; i < CONCENTRATOR_MAX_NODES; i++)
+    {
+        if (phyNodes[i].used)
+        {
+            mask |= (1 << phyNodes[i].phy) | (1 << phyNodes[i].proposedPhy);
+        }
+    }
+    ConcentratorRadioTask_setPhyMask(mask);
+}
+
+/* The fastest PHY with the margin to move up, or the next slower one when short of margin */
+static uint8_t targetPhy(struct PhyNode* node)
+{
+    static const int8_t sensitivities[RADIO_PHY_COUNT] = RADIO_PHY_SENSITIVITIES_DBM;
+    uint8_t phy;
+
+    for (phy = 0; phy < node->phy; phy++)
+    {
+        if (node->rssi - sensitivities[phy] >= CONCENTRATOR_PHY_UP_MARGIN_DB)
+        {
+            return phy;
+        }
+    }
+
+    if ((node->rssi - sensitivities[node->phy] < CONCENTRATOR_PHY_DOWN_MARGIN_DB) && (node->phy + 1 < RADIO_PHY_COUNT))
+    {
+        return node->phy + 1;
+    }
+
+    return node->phy;
+}
+
+/* The entry of a node, the oldest entry is reused for a new node */
+static struct PhyNode* phyNode(uint8_t address)
+{
+    static uint8_t next = 0;
+    struct PhyNode* node;
+    uint8_t i;
+
+    for (i = 0; i < CONCENTRATOR_MAX_NODES; i++)
+    {
+        if (phyNodes[i].used && (phyNodes[i].address == address))
+        {
+            return &phyNodes[i];
+        }
+    }
+
+    node = &phyNodes[next];
+    next = (next + 1) % CONCENTRATOR_MAX_NODES;
+
+    memset(node, 0, sizeof(struct PhyNode));
+    node->address = address;
+    node->used = true;
+    node->phy = RADIO_PHY_BASE;
+    node->proposedPhy = RADIO_PHY_BASE;
+
+    return node;
+}
+
+/* The entry of a node, the oldest entry is reused for a new node */
+static struct EnergyNode* energyNode(uint8_t address)
+{
+    static uint8_t next = 0;
+    struct EnergyNode* node;
+    uint8_t i;
+
+    for (i = 0; i < CONCENTRATOR_MAX_NODES; i++)
+    {
+        if ((energyNodes[i].address == address) && (energyNodes[i].reports != 0))
+        {
+            return &energyNodes[i];
+        }
+    }
+
+    node = &energyNodes[next];
+    next = (next + 1) % CONCENTRATOR_MAX_NODES;
+
+    memset(node, 0, sizeof(struct EnergyNode));
+    node->address = address;
+
+    return node;
+}
+
+static uint32_t get32(uint8_t* data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
 static uint8_t isKnownNodeAddress(uint8_t address)
 {
     uint8_t found = 0;
@@ -133,6 +133,7 @@ extern "C" {
 #define Board_SPI0              CC1310_LAUNCHXL_SPI0
 #define Board_SPI1              CC1310_LAUNCHXL_SPI1
 #define Board_SPI_FLASH_CS      CC1310_LAUNCHXL_SPI_FLASH_CS
+#define Board_SPI_FLASH         CC1310_LAUNCHXL_SPI1
 #define Board_FLASH_CS_ON       0
 #define Board_FLASH_CS_OFF      1
 
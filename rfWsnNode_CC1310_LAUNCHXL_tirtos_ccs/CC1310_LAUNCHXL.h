@@ -137,7 +137,7 @@ extern const PIN_Config BoardGpioInitTable[];
 #define CC1310_LAUNCHXL_SPI1_MISO             IOID_8
 #define CC1310_LAUNCHXL_SPI1_MOSI             IOID_9
 #define CC1310_LAUNCHXL_SPI1_CLK              IOID_10
-#define CC1310_LAUNCHXL_SPI1_CSN              IOID_20
+#define CC1310_LAUNCHXL_SPI1_CSN              PIN_UNASSIGNED  /* Ext. flash CS is driven by ExtFlash */
 
 /* UART Board */
 #define CC1310_LAUNCHXL_UART_RX               IOID_2          /* RXD */
@@ -50,8 +50,18 @@ HEAPSIZE = 0x1000;  /* Size of heap buffer used by HeapMem */
 
 /* The starting address of the application.  Normally the interrupt vectors  */
 /* must be located at the beginning of the application.                      */
+#ifdef OAD_IMG_E
+/* Started by the off-chip OAD BIM: the OAD image header at the start of     */
+/* page 1, the vectors after it (m3Hwi.resetVectorAddress = 0x1010), up to   */
+/* the end of the image region. The BIM and the CCFG are in the last page.   */
+#define IMG_HDR_BASE            0x1000
+#define IMG_HDR_SIZE            0x10
+#define FLASH_BASE              0x1010
+#define FLASH_SIZE              (0x1C000 - IMG_HDR_SIZE)
+#else
 #define FLASH_BASE              0x0
 #define FLASH_SIZE              0x20000
+#endif
 #define RAM_BASE                0x20000000
 #define RAM_SIZE                0x5000
 
@@ -59,6 +69,10 @@ HEAPSIZE = 0x1000;  /* Size of heap buffer used by HeapMem */
 
 MEMORY
 {
+#ifdef OAD_IMG_E
+    /* OAD image header, see oad/native_oad/oad_image_header.c */
+    FLASH_IMG_HDR (RX) : origin = IMG_HDR_BASE, length = IMG_HDR_SIZE
+#endif
     /* Application stored in and executes from internal flash */
     FLASH (RX) : origin = FLASH_BASE, length = FLASH_SIZE
     /* Application uses internal RAM for data */
@@ -78,7 +92,11 @@ SECTIONS
     .pinit          :   > FLASH
     .init_array     :   > FLASH
     .emb_text       :   >> FLASH
+#ifdef OAD_IMG_E
+    .imgHdr         :   > FLASH_IMG_HDR
+#else
     .ccfg           :   > FLASH (HIGH)
+#endif
 
     .data           :   > SRAM
     .bss            :   > SRAM
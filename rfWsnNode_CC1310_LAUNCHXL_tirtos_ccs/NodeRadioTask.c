@@ -53,6 +53,7 @@
 
 /* Standard C Libraries */
 #include <stdlib.h>
+#include <string.h>
 
 /* EasyLink API Header files */ 
 #include "easylink/EasyLink.h"
@@ -62,6 +63,7 @@
 #include "NodeRadioTask.h"
 #include "NodeTask.h"
 #include "crc16.h"
+#include "energy.h"
 
 #include <ti/devices/DeviceFamily.h>
 #include DeviceFamily_constructPath(driverlib/aon_batmon.h)
@@ -78,9 +80,40 @@
 #define RADIO_EVENT_SEND_FAIL           (uint32_t)(1 << 3)
 #define RADIO_EVENT_SEND_RAW_DATA       (uint32_t)(1 << 5)
 #define RADIO_EVENT_TEST_RESET          (uint32_t)(1 << 4)
+#define RADIO_EVENT_SEND_OAD_DATA       (uint32_t)(1 << 6)
+#define RADIO_EVENT_PENDING_FRAME_RECEIVED  (uint32_t)(1 << 7)
+#define RADIO_EVENT_PENDING_FRAME_DONE      (uint32_t)(1 << 8)
+#define RADIO_EVENT_SEND_ENERGY_REPORT      (uint32_t)(1 << 9)
+#define RADIO_EVENT_BROADCAST_WINDOW        (uint32_t)(1 << 10)
+#define RADIO_EVENT_BROADCAST_RECEIVED      (uint32_t)(1 << 11)
+#define RADIO_EVENT_BROADCAST_DONE          (uint32_t)(1 << 12)
 
 #define NODERADIO_MAX_RETRIES 2
 #define NORERADIO_ACK_TIMEOUT_TIME_MS (160)
+#define NODERADIO_LONG_RANGE_ACK_TIMEOUT_TIME_MS (500)
+
+/* Failed operations on another PHY before going back to the base PHY */
+#define NODERADIO_PHY_FALLBACK_FAILURES 2
+
+/* TX power control, on the margin of the RSSI in the ACKs over the PHY sensitivity.
+ * The power steps through the levels of the PHY TX power table, up to the
+ * highest one usable in this build. */
+#define NODERADIO_MAX_TX_POWER_DBM      14
+#define NODERADIO_TARGET_MARGIN_DB      15
+#define NODERADIO_MARGIN_HYSTERESIS_DB  5
+
+/* Wait for a frame the concentrator flagged as pending, it follows the
+ * previous one after a short gap */
+#define NODERADIO_FRAME_PENDING_TIMEOUT_MS (20)
+
+/* Every transmission starts at a set radio timer time, after the radio
+ * power up and synthesizer calibration the wake up charge accounts for,
+ * so the TX time measured from it is the airtime alone */
+#define NODERADIO_TX_START_DELAY_US (2000)
+
+/* Time after the last broadcast frame received before the broadcast slots
+ * are searched for again, the slots drift off the radio timer of the node */
+#define NODERADIO_BROADCAST_RESYNC_MS (10000)
 
 
 /***** Type declarations *****/
@@ -88,6 +121,7 @@ struct RadioOperation {
     EasyLink_TxPacket easyLinkTxPacket;
     uint8_t retriesDone;
     uint8_t maxNumberOfRetries;
+    uint8_t deliveredLength;
     uint32_t ackTimeoutMs;
     enum NodeRadioOperationStatus result;
 };
@@ -109,15 +143,76 @@ static uint8_t  *rawData = NULL;
 static uint16_t rawDataLength = 0;
 static uint8_t  nodeAddress = 0;
 
+static NodeRadio_AckDownlinkCallback ackDownlinkCallback;
+static uint8_t  ackDownlink[RADIO_ACK_DOWNLINK_MAX_LENGTH];
+static uint8_t  ackDownlinkLength = 0;
+
+static NodeRadio_OadPacketCallback oadPacketCallback;
+static uint8_t  pendingFrame[EASYLINK_MAX_DATA_LENGTH];
+static uint8_t  pendingFrameLength = 0;
+static volatile bool framePending = false;
+static bool     receivingPendingFrames = false;
+static bool     operationInProgress = false;
+
+/* Broadcast slots of the concentrator, they repeat the time stamp of the
+ * last broadcast frame received every RADIO_BROADCAST_SLOT_MS */
+static volatile bool followBroadcast = false;
+static bool     broadcastSynced = false;
+static uint32_t broadcastFrameTime = 0;
+static bool     receivingBroadcast = false;
+static uint8_t  broadcastFrame[EASYLINK_MAX_DATA_LENGTH];
+static uint8_t  broadcastFrameLength = 0;
+Clock_Struct broadcastClock;      /* not static so you can see in ROV */
+static Clock_Handle broadcastClockHandle;
+
+static uint8_t  maxNumberOfRetries = NODERADIO_MAX_RETRIES;
+static RF_TxPowerTable_Entry *txPowerTable = NULL;
+static uint8_t  txPowerLevels = 0;
+static uint8_t  txPowerLevel = 0;           /* Level for the next transmission */
+static uint8_t  maxTxPowerLevel = 0;
+static int8_t   txPowerDbm = 0;             /* Power the radio transmits at */
+static volatile int8_t maxTxPowerDbm = NODERADIO_MAX_TX_POWER_DBM;
+static volatile bool txPowerChanged = true;
+static int16_t  marginDb = 0;
+static uint8_t  marginSamples = 0;
+static int8_t   ackRssi = 0;
+static bool     ackRssiValid = false;
+
+/* Radio timer at the start of the current RX, for the energy accounting */
+static uint32_t rxStartTime = 0;
+
+static const EasyLink_PhyType phyTypes[RADIO_PHY_COUNT] = RADIO_PHY_EASYLINK_TYPES;
+static const ENERGY_MODEL* const energyModels[RADIO_PHY_COUNT] = { &Energy_fastModel, &Energy_baseModel, &Energy_longRangeModel };
+static uint8_t  currentPhy = RADIO_PHY_BASE;
+static volatile uint8_t requestedPhy = RADIO_PHY_BASE;
+static uint8_t  phyFailures = 0;
+static bool     timeSynced = false;         /* The network time follows the concentrator */
+
 /* Pin driver handle */
 extern PIN_Handle ledPinHandle;
 
 /***** Prototypes *****/
 static void nodeRadioTaskFunction(UArg arg0, UArg arg1);
 static void returnRadioOperationStatus(enum NodeRadioOperationStatus status);
-static void sendRawData(uint8_t *data, uint8_t dataLength, uint8_t options, uint8_t maxNumberOfRetries, uint32_t ackTimeoutMs);
+static void sendRawData(uint8_t packetType, uint8_t *data, uint8_t dataLength, uint8_t options, uint8_t maxNumberOfRetries, uint32_t ackTimeoutMs);
 static void sendTestReset(uint8_t maxNumberOfRetries, uint32_t ackTimeoutMs);
 static void resendPacket(void);
+static void receivePendingFrame(void);
+static void enableRxAddrFilter(void);
+static void openBroadcastWindow(void);
+static void stopBroadcastRx(void);
+static void broadcastClockCallback(UArg arg0);
+static void applyTxPower(void);
+static void applyPhy(void);
+static void loadTxPowerTable(void);
+static uint8_t txPowerLevelFor(int8_t powerDbm);
+static void controlTxPower(int8_t rssi);
+static void raiseTxPower(uint8_t level);
+static uint32_t phyWindowDelayMs(void);
+static uint32_t ackTimeoutMs(void);
+static EasyLink_Status transmitPacket(EasyLink_TxPacket *txPacket);
+static EasyLink_Status receivePacket(void);
+static bool saveBroadcastFrame(EasyLink_RxPacket * rxPacket, EasyLink_Status status);
 static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status);
 
 /***** Function definitions *****/
@@ -139,6 +234,14 @@ void NodeRadioTask_init(void) {
     Event_construct(&radioOperationEvent, &eventParam);
     radioOperationEventHandle = Event_handle(&radioOperationEvent);
 
+    /* Create clock object which opens the broadcast windows */
+    Clock_Params clkParams;
+    Clock_Params_init(&clkParams);
+    clkParams.period = 0;
+    clkParams.startFlag = FALSE;
+    Clock_construct(&broadcastClock, broadcastClockCallback, 1, &clkParams);
+    broadcastClockHandle = Clock_handle(&broadcastClock);
+
     /* Create the radio protocol task */
     Task_Params_init(&nodeRadioTaskParams);
     nodeRadioTaskParams.stackSize = NODERADIO_TASK_STACK_SIZE;
@@ -147,17 +250,60 @@ void NodeRadioTask_init(void) {
     Task_construct(&nodeRadioTask, nodeRadioTaskFunction, &nodeRadioTaskParams, NULL);
 }
 
+void NodeRadioTask_registerAckDownlinkCallback(NodeRadio_AckDownlinkCallback callback)
+{
+    ackDownlinkCallback = callback;
+}
+
+void NodeRadioTask_registerOadPacketCallback(NodeRadio_OadPacketCallback callback)
+{
+    oadPacketCallback = callback;
+}
+
 uint8_t nodeRadioTask_getNodeAddr(void)
 {
     return nodeAddress;
 }
 
+void NodeRadioTask_setMaxRetries(uint8_t retries)
+{
+    maxNumberOfRetries = retries;
+}
+
+void NodeRadioTask_setPhy(uint8_t phy)
+{
+    /* Applied by the radio task before its next transmission */
+    requestedPhy = phy;
+}
+
+uint8_t NodeRadioTask_getPhy(void)
+{
+    return currentPhy;
+}
+
+void NodeRadioTask_setMaxTxPower(int8_t powerDbm)
+{
+    /* Applied by the radio task before its next transmission */
+    maxTxPowerDbm = powerDbm;
+    txPowerChanged = true;
+}
+
+void NodeRadioTask_followBroadcast(bool follow)
+{
+    /* The radio task opens or stops the broadcast windows */
+    followBroadcast = follow;
+    Event_post(radioOperationEventHandle, RADIO_EVENT_BROADCAST_WINDOW);
+}
+
 static void nodeRadioTaskFunction(UArg arg0, UArg arg1)
 {
     // Initialize the EasyLink parameters to their default values
     EasyLink_Params easyLink_params;
     EasyLink_Params_init(&easyLink_params);
 
+    /* Start on the base PHY, the concentrator moves us from there */
+    easyLink_params.ui32ModType = phyTypes[RADIO_PHY_BASE];
+
     /* Initialize EasyLink */
     if(EasyLink_init(&easyLink_params) != EasyLink_Status_Success){
         System_abort("EasyLink_init failed");
@@ -183,10 +329,10 @@ static void nodeRadioTaskFunction(UArg arg0, UArg arg1)
     Power_releaseDependency(PowerCC26XX_PERIPH_TRNG);
 
     /* Set the filter to the generated random address */
-    if (EasyLink_enableRxAddrFilter(&nodeAddress, 1, 1) != EasyLink_Status_Success)
-    {
-        System_abort("EasyLink_enableRxAddrFilter failed");
-    }
+    enableRxAddrFilter();
+
+    loadTxPowerTable();
+    Energy_setModel(energyModels[currentPhy]);
 
     /* Enter main task loop */
     while (1)
@@ -194,19 +340,112 @@ static void nodeRadioTaskFunction(UArg arg0, UArg arg1)
         /* Wait for an event */
         uint32_t events = Event_pend(radioOperationEventHandle, 0, RADIO_EVENT_ALL, BIOS_WAIT_FOREVER);
 
+        /* A broadcast frame, in a broadcast window or in any other RX. It
+         * was sent at the start of a slot of the concentrator. */
+        if (events & RADIO_EVENT_BROADCAST_RECEIVED)
+        {
+            broadcastSynced = true;
+            if (oadPacketCallback)
+            {
+                oadPacketCallback(broadcastFrame, broadcastFrameLength);
+            }
+        }
+
+        /* The radio is idle between operations, a broadcast window gives way */
+        if (events & (RADIO_EVENT_SEND_RAW_DATA | RADIO_EVENT_SEND_OAD_DATA | RADIO_EVENT_TEST_RESET | RADIO_EVENT_SEND_ENERGY_REPORT))
+        {
+            stopBroadcastRx();
+            operationInProgress = true;
+
+            applyPhy();
+            applyTxPower();
+        }
+
         /* If we should send ADC data */
         if (events & RADIO_EVENT_SEND_RAW_DATA)
         {
-            sendRawData(rawData, rawDataLength, RADIO_PACKET_OPTIONS_CRC, NODERADIO_MAX_RETRIES, NORERADIO_ACK_TIMEOUT_TIME_MS);
+            sendRawData(RADIO_PACKET_TYPE_RAW_DATA_PACKET, rawData, rawDataLength, RADIO_PACKET_OPTIONS_CRC, maxNumberOfRetries, ackTimeoutMs());
+        }
+        else if (events & RADIO_EVENT_SEND_OAD_DATA)
+        {
+            sendRawData(RADIO_PACKET_TYPE_OAD_PACKET, rawData, rawDataLength, 0, NODERADIO_MAX_RETRIES, ackTimeoutMs());
         }
         else if (events & RADIO_EVENT_TEST_RESET)
         {
-            sendTestReset(NODERADIO_MAX_RETRIES, NORERADIO_ACK_TIMEOUT_TIME_MS);
+            sendTestReset(NODERADIO_MAX_RETRIES, ackTimeoutMs());
+        }
+        else if (events & RADIO_EVENT_SEND_ENERGY_REPORT)
+        {
+            sendRawData(RADIO_PACKET_TYPE_ENERGY_REPORT, rawData, rawDataLength, 0, maxNumberOfRetries, ackTimeoutMs());
         }
 
         /* If we get an ACK from the concentrator */
         if (events & RADIO_EVENT_DATA_ACK_RECEIVED)
         {
+            Energy_delivered(currentRadioOperation.deliveredLength);
+            phyFailures = 0;
+
+            if (ackRssiValid)
+            {
+                controlTxPower(ackRssi);
+            }
+
+            /* Hand over the downlink carried in the ACK, if any, an OAD
+             * message from the OAD server goes to the OAD client */
+            if ((ackDownlinkLength != 0) &&
+                ((ackDownlink[0] == RADIO_DOWNLINK_TYPE_TIME_SYNC) || (ackDownlink[0] == RADIO_DOWNLINK_TYPE_PHY)))
+            {
+                /* The concentrator schedules its PHYs on this time, keep off its windows */
+                timeSynced = true;
+            }
+
+            if ((ackDownlinkLength > 1) && (ackDownlink[0] == RADIO_DOWNLINK_TYPE_OAD))
+            {
+                if (oadPacketCallback)
+                {
+                    oadPacketCallback(&ackDownlink[1], ackDownlinkLength - 1);
+                }
+            }
+            else if ((ackDownlinkLength != 0) && ackDownlinkCallback)
+            {
+                ackDownlinkCallback(ackDownlink, ackDownlinkLength);
+            }
+            ackDownlinkLength = 0;
+
+            /* Stay in RX if the concentrator has more frames for us */
+            if (framePending)
+            {
+                receivePendingFrame();
+            }
+            else
+            {
+                returnRadioOperationStatus(NodeRadioStatus_Success);
+            }
+        }
+
+        /* If we got a frame that followed the ACK */
+        if (events & RADIO_EVENT_PENDING_FRAME_RECEIVED)
+        {
+            if (oadPacketCallback)
+            {
+                oadPacketCallback(pendingFrame, pendingFrameLength);
+            }
+
+            if (framePending)
+            {
+                receivePendingFrame();
+            }
+            else
+            {
+                receivingPendingFrames = false;
+                returnRadioOperationStatus(NodeRadioStatus_Success);
+            }
+        }
+
+        /* The frames that followed the ACK are lost or over, the ACK was received */
+        if (events & RADIO_EVENT_PENDING_FRAME_DONE)
+        {
+            receivingPendingFrames = false;
             returnRadioOperationStatus(NodeRadioStatus_Success);
         }
 
@@ -217,6 +456,8 @@ static void nodeRadioTaskFunction(UArg arg0, UArg arg1)
             /* If we haven't resent it the maximum number of times yet, then resend packet */
             if (currentRadioOperation.retriesDone < currentRadioOperation.maxNumberOfRetries)
             {
+                /* A level more power for the resend */
+                raiseTxPower(txPowerLevel + 1);
                 resendPacket();
             }
             else
@@ -229,8 +470,23 @@ static void nodeRadioTaskFunction(UArg arg0, UArg arg1)
         /* If send fail */
         if (events & RADIO_EVENT_SEND_FAIL)
         {
+            /* The concentrator may have lost our PHY, meet it again on the base PHY */
+            if ((currentPhy != RADIO_PHY_BASE) && (++phyFailures >= NODERADIO_PHY_FALLBACK_FAILURES))
+            {
+                requestedPhy = RADIO_PHY_BASE;
+            }
+
+            /* The next operation starts at full power */
+            raiseTxPower(maxTxPowerLevel);
+
             returnRadioOperationStatus(NodeRadioStatus_Failed);
         }
+
+        /* Listen in the next broadcast slot while the radio is idle */
+        if (events & (RADIO_EVENT_BROADCAST_WINDOW | RADIO_EVENT_BROADCAST_RECEIVED | RADIO_EVENT_BROADCAST_DONE))
+        {
+            openBroadcastWindow();
+        }
     }
 }
 
@@ -283,18 +539,77 @@ enum NodeRadioOperationStatus NodeRadioTask_sendRawData(uint8_t *data, uint16_t
     return status;
 }
 
+enum NodeRadioOperationStatus NodeRadioTask_sendEnergyReport(uint8_t *data, uint16_t length)
+{
+    enum NodeRadioOperationStatus status;
+
+    /* Get radio access semaphore */
+    Semaphore_pend(radioAccessSemHandle, BIOS_WAIT_FOREVER);
+
+    /* Save data to send */
+    rawData = data;
+    rawDataLength = length;
+
+    /* Raise RADIO_EVENT_SEND_ENERGY_REPORT event */
+    Event_post(radioOperationEventHandle, RADIO_EVENT_SEND_ENERGY_REPORT);
+
+    /* Wait for result */
+    Semaphore_pend(radioResultSemHandle, BIOS_WAIT_FOREVER);
+
+    /* Get result */
+    status = currentRadioOperation.result;
+
+    /* Return radio access semaphore */
+    Semaphore_post(radioAccessSemHandle);
+
+    return status;
+}
+
+enum NodeRadioOperationStatus NodeRadioTask_sendOadData(uint8_t *data, uint16_t length)
+{
+    enum NodeRadioOperationStatus status;
+
+    /* Get radio access semaphore */
+    Semaphore_pend(radioAccessSemHandle, BIOS_WAIT_FOREVER);
+
+    /* Save data to send */
+    rawData = data;
+    rawDataLength = length;
+
+    /* Raise RADIO_EVENT_SEND_OAD_DATA event */
+    Event_post(radioOperationEventHandle, RADIO_EVENT_SEND_OAD_DATA);
+
+    /* Wait for result, the frames following the ACK have been received */
+    Semaphore_pend(radioResultSemHandle, BIOS_WAIT_FOREVER);
+
+    /* Get result */
+    status = currentRadioOperation.result;
+
+    /* Return radio access semaphore */
+    Semaphore_post(radioAccessSemHandle);
+
+    return status;
+}
+
 
 
 static void returnRadioOperationStatus(enum NodeRadioOperationStatus result)
 {
     /* Save result */
     currentRadioOperation.result = result;
+    operationInProgress = false;
 
     /* Post result semaphore */
     Semaphore_post(radioResultSemHandle);
+
+    /* The broadcast windows resume */
+    if (followBroadcast)
+    {
+        Event_post(radioOperationEventHandle, RADIO_EVENT_BROADCAST_WINDOW);
+    }
 }
 
-static void sendRawData(uint8_t *data, uint8_t dataLength, uint8_t options, uint8_t maxNumberOfRetries, uint32_t ackTimeoutMs)
+static void sendRawData(uint8_t packetType, uint8_t *data, uint8_t dataLength, uint8_t options, uint8_t maxNumberOfRetries, uint32_t ackTimeoutMs)
 {
     uint8_t i;
     uint16_t    payloadLength = 0;
@@ -304,7 +619,7 @@ static void sendRawData(uint8_t *data, uint8_t dataLength, uint8_t options, uint
     /* Copy ADC packet to payload
      * Note that the EasyLink API will implcitily both add the length byte and the destination address byte. */
     currentRadioOperation.easyLinkTxPacket.payload[payloadLength++] = nodeAddress;
-    currentRadioOperation.easyLinkTxPacket.payload[payloadLength++] = RADIO_PACKET_TYPE_RAW_DATA_PACKET;
+    currentRadioOperation.easyLinkTxPacket.payload[payloadLength++] = packetType;
     currentRadioOperation.easyLinkTxPacket.payload[payloadLength++] = options;
     currentRadioOperation.easyLinkTxPacket.payload[payloadLength++] = dataLength;
     if (options & RADIO_PACKET_OPTIONS_CRC)
@@ -322,6 +637,9 @@ static void sendRawData(uint8_t *data, uint8_t dataLength, uint8_t options, uint
 
     currentRadioOperation.easyLinkTxPacket.len = payloadLength;
 
+    /* Only the application data counts as delivered */
+    currentRadioOperation.deliveredLength = (packetType == RADIO_PACKET_TYPE_RAW_DATA_PACKET) ? dataLength : 0;
+    Energy_wake();
 
     /* Setup retries */
     currentRadioOperation.maxNumberOfRetries = maxNumberOfRetries;
@@ -330,13 +648,13 @@ static void sendRawData(uint8_t *data, uint8_t dataLength, uint8_t options, uint
     EasyLink_setCtrl(EasyLink_Ctrl_AsyncRx_TimeOut, EasyLink_ms_To_RadioTime(ackTimeoutMs));
 
     /* Send packet  */
-    if (EasyLink_transmit(&currentRadioOperation.easyLinkTxPacket) != EasyLink_Status_Success)
+    if (transmitPacket(&currentRadioOperation.easyLinkTxPacket) != EasyLink_Status_Success)
     {
         System_abort("EasyLink_transmit failed");
     }
 
     /* Enter RX */
-    if (EasyLink_receiveAsync(rxDoneCallback, 0) != EasyLink_Status_Success)
+    if (receivePacket() != EasyLink_Status_Success)
     {
         System_abort("EasyLink_receiveAsync failed");
     }
@@ -357,6 +675,8 @@ static void sendTestReset(uint8_t maxNumberOfRetries, uint32_t ackTimeoutMs)
 
     currentRadioOperation.easyLinkTxPacket.len = payloadLength;
 
+    currentRadioOperation.deliveredLength = 0;
+    Energy_wake();
 
     /* Setup retries */
     currentRadioOperation.maxNumberOfRetries = maxNumberOfRetries;
@@ -365,13 +685,13 @@ static void sendTestReset(uint8_t maxNumberOfRetries, uint32_t ackTimeoutMs)
     EasyLink_setCtrl(EasyLink_Ctrl_AsyncRx_TimeOut, EasyLink_ms_To_RadioTime(ackTimeoutMs));
 
     /* Send packet  */
-    if (EasyLink_transmit(&currentRadioOperation.easyLinkTxPacket) != EasyLink_Status_Success)
+    if (transmitPacket(&currentRadioOperation.easyLinkTxPacket) != EasyLink_Status_Success)
     {
         System_abort("EasyLink_transmit failed");
     }
 
     /* Enter RX */
-    if (EasyLink_receiveAsync(rxDoneCallback, 0) != EasyLink_Status_Success)
+    if (receivePacket() != EasyLink_Status_Success)
     {
         System_abort("EasyLink_receiveAsync failed");
     }
@@ -379,14 +699,16 @@ static void sendTestReset(uint8_t maxNumberOfRetries, uint32_t ackTimeoutMs)
 
 static void resendPacket(void)
 {
+    applyTxPower();
+
     /* Send packet  */
-    if (EasyLink_transmit(&currentRadioOperation.easyLinkTxPacket) != EasyLink_Status_Success)
+    if (transmitPacket(&currentRadioOperation.easyLinkTxPacket) != EasyLink_Status_Success)
     {
         System_abort("EasyLink_transmit failed");
     }
 
     /* Enter RX and wait for ACK with timeout */
-    if (EasyLink_receiveAsync(rxDoneCallback, 0) != EasyLink_Status_Success)
+    if (receivePacket() != EasyLink_Status_Success)
     {
         System_abort("EasyLink_receiveAsync failed");
     }
@@ -395,10 +717,407 @@ static void resendPacket(void)
     currentRadioOperation.retriesDone++;
 }
 
+/* Switch to the PHY the concentrator asked for, keeping the frequency and address filter */
+static void applyPhy(void)
+{
+    EasyLink_Params easyLink_params;
+    uint32_t    frequency;
+    uint8_t     phy = requestedPhy;
+
+    if ((phy == currentPhy) || (phy >= RADIO_PHY_COUNT))
+    {
+        return;
+    }
+
+    frequency = EasyLink_getFrequency();
+
+    EasyLink_Params_init(&easyLink_params);
+    easyLink_params.ui32ModType = phyTypes[phy];
+    if (EasyLink_init(&easyLink_params) != EasyLink_Status_Success)
+    {
+        System_abort("EasyLink_init failed");
+    }
+
+    EasyLink_setFrequency(frequency);
+    enableRxAddrFilter();
+
+    currentPhy = phy;
+    phyFailures = 0;
+    Energy_setModel(energyModels[currentPhy]);
+
+    /* The margin is another on this PHY, start again from full power */
+    loadTxPowerTable();
+    marginSamples = 0;
+}
+
+/*
+ * The TX power levels of the current PHY, without the top level of the
+ * default PA when the VDDR boost it needs is not enabled (EasyLink refuses
+ * it). The radio is back at its default power after EasyLink_init, the
+ * next transmission goes out at the highest level.
+ */
+static void loadTxPowerTable(void)
+{
+    uint8_t     i;
+
+    txPowerTable = NULL;
+    txPowerLevels = 0;
+    for (i = 0; i < EasyLink_numSupportedPhys; i++)
+    {
+        if ((EasyLink_supportedPhys[i].EasyLink_phyType == phyTypes[currentPhy]) &&
+            (EasyLink_supportedPhys[i].RF_pTxPowerTable != NULL))
+        {
+            txPowerTable = EasyLink_supportedPhys[i].RF_pTxPowerTable;
+            while ((txPowerLevels < EasyLink_supportedPhys[i].RF_txPowerTableSize) &&
+                   (txPowerTable[txPowerLevels].power != RF_TxPowerTable_INVALID_DBM))
+            {
+                txPowerLevels++;
+            }
+#if (CCFG_FORCE_VDDR_HH != 0x1)
+            if ((txPowerLevels > 1) && (txPowerTable[txPowerLevels - 1].value.paType == RF_TxPowerTable_DefaultPA))
+            {
+                txPowerLevels--;
+            }
+#endif
+            break;
+        }
+    }
+
+    if (EasyLink_getRfPower(&txPowerDbm) == EasyLink_Status_Success)
+    {
+        Energy_setTxPower(txPowerDbm);
+    }
+
+    maxTxPowerLevel = txPowerLevelFor(maxTxPowerDbm);
+    raiseTxPower(maxTxPowerLevel);
+}
+
+/* Highest level at or below the power, the lowest level below the table */
+static uint8_t txPowerLevelFor(int8_t powerDbm)
+{
+    uint8_t     level = 0;
+
+    while ((level + 1 < txPowerLevels) && (txPowerTable[level + 1].power <= powerDbm))
+    {
+        level++;
+    }
+
+    return level;
+}
+
+/*
+ * Step the TX power toward the target margin of the concentrator RSSI over
+ * the PHY sensitivity, one step per ACK and only out of the hysteresis.
+ */
+static void controlTxPower(int8_t rssi)
+{
+    static const int8_t sensitivities[RADIO_PHY_COUNT] = RADIO_PHY_SENSITIVITIES_DBM;
+    int16_t     margin = rssi - sensitivities[currentPhy];
+
+    marginDb = (marginSamples == 0) ? margin : (3 * marginDb + margin) / 4;
+    if (marginSamples < 255)
+    {
+        marginSamples++;
+    }
+
+    if ((marginDb > NODERADIO_TARGET_MARGIN_DB + NODERADIO_MARGIN_HYSTERESIS_DB) && (txPowerLevel > 0))
+    {
+        txPowerLevel--;
+        marginDb -= txPowerDbm - txPowerTable[txPowerLevel].power;
+        txPowerChanged = true;
+    }
+    else if ((marginDb < NODERADIO_TARGET_MARGIN_DB - NODERADIO_MARGIN_HYSTERESIS_DB) && (txPowerLevel < maxTxPowerLevel))
+    {
+        raiseTxPower(txPowerLevel + 1);
+        marginDb += txPowerTable[txPowerLevel].power - txPowerDbm;
+    }
+}
+
+/* Up to the maximum TX power level, applied before the next transmission */
+static void raiseTxPower(uint8_t level)
+{
+    txPowerLevel = (level < maxTxPowerLevel) ? level : maxTxPowerLevel;
+    txPowerChanged = true;
+}
+
+/* Time in ms until a transmission may start in the concentrator schedule. On
+ * the fast and long range PHYs it is the first half of their window. On the
+ * base PHY, once synced to the network time, it is outside these windows
+ * with room for the packet and its ACK before the next one. */
+static uint32_t phyWindowDelayMs(void)
+{
+    static const uint32_t windowStarts[] = { RADIO_PHY_FAST_WINDOW_START_MS, RADIO_PHY_LONG_RANGE_WINDOW_START_MS };
+    static const uint32_t windowLengths[] = { RADIO_PHY_FAST_WINDOW_MS, RADIO_PHY_LONG_RANGE_WINDOW_MS };
+    uint32_t    timeMs;
+    uint32_t    startMs;
+    uint32_t    lengthMs;
+    uint32_t    offsetMs;
+    uint32_t    delayMs;
+    uint32_t    i;
+
+    timeMs = NodeTask_getNetworkTime();
+
+    if ((currentPhy == RADIO_PHY_FAST) || (currentPhy == RADIO_PHY_LONG_RANGE))
+    {
+        startMs = (currentPhy == RADIO_PHY_FAST) ? RADIO_PHY_FAST_WINDOW_START_MS : RADIO_PHY_LONG_RANGE_WINDOW_START_MS;
+        lengthMs = (currentPhy == RADIO_PHY_FAST) ? RADIO_PHY_FAST_WINDOW_MS : RADIO_PHY_LONG_RANGE_WINDOW_MS;
+
+        offsetMs = (timeMs + RADIO_PHY_SUPERFRAME_MS - startMs) % RADIO_PHY_SUPERFRAME_MS;
+        if (offsetMs < RADIO_PHY_WINDOW_GUARD_MS)
+        {
+            return RADIO_PHY_WINDOW_GUARD_MS - offsetMs;
+        }
+        else if (offsetMs > lengthMs / 2)
+        {
+            return RADIO_PHY_SUPERFRAME_MS - offsetMs + RADIO_PHY_WINDOW_GUARD_MS;
+        }
+        return 0;
+    }
+
+    if (!timeSynced)
+    {
+        return 0;
+    }
+
+    /* Skip the windows until the base PHY time left before the next one is enough */
+    delayMs = 0;
+    for (i = 0; i < sizeof(windowStarts) / sizeof(windowStarts[0]); i++)
+    {
+        offsetMs = (timeMs + delayMs + RADIO_PHY_SUPERFRAME_MS - windowStarts[i]) % RADIO_PHY_SUPERFRAME_MS;
+        if (offsetMs < windowLengths[i] + RADIO_PHY_WINDOW_GUARD_MS)
+        {
+            delayMs += windowLengths[i] + RADIO_PHY_WINDOW_GUARD_MS - offsetMs;
+        }
+        else if (offsetMs > RADIO_PHY_SUPERFRAME_MS - RADIO_PHY_BASE_TX_MARGIN_MS)
+        {
+            delayMs += RADIO_PHY_SUPERFRAME_MS - offsetMs + windowLengths[i] + RADIO_PHY_WINDOW_GUARD_MS;
+        }
+    }
+
+    return delayMs;
+}
+
+static uint32_t ackTimeoutMs(void)
+{
+    return (currentPhy == RADIO_PHY_LONG_RANGE) ? NODERADIO_LONG_RANGE_ACK_TIMEOUT_TIME_MS : NORERADIO_ACK_TIMEOUT_TIME_MS;
+}
+
+static void applyTxPower(void)
+{
+    if (!txPowerChanged || (txPowerLevels == 0))
+    {
+        return;
+    }
+    txPowerChanged = false;
+
+    /* The maximum may have been lowered meanwhile */
+    maxTxPowerLevel = txPowerLevelFor(maxTxPowerDbm);
+    if (txPowerLevel > maxTxPowerLevel)
+    {
+        txPowerLevel = maxTxPowerLevel;
+    }
+
+    if (EasyLink_setRfPower(txPowerTable[txPowerLevel].power) == EasyLink_Status_Success)
+    {
+        txPowerDbm = txPowerTable[txPowerLevel].power;
+        Energy_setTxPower(txPowerDbm);
+    }
+    else
+    {
+        /* Still at the previous power */
+        txPowerLevel = txPowerLevelFor(txPowerDbm);
+    }
+}
+
+/* Transmit, started on the radio timer in the PHY window, with the airtime
+ * measured from that start time of the TX command */
+static EasyLink_Status transmitPacket(EasyLink_TxPacket *txPacket)
+{
+    EasyLink_Status status;
+    uint32_t        startTime = 0;
+    uint32_t        endTime = 0;
+    uint32_t        delayMs;
+
+    uint8_t         backoff = 0;
+
+    if ((txPowerLevels != 0) && (txPowerDbm < txPowerTable[maxTxPowerLevel].power))
+    {
+        backoff = (txPowerTable[maxTxPowerLevel].power - txPowerDbm + RADIO_POWER_BACKOFF_STEP_DB / 2) / RADIO_POWER_BACKOFF_STEP_DB;
+    }
+
+    /* Tell the concentrator how far below its maximum we transmit */
+    if (backoff > (RADIO_PACKET_OPTIONS_POWER_BACKOFF_MASK >> RADIO_PACKET_OPTIONS_POWER_BACKOFF_SHIFT))
+    {
+        backoff = RADIO_PACKET_OPTIONS_POWER_BACKOFF_MASK >> RADIO_PACKET_OPTIONS_POWER_BACKOFF_SHIFT;
+    }
+    txPacket->payload[2] = (txPacket->payload[2] & ~RADIO_PACKET_OPTIONS_POWER_BACKOFF_MASK) | (backoff << RADIO_PACKET_OPTIONS_POWER_BACKOFF_SHIFT);
+
+    /* The radio waits for the window, not the task */
+    EasyLink_getAbsTime(&startTime);
+    delayMs = phyWindowDelayMs();
+    startTime += EasyLink_ms_To_RadioTime(delayMs) + EasyLink_us_To_RadioTime(NODERADIO_TX_START_DELAY_US);
+    txPacket->absTime = (startTime != 0) ? startTime : 1;
+
+    status = EasyLink_transmit(txPacket);
+    EasyLink_getAbsTime(&endTime);
+
+    Energy_tx(endTime - startTime);
+
+    return status;
+}
+
+/* Enter RX, rxDoneCallback accounts the time listened */
+static EasyLink_Status receivePacket(void)
+{
+    EasyLink_getAbsTime(&rxStartTime);
+
+    return EasyLink_receiveAsync(rxDoneCallback, 0);
+}
+
+/* Receive the frames for the node and the broadcast frames */
+static void enableRxAddrFilter(void)
+{
+    uint8_t addresses[2] = { nodeAddress, RADIO_BROADCAST_ADDRESS };
+
+    if (EasyLink_enableRxAddrFilter(addresses, 1, 2) != EasyLink_Status_Success)
+    {
+        System_abort("EasyLink_enableRxAddrFilter failed");
+    }
+}
+
+/*
+ * Listen for the next broadcast slot, or wake up before it. Until the slots
+ * are known, or once the last broadcast frame is too old to find them, the
+ * window is a whole slot period. Slots the radio is busy in are skipped.
+ */
+static void openBroadcastWindow(void)
+{
+    uint32_t slotTime = EasyLink_ms_To_RadioTime(RADIO_BROADCAST_SLOT_MS);
+    uint32_t guardTime = EasyLink_us_To_RadioTime(RADIO_BROADCAST_GUARD_US);
+    uint32_t absTime;
+    uint32_t sinceFrame;
+    uint32_t untilSlot;
+    uint32_t rxTimeout;
+
+    Clock_stop(broadcastClockHandle);
+
+    if (!followBroadcast)
+    {
+        stopBroadcastRx();
+        return;
+    }
+
+    if (operationInProgress || receivingBroadcast || (EasyLink_getAbsTime(&absTime) != EasyLink_Status_Success))
+    {
+        return;
+    }
+
+    sinceFrame = absTime - broadcastFrameTime;
+    if (sinceFrame >= EasyLink_ms_To_RadioTime(NODERADIO_BROADCAST_RESYNC_MS))
+    {
+        broadcastSynced = false;
+    }
+
+    if (broadcastSynced)
+    {
+        /* Next slot whose frame has not started yet */
+        untilSlot = slotTime - sinceFrame % slotTime;
+        if (untilSlot > guardTime)
+        {
+            Clock_setTimeout(broadcastClockHandle, (untilSlot - guardTime) / EasyLink_us_To_RadioTime(Clock_tickPeriod) + 1);
+            Clock_start(broadcastClockHandle);
+            return;
+        }
+        rxTimeout = untilSlot + guardTime;
+    }
+    else
+    {
+        rxTimeout = slotTime + guardTime;
+    }
+
+    receivingBroadcast = true;
+    EasyLink_setCtrl(EasyLink_Ctrl_AsyncRx_TimeOut, rxTimeout);
+    if (receivePacket() != EasyLink_Status_Success)
+    {
+        System_abort("EasyLink_receiveAsync failed");
+    }
+}
+
+/* Give up the broadcast window in progress, the radio is needed */
+static void stopBroadcastRx(void)
+{
+    if (receivingBroadcast)
+    {
+        receivingBroadcast = false;
+        EasyLink_abort();
+    }
+}
+
+static void broadcastClockCallback(UArg arg0)
+{
+    Event_post(radioOperationEventHandle, RADIO_EVENT_BROADCAST_WINDOW);
+}
+
+static void receivePendingFrame(void)
+{
+    receivingPendingFrames = true;
+    framePending = false;
+
+    /* Enter RX and wait for the frame with a short timeout */
+    EasyLink_setCtrl(EasyLink_Ctrl_AsyncRx_TimeOut, EasyLink_ms_To_RadioTime(NODERADIO_FRAME_PENDING_TIMEOUT_MS));
+    if (receivePacket() != EasyLink_Status_Success)
+    {
+        System_abort("EasyLink_receiveAsync failed");
+    }
+}
+
+
+/* Keep an OAD frame sent to the broadcast address for the radio task */
+static bool saveBroadcastFrame(EasyLink_RxPacket * rxPacket, EasyLink_Status status)
+{
+    struct PacketHeader* packetHeader = (struct PacketHeader*)rxPacket->payload;
+
+    if ((status != EasyLink_Status_Success) ||
+        (rxPacket->dstAddr[0] != RADIO_BROADCAST_ADDRESS) ||
+        (packetHeader->packetType != RADIO_PACKET_TYPE_OAD_PACKET) ||
+        (rxPacket->len < sizeof(struct PacketHeader) + packetHeader->length))
+    {
+        return false;
+    }
+
+    memcpy(broadcastFrame, &rxPacket->payload[sizeof(struct PacketHeader)], packetHeader->length);
+    broadcastFrameLength = packetHeader->length;
+    broadcastFrameTime = rxPacket->absTime;
+
+    Event_post(radioOperationEventHandle, RADIO_EVENT_BROADCAST_RECEIVED);
+
+    return true;
+}
 
 static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status)
 {
     struct PacketHeader* packetHeader;
+    uint32_t rxEndTime = 0;
+
+    EasyLink_getAbsTime(&rxEndTime);
+    Energy_rx(rxEndTime - rxStartTime);
+
+    /* Given up by the radio task, which goes on with another operation */
+    if (status == EasyLink_Status_Aborted)
+    {
+        return;
+    }
+
+    /* A broadcast window ends with the frame or at its timeout */
+    if (receivingBroadcast)
+    {
+        receivingBroadcast = false;
+        if (!saveBroadcastFrame(rxPacket, status))
+        {
+            Event_post(radioOperationEventHandle, RADIO_EVENT_BROADCAST_DONE);
+        }
+        return;
+    }
 
     /* If this callback is called because of a packet received */
     if (status == EasyLink_Status_Success)
@@ -406,9 +1125,56 @@ static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status)
         /* Check the payload header */
         packetHeader = (struct PacketHeader*)rxPacket->payload;
 
+        /* A broadcast frame in the RX for a frame of ours, this one is lost */
+        if (saveBroadcastFrame(rxPacket, status))
+        {
+            Event_post(radioOperationEventHandle,
+                       receivingPendingFrames ? RADIO_EVENT_PENDING_FRAME_DONE : RADIO_EVENT_ACK_TIMEOUT);
+        }
+        /* A frame following the ACK */
+        else if (receivingPendingFrames)
+        {
+            if ((packetHeader->packetType == RADIO_PACKET_TYPE_OAD_PACKET) &&
+                (rxPacket->len >= sizeof(struct PacketHeader) + packetHeader->length))
+            {
+                memcpy(pendingFrame, &rxPacket->payload[sizeof(struct PacketHeader)], packetHeader->length);
+                pendingFrameLength = packetHeader->length;
+                framePending = (packetHeader->options & RADIO_PACKET_OPTIONS_FRAME_PENDING) != 0;
+
+                Event_post(radioOperationEventHandle, RADIO_EVENT_PENDING_FRAME_RECEIVED);
+            }
+            else
+            {
+                Event_post(radioOperationEventHandle, RADIO_EVENT_PENDING_FRAME_DONE);
+            }
+        }
         /* Check if this is an ACK packet */
-        if (packetHeader->packetType == RADIO_PACKET_TYPE_ACK_PACKET)
+        else if (packetHeader->packetType == RADIO_PACKET_TYPE_ACK_PACKET)
         {
+            uint8_t offset = sizeof(struct PacketHeader);
+            uint8_t length = packetHeader->length;
+
+            /* More frames follow the ACK */
+            framePending = (packetHeader->options & RADIO_PACKET_OPTIONS_FRAME_PENDING) != 0;
+
+            /* The RSSI the concentrator received our packet with */
+            ackRssiValid = false;
+            if ((packetHeader->options & RADIO_PACKET_OPTIONS_RSSI) && (length != 0) && (rxPacket->len > offset))
+            {
+                ackRssi = (int8_t)rxPacket->payload[offset++];
+                ackRssiValid = true;
+                length--;
+            }
+
+            /* Save the downlink piggy-backed on the ACK */
+            if ((length != 0) &&
+                (length <= RADIO_ACK_DOWNLINK_MAX_LENGTH) &&
+                (rxPacket->len >= offset + length))
+            {
+                memcpy(ackDownlink, &rxPacket->payload[offset], length);
+                ackDownlinkLength = length;
+            }
+
             /* Signal ACK packet received */
             Event_post(radioOperationEventHandle, RADIO_EVENT_DATA_ACK_RECEIVED);
         }
@@ -419,6 +1185,11 @@ static void rxDoneCallback(EasyLink_RxPacket * rxPacket, EasyLink_Status status)
             Event_post(radioOperationEventHandle, RADIO_EVENT_ACK_TIMEOUT);
         }
     }
+    /* no more frames followed the ACK */
+    else if(receivingPendingFrames)
+    {
+        Event_post(radioOperationEventHandle, RADIO_EVENT_PENDING_FRAME_DONE);
+    }
     /* did the Rx timeout */
     else if(status == EasyLink_Status_Rx_Timeout)
     {
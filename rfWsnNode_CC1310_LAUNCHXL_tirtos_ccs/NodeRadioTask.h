@@ -34,6 +34,7 @@
 #define TASKS_NODERADIOTASKTASK_H_
 
 #include "stdint.h"
+#include "stdbool.h"
 
 enum NodeRadioOperationStatus {
     NodeRadioStatus_Success,
@@ -41,12 +42,37 @@ enum NodeRadioOperationStatus {
     NodeRadioStatus_FailedNotConnected,
 };
 
+typedef void (*NodeRadio_AckDownlinkCallback)(uint8_t* data, uint8_t length);
+typedef void (*NodeRadio_OadPacketCallback)(uint8_t* data, uint8_t length);
+
 /* Initializes the NodeRadioTask and creates all TI-RTOS objects */
 void NodeRadioTask_init(void);
 
+/* Register the callback for downlinks carried in ACK packets */
+void NodeRadioTask_registerAckDownlinkCallback(NodeRadio_AckDownlinkCallback callback);
+
+/* Register the callback for OAD packets received after an ACK or broadcast, called from the radio task */
+void NodeRadioTask_registerOadPacketCallback(NodeRadio_OadPacketCallback callback);
+
 enum NodeRadioOperationStatus NodeRadioTask_sendRawData(uint8_t *data, uint16_t length);
+enum NodeRadioOperationStatus NodeRadioTask_sendOadData(uint8_t *data, uint16_t length);
+enum NodeRadioOperationStatus NodeRadioTask_sendEnergyReport(uint8_t *data, uint16_t length);
 enum NodeRadioOperationStatus NodeRadioTask_testReset(void);
 
+/* Resends of a raw data packet without ACK */
+void NodeRadioTask_setMaxRetries(uint8_t retries);
+
+/* Highest TX power, the radio task lowers the power while the concentrator receives us with margin */
+void NodeRadioTask_setMaxTxPower(int8_t powerDbm);
+
+/* PHY of the next transmissions, RADIO_PHY_xxx */
+void NodeRadioTask_setPhy(uint8_t phy);
+uint8_t NodeRadioTask_getPhy(void);
+
+/* Listen in the broadcast slots of the concentrator while the radio is idle,
+ * broadcast OAD packets go to the OAD packet callback */
+void NodeRadioTask_followBroadcast(bool follow);
+
 /* Get node address, return 0 if node address has not been set */
 uint8_t nodeRadioTask_getNodeAddr(void);
 
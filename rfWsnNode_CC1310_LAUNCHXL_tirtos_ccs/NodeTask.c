@@ -31,6 +31,9 @@
  */
 
 /***** Includes *****/
+/* Standard C Libraries */
+#include <string.h>
+
 /* XDCtools Header files */ 
 #include <xdc/std.h>
 #include <xdc/runtime/System.h>
@@ -50,6 +53,7 @@
 
 #include <ti/devices/DeviceFamily.h>
 #include DeviceFamily_constructPath(driverlib/cpu.h)
+#include DeviceFamily_constructPath(driverlib/sys_ctrl.h)
 
 #include "easylink/EasyLink.h"
 
@@ -59,9 +63,14 @@
 /* Application Header files */ 
 #include "NodeTask.h"
 #include "NodeRadioTask.h"
+#include "RadioProtocol.h"
 #include "DataQueue.h"
 #include "Trace.h"
 #include "mpu6050.h"
+#include "vibration.h"
+#include "burst.h"
+#include "battery.h"
+#include "energy.h"
 
 /***** Defines *****/
 #define NODE_TASK_STACK_SIZE 1024
@@ -79,6 +88,29 @@
 #define NODE_EVENT_WAKEUP               (uint32_t)(1 << 9)
 #define NODE_EVENT_MOTION_DETECTION_START    (uint32_t)(1 << 10)
 #define NODE_EVENT_MOTION_DETECTION_STOP     (uint32_t)(1 << 11)
+#define NODE_EVENT_MOTION_DETECTED           (uint32_t)(1 << 12)
+#define NODE_EVENT_FEATURE_EXTRACTION        (uint32_t)(1 << 13)
+#define NODE_EVENT_BURST_START               (uint32_t)(1 << 14)
+#define NODE_EVENT_BURST_STOP                (uint32_t)(1 << 15)
+#define NODE_EVENT_BURST_POLL                (uint32_t)(1 << 16)
+#define NODE_EVENT_BURST_TRIGGER             (uint32_t)(1 << 17)
+#define NODE_EVENT_BATTERY_LEVEL             (uint32_t)(1 << 18)
+#define NODE_EVENT_ENERGY_REPORT             (uint32_t)(1 << 19)
+#define NODE_EVENT_INSTALL_IMAGE             (uint32_t)(1 << 20)
+#define NODE_EVENT_APPLY_CONFIG              (uint32_t)(1 << 21)
+
+#define NODE_MOTION_THRESHOLD_MG        200     /* Default wake on motion threshold */
+#define NODE_MOTION_DURATION_MS         1
+
+#define NODE_FEATURE_PERIOD_MS          60000   /* Default vibration feature period */
+
+#define NODE_BURST_QUEUE_DEPTH          8       /* Queued burst fragments, the rest of the queue is left to other data */
+#define NODE_HOLD_QUEUE_DEPTH           8       /* Queued packets sent without waiting for the hold time */
+
+#define NODE_ENERGY_REPORT_PERIOD_MS    60000   /* Energy report to the concentrator */
+
+#define NODE_MIN_TX_POWER_DBM           (-10)   /* Range of the configured TX power */
+#define NODE_MAX_TX_POWER_DBM           14
 
 #define TRANSFER_EVENT_ALL              0xFFFFFFFF
 #define TRANSFER_EVENT_SUCCESS          (uint32_t)(1 << 1)
@@ -110,6 +142,22 @@ static Clock_Handle messageTimeoutClockHandle;
 Clock_Struct postMotionDetectedTimeoutClock;     /* not static so you can see in ROV */
 static Clock_Handle postMotionDetectedTimeoutClockHandle;
 
+/* Clock for the vibration feature period */
+Clock_Struct featureExtractionClock;     /* not static so you can see in ROV */
+static Clock_Handle featureExtractionClockHandle;
+
+/* Clock for the burst capture FIFO drain and fragment sending */
+Clock_Struct burstClock;     /* not static so you can see in ROV */
+static Clock_Handle burstClockHandle;
+
+/* Clock holding the queued packets on a low battery */
+Clock_Struct transferHoldClock;     /* not static so you can see in ROV */
+static Clock_Handle transferHoldClockHandle;
+
+/* Clock for the energy report period */
+Clock_Struct energyReportClock;     /* not static so you can see in ROV */
+static Clock_Handle energyReportClockHandle;
+
 /* Display driver handles */
 Display_Handle hDisplaySerial;
 
@@ -161,8 +209,17 @@ static  uint32_t    messageGenerationOverrunSleep = 200;
 
 static  bool        overrun = false;
 
-static  uint32_t    motionDetectionTryCount = 0;
-static  uint32_t    motionDetectionMaxCount = 10;
+static  bool        motionDetectionEnabled = false;
+static  uint16_t    motionThresholdMg = NODE_MOTION_THRESHOLD_MG;
+
+static  bool        burstEnabled = false;
+static  uint16_t    burstPreFrames = BURST_PRE_FRAMES;
+static  uint16_t    burstPostFrames = BURST_POST_FRAMES;
+static  uint16_t    burstThresholdMg = NODE_MOTION_THRESHOLD_MG;
+
+static  uint32_t    featurePeriodMs = NODE_FEATURE_PERIOD_MS;
+static  bool        transferHoldElapsed = false;
+static  bool        installImagePending = false;
 
 static  uint32_t    noitificationTryCount = 0;
 static  uint32_t    noitificationMaxCount = 10;
@@ -170,6 +227,8 @@ static  uint32_t    noitificationMaxCount = 10;
 static  uint8_t     directTransferData[128];
 static  uint32_t    directTransferDataLength = 0;
 
+static  uint32_t    networkTimeOffset = 0;
+
 #define msToClock(ms) ((ms) * 1000 / Clock_tickPeriod)
 
 /***** Prototypes *****/
@@ -177,6 +236,10 @@ static void nodeTaskFunction(UArg arg0, UArg arg1);
 static void transferTimeoutCallback(UArg arg0);
 static void messageTimeoutCallback(UArg arg0);
 static void postMotionDetectedTimeoutCallback(UArg arg0);
+static void featureExtractionCallback(UArg arg0);
+static void burstClockCallback(UArg arg0);
+static void transferHoldCallback(UArg arg0);
+static void energyReportClockCallback(UArg arg0);
 
 static void NodeTask_eventTestTransferStart(void);
 static void NodeTask_eventTestTransferStop(void);
@@ -184,16 +247,37 @@ static void NodeTask_eventTestReset(void);
 
 static void NodeTask_eventMotionDetectionStart(void);
 static void NodeTask_eventMotionDetectionStop(void);
+static void NodeTask_eventMotionDetected(void);
+static void NodeTask_motionCallback(void);
+
+static void NodeTask_eventFeatureExtraction(void);
+
+static void NodeTask_eventBurstStart(void);
+static void NodeTask_eventBurstStop(void);
+static void NodeTask_eventBurstPoll(void);
+static void NodeTask_burstTriggerCallback(void);
+
+static void NodeTask_batteryLevelCallback(BATTERY_LEVEL level);
+static void NodeTask_eventBatteryLevel(void);
+static void NodeTask_applyMaxTxPower(void);
+
+static void NodeTask_eventEnergyReport(void);
+static void NodeTask_eventInstallImage(void);
+static void NodeTask_eventApplyConfig(void);
 
 static void NodeTask_eventDataTransfer(void);
 static void NodeTask_eventPostTransfer(void);
 
 static void NodeTask_postNotification(uint8_t _type);
+static void NodeTask_postNotificationData(uint8_t _type, uint8_t* data, uint32_t length);
 static void NodeTask_postMotionDetected(void);
 
 static void NodeTask_dataTransferSuccess(void);
+static uint64_t NodeTask_localTimeMs(void);
 static void NodeTask_dataTransferFailed(void);
 
+static void NodeTask_ackDownlinkCallback(uint8_t* data, uint8_t length);
+
 
 /***** Function definitions *****/
 void NodeTask_init(void)
@@ -226,6 +310,24 @@ void NodeTask_init(void)
     Clock_construct(&postMotionDetectedTimeoutClock, postMotionDetectedTimeoutCallback, 0, &clkParams);
     postMotionDetectedTimeoutClockHandle = Clock_handle(&postMotionDetectedTimeoutClock);
 
+    Clock_construct(&featureExtractionClock, featureExtractionCallback, 0, &clkParams);
+    featureExtractionClockHandle = Clock_handle(&featureExtractionClock);
+
+    clkParams.period = msToClock(BURST_POLL_MS);
+    Clock_construct(&burstClock, burstClockCallback, clkParams.period, &clkParams);
+    burstClockHandle = Clock_handle(&burstClock);
+
+    clkParams.period = 0;
+    Clock_construct(&transferHoldClock, transferHoldCallback, 0, &clkParams);
+    transferHoldClockHandle = Clock_handle(&transferHoldClock);
+
+    clkParams.period = msToClock(NODE_ENERGY_REPORT_PERIOD_MS);
+    clkParams.startFlag = TRUE;
+    Clock_construct(&energyReportClock, energyReportClockCallback, clkParams.period, &clkParams);
+    energyReportClockHandle = Clock_handle(&energyReportClock);
+
+    Battery_init(NodeTask_batteryLevelCallback);
+
     /* Create the node task */
     Task_Params_init(&nodeTaskParams);
     nodeTaskParams.stackSize = NODE_TASK_STACK_SIZE;
@@ -261,6 +363,12 @@ static void nodeTaskFunction(UArg arg0, UArg arg1)
 
     MPU6050_init();
 
+    NodeRadioTask_registerAckDownlinkCallback(NodeTask_ackDownlinkCallback);
+
+    /* Start with the policy of the current battery level */
+    Battery_sample();
+    NodeTask_eventBatteryLevel();
+
     while (1)
     {
         /* Wait for event */
@@ -318,6 +426,57 @@ static void nodeTaskFunction(UArg arg0, UArg arg1)
         {
             NodeTask_eventMotionDetectionStop();
         }
+
+        if( events & NODE_EVENT_MOTION_DETECTED)
+        {
+            NodeTask_eventMotionDetected();
+        }
+
+        if( events & NODE_EVENT_FEATURE_EXTRACTION)
+        {
+            NodeTask_eventFeatureExtraction();
+        }
+
+        if( events & NODE_EVENT_BURST_START)
+        {
+            NodeTask_eventBurstStart();
+        }
+        else if( events & NODE_EVENT_BURST_STOP)
+        {
+            NodeTask_eventBurstStop();
+        }
+
+        if( events & NODE_EVENT_BURST_TRIGGER)
+        {
+            Burst_trigger();
+            Trace_printf(hDisplaySerial, "Burst triggered");
+        }
+
+        if( events & NODE_EVENT_BURST_POLL)
+        {
+            NodeTask_eventBurstPoll();
+        }
+
+        if( events & NODE_EVENT_BATTERY_LEVEL)
+        {
+            NodeTask_eventBatteryLevel();
+        }
+
+        if( events & NODE_EVENT_ENERGY_REPORT)
+        {
+            NodeTask_eventEnergyReport();
+        }
+
+        /* Checked again on every wake up until the queue is sent */
+        if ((events & NODE_EVENT_INSTALL_IMAGE) || installImagePending)
+        {
+            NodeTask_eventInstallImage();
+        }
+
+        if( events & NODE_EVENT_APPLY_CONFIG)
+        {
+            NodeTask_eventApplyConfig();
+        }
     }
 }
 
@@ -369,6 +528,27 @@ void postMotionDetectedTimeoutCallback(UArg arg0)
     }
 }
 
+static void featureExtractionCallback(UArg arg0)
+{
+    Event_post(nodeEventHandle, NODE_EVENT_FEATURE_EXTRACTION);
+}
+
+static void burstClockCallback(UArg arg0)
+{
+    Event_post(nodeEventHandle, NODE_EVENT_BURST_POLL);
+}
+
+static void energyReportClockCallback(UArg arg0)
+{
+    Event_post(nodeEventHandle, NODE_EVENT_ENERGY_REPORT);
+}
+
+static void transferHoldCallback(UArg arg0)
+{
+    transferHoldElapsed = true;
+    Event_post(nodeEventHandle, NODE_EVENT_POST_TRANSFER);
+}
+
 void NodeTask_dataOn(void)
 {
     //stop fast report
@@ -427,24 +607,115 @@ void    NodeTask_wakeup(void)
     Event_post(nodeEventHandle, NODE_EVENT_WAKEUP);
 }
 
-void    NodeTask_motionDetectionStart(void)
+void    NodeTask_installImage(void)
 {
-    motionDetectionTryCount = 0;
+    Event_post(nodeEventHandle, NODE_EVENT_INSTALL_IMAGE);
+}
+
+void    NodeTask_motionDetectionStart(uint16_t thresholdMg)
+{
+    motionThresholdMg = (thresholdMg != 0) ? thresholdMg : NODE_MOTION_THRESHOLD_MG;
+    motionDetectionEnabled = true;
     Event_post(nodeEventHandle, NODE_EVENT_MOTION_DETECTION_START);
 }
 
 void    NodeTask_motionDetectionStop(void)
 {
-    motionDetectionTryCount = motionDetectionMaxCount;
+    motionDetectionEnabled = false;
     Event_post(nodeEventHandle, NODE_EVENT_MOTION_DETECTION_STOP);
 }
 
+void    NodeTask_featureExtractionStart(uint32_t periodMs)
+{
+    if (periodMs == 0)
+    {
+        periodMs = NODE_FEATURE_PERIOD_MS;
+    }
+
+    featurePeriodMs = periodMs;
+
+    /* Slower on a low battery */
+    periodMs *= Battery_getPolicy()->rateDivider;
+
+    Clock_stop(featureExtractionClockHandle);
+    Clock_setTimeout(featureExtractionClockHandle, msToClock(periodMs));
+    Clock_setPeriod(featureExtractionClockHandle, msToClock(periodMs));
+    Clock_start(featureExtractionClockHandle);
+}
+
+void    NodeTask_featureExtractionStop(void)
+{
+    Clock_stop(featureExtractionClockHandle);
+}
+
+void    NodeTask_burstCaptureStart(uint16_t preFrames, uint16_t postFrames, uint16_t thresholdMg)
+{
+    burstPreFrames = (preFrames != 0) ? preFrames : BURST_PRE_FRAMES;
+    burstPostFrames = (postFrames != 0) ? postFrames : BURST_POST_FRAMES;
+    burstThresholdMg = (thresholdMg != 0) ? thresholdMg : NODE_MOTION_THRESHOLD_MG;
+    burstEnabled = true;
+
+    /* The burst capture takes over the accelerometer and its interrupt */
+    motionDetectionEnabled = false;
+    Event_post(nodeEventHandle, NODE_EVENT_MOTION_DETECTION_STOP | NODE_EVENT_BURST_START);
+}
+
+void    NodeTask_burstCaptureStop(void)
+{
+    burstEnabled = false;
+    Event_post(nodeEventHandle, NODE_EVENT_BURST_STOP);
+}
+
+/* Called from the battery clock when the battery level changed */
+static void NodeTask_batteryLevelCallback(BATTERY_LEVEL level)
+{
+    Event_post(nodeEventHandle, NODE_EVENT_BATTERY_LEVEL);
+}
+
+void    NodeTask_eventBatteryLevel(void)
+{
+    const BATTERY_POLICY*   policy = Battery_getPolicy();
+
+    NodeTask_applyMaxTxPower();
+    NodeRadioTask_setMaxRetries(policy->radioRetries);
+    transferMaxRetryCount = policy->transferRetries;
+
+    if (Clock_isActive(featureExtractionClockHandle))
+    {
+        NodeTask_featureExtractionStart(featurePeriodMs);
+    }
+
+    Trace_printf(hDisplaySerial, "Battery : %d mV, %d C, level %d, max %d dBm", Battery_getVoltageMv(), Battery_getTemperature(), Battery_getLevel(), policy->maxTxPowerDbm);
+}
+
+/* Called from the MPU6050 pin interrupt while the burst capture is armed */
+static void NodeTask_burstTriggerCallback(void)
+{
+    Event_post(nodeEventHandle, NODE_EVENT_BURST_TRIGGER);
+}
+
+/* Called from the MPU6050 pin interrupt */
+static void NodeTask_motionCallback(void)
+{
+    Event_post(nodeEventHandle, NODE_EVENT_MOTION_DETECTED);
+}
+
 void    NodeTask_postNotification(uint8_t _type)
+{
+    NodeTask_postNotificationData(_type, NULL, 0);
+}
+
+void    NodeTask_postNotificationData(uint8_t _type, uint8_t* data, uint32_t length)
 {
     //stop fast report
     static uint8_t buffer[128];
     uint8_t dataLength = 0;
 
+    if (length > sizeof(buffer) - 9)
+    {
+        return;
+    }
+
     buffer[dataLength++] = 0;
     buffer[dataLength++] = 0;
     buffer[dataLength++] = 0;
@@ -452,9 +723,15 @@ void    NodeTask_postNotification(uint8_t _type)
     buffer[dataLength++] = 1;   // Port
     buffer[dataLength++] = 0;   // Option
     buffer[dataLength++] = 0;   // Count
-    buffer[dataLength++] = 1;   // Size
+    buffer[dataLength++] = 1 + length;   // Size
     buffer[dataLength++] = _type;
 
+    if (length != 0)
+    {
+        memcpy(&buffer[dataLength], data, length);
+        dataLength += length;
+    }
+
     if (DataQ_push(buffer, dataLength) == true)
     {
         Event_post(nodeEventHandle, NODE_EVENT_POST_TRANSFER);
@@ -534,29 +811,167 @@ void    NodeTask_eventTestReset(void)
 
 void    NodeTask_eventMotionDetectionStart(void)
 {
-    if (++motionDetectionTryCount <= motionDetectionMaxCount)
+    if (!motionDetectionEnabled)
     {
-        Trace_printf(hDisplaySerial, "motion detection[%d]", motionDetectionTryCount);
-        if (MPU6050_startMotionDetection(0.4))
-        {
-            Trace_printf(hDisplaySerial, "Motion detected");
+        return;
+    }
+
+    /* The node sleeps until the sensor raises its motion interrupt */
+    if (MPU6050_startWakeOnMotion(motionThresholdMg, NODE_MOTION_DURATION_MS, NodeTask_motionCallback))
+    {
+        Trace_printf(hDisplaySerial, "motion detection : %d mg", motionThresholdMg);
+    }
+    else
+    {
+        Trace_printf(hDisplaySerial, "motion detection failed");
+    }
+}
+
+void    NodeTask_eventMotionDetectionStop(void)
+{
+    Clock_stop(postMotionDetectedTimeoutClockHandle);
+    MPU6050_stopWakeOnMotion();
+}
 
-            noitificationTryCount =  0;
+void    NodeTask_eventMotionDetected(void)
+{
+    MPU6050_SHADOW_STATS    stats;
 
-            NodeTask_postMotionDetected();
-            Clock_setPeriod(postMotionDetectedTimeoutClockHandle, msToClock(10000));
-            Clock_start(postMotionDetectedTimeoutClockHandle);
+    MPU6050_stopWakeOnMotion();
 
-        }
-        else
+    if (!motionDetectionEnabled)
+    {
+        return;
+    }
+
+    MPU6050_getShadowStats(&stats);
+    Trace_printf(hDisplaySerial, "Motion detected, I2C : %d transactions, %d saved", stats.transactions, stats.skipped + stats.coalesced);
+
+    noitificationTryCount =  0;
+
+    NodeTask_postMotionDetected();
+    Clock_setPeriod(postMotionDetectedTimeoutClockHandle, msToClock(10000));
+    Clock_start(postMotionDetectedTimeoutClockHandle);
+}
+
+void    NodeTask_eventFeatureExtraction(void)
+{
+    VIBRATION_FEATURES  features;
+    uint8_t     buffer[VIBRATION_FEATURES_LENGTH];
+    uint32_t    length;
+
+    /* The burst capture streams from the accelerometer */
+    if (burstEnabled)
+    {
+        return;
+    }
+
+    /* The capture takes the accelerometer, the motion interrupt is armed again after it */
+    if (!Vibration_capture(&features))
+    {
+        Trace_printf(hDisplaySerial, "Vibration capture failed");
+    }
+    else
+    {
+        length = Vibration_encode(&features, buffer, sizeof(buffer));
+
+        Trace_printf(hDisplaySerial, "Vibration RMS : %d %d %d mg",
+                     MPU6050_Q15_TO_MG(features.axis[0].rms),
+                     MPU6050_Q15_TO_MG(features.axis[1].rms),
+                     MPU6050_Q15_TO_MG(features.axis[2].rms));
+
+        NodeTask_postNotificationData(NODE_NOTIFICATION_TYPE_VIBRATION, buffer, length);
+    }
+
+    if (motionDetectionEnabled && !Clock_isActive(postMotionDetectedTimeoutClockHandle))
+    {
+        Event_post(nodeEventHandle, NODE_EVENT_MOTION_DETECTION_START);
+    }
+}
+
+void    NodeTask_eventBurstStart(void)
+{
+    if (!burstEnabled)
+    {
+        return;
+    }
+
+    Burst_stop();
+    if (Burst_start(burstPreFrames, burstPostFrames, burstThresholdMg, NodeTask_burstTriggerCallback))
+    {
+        Clock_start(burstClockHandle);
+        Trace_printf(hDisplaySerial, "Burst armed : %d/%d frames, %d mg", burstPreFrames, burstPostFrames, burstThresholdMg);
+    }
+    else
+    {
+        Clock_stop(burstClockHandle);
+        Trace_printf(hDisplaySerial, "Burst start failed");
+    }
+}
+
+void    NodeTask_eventBurstStop(void)
+{
+    Clock_stop(burstClockHandle);
+    Burst_stop();
+}
+
+void    NodeTask_eventBurstPoll(void)
+{
+    uint8_t     fragment[BURST_FRAGMENT_LENGTH];
+    uint32_t    length;
+
+    if (Burst_poll() != BURST_STATE_READY)
+    {
+        return;
+    }
+
+    /* Queue the fragments as the queue drains, one poll at a time */
+    while (DataQ_count() < NODE_BURST_QUEUE_DEPTH)
+    {
+        length = Burst_nextFragment(fragment, sizeof(fragment));
+        if (length == 0)
         {
-            Event_post(nodeEventHandle, NODE_EVENT_MOTION_DETECTION_START);
+            /* All sent, wait for the next event */
+            Trace_printf(hDisplaySerial, "Burst sent");
+            Event_post(nodeEventHandle, NODE_EVENT_BURST_START);
+            break;
         }
+
+        NodeTask_postNotificationData(NODE_NOTIFICATION_TYPE_BURST, fragment, length);
     }
 }
 
-void    NodeTask_eventMotionDetectionStop(void)
+void    NodeTask_eventEnergyReport(void)
 {
+    static  uint8_t report[ENERGY_REPORT_LENGTH];
+    ENERGY_STATS    stats;
+    uint32_t        length;
+
+    length = Energy_encodeReport(report, sizeof(report));
+
+    Energy_getStats(&stats);
+    Trace_printf(hDisplaySerial, "Energy : %d uJ, %d nJ/B, TX %d ms, RX %d ms, %d wakes", stats.energyUj, stats.energyPerByteNj, stats.txTimeMs, stats.rxTimeMs, stats.wakeCount);
+
+    if (NodeRadioTask_sendEnergyReport(report, length) != NodeRadioStatus_Success)
+    {
+        Trace_printf(hDisplaySerial, "Energy report failed");
+    }
+}
+
+static void NodeTask_eventInstallImage(void)
+{
+    installImagePending = true;
+
+    /* Reset between two radio operations, once the queued data is sent */
+    if (DataQ_count() != 0)
+    {
+        return;
+    }
+
+    Trace_printf(hDisplaySerial, "Installing the new image");
+
+    /* The BIM copies the image from the external flash and starts it */
+    SysCtrlSystemReset();
 }
 
 void    NodeTask_eventDataTransfer(void)
@@ -573,6 +988,17 @@ void    NodeTask_eventDataTransfer(void)
 
 void    NodeTask_eventPostTransfer(void)
 {
+    /* On a low battery hold the queue, the packets are then sent in one go */
+    if ((Battery_getPolicy()->holdMs != 0) && !transferHoldElapsed && (DataQ_count() < NODE_HOLD_QUEUE_DEPTH))
+    {
+        if (!Clock_isActive(transferHoldClockHandle))
+        {
+            Clock_setTimeout(transferHoldClockHandle, msToClock(Battery_getPolicy()->holdMs));
+            Clock_start(transferHoldClockHandle);
+        }
+        return;
+    }
+
     /* Toggle activity LED */
     if (DataQ_count() != 0)
     {
@@ -610,9 +1036,10 @@ void    NodeTask_eventPostTransfer(void)
 
         if (currentTransferTime / 1000 != previousTransferTime / 1000)
         {
-            Trace_printf(hDisplaySerial, "%8d %8d %8d %8d %8d %8d",
+            Trace_printf(hDisplaySerial, "%8d %8d %8d %8d %8d %8d %5dmV",
                            transferCount, transferDataSize, transferSuccessCount,
-                           totalTransferCount, totalTransferDataSize, totalTransferSuccessCount);
+                           totalTransferCount, totalTransferDataSize, totalTransferSuccessCount,
+                           Battery_getVoltageMv());
             transferCount =  0;
             transferDataSize = 0;
             transferSuccessCount = 0;
@@ -625,26 +1052,159 @@ void    NodeTask_eventPostTransfer(void)
     {
         Event_post(nodeEventHandle, NODE_EVENT_POST_TRANSFER);
     }
+    else
+    {
+        transferHoldElapsed = false;
+    }
+}
+
+/* Called from the radio task when an ACK carried a downlink */
+static void NodeTask_ackDownlinkCallback(uint8_t* data, uint8_t length)
+{
+    switch(data[0])
+    {
+    case    RADIO_DOWNLINK_TYPE_CONFIG:
+        if (length >= 5)
+        {
+            NODETASK_CONFIG config;
+
+            NodeTask_getConfig(&config);
+            config.frequency = ((uint32_t)data[1] << 24) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 8) | (uint32_t)data[4];
+            NodeTask_setConfig(&config);
+        }
+        break;
+
+    case    RADIO_DOWNLINK_TYPE_TIME_SYNC:
+        if (length >= 5)
+        {
+            uint32_t    concentratorTime;
+
+            concentratorTime = ((uint32_t)data[1] << 24) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 8) | (uint32_t)data[4];
+            networkTimeOffset = (uint32_t)(((uint64_t)concentratorTime + RADIO_NETWORK_TIME_WRAP_MS -
+                                            NodeTask_localTimeMs() % RADIO_NETWORK_TIME_WRAP_MS) % RADIO_NETWORK_TIME_WRAP_MS);
+        }
+        break;
+
+    case    RADIO_DOWNLINK_TYPE_PHY:
+        if ((length >= 6) && (data[1] < RADIO_PHY_COUNT))
+        {
+            uint32_t    concentratorTime;
+
+            /* The time aligns us on the concentrator PHY schedule */
+            concentratorTime = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 8) | (uint32_t)data[5];
+            networkTimeOffset = (uint32_t)(((uint64_t)concentratorTime + RADIO_NETWORK_TIME_WRAP_MS -
+                                            NodeTask_localTimeMs() % RADIO_NETWORK_TIME_WRAP_MS) % RADIO_NETWORK_TIME_WRAP_MS);
+
+            NodeRadioTask_setPhy(data[1]);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
 
+uint32_t    NodeTask_getNetworkTime(void)
+{
+    return  (uint32_t)((NodeTask_localTimeMs() + networkTimeOffset) % RADIO_NETWORK_TIME_WRAP_MS);
+}
+
+/* Local time in ms. The 32-bit tick count wraps after about 11.9 hours, the
+ * wraps are counted here. Between time syncs on a PHY with windows it is read
+ * before each transmission, so none is missed. */
+static uint64_t NodeTask_localTimeMs(void)
+{
+    static uint32_t lastTicks = 0;
+    static uint32_t tickWraps = 0;
+    uint32_t ticks;
+    uint64_t timeMs;
+    UInt key;
+
+    key = Task_disable();
+    ticks = Clock_getTicks();
+    if (ticks < lastTicks)
+    {
+        tickWraps++;
+    }
+    lastTicks = ticks;
+    timeMs = ((((uint64_t)tickWraps << 32) | ticks) * Clock_tickPeriod) / 1000;
+    Task_restore(key);
+
+    return  timeMs;
 }
 
 void    NodeTask_getRFStatus(NODETASK_STATUS* status)
 {
+    ENERGY_STATS    energy;
+
     status->frequency = EasyLink_getFrequency();
     EasyLink_getRfPower(&status->power);
     EasyLink_getRssi(&status->rssi);
+    status->batteryMv = Battery_getVoltageMv();
+    status->temperature = Battery_getTemperature();
+    status->batteryLevel = Battery_getLevel();
+    status->phy = NodeRadioTask_getPhy();
+
+    Energy_getStats(&energy);
+    status->txTimeMs = energy.txTimeMs;
+    status->rxTimeMs = energy.rxTimeMs;
+    status->radioWakes = energy.wakeCount;
+    status->deliveredBytes = energy.deliveredBytes;
+    status->energyUj = energy.energyUj;
+    status->energyPerByteNj = energy.energyPerByteNj;
+}
+
+
+/* The configured power is the highest the radio task may use, capped by the battery policy */
+static void NodeTask_applyMaxTxPower(void)
+{
+    int8_t      power = (int8_t)config_.power;
+
+    if (power > Battery_getPolicy()->maxTxPowerDbm)
+    {
+        power = Battery_getPolicy()->maxTxPowerDbm;
+    }
+
+    NodeRadioTask_setMaxTxPower(power);
 }
 
 
 void    NodeTask_getConfig(NODETASK_CONFIG* config)
 {
+    *config = config_;
     config->frequency = EasyLink_getFrequency();
 }
 
 
+/* Called from the SPI thread and the radio task, the node task applies it */
 bool    NodeTask_setConfig(NODETASK_CONFIG* config)
 {
-    EasyLink_setFrequency(config->frequency);
+    UInt        key;
+
+    if ((config->power < NODE_MIN_TX_POWER_DBM) || (config->power > NODE_MAX_TX_POWER_DBM))
+    {
+        return  false;
+    }
+
+    key = Task_disable();
+    config_.frequency = config->frequency;
+    config_.power = config->power;
+    Task_restore(key);
+
+    Event_post(nodeEventHandle, NODE_EVENT_APPLY_CONFIG);
 
     return  true;
 }
+
+static void NodeTask_eventApplyConfig(void)
+{
+    uint32_t    frequency;
+    UInt        key;
+
+    key = Task_disable();
+    frequency = config_.frequency;
+    Task_restore(key);
+
+    EasyLink_setFrequency(frequency);
+    NodeTask_applyMaxTxPower();
+}
@@ -36,6 +36,8 @@
 #include <ti/drivers/rf/RF.h>
 
 #define  NODE_NOTIFICATION_TYPE_MOTION_DETECTED   0x81
+#define  NODE_NOTIFICATION_TYPE_VIBRATION         0x82
+#define  NODE_NOTIFICATION_TYPE_BURST             0x83
 
 typedef struct
 {
@@ -51,6 +53,16 @@ typedef struct
     uint32_t    frequency;
     int8_t      power;
     int8_t      rssi;
+    uint16_t    batteryMv;
+    int8_t      temperature;
+    uint8_t     batteryLevel;   /* BATTERY_LEVEL */
+    uint32_t    txTimeMs;
+    uint32_t    rxTimeMs;
+    uint32_t    radioWakes;
+    uint32_t    deliveredBytes;
+    uint32_t    energyUj;
+    uint32_t    energyPerByteNj;
+    uint8_t     phy;            /* RADIO_PHY_xxx */
 }   NODETASK_STATUS;
 
 /* Initializes the Node Task and creates all TI-RTOS objects */
@@ -63,14 +75,35 @@ bool NodeTask_postTransfer(uint8_t* buffer, uint32_t length);
 void NodeTask_testTransferStart(void);
 void NodeTask_testTransferStop(void);
 
-void NodeTask_motionDetectionStart(void);
+/* Wake on motion above thresholdMg, 0 for the default threshold */
+void NodeTask_motionDetectionStart(uint16_t thresholdMg);
 void NodeTask_motionDetectionStop(void);
 
+/* Send vibration features every periodMs, 0 for the default period */
+void NodeTask_featureExtractionStart(uint32_t periodMs);
+void NodeTask_featureExtractionStop(void);
+
+/*
+ * Capture preFrames before and postFrames from a motion above thresholdMg and
+ * send them as a burst, 0 for the defaults. Stops the motion detection.
+ */
+void NodeTask_burstCaptureStart(uint16_t preFrames, uint16_t postFrames, uint16_t thresholdMg);
+void NodeTask_burstCaptureStop(void);
+
 void NodeTask_wakeup(void);
 
+/* Reset into the image stored by the OAD client once the queued data is sent,
+ * the BIM installs it */
+void NodeTask_installImage(void);
+
 void    NodeTask_getConfig(NODETASK_CONFIG* config);
+/* Checks the config, the node task then sets the frequency and the power */
 bool    NodeTask_setConfig(NODETASK_CONFIG* config);
 
 void    NodeTask_getRFStatus(NODETASK_STATUS* status);
 
+/* Local time in ms corrected by the last time sync received from the concentrator,
+ * modulo RADIO_NETWORK_TIME_WRAP_MS */
+uint32_t    NodeTask_getNetworkTime(void);
+
 #endif /* TASKS_NODETASK_H_ */
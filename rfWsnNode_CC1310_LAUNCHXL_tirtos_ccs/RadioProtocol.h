@@ -37,21 +37,103 @@
 #include "easylink/EasyLink.h"
 
 #define RADIO_CONCENTRATOR_ADDRESS     0x00
+/* Destination address of frames for every node that is listening */
+#define RADIO_BROADCAST_ADDRESS        0xFF
 
 /*
- * Uncomment to change the modulation away from the default found in the 
- * EASYLINK_PARAM_CONFIG macro in easylink_config.h
- *
- * Valid values can be found in the EasyLink_PhyType enum in EasyLink.h
+ * Broadcast frames of the concentrator start at a broadcast slot, every
+ * RADIO_BROADCAST_SLOT_MS on its radio timer. A node that follows a
+ * broadcast finds the slots from the first broadcast frame it receives and
+ * then listens from RADIO_BROADCAST_GUARD_US before each slot to as long
+ * after it.
+ */
+#define RADIO_BROADCAST_SLOT_MS        100
+#define RADIO_BROADCAST_GUARD_US       2000
+
+/*
+ * PHYs of the link, fastest first, as EasyLink_PhyType values. Nodes start
+ * on the base PHY and are moved by the concentrator with a
+ * RADIO_DOWNLINK_TYPE_PHY downlink when their link margin allows a faster
+ * PHY or needs a slower one. A node that loses the concentrator on another
+ * PHY falls back to the base PHY. The fast PHY is the custom 500 kbaud
+ * setting of smartrf_settings.c. All PHYs keep the frequency of the base PHY.
+ */
+#define RADIO_PHY_FAST                          0
+#define RADIO_PHY_BASE                          1
+#define RADIO_PHY_LONG_RANGE                    2
+#define RADIO_PHY_COUNT                         3
+
+#define RADIO_PHY_EASYLINK_TYPES                { EasyLink_Phy_Custom, EasyLink_Phy_50kbps2gfsk, EasyLink_Phy_5kbpsSlLr }
+
+/* Sensitivity of each PHY, the link margin is the RSSI above it */
+#define RADIO_PHY_SENSITIVITIES_DBM             { -95, -110, -120 }
+
+/*
+ * The concentrator listens on the fast and long range PHYs only in their
+ * window of a superframe on the network time, if a node uses them, and on
+ * the base PHY the rest of the time. Nodes on these PHYs start a
+ * transmission in the first half of their window. Nodes on the base PHY,
+ * once they have the network time, start one outside the windows and at
+ * least RADIO_PHY_BASE_TX_MARGIN_MS before the next one.
  */
-//#define DEFINED_RADIO_EASYLINK_MODULATION     EasyLink_Phy_Custom
+#define RADIO_PHY_SUPERFRAME_MS                 2000
+#define RADIO_PHY_FAST_WINDOW_START_MS          0
+#define RADIO_PHY_FAST_WINDOW_MS                200
+#define RADIO_PHY_LONG_RANGE_WINDOW_START_MS    1000
+#define RADIO_PHY_LONG_RANGE_WINDOW_MS          600     /* A full packet and its ACK from the middle of the window */
+#define RADIO_PHY_WINDOW_GUARD_MS               10
+#define RADIO_PHY_BASE_TX_MARGIN_MS             200     /* A full packet and its ACK on the base PHY */
+
+/*
+ * The network time in the downlinks is the concentrator time in ms modulo
+ * a whole number of superframes that fits in 32 bits, so the superframe
+ * position carries on over the wrap.
+ */
+#define RADIO_NETWORK_TIME_WRAP_MS              ((uint32_t)RADIO_PHY_SUPERFRAME_MS * 2000000)
 
 #define RADIO_PACKET_TYPE_ACK_PACKET            0
 #define RADIO_PACKET_TYPE_RAW_DATA_PACKET       1
 #define RADIO_PACKET_TYPE_TEST_RESET            2
+#define RADIO_PACKET_TYPE_OAD_PACKET            3
+#define RADIO_PACKET_TYPE_ENERGY_REPORT         4
 
 #define RADIO_PACKET_OPTIONS_CRC                (1 << 0)
 
+/*
+ * Set in the options of an ACK or OAD packet from the concentrator when
+ * another frame for the node follows it, the node stays in RX for it.
+ */
+#define RADIO_PACKET_OPTIONS_FRAME_PENDING      (1 << 1)
+
+/*
+ * Set in the options of an ACK when its first byte is the RSSI of the
+ * acknowledged packet, the downlink follows it. The node steers its TX
+ * power with it.
+ */
+#define RADIO_PACKET_OPTIONS_RSSI               (1 << 2)
+
+/*
+ * The node sets in the options of its packets how far its TX power is below
+ * its maximum, in RADIO_POWER_BACKOFF_STEP_DB steps, so the concentrator
+ * chooses the PHY on the RSSI the node would have at its maximum.
+ */
+#define RADIO_PACKET_OPTIONS_POWER_BACKOFF_SHIFT    4
+#define RADIO_PACKET_OPTIONS_POWER_BACKOFF_MASK     0xF0
+#define RADIO_POWER_BACKOFF_STEP_DB                 2
+
+/*
+ * Short downlink messages are carried inside the ACK frame so they cost no
+ * extra TX/RX turnaround. The ACK header length field holds the number of
+ * bytes after the header, the RSSI byte and the downlink bytes, the first
+ * of which is the downlink type.
+ */
+#define RADIO_ACK_DOWNLINK_MAX_LENGTH           16
+
+#define RADIO_DOWNLINK_TYPE_CONFIG              1   /* type, frequency[4] (big endian) */
+#define RADIO_DOWNLINK_TYPE_TIME_SYNC           2   /* type, concentrator time in ms[4] (big endian) */
+#define RADIO_DOWNLINK_TYPE_PHY                 3   /* type, PHY, concentrator time in ms[4] (big endian) */
+#define RADIO_DOWNLINK_TYPE_OAD                 4   /* type, OAD message (from the OAD server) */
+
 struct  PacketHeader {
     uint8_t     sourceAddress;
     uint8_t     packetType;
@@ -74,8 +156,28 @@ struct  RawDataPacket {
     uint8_t     data[EASYLINK_MAX_DATA_LENGTH - sizeof(struct PacketHeader) - sizeof(uint16_t)];
 };
 
+/*
+ * Radio energy of the node since its start, sent periodically. Fields big
+ * endian: TX airtime ms, RX listen ms, radio wake ups, payload bytes
+ * delivered, energy uJ and energy per delivered byte nJ.
+ */
+#define RADIO_ENERGY_REPORT_LENGTH              24
+
+struct EnergyReportPacket {
+    struct PacketHeader header;
+    uint8_t report[RADIO_ENERGY_REPORT_LENGTH];
+};
+
 struct AckPacket {
     struct PacketHeader header;
+    int8_t  rssi;
+    uint8_t downlink[RADIO_ACK_DOWNLINK_MAX_LENGTH];
+};
+
+/* OAD protocol message (oad/native_oad/oad_protocol.h), length in the header */
+struct OadPacket {
+    struct PacketHeader header;
+    uint8_t oadPayload[EASYLINK_MAX_DATA_LENGTH - sizeof(struct PacketHeader)];
 };
 
 union Packet {
@@ -83,6 +185,7 @@ union Packet {
     struct TestConfigPacket testConfig;
     struct RawDataPacket    rawData;
     struct AckPacket        ack;
+    struct OadPacket        oad;
 };
 
 #endif /* RADIOPROTOCOL_H_ */
@@ -237,6 +237,19 @@ void *slaveThread(void *arg0)
                     }
                     break;
 
+                case    RF_SPI_CMD_GET_STATUS:
+                    {
+                        NODETASK_STATUS   status;
+
+                        NodeTask_getRFStatus(&status);
+
+                        txBuffer.frame.cmd = rxBuffer.frame.cmd;
+                        txBuffer.frame.len = sizeof(NODETASK_STATUS);
+                        memcpy(txBuffer.frame.payload, &status, sizeof(NODETASK_STATUS));
+                        txBuffer.frame.crc =   CRC16_calc(txBuffer.frame.payload, txBuffer.frame.len);
+                    }
+                    break;
+
                 case    RF_SPI_CMD_SET_CONFIG:
                     {
                         Trace_printf(hDisplaySerial, "Request set RF config!");
@@ -279,7 +292,15 @@ void *slaveThread(void *arg0)
 
                 case    RF_SPI_CMD_START_MOTION_DETECTION:
                     {
-                        NodeTask_motionDetectionStart();
+                        uint16_t    thresholdMg = 0;
+
+                        /* Optional 16 bit threshold in mg */
+                        if (rxBuffer.frame.len >= 2)
+                        {
+                            thresholdMg = rxBuffer.frame.payload[0] | ((uint16_t)rxBuffer.frame.payload[1] << 8);
+                        }
+
+                        NodeTask_motionDetectionStart(thresholdMg);
                     }
                     break;
 
@@ -289,6 +310,51 @@ void *slaveThread(void *arg0)
                     }
                     break;
 
+                case    RF_SPI_CMD_START_FEATURE_EXTRACTION:
+                    {
+                        uint32_t    periodMs = 0;
+
+                        /* Optional 32 bit period in ms */
+                        if (rxBuffer.frame.len >= 4)
+                        {
+                            periodMs = rxBuffer.frame.payload[0] | ((uint32_t)rxBuffer.frame.payload[1] << 8) |
+                                       ((uint32_t)rxBuffer.frame.payload[2] << 16) | ((uint32_t)rxBuffer.frame.payload[3] << 24);
+                        }
+
+                        NodeTask_featureExtractionStart(periodMs);
+                    }
+                    break;
+
+                case    RF_SPI_CMD_STOP_FEATURE_EXTRACTION:
+                    {
+                        NodeTask_featureExtractionStop();
+                    }
+                    break;
+
+                case    RF_SPI_CMD_START_BURST_CAPTURE:
+                    {
+                        uint16_t    preFrames = 0;
+                        uint16_t    postFrames = 0;
+                        uint16_t    thresholdMg = 0;
+
+                        /* Optional 16 bit pre-trigger frames, post-trigger frames and threshold in mg */
+                        if (rxBuffer.frame.len >= 6)
+                        {
+                            preFrames = rxBuffer.frame.payload[0] | ((uint16_t)rxBuffer.frame.payload[1] << 8);
+                            postFrames = rxBuffer.frame.payload[2] | ((uint16_t)rxBuffer.frame.payload[3] << 8);
+                            thresholdMg = rxBuffer.frame.payload[4] | ((uint16_t)rxBuffer.frame.payload[5] << 8);
+                        }
+
+                        NodeTask_burstCaptureStart(preFrames, postFrames, thresholdMg);
+                    }
+                    break;
+
+                case    RF_SPI_CMD_STOP_BURST_CAPTURE:
+                    {
+                        NodeTask_burstCaptureStop();
+                    }
+                    break;
+
                 case    RF_SPI_CMD_DATA_TRANSFER:
                     {
                         if (!NodeTask_postTransfer(rxBuffer.frame.payload, rxBuffer.frame.len))
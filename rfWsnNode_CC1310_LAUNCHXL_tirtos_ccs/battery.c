@@ -0,0 +1,125 @@
+/*
+ * battery.c
+ *
+ *  AON battery monitor sampling and battery level policy.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include <ti/devices/DeviceFamily.h>
+#include DeviceFamily_constructPath(driverlib/aon_batmon.h)
+
+#include "battery.h"
+
+#define msToClock(ms) ((ms) * 1000 / Clock_tickPeriod)
+
+/* Indexed by BATTERY_LEVEL */
+static  const BATTERY_POLICY    policies_[] =
+{
+    { .holdMs = 0,      .rateDivider = 1,   .radioRetries = 2,  .transferRetries = 10,  .maxTxPowerDbm = BATTERY_MAX_TX_POWER_DBM },
+    { .holdMs = 2000,   .rateDivider = 2,   .radioRetries = 1,  .transferRetries = 3,   .maxTxPowerDbm = 10 },
+    { .holdMs = 10000,  .rateDivider = 4,   .radioRetries = 0,  .transferRetries = 1,   .maxTxPowerDbm = 0 }
+};
+
+/* Clock for the battery monitor sampling */
+Clock_Struct batteryClock;     /* not static so you can see in ROV */
+
+static  Battery_LevelCallback   callback_ = NULL;
+static  volatile uint16_t       voltageMv_ = 0;
+static  volatile int8_t         temperature_ = 0;
+static  volatile BATTERY_LEVEL  level_ = BATTERY_LEVEL_NORMAL;
+
+static void batteryClockCallback(UArg arg0)
+{
+    Battery_sample();
+}
+
+void    Battery_init(Battery_LevelCallback callback)
+{
+    Clock_Params clkParams;
+
+    callback_ = callback;
+
+    /* The monitor measures continuously, reading it is only a register access */
+    AONBatMonEnable();
+
+    Clock_Params_init(&clkParams);
+    clkParams.period = msToClock(BATTERY_SAMPLE_PERIOD_MS);
+    clkParams.startFlag = TRUE;
+    Clock_construct(&batteryClock, batteryClockCallback, msToClock(BATTERY_SAMPLE_PERIOD_MS), &clkParams);
+}
+
+void    Battery_sample(void)
+{
+    uint32_t        voltage;
+    BATTERY_LEVEL   level;
+    uint16_t        lowMv = BATTERY_LOW_MV;
+    uint16_t        criticalMv = BATTERY_CRITICAL_MV;
+
+    /* 3.8 fixed point volts */
+    voltage = AONBatMonBatteryVoltageGet();
+    voltageMv_ = (uint16_t)((voltage * 1000) >> 8);
+    temperature_ = (int8_t)AONBatMonTemperatureGetDegC();
+
+    /* Leave a level only once the voltage rose by the hysteresis */
+    if (level_ >= BATTERY_LEVEL_LOW)
+    {
+        lowMv += BATTERY_HYSTERESIS_MV;
+    }
+
+    if (level_ >= BATTERY_LEVEL_CRITICAL)
+    {
+        criticalMv += BATTERY_HYSTERESIS_MV;
+    }
+
+    if (voltageMv_ < criticalMv)
+    {
+        level = BATTERY_LEVEL_CRITICAL;
+    }
+    else if (voltageMv_ < lowMv)
+    {
+        level = BATTERY_LEVEL_LOW;
+    }
+    else
+    {
+        level = BATTERY_LEVEL_NORMAL;
+    }
+
+    if ((temperature_ < BATTERY_COLD_DEGC) && (level < BATTERY_LEVEL_CRITICAL))
+    {
+        level = (BATTERY_LEVEL)(level + 1);
+    }
+
+    if (level != level_)
+    {
+        level_ = level;
+        if (callback_ != NULL)
+        {
+            callback_(level);
+        }
+    }
+}
+
+uint16_t    Battery_getVoltageMv(void)
+{
+    return  voltageMv_;
+}
+
+int8_t      Battery_getTemperature(void)
+{
+    return  temperature_;
+}
+
+BATTERY_LEVEL   Battery_getLevel(void)
+{
+    return  level_;
+}
+
+const BATTERY_POLICY*   Battery_getPolicy(void)
+{
+    return  &policies_[level_];
+}
@@ -0,0 +1,59 @@
+/*
+ * battery.h
+ *
+ *  Battery voltage and temperature from the AON battery monitor, sampled on a
+ *  slow clock, and the transmit policy for the battery level.
+ */
+
+#ifndef BATTERY_H_
+#define BATTERY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BATTERY_SAMPLE_PERIOD_MS    30000   /* Battery monitor sampling period */
+
+#define BATTERY_LOW_MV              2700    /* Below, the node saves energy */
+#define BATTERY_CRITICAL_MV         2400    /* Below, the node sends only what it must */
+#define BATTERY_HYSTERESIS_MV       100     /* Rise needed to leave a level */
+#define BATTERY_COLD_DEGC           (-10)   /* Below, the cell sags under load, one level lower */
+
+/* Highest TX power of the default PA, 14dBm needs the VDDR boost */
+#if (CCFG_FORCE_VDDR_HH == 0x1)
+#define BATTERY_MAX_TX_POWER_DBM    14
+#else
+#define BATTERY_MAX_TX_POWER_DBM    13
+#endif
+
+typedef enum
+{
+    BATTERY_LEVEL_NORMAL = 0,
+    BATTERY_LEVEL_LOW,
+    BATTERY_LEVEL_CRITICAL
+}   BATTERY_LEVEL;
+
+/*
+ * What the node does at a battery level. Queued packets are held holdMs to
+ * be sent together, periodic work runs rateDivider times slower.
+ */
+typedef struct
+{
+    uint32_t    holdMs;
+    uint8_t     rateDivider;
+    uint8_t     radioRetries;       /* Resends of a packet without ACK */
+    uint8_t     transferRetries;    /* Transfers of a queued packet before it is dropped */
+    int8_t      maxTxPowerDbm;
+}   BATTERY_POLICY;
+
+/* Called from the clock Swi when the level changed */
+typedef void (*Battery_LevelCallback)(BATTERY_LEVEL level);
+
+void    Battery_init(Battery_LevelCallback callback);
+void    Battery_sample(void);
+
+uint16_t        Battery_getVoltageMv(void);
+int8_t          Battery_getTemperature(void);
+BATTERY_LEVEL   Battery_getLevel(void);
+const BATTERY_POLICY*   Battery_getPolicy(void);
+
+#endif /* BATTERY_H_ */
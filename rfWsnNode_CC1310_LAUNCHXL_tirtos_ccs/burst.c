@@ -0,0 +1,216 @@
+/*
+ * burst.c
+ *
+ *  Pre-trigger ring and fragment encoding of the triggered burst capture.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "burst.h"
+#include "mpu6050.h"
+
+#define BURST_FRAME_WORST_LENGTH    (3 * 3)     /* Three escaped axes */
+
+static  int16_t     ring_[BURST_RING_FRAMES * 3];
+static  uint32_t    framesWritten_ = 0;         /* Frames drained since start */
+static  uint32_t    triggerFrame_ = 0;
+static  uint32_t    windowStart_ = 0;
+static  uint16_t    windowFrames_ = 0;
+static  uint16_t    preFrames_ = BURST_PRE_FRAMES;
+static  uint16_t    postFrames_ = BURST_POST_FRAMES;
+static  uint16_t    nextFrame_ = 0;             /* Next frame of the window to send */
+static  uint8_t     sequence_ = 0;
+static  uint8_t     fragment_ = 0;
+static  bool        overflowed_ = false;
+static  uint32_t    overflowFrame_ = 0;         /* Frames drained before the last overflow */
+static  BURST_STATE state_ = BURST_STATE_IDLE;
+
+static  void        Burst_drain(uint32_t maxFrames);
+
+bool    Burst_start(uint16_t preFrames, uint16_t postFrames, uint16_t thresholdMg, Burst_TriggerCallback callback)
+{
+    if ((postFrames == 0) || ((uint32_t)preFrames + postFrames > BURST_RING_FRAMES))
+    {
+        return  false;
+    }
+
+    preFrames_ = preFrames;
+    postFrames_ = postFrames;
+    framesWritten_ = 0;
+    overflowed_ = false;
+
+    if (!MPU6050_startStream(BURST_SAMPLE_RATE_HZ, thresholdMg, callback))
+    {
+        state_ = BURST_STATE_IDLE;
+        return  false;
+    }
+
+    state_ = BURST_STATE_ARMED;
+
+    return  true;
+}
+
+void    Burst_stop(void)
+{
+    if ((state_ == BURST_STATE_ARMED) || (state_ == BURST_STATE_TRIGGERED))
+    {
+        MPU6050_stopStream();
+    }
+
+    state_ = BURST_STATE_IDLE;
+}
+
+BURST_STATE Burst_poll(void)
+{
+    if (state_ == BURST_STATE_ARMED)
+    {
+        Burst_drain(UINT32_MAX);
+    }
+    else if (state_ == BURST_STATE_TRIGGERED)
+    {
+        /* Stop at the end of the window, the ring must not wrap over its start */
+        Burst_drain(triggerFrame_ + postFrames_ - framesWritten_);
+
+        if (framesWritten_ >= triggerFrame_ + postFrames_)
+        {
+            MPU6050_stopStream();
+
+            windowStart_ = triggerFrame_ - ((triggerFrame_ < preFrames_) ? triggerFrame_ : preFrames_);
+            windowFrames_ = (uint16_t)(framesWritten_ - windowStart_);
+            nextFrame_ = 0;
+            fragment_ = 0;
+            sequence_++;
+
+            state_ = BURST_STATE_READY;
+        }
+    }
+
+    return  state_;
+}
+
+void    Burst_trigger(void)
+{
+    if (state_ != BURST_STATE_ARMED)
+    {
+        return;
+    }
+
+    Burst_drain(UINT32_MAX);
+
+    triggerFrame_ = framesWritten_;
+    state_ = BURST_STATE_TRIGGERED;
+}
+
+BURST_STATE Burst_getState(void)
+{
+    return  state_;
+}
+
+uint32_t    Burst_nextFragment(uint8_t* buffer, uint32_t maxLength)
+{
+    int16_t     previous[3] = { 0, 0, 0 };
+    uint32_t    length = BURST_FRAGMENT_HEADER_LENGTH;
+    uint16_t    first = nextFrame_;
+    uint8_t     frames = 0;
+    uint8_t     axis;
+
+    if ((state_ != BURST_STATE_READY) || (nextFrame_ >= windowFrames_))
+    {
+        state_ = BURST_STATE_IDLE;
+        return  0;
+    }
+
+    if (maxLength > BURST_FRAGMENT_LENGTH)
+    {
+        maxLength = BURST_FRAGMENT_LENGTH;
+    }
+
+    while ((nextFrame_ < windowFrames_) && (frames < BURST_FRAGMENT_FRAMES_MASK) &&
+           (length + BURST_FRAME_WORST_LENGTH <= maxLength))
+    {
+        const int16_t*  frame = &ring_[((windowStart_ + nextFrame_) % BURST_RING_FRAMES) * 3];
+
+        for(axis = 0 ; axis < 3 ; axis++)
+        {
+            int32_t delta = (int32_t)frame[axis] - previous[axis];
+
+            if ((delta > -BURST_ESCAPE) && (delta < BURST_ESCAPE))
+            {
+                buffer[length++] = (uint8_t)(int8_t)delta;
+            }
+            else
+            {
+                buffer[length++] = BURST_ESCAPE;
+                buffer[length++] = ((uint16_t)frame[axis] >> 8) & 0xFF;
+                buffer[length++] = (uint16_t)frame[axis] & 0xFF;
+            }
+
+            previous[axis] = frame[axis];
+        }
+
+        nextFrame_++;
+        frames++;
+    }
+
+    if (frames == 0)
+    {
+        return  0;
+    }
+
+    buffer[BURST_FRAGMENT_SEQUENCE_OFFSET] = sequence_;
+    buffer[BURST_FRAGMENT_INDEX_OFFSET] = fragment_++;
+    buffer[BURST_FRAGMENT_FRAMES_OFFSET] = frames;
+    if (overflowed_ && (overflowFrame_ > windowStart_))
+    {
+        buffer[BURST_FRAGMENT_FRAMES_OFFSET] |= BURST_FRAGMENT_DISCONTINUOUS;
+    }
+    buffer[BURST_FRAGMENT_FIRST_OFFSET] = (first >> 8) & 0xFF;
+    buffer[BURST_FRAGMENT_FIRST_OFFSET + 1] = first & 0xFF;
+    buffer[BURST_FRAGMENT_TOTAL_OFFSET] = (windowFrames_ >> 8) & 0xFF;
+    buffer[BURST_FRAGMENT_TOTAL_OFFSET + 1] = windowFrames_ & 0xFF;
+    buffer[BURST_FRAGMENT_TRIGGER_OFFSET] = ((triggerFrame_ - windowStart_) >> 8) & 0xFF;
+    buffer[BURST_FRAGMENT_TRIGGER_OFFSET + 1] = (triggerFrame_ - windowStart_) & 0xFF;
+
+    return  length;
+}
+
+/* Read the FIFO into the ring, at most maxFrames, in two parts when the ring wraps */
+static void Burst_drain(uint32_t maxFrames)
+{
+    uint16_t    head;
+    uint16_t    space;
+    uint16_t    frames;
+    bool        overflowed;
+
+    while (maxFrames > 0)
+    {
+        head = framesWritten_ % BURST_RING_FRAMES;
+        space = BURST_RING_FRAMES - head;
+        if (space > maxFrames)
+        {
+            space = (uint16_t)maxFrames;
+        }
+
+        frames = MPU6050_readStreamQ15(&ring_[head * 3], space, &overflowed);
+        if (overflowed)
+        {
+            /* The frames lost are between these two */
+            overflowed_ = true;
+            overflowFrame_ = framesWritten_;
+        }
+
+        if (frames == 0)
+        {
+            break;
+        }
+
+        framesWritten_ += frames;
+        maxFrames -= frames;
+
+        if (frames < space)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * burst.h
+ *
+ *  Triggered burst capture: the MPU6050 streams X, Y and Z frames into a
+ *  pre-trigger ring, the motion interrupt freezes a window around the event
+ *  which is then sent compressed in fragments.
+ */
+
+#ifndef BURST_H_
+#define BURST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BURST_SAMPLE_RATE_HZ        1000
+#define BURST_RING_FRAMES           512     /* 3 kB ring, pre + post frames at most */
+#define BURST_PRE_FRAMES            128     /* Default frames before the trigger */
+#define BURST_POST_FRAMES           384     /* Default frames from the trigger */
+#define BURST_POLL_MS               50      /* FIFO drain period, 50 frames of 170 */
+#define BURST_FRAGMENT_LENGTH       100     /* Longest encoded fragment */
+
+/*
+ * Fragment header, multi byte fields big endian, frame numbers relative to
+ * the first frame of the window.
+ */
+#define BURST_FRAGMENT_SEQUENCE_OFFSET  0   /* Burst sequence number */
+#define BURST_FRAGMENT_INDEX_OFFSET     1   /* Fragment number in the burst */
+#define BURST_FRAGMENT_FRAMES_OFFSET    2   /* Frames in the fragment, and the flag below */
+#define BURST_FRAGMENT_FIRST_OFFSET     3   /* 16b first frame of the fragment */
+#define BURST_FRAGMENT_TOTAL_OFFSET     5   /* 16b frames in the window */
+#define BURST_FRAGMENT_TRIGGER_OFFSET   7   /* 16b frame of the trigger */
+#define BURST_FRAGMENT_HEADER_LENGTH    9
+
+/*
+ * Set in the frames byte of every fragment of a window the FIFO overflowed
+ * in, frames are missing after the overflow and the frame numbers are no
+ * longer on the sample clock.
+ */
+#define BURST_FRAGMENT_DISCONTINUOUS    0x80
+#define BURST_FRAGMENT_FRAMES_MASK      0x7F
+
+/*
+ * Frame encoding, per axis: the 8b difference to the previous value of the
+ * axis, or BURST_ESCAPE followed by the 16b value. The previous values are 0
+ * at the start of each fragment so fragments decode on their own.
+ */
+#define BURST_ESCAPE                0x80
+
+typedef enum
+{
+    BURST_STATE_IDLE,
+    BURST_STATE_ARMED,          /* Filling the pre-trigger ring */
+    BURST_STATE_TRIGGERED,      /* Filling the post-trigger frames */
+    BURST_STATE_READY,          /* Window frozen, fragments to send */
+}   BURST_STATE;
+
+typedef void (*Burst_TriggerCallback)(void);
+
+/* Start streaming into the ring, the callback is called from the motion interrupt */
+bool        Burst_start(uint16_t preFrames, uint16_t postFrames, uint16_t thresholdMg, Burst_TriggerCallback callback);
+void        Burst_stop(void);
+
+/* Drain the FIFO into the ring, call every BURST_POLL_MS while armed or triggered */
+BURST_STATE Burst_poll(void);
+
+/* Mark the trigger, after the frames drained so far */
+void        Burst_trigger(void);
+
+BURST_STATE Burst_getState(void);
+
+/* Encode the next fragment of the frozen window, returns 0 once all are sent */
+uint32_t    Burst_nextFragment(uint8_t* buffer, uint32_t maxLength);
+
+#endif /* BURST_H_ */
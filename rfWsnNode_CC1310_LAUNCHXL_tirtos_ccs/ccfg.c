@@ -47,5 +47,8 @@
  *        remain unmodified.
  */
 
+/* Built for the off-chip OAD BIM, the CCFG is the one of the BIM */
+#ifndef OAD_IMG_E
 #include <ti/devices/DeviceFamily.h>
 #include DeviceFamily_constructPath(startup_files/ccfg.c)
+#endif
@@ -0,0 +1,188 @@
+/*
+ * energy.c
+ *
+ *  Radio energy accounting with a current model.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "energy.h"
+#include "battery.h"
+
+/* CC1310 868 MHz TX currents, the PA current does not depend on the PHY */
+#define ENERGY_CC1310_TX_LEVELS \
+    { \
+        { -10,  6100 }, \
+        {   0,  8000 }, \
+        {   5,  10100 }, \
+        {  10,  13400 }, \
+        {  12,  18300 }, \
+        {  14,  25100 } \
+    }
+
+/* 500 kbps 2-GFSK, the wider receiver draws more */
+const   ENERGY_MODEL    Energy_fastModel =
+{
+    .txLevels = ENERGY_CC1310_TX_LEVELS,
+    .rxCurrentUa = 6300,
+    .wakeChargeNc = 3000
+};
+
+/* 50 kbps 2-GFSK */
+const   ENERGY_MODEL    Energy_baseModel =
+{
+    .txLevels = ENERGY_CC1310_TX_LEVELS,
+    .rxCurrentUa = 5500,
+    .wakeChargeNc = 3000
+};
+
+/* 5 kbps SimpleLink long range, the correlator runs through the long preamble */
+const   ENERGY_MODEL    Energy_longRangeModel =
+{
+    .txLevels = ENERGY_CC1310_TX_LEVELS,
+    .rxCurrentUa = 5800,
+    .wakeChargeNc = 3500
+};
+
+static  ENERGY_MODEL    model_ = Energy_baseModel;
+static  uint16_t        txCurrentUa_ = 25100;
+
+/* Charges in pC (uA x us), the supply voltage is applied when read. The
+ * counters are updated from the RX callback too, they are accessed with
+ * the interrupts disabled. */
+static  uint64_t        txChargePc_ = 0;
+static  uint64_t        txTimeUs_ = 0;
+static  uint64_t        rxTimeUs_ = 0;
+static  uint32_t        wakeCount_ = 0;
+static  uint32_t        deliveredBytes_ = 0;
+static  int8_t          txPowerDbm_ = 14;
+
+void    Energy_setModel(const ENERGY_MODEL* model)
+{
+    UInt        key;
+
+    key = Hwi_disable();
+    model_ = *model;
+    Hwi_restore(key);
+
+    Energy_setTxPower(txPowerDbm_);
+}
+
+void    Energy_setTxPower(int8_t powerDbm)
+{
+    uint8_t     i;
+
+    txPowerDbm_ = powerDbm;
+
+    /* Nearest level at or above, the highest above the table */
+    txCurrentUa_ = model_.txLevels[ENERGY_TX_LEVELS - 1].currentUa;
+    for(i = 0 ; i < ENERGY_TX_LEVELS ; i++)
+    {
+        if (model_.txLevels[i].powerDbm >= powerDbm)
+        {
+            txCurrentUa_ = model_.txLevels[i].currentUa;
+            break;
+        }
+    }
+}
+
+void    Energy_tx(uint32_t ratTicks)
+{
+    uint32_t    us = ratTicks / ENERGY_RAT_TICKS_PER_US;
+    UInt        key;
+
+    key = Hwi_disable();
+    txTimeUs_ += us;
+    txChargePc_ += (uint64_t)us * txCurrentUa_;
+    Hwi_restore(key);
+}
+
+void    Energy_rx(uint32_t ratTicks)
+{
+    UInt        key;
+
+    key = Hwi_disable();
+    rxTimeUs_ += ratTicks / ENERGY_RAT_TICKS_PER_US;
+    Hwi_restore(key);
+}
+
+void    Energy_wake(void)
+{
+    wakeCount_++;
+}
+
+void    Energy_delivered(uint32_t bytes)
+{
+    deliveredBytes_ += bytes;
+}
+
+void    Energy_getStats(ENERGY_STATS* stats)
+{
+    uint64_t    chargePc;
+    uint64_t    energyNj;
+    uint64_t    txTimeUs;
+    uint64_t    rxTimeUs;
+    uint32_t    wakeCount;
+    uint32_t    deliveredBytes;
+    uint32_t    voltageMv = Battery_getVoltageMv();
+    UInt        key;
+
+    if (voltageMv == 0)
+    {
+        voltageMv = ENERGY_DEFAULT_MV;
+    }
+
+    key = Hwi_disable();
+    chargePc = txChargePc_ + rxTimeUs_ * model_.rxCurrentUa + (uint64_t)wakeCount_ * model_.wakeChargeNc * 1000;
+    txTimeUs = txTimeUs_;
+    rxTimeUs = rxTimeUs_;
+    wakeCount = wakeCount_;
+    deliveredBytes = deliveredBytes_;
+    Hwi_restore(key);
+
+    /* pC x mV = fJ */
+    energyNj = chargePc * voltageMv / 1000000;
+
+    stats->txTimeMs = (uint32_t)(txTimeUs / 1000);
+    stats->rxTimeMs = (uint32_t)(rxTimeUs / 1000);
+    stats->wakeCount = wakeCount;
+    stats->deliveredBytes = deliveredBytes;
+    stats->energyUj = (uint32_t)(energyNj / 1000);
+    stats->energyPerByteNj = (deliveredBytes != 0) ? (uint32_t)(energyNj / deliveredBytes) : 0;
+}
+
+static uint32_t Energy_put32(uint8_t* buffer, uint32_t value)
+{
+    buffer[0] = (value >> 24) & 0xFF;
+    buffer[1] = (value >> 16) & 0xFF;
+    buffer[2] = (value >>  8) & 0xFF;
+    buffer[3] = (value      ) & 0xFF;
+
+    return  4;
+}
+
+uint32_t    Energy_encodeReport(uint8_t* buffer, uint32_t maxLength)
+{
+    ENERGY_STATS    stats;
+    uint32_t        length = 0;
+
+    if (maxLength < ENERGY_REPORT_LENGTH)
+    {
+        return  0;
+    }
+
+    Energy_getStats(&stats);
+
+    length += Energy_put32(&buffer[length], stats.txTimeMs);
+    length += Energy_put32(&buffer[length], stats.rxTimeMs);
+    length += Energy_put32(&buffer[length], stats.wakeCount);
+    length += Energy_put32(&buffer[length], stats.deliveredBytes);
+    length += Energy_put32(&buffer[length], stats.energyUj);
+    length += Energy_put32(&buffer[length], stats.energyPerByteNj);
+
+    return  length;
+}
@@ -0,0 +1,67 @@
+/*
+ * energy.h
+ *
+ *  Radio energy accounting: TX airtime, RX listen time and radio wake ups
+ *  measured with the radio timer, turned into energy with a current model.
+ */
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ENERGY_RAT_TICKS_PER_US     4       /* Radio timer at 4 MHz */
+#define ENERGY_DEFAULT_MV           3000    /* Supply before the battery is sampled */
+#define ENERGY_TX_LEVELS            6
+#define ENERGY_REPORT_LENGTH        24      /* Energy_encodeReport() */
+
+/*
+ * Current model of the radio for a PHY. TX currents by power, the nearest
+ * level at or above the TX power is used. The wake up charge covers the
+ * radio power up and the synthesizer calibration of one operation, the TX
+ * time counts from the start of the TX command only.
+ */
+typedef struct
+{
+    int8_t      powerDbm;
+    uint16_t    currentUa;
+}   ENERGY_TX_LEVEL;
+
+typedef struct
+{
+    ENERGY_TX_LEVEL txLevels[ENERGY_TX_LEVELS];     /* Ascending powers */
+    uint16_t    rxCurrentUa;
+    uint32_t    wakeChargeNc;
+}   ENERGY_MODEL;
+
+typedef struct
+{
+    uint32_t    txTimeMs;
+    uint32_t    rxTimeMs;
+    uint32_t    wakeCount;
+    uint32_t    deliveredBytes;     /* Payload bytes of the ACKed data packets */
+    uint32_t    energyUj;
+    uint32_t    energyPerByteNj;    /* energyUj / deliveredBytes, in nJ */
+}   ENERGY_STATS;
+
+/* Models of the radio PHYs, the base one until another is set */
+extern  const   ENERGY_MODEL    Energy_fastModel;
+extern  const   ENERGY_MODEL    Energy_baseModel;
+extern  const   ENERGY_MODEL    Energy_longRangeModel;
+
+void    Energy_setModel(const ENERGY_MODEL* model);
+void    Energy_setTxPower(int8_t powerDbm);
+
+/* Called by the radio task, Energy_rx also from the RX callback */
+void    Energy_tx(uint32_t ratTicks);
+void    Energy_rx(uint32_t ratTicks);
+void    Energy_wake(void);
+void    Energy_delivered(uint32_t bytes);
+
+void    Energy_getStats(ENERGY_STATS* stats);
+
+/* ENERGY_STATS big endian, for the energy report packet */
+uint32_t    Energy_encodeReport(uint8_t* buffer, uint32_t maxLength);
+
+#endif /* ENERGY_H_ */
@@ -35,6 +35,9 @@
 
 #define WAKEUP  0
 
+#define MPU6050_CAPTURE_POLL_MS     10
+#define MPU6050_CAPTURE_POLL_MAX    10
+
 /* Pin driver handles */
 static PIN_Handle interruptHandle;
 
@@ -62,15 +65,38 @@ static  I2C_Handle      i2c_;
 static  uint8_t         txBuffer[MPU6050_BUFFER_LENGTH_MAX];
 static  uint8_t         rxBuffer[MPU6050_BUFFER_LENGTH_MAX];
 static  I2C_Transaction i2cTransaction;
+static  MPU6050_MotionCallback  motionCallback_ = NULL;
+
+/* Transactions queued to the I2C driver, completed by MPU6050_i2cCallbackFxn */
+static  I2C_Transaction i2cQueue_[MPU6050_I2C_QUEUE_LENGTH];
+static  uint8_t         i2cQueueTx_[MPU6050_I2C_QUEUE_LENGTH * 2];
+static  uint8_t         i2cQueueRx_[MPU6050_I2C_QUEUE_LENGTH];
+static  volatile bool   i2cFault_ = false;
+
+/* Last value written to each register, redundant writes are skipped */
+static  uint8_t         shadow_[MPU6050_REGISTER_COUNT];
+static  uint8_t         shadowValid_[MPU6050_REGISTER_COUNT / 8];
+static  MPU6050_SHADOW_STATS    shadowStats_;
+
+/* All sensors in standby, as after MPU6050_init. USER_CTRL to PWR_MGMT_2 are one burst */
+static  const MPU6050_REGISTER  standbySequence_[] =
+{
+    { MPU6050_INT_ENABLE,   0 },
+    { MPU6050_FIFO_CTRL,    0 },
+    { MPU6050_USER_CTRL,    0 },
+    { MPU6050_PWR_MGMT_1,   MPU6050_PWR_MGMT_TEMP_DISABLE },
+    { MPU6050_PWR_MGMT_2,   MPU6050_PWR_MGMT_LP_WAKE_CTRL_3 | MPU6050_PWR_MGMT_STBY_ACCL_X | MPU6050_PWR_MGMT_STBY_ACCL_Y | MPU6050_PWR_MGMT_STBY_ACCL_Z | MPU6050_PWR_MGMT_STBY_GYLO_X | MPU6050_PWR_MGMT_STBY_GYLO_Y | MPU6050_PWR_MGMT_STBY_GYLO_Z }
+};
 
 bool    MPU6050_write8(uint8_t address, uint8_t value);
 bool    MPU6050_write16(uint8_t address, uint16_t value);
 void    MPU6050_showRegister(uint8_t address, char *name);
-float    MPU6050_getOscillationValue(void);
+int32_t  MPU6050_getOscillationQ15(void);
 
 /* Semaphore to block slave until transfer is complete */
 sem_t lock_;
 sem_t fifoFull_;
+sem_t i2cDone_;
 
 /*
  *  ======== buttonCallbackFxn ========
@@ -87,46 +113,224 @@ void MPU6050_interruptCallbackFxn(PIN_Handle handle, PIN_Id pinId)
 //        Trace_printf(hDisplaySerial, "Interrupt occurred.");
         PIN_setInterrupt(interruptHandle, PIN_IRQ_DIS);
 
-        sem_post(&fifoFull_);
+        if (motionCallback_ != NULL)
+        {
+            motionCallback_();
+        }
+        else
+        {
+            sem_post(&fifoFull_);
+        }
     }
 }
 
-bool    MPU6050_write8(uint8_t address, uint8_t value)
+/*
+ *  ======== MPU6050_i2cCallbackFxn ========
+ *  Called by the I2C driver as each queued transaction completes.
+ */
+static void MPU6050_i2cCallbackFxn(I2C_Handle handle, I2C_Transaction *transaction, bool transferStatus)
 {
-    bool    ret = true;
+    if (!transferStatus)
+    {
+        i2cFault_ = true;
+    }
 
-    sem_wait(&lock_);
+    sem_post(&i2cDone_);
+}
 
-    ((uint8_t *)i2cTransaction.writeBuf)[0] = address;
-    ((uint8_t *)i2cTransaction.writeBuf)[1] = value;
-    i2cTransaction.writeCount = 2;
-    i2cTransaction.readCount = 0;
+/*
+ * Queue the transactions to the driver and sleep until they all completed.
+ * The caller holds lock_.
+ */
+static bool MPU6050_transfer(I2C_Transaction *transactions, uint8_t count)
+{
+    uint8_t     queued;
+    uint8_t     i;
 
-    if (!I2C_transfer(i2c_, &i2cTransaction))
+    i2cFault_ = false;
+
+    for(queued = 0 ; queued < count ; queued++)
+    {
+        if (!I2C_transfer(i2c_, &transactions[queued]))
+        {
+            i2cFault_ = true;
+            break;
+        }
+    }
+
+    for(i = 0 ; i < queued ; i++)
+    {
+        sem_wait(&i2cDone_);
+    }
+
+    if (i2cFault_)
     {
-        sem_post(&lock_);
         Trace_printf(hDisplaySerial, "I2C Bus fault.");
-        ret = false;
+        return  false;
     }
-    else
+
+    return  true;
+}
+
+/*
+ * The value a register holds once written, without the bits the sensor
+ * clears by itself.
+ */
+static uint8_t  MPU6050_settledValue(uint8_t address, uint8_t value)
+{
+    switch(address)
+    {
+    case    MPU6050_USER_CTRL:
+        return  value & ~(MPU6050_USER_CTRL_FIFO_RESET | MPU6050_USER_CTRL_SIG_COND_RESET);
+
+    case    MPU6050_PWR_MGMT_1:
+        return  value & ~MPU6050_PWR_MGMT_RESET;
+
+    default:
+        return  value;
+    }
+}
+
+static void MPU6050_shadowInvalidate(uint8_t address, uint16_t length)
+{
+    for( ; (length > 0) && (address < MPU6050_REGISTER_COUNT) ; address++, length--)
+    {
+        shadowValid_[address / 8] &= ~(1 << (address % 8));
+    }
+}
+
+/* Whether the write changes the register, or has a side effect */
+static bool MPU6050_shadowDiffers(const MPU6050_REGISTER* reg)
+{
+    if ((reg->address >= MPU6050_REGISTER_COUNT) || (MPU6050_settledValue(reg->address, reg->value) != reg->value))
+    {
+        return  true;
+    }
+
+    return  !(shadowValid_[reg->address / 8] & (1 << (reg->address % 8))) || (shadow_[reg->address] != reg->value);
+}
+
+static void MPU6050_shadowUpdate(const MPU6050_REGISTER* reg)
+{
+    if (reg->address >= MPU6050_REGISTER_COUNT)
+    {
+        return;
+    }
+
+    /* A device reset sets all registers back to their defaults */
+    if ((reg->address == MPU6050_PWR_MGMT_1) && (reg->value & MPU6050_PWR_MGMT_RESET))
+    {
+        memset(shadowValid_, 0, sizeof(shadowValid_));
+        return;
+    }
+
+    shadow_[reg->address] = MPU6050_settledValue(reg->address, reg->value);
+    shadowValid_[reg->address / 8] |= (1 << (reg->address % 8));
+}
+
+bool    MPU6050_writeSequence(const MPU6050_REGISTER* sequence, uint8_t count, bool verify)
+{
+    bool        ret = true;
+    uint8_t     index = 0;
+    uint8_t     transactions;
+    uint8_t     values;
+    uint8_t     txLength;
+    uint8_t     rxLength;
+    uint8_t     lastAddress = 0;
+    uint8_t     *tx;
+    uint8_t     *rx;
+    uint8_t     expected;
+    uint8_t     i;
+    uint8_t     j;
+
+    sem_wait(&lock_);
+
+    while (ret && (index < count))
     {
-        ((uint8_t *)i2cTransaction.writeBuf)[0] = address;
-        i2cTransaction.writeCount = 1;
-        i2cTransaction.readCount = 1;
+        transactions = 0;
+        values = 0;
+        txLength = 0;
 
-        if (!I2C_transfer(i2c_, &i2cTransaction))
+        /* Skip the values already in the registers, and write following registers in one burst */
+        for( ; (index < count) && (values < MPU6050_I2C_QUEUE_LENGTH) ; index++)
         {
-            sem_post(&lock_);
-            Trace_printf(hDisplaySerial, "I2C Bus fault.");
-            ret = false;
+            const MPU6050_REGISTER  *reg = &sequence[index];
+
+            shadowStats_.writes++;
+            if (!MPU6050_shadowDiffers(reg))
+            {
+                shadowStats_.skipped++;
+                continue;
+            }
+
+            if ((transactions != 0) && (reg->address == (uint8_t)(lastAddress + 1)))
+            {
+                i2cQueue_[transactions - 1].writeCount++;
+                shadowStats_.coalesced++;
+            }
+            else
+            {
+                i2cQueue_[transactions].slaveAddress = slaveId_;
+                i2cQueue_[transactions].writeBuf = &i2cQueueTx_[txLength];
+                i2cQueue_[transactions].writeCount = 2;
+                i2cQueue_[transactions].readBuf = NULL;
+                i2cQueue_[transactions].readCount = 0;
+                i2cQueueTx_[txLength++] = reg->address;
+                transactions++;
+            }
+
+            i2cQueueTx_[txLength++] = reg->value;
+            lastAddress = reg->address;
+            values++;
+
+            MPU6050_shadowUpdate(reg);
         }
-        else
+
+        if (transactions == 0)
         {
-#if 0
-            Trace_printf(hDisplaySerial, "%02x : %d|%d|%d|%d|%d|%d|%d|%d",  ((uint8_t *)i2cTransaction.readBuf)[0],
-                 (((uint8_t *)i2cTransaction.readBuf)[0] >> 7) & 1, (((uint8_t *)i2cTransaction.readBuf)[0] >> 6) & 1, (((uint8_t *)i2cTransaction.readBuf)[0] >> 5) & 1, (((uint8_t *)i2cTransaction.readBuf)[0] >> 4) & 1,
-                 (((uint8_t *)i2cTransaction.readBuf)[0] >> 3) & 1, (((uint8_t *)i2cTransaction.readBuf)[0] >> 2) & 1, (((uint8_t *)i2cTransaction.readBuf)[0] >> 1) & 1, (((uint8_t *)i2cTransaction.readBuf)[0] >> 0) & 1);
-#endif
+            continue;
+        }
+
+        shadowStats_.transactions += transactions;
+
+        ret = MPU6050_transfer(i2cQueue_, transactions);
+        if (ret && verify)
+        {
+            /* Read the registers back in a second batch */
+            rxLength = 0;
+            for(i = 0 ; i < transactions ; i++)
+            {
+                i2cQueue_[i].readBuf = &i2cQueueRx_[rxLength];
+                i2cQueue_[i].readCount = i2cQueue_[i].writeCount - 1;
+                i2cQueue_[i].writeCount = 1;
+                rxLength += i2cQueue_[i].readCount;
+            }
+
+            shadowStats_.transactions += transactions;
+
+            ret = MPU6050_transfer(i2cQueue_, transactions);
+
+            for(i = 0 ; ret && (i < transactions) ; i++)
+            {
+                tx = (uint8_t *)i2cQueue_[i].writeBuf;
+                rx = (uint8_t *)i2cQueue_[i].readBuf;
+
+                for(j = 0 ; j < i2cQueue_[i].readCount ; j++)
+                {
+                    expected = MPU6050_settledValue(tx[0] + j, tx[1 + j]);
+                    if (rx[j] != expected)
+                    {
+                        Trace_printf(hDisplaySerial, "Register %02x : %02x, expected %02x", tx[0] + j, rx[j], expected);
+                        ret = false;
+                    }
+                }
+            }
+        }
+
+        /* The registers are unknown after a failure */
+        if (!ret)
+        {
+            memset(shadowValid_, 0, sizeof(shadowValid_));
         }
     }
 
@@ -135,6 +339,20 @@ bool    MPU6050_write8(uint8_t address, uint8_t value)
     return  ret;
 }
 
+void    MPU6050_getShadowStats(MPU6050_SHADOW_STATS* stats)
+{
+    sem_wait(&lock_);
+    *stats = shadowStats_;
+    sem_post(&lock_);
+}
+
+bool    MPU6050_write8(uint8_t address, uint8_t value)
+{
+    MPU6050_REGISTER    reg = { address, value };
+
+    return  MPU6050_writeSequence(&reg, 1, false);
+}
+
 bool    MPU6050_read8(uint8_t address, uint8_t *value)
 {
     bool    ret = true;
@@ -145,9 +363,8 @@ bool    MPU6050_read8(uint8_t address, uint8_t *value)
     i2cTransaction.writeCount = 1;
     i2cTransaction.readCount = 1;
 
-    if (!I2C_transfer(i2c_, &i2cTransaction))
+    if (!MPU6050_transfer(&i2cTransaction, 1))
     {
-        Trace_printf(hDisplaySerial, "I2C Bus fault.");
         ret = false;
     }
     else
@@ -171,10 +388,10 @@ bool    MPU6050_write16(uint8_t address, uint16_t value)
     ((uint8_t *)i2cTransaction.writeBuf)[2] = value & 0xFF;
     i2cTransaction.writeCount = 3;
     i2cTransaction.readCount = 0;
+    MPU6050_shadowInvalidate(address, 2);
 
-    if (!I2C_transfer(i2c_, &i2cTransaction))
+    if (!MPU6050_transfer(&i2cTransaction, 1))
     {
-        Trace_printf(hDisplaySerial, "I2C Bus fault.");
         ret = false;
     }
 
@@ -193,9 +410,8 @@ bool    MPU6050_read16(uint8_t address, uint16_t *value)
     i2cTransaction.writeCount = 1;
     i2cTransaction.readCount = 2;
 
-    if (!I2C_transfer(i2c_, &i2cTransaction))
+    if (!MPU6050_transfer(&i2cTransaction, 1))
     {
-        Trace_printf(hDisplaySerial, "I2C Bus fault.");
         ret = false;
     }
     else
@@ -218,11 +434,10 @@ bool    MPU6050_writeArray(uint8_t address, uint8_t *values, uint8_t length)
     memcpy(&((uint8_t *)i2cTransaction.writeBuf)[1], values, length);
     i2cTransaction.writeCount = length+1;
     i2cTransaction.readCount = 0;
+    MPU6050_shadowInvalidate(address, length);
 
-    if (!I2C_transfer(i2c_, &i2cTransaction))
+    if (!MPU6050_transfer(&i2cTransaction, 1))
     {
-        sem_post(&lock_);
-        Trace_printf(hDisplaySerial, "I2C Bus fault.");
         ret = false;
     }
 
@@ -231,25 +446,24 @@ bool    MPU6050_writeArray(uint8_t address, uint8_t *values, uint8_t length)
     return  ret;
 }
 
-bool    MPU6050_readArray(uint8_t address, uint8_t *values, uint8_t length)
+bool    MPU6050_readArray(uint8_t address, uint8_t *values, uint16_t length)
 {
     bool    ret = true;
 
     sem_wait(&lock_);
 
+    /* Read straight into the caller buffer, the length is not limited by rxBuffer */
     ((uint8_t *)i2cTransaction.writeBuf)[0] = address;
     i2cTransaction.writeCount = 1;
+    i2cTransaction.readBuf = values;
     i2cTransaction.readCount = length;
 
-    if (!I2C_transfer(i2c_, &i2cTransaction))
+    if (!MPU6050_transfer(&i2cTransaction, 1))
     {
-        Trace_printf(hDisplaySerial, "I2C Bus fault.");
         ret = false;
     }
-    else
-    {
-        memcpy(values, i2cTransaction.readBuf, length);
-    }
+
+    i2cTransaction.readBuf = rxBuffer;
 
     sem_post(&lock_);
 
@@ -326,73 +540,220 @@ bool    MPU6050_readValue(uint8_t type, double* value)
 }
 
 
-bool    MPU6050_fifoCount(uint16_t* count)
+bool    MPU6050_readValueQ15(uint8_t type, int16_t* value)
 {
-    uint8_t value;
-
-    if (!MPU6050_read8(MPU6050_FIFO_COUNT, &value))
+    switch(type)
     {
+    case    MPU6050_VALUE_ACCL_X:
+    case    MPU6050_VALUE_ACCL_Y:
+    case    MPU6050_VALUE_ACCL_Z:
+    case    MPU6050_VALUE_TEMP:
+    case    MPU6050_VALUE_GYRO_X:
+    case    MPU6050_VALUE_GYRO_Y:
+    case    MPU6050_VALUE_GYRO_Z:
+        return  MPU6050_read16(type, (uint16_t *)value);
+
+    default:
         return  false;
     }
-    *count = value;
+}
 
-    if (!MPU6050_read8(MPU6050_FIFO_COUNT + 1, &value))
+bool    MPU6050_fifoCount(uint16_t* count)
+{
+    /* FIFO_COUNT_H and FIFO_COUNT_L in one transaction */
+    return  MPU6050_read16(MPU6050_FIFO_COUNT, count);
+}
+
+bool    MPU6050_readFifoQ15(int16_t* values, uint16_t count)
+{
+    uint8_t     *bytes = (uint8_t *)values;
+    uint16_t    length = count * 2;
+    uint16_t    offset;
+    uint16_t    i;
+
+    for(offset = 0 ; offset < length ; offset += MPU6050_FIFO_BURST_LENGTH)
     {
-        return  false;
+        uint16_t    burst = length - offset;
+
+        if (burst > MPU6050_FIFO_BURST_LENGTH)
+        {
+            burst = MPU6050_FIFO_BURST_LENGTH;
+        }
+
+        if (!MPU6050_readArray(MPU6050_FIFO_VALUE, &bytes[offset], burst))
+        {
+            return  false;
+        }
     }
 
-    *count = ((*count) << 8) | value;
+    /* The FIFO is big endian */
+    for(i = 0 ; i < count ; i++)
+    {
+        values[i] = (int16_t)(((uint16_t)bytes[i * 2] << 8) | bytes[i * 2 + 1]);
+    }
 
     return  true;
 }
 
-bool    MPU6050_popValue(uint8_t type, double* value)
+bool    MPU6050_captureAccelQ15(int16_t* xyz, uint16_t frames, uint16_t sampleRateHz)
 {
-    uint16_t value16;
+    bool        ret = false;
+    uint16_t    fifoCount = 0;
+    uint16_t    length = frames * MPU6050_FIFO_ACCL_FRAME_LENGTH;
+    uint32_t    waitMs;
+    uint8_t     poll;
+    MPU6050_REGISTER    sequence[] =
+    {
+        /* Accelerometer only, sampled at sampleRateHz into the FIFO */
+        { MPU6050_PWR_MGMT_1,   MPU6050_PWR_MGMT_TEMP_DISABLE },
+        { MPU6050_PWR_MGMT_2,   MPU6050_PWR_MGMT_STBY_GYLO_X | MPU6050_PWR_MGMT_STBY_GYLO_Y | MPU6050_PWR_MGMT_STBY_GYLO_Z },
+        { MPU6050_SMPLRT_DIV,   0 },
+        { MPU6050_CONFIG,       MPU6050_CONFIG_DLPF_188HZ },
+        { MPU6050_INT_ENABLE,   0 },
+        { MPU6050_FIFO_CTRL,    MPU6050_FIFO_CTRL_ACCL },
+        { MPU6050_USER_CTRL,    MPU6050_USER_CTRL_FIFO_RESET },
+        { MPU6050_USER_CTRL,    MPU6050_USER_CTRL_FIFO_EN }
+    };
+
+    if ((length > MPU6050_FIFO_SIZE) || (sampleRateHz == 0) || (sampleRateHz > MPU6050_SAMPLE_RATE_DLPF_HZ))
+    {
+        return  false;
+    }
 
-#if 0
-    uint8_t *value8 = (uint8_t *)&value16;
+    sequence[2].value = (uint8_t)(MPU6050_SAMPLE_RATE_DLPF_HZ / sampleRateHz - 1);
 
-    if (!MPU6050_read8(MPU6050_FIFO_VALUE, &value8[1]))
+    if (MPU6050_writeSequence(sequence, sizeof(sequence) / sizeof(sequence[0]), false))
     {
-        return  false;
+        /* Sleep while the window fills */
+        waitMs = (uint32_t)frames * 1000 / sampleRateHz;
+        while (waitMs >= 1000)
+        {
+            sleep(1);
+            waitMs -= 1000;
+        }
+        usleep(waitMs * 1000);
+
+        for(poll = 0 ; poll <= MPU6050_CAPTURE_POLL_MAX ; poll++)
+        {
+            if (!MPU6050_fifoCount(&fifoCount))
+            {
+                break;
+            }
+
+            if (fifoCount >= length)
+            {
+                ret = MPU6050_readFifoQ15(xyz, frames * 3);
+                break;
+            }
+
+            usleep(MPU6050_CAPTURE_POLL_MS * 1000);
+        }
     }
 
-    if (!MPU6050_read8(MPU6050_FIFO_VALUE, &value8[0]))
+    /* Back to standby */
+    MPU6050_writeSequence(standbySequence_, sizeof(standbySequence_) / sizeof(standbySequence_[0]), false);
+
+    return  ret;
+}
+
+bool    MPU6050_startStream(uint16_t sampleRateHz, uint16_t thresholdMg, MPU6050_MotionCallback callback)
+{
+    uint16_t    threshold = thresholdMg / MPU6050_MOT_THR_LSB_MG;
+    uint8_t     status;
+    MPU6050_REGISTER    sequence[] =
+    {
+        /* Accelerometer only into the FIFO, the motion interrupt works in normal mode too */
+        { MPU6050_PWR_MGMT_1,   MPU6050_PWR_MGMT_TEMP_DISABLE },
+        { MPU6050_PWR_MGMT_2,   MPU6050_PWR_MGMT_STBY_GYLO_X | MPU6050_PWR_MGMT_STBY_GYLO_Y | MPU6050_PWR_MGMT_STBY_GYLO_Z },
+        { MPU6050_SMPLRT_DIV,   0 },
+        { MPU6050_CONFIG,       MPU6050_CONFIG_DLPF_188HZ },
+        { MPU6050_ACCEL_CONFIG, MPU6050_ACCEL_CONFIG_HPF_5HZ },
+        { MPU6050_MOT_THR,      0 },
+        { MPU6050_MOT_DUR,      1 },
+        { MPU6050_INT_CONFIG,   MPU6050_INT_CONFIG_LATCH | MPU6050_INT_CONFIG_RD_CLEAR },
+        { MPU6050_INT_ENABLE,   MPU6050_INT_ENABLE_MOTION },
+        { MPU6050_FIFO_CTRL,    MPU6050_FIFO_CTRL_ACCL },
+        { MPU6050_USER_CTRL,    MPU6050_USER_CTRL_FIFO_RESET },
+        { MPU6050_USER_CTRL,    MPU6050_USER_CTRL_FIFO_EN }
+    };
+
+    if ((sampleRateHz == 0) || (sampleRateHz > MPU6050_SAMPLE_RATE_DLPF_HZ))
     {
         return  false;
     }
-#else
-    if (!MPU6050_read16(MPU6050_FIFO_VALUE, &value16))
+
+    if (threshold == 0)
     {
+        threshold = 1;
+    }
+    else if (threshold > 0xFF)
+    {
+        threshold = 0xFF;
+    }
+
+    PIN_setInterrupt(interruptHandle, PIN_IRQ_DIS);
+    motionCallback_ = callback;
+
+    sequence[2].value = (uint8_t)(MPU6050_SAMPLE_RATE_DLPF_HZ / sampleRateHz - 1);
+    sequence[5].value = (uint8_t)threshold;
+
+    if (!MPU6050_writeSequence(sequence, sizeof(sequence) / sizeof(sequence[0]), false))
+    {
+        MPU6050_stopStream();
         return  false;
     }
 
-#endif
+    /* Clear a motion latched while the filter settled */
+    MPU6050_read8(MPU6050_INT_STATUS, &status);
+    PIN_setInterrupt(interruptHandle, PIN_IRQ_POSEDGE);
 
-    switch(type)
+    return  true;
+}
+
+uint16_t    MPU6050_readStreamQ15(int16_t* xyz, uint16_t maxFrames, bool* overflowed)
+{
+    uint16_t    fifoCount = 0;
+    uint16_t    frames;
+
+    *overflowed = false;
+
+    if (!MPU6050_fifoCount(&fifoCount))
     {
-    case    MPU6050_VALUE_ACCL_X:
-    case    MPU6050_VALUE_ACCL_Y:
-    case    MPU6050_VALUE_ACCL_Z:
-        *value = value16 / 16384.0;
-        break;
+        return  0;
+    }
 
-    case    MPU6050_VALUE_TEMP:
-        *value = value16 / 340.0 + 136.53;
-        break;
+    /* The oldest bytes were dropped, the frames are no longer aligned */
+    if (fifoCount >= MPU6050_FIFO_SIZE)
+    {
+        MPU6050_write8(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+        MPU6050_write8(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN);
+        *overflowed = true;
+        return  0;
+    }
 
-    case    MPU6050_VALUE_GYRO_X:
-    case    MPU6050_VALUE_GYRO_Y:
-    case    MPU6050_VALUE_GYRO_Z:
-        *value = value16 / 131.0;
-        break;
+    frames = fifoCount / MPU6050_FIFO_ACCL_FRAME_LENGTH;
+    if (frames > maxFrames)
+    {
+        frames = maxFrames;
+    }
 
-    default:
-        return  false;
+    if ((frames == 0) || !MPU6050_readFifoQ15(xyz, frames * 3))
+    {
+        return  0;
     }
 
-    return  true;
+    return  frames;
+}
+
+void    MPU6050_stopStream(void)
+{
+    uint8_t     status;
+
+    PIN_setInterrupt(interruptHandle, PIN_IRQ_DIS);
+    motionCallback_ = NULL;
+
+    MPU6050_writeSequence(standbySequence_, sizeof(standbySequence_) / sizeof(standbySequence_[0]), false);
+    MPU6050_read8(MPU6050_INT_STATUS, &status);
 }
 
 /*
@@ -405,7 +766,7 @@ bool    MPU6050_startMotionDetection(float _limit)
     MPU6050_write8(MPU6050_FIFO_CTRL, MPU6050_FIFO_CTRL_ACCL);
     MPU6050_write8(MPU6050_INT_ENABLE, MPU6050_INT_ENABLE_FIFO_OVERFLOW);
     MPU6050_write8(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
-    CPUdelay(10000*12);
+    usleep(MPU6050_SETTLE_DELAY_MS * 1000);
     MPU6050_write8(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN);
     MPU6050_write8(MPU6050_PWR_MGMT_1, MPU6050_PWR_MGMT_CYCLE | MPU6050_PWR_MGMT_TEMP_DISABLE);
     MPU6050_write8(MPU6050_PWR_MGMT_2, MPU6050_PWR_MGMT_LP_WAKE_CTRL_3 | MPU6050_PWR_MGMT_STBY_ACCL_X | MPU6050_PWR_MGMT_STBY_ACCL_Y | MPU6050_PWR_MGMT_STBY_GYLO_X | MPU6050_PWR_MGMT_STBY_GYLO_Y | MPU6050_PWR_MGMT_STBY_GYLO_Z);
@@ -426,7 +787,71 @@ bool    MPU6050_startMotionDetection(float _limit)
     MPU6050_write8(MPU6050_PWR_MGMT_2, MPU6050_PWR_MGMT_LP_WAKE_CTRL_3 | MPU6050_PWR_MGMT_STBY_ACCL_X | MPU6050_PWR_MGMT_STBY_ACCL_Y | MPU6050_PWR_MGMT_STBY_ACCL_Z | MPU6050_PWR_MGMT_STBY_GYLO_X | MPU6050_PWR_MGMT_STBY_GYLO_Y | MPU6050_PWR_MGMT_STBY_GYLO_Z);
     MPU6050_write8(MPU6050_PWR_MGMT_1,  MPU6050_PWR_MGMT_TEMP_DISABLE);
 
-    return  MPU6050_getOscillationValue() > _limit;
+    return  MPU6050_getOscillationQ15() > MPU6050_MG_TO_Q15(_limit * 1000);
+}
+
+bool    MPU6050_startWakeOnMotion(uint16_t thresholdMg, uint8_t durationMs, MPU6050_MotionCallback callback)
+{
+    uint16_t    threshold = thresholdMg / MPU6050_MOT_THR_LSB_MG;
+    uint8_t     status;
+    MPU6050_REGISTER    sequence[] =
+    {
+        /* Accelerometer only, the gyro stays in standby */
+        { MPU6050_PWR_MGMT_1,   MPU6050_PWR_MGMT_TEMP_DISABLE },
+        { MPU6050_PWR_MGMT_2,   MPU6050_PWR_MGMT_LP_WAKE_CTRL_3 | MPU6050_PWR_MGMT_STBY_GYLO_X | MPU6050_PWR_MGMT_STBY_GYLO_Y | MPU6050_PWR_MGMT_STBY_GYLO_Z },
+        { MPU6050_ACCEL_CONFIG, MPU6050_ACCEL_CONFIG_HPF_5HZ },
+        { MPU6050_MOT_THR,      0 },
+        { MPU6050_MOT_DUR,      0 },
+        { MPU6050_INT_CONFIG,   MPU6050_INT_CONFIG_LATCH | MPU6050_INT_CONFIG_RD_CLEAR },
+        { MPU6050_INT_ENABLE,   MPU6050_INT_ENABLE_MOTION }
+    };
+
+    if (threshold == 0)
+    {
+        threshold = 1;
+    }
+    else if (threshold > 0xFF)
+    {
+        threshold = 0xFF;
+    }
+
+    PIN_setInterrupt(interruptHandle, PIN_IRQ_DIS);
+    motionCallback_ = callback;
+
+    sequence[3].value = (uint8_t)threshold;
+    sequence[4].value = durationMs;
+
+    /* Read back, the sensor sleeps on these until the next motion */
+    if (!MPU6050_writeSequence(sequence, sizeof(sequence) / sizeof(sequence[0]), true))
+    {
+        motionCallback_ = NULL;
+        return  false;
+    }
+
+    /* Let the high pass filter settle, then clear a motion latched meanwhile */
+    usleep(MPU6050_SETTLE_DELAY_MS * 1000);
+    MPU6050_read8(MPU6050_INT_STATUS, &status);
+
+    if (!MPU6050_write8(MPU6050_PWR_MGMT_1, MPU6050_PWR_MGMT_CYCLE | MPU6050_PWR_MGMT_TEMP_DISABLE))
+    {
+        motionCallback_ = NULL;
+        return  false;
+    }
+
+    PIN_setInterrupt(interruptHandle, PIN_IRQ_POSEDGE);
+
+    return  true;
+}
+
+void    MPU6050_stopWakeOnMotion(void)
+{
+    uint8_t     status;
+
+    PIN_setInterrupt(interruptHandle, PIN_IRQ_DIS);
+    motionCallback_ = NULL;
+
+    MPU6050_writeSequence(standbySequence_, sizeof(standbySequence_) / sizeof(standbySequence_[0]), false);
+    MPU6050_read8(MPU6050_INT_STATUS, &status);
 }
 
 void    MPU6050_showRegister(uint8_t address, char *name)
@@ -441,12 +866,14 @@ void    MPU6050_showRegister(uint8_t address, char *name)
     }
 }
 
-float    MPU6050_getOscillationValue(void)
+int32_t  MPU6050_getOscillationQ15(void)
 {
-    int i;
-    float min = 10;
-    float max = 0;
+    static int16_t  samples[MPU6050_FIFO_BURST_LENGTH / 2];
+    int16_t     min = INT16_MAX;
+    int16_t     max = INT16_MIN;
     uint16_t    fifoCount = 0;
+    uint16_t    count;
+    uint16_t    i;
 
     if (!MPU6050_fifoCount(&fifoCount))
     {
@@ -454,23 +881,42 @@ float    MPU6050_getOscillationValue(void)
         return  0;
     }
 
-    for(i = 0 ;  i < fifoCount / 2; i++)
+    /* Drain the FIFO a burst at a time */
+    for(fifoCount /= 2 ; fifoCount > 0 ; fifoCount -= count)
     {
-        double  value;
+        count = fifoCount;
+        if (count > MPU6050_FIFO_BURST_LENGTH / 2)
+        {
+            count = MPU6050_FIFO_BURST_LENGTH / 2;
+        }
 
-        MPU6050_popValue(MPU6050_VALUE_ACCL_Z, &value);
-        if (value != 0)
+        if (!MPU6050_readFifoQ15(samples, count))
         {
-            if (value < min)
-                min = value;
+            break;
+        }
 
-            if (value > max)
-                max = value;
+        for(i = 0 ; i < count ; i++)
+        {
+            /* Axes in standby read 0 */
+            if (samples[i] != 0)
+            {
+                if (samples[i] < min)
+                    min = samples[i];
+
+                if (samples[i] > max)
+                    max = samples[i];
+            }
         }
     }
-    Trace_printf(hDisplaySerial, "Min, Max : %f, %f", min, max);
 
-    return  (max - min);
+    if (min > max)
+    {
+        return  0;
+    }
+
+    Trace_printf(hDisplaySerial, "Min, Max : %d, %d mg", MPU6050_Q15_TO_MG(min), MPU6050_Q15_TO_MG(max));
+
+    return  ((int32_t)max - min);
 }
 
 /*
@@ -500,8 +946,17 @@ bool    MPU6050_init(void)
         return  false;
     }
 
+    if (sem_init(&i2cDone_, 0, 0) != 0)
+    {
+        Trace_printf(hDisplaySerial, "Error creating i2cDone_\n");
+        return  false;
+    }
+
+    /* Transactions are queued and completed in MPU6050_i2cCallbackFxn */
     I2C_Params_init(&i2cParams);
     i2cParams.bitRate = I2C_400kHz;
+    i2cParams.transferMode = I2C_MODE_CALLBACK;
+    i2cParams.transferCallbackFxn = MPU6050_i2cCallbackFxn;
 
     i2c_ = I2C_open(Board_I2C_TMP, &i2cParams);
     if (i2c_ == NULL)
@@ -523,10 +978,9 @@ bool    MPU6050_init(void)
         return  false;
     }
 
-    MPU6050_write8(MPU6050_PWR_MGMT_1, 0x80);
-    CPUdelay(10000*12);
-    MPU6050_write8(MPU6050_PWR_MGMT_1, MPU6050_PWR_MGMT_TEMP_DISABLE);
-    MPU6050_write8(MPU6050_PWR_MGMT_2, MPU6050_PWR_MGMT_LP_WAKE_CTRL_3 | MPU6050_PWR_MGMT_STBY_ACCL_X | MPU6050_PWR_MGMT_STBY_ACCL_Y | MPU6050_PWR_MGMT_STBY_ACCL_Z | MPU6050_PWR_MGMT_STBY_GYLO_X | MPU6050_PWR_MGMT_STBY_GYLO_Y | MPU6050_PWR_MGMT_STBY_GYLO_Z);
+    /* Sleep through the reset instead of spinning */
+    MPU6050_write8(MPU6050_PWR_MGMT_1, MPU6050_PWR_MGMT_RESET);
+    usleep(MPU6050_RESET_DELAY_MS * 1000);
 
-    return   true;
+    return  MPU6050_writeSequence(standbySequence_, sizeof(standbySequence_) / sizeof(standbySequence_[0]), true);
 }
@@ -16,6 +16,12 @@
 #define MPU6050_VALUE_GYRO_Y    0x45
 #define MPU6050_VALUE_GYRO_Z    0x47
 
+#define MPU6050_SMPLRT_DIV      0x19
+#define MPU6050_CONFIG          0x1A
+#define MPU6050_ACCEL_CONFIG    0x1C
+#define MPU6050_MOT_THR         0x1F
+#define MPU6050_MOT_DUR         0x20
+
 #define MPU6050_INT_CONFIG      0x37
 #define MPU6050_INT_ENABLE      0x38
 #define MPU6050_INT_STATUS      0x3A
@@ -50,9 +56,21 @@
 #define MPU6050_INT_CONFIG_LEVEL_LOW        (1 << 7)
 #define MPU6050_INT_CONFIG_OPEN_DRAIN       (1 << 6)
 #define MPU6050_INT_CONFIG_LATCH            (1 << 5)
+#define MPU6050_INT_CONFIG_RD_CLEAR         (1 << 4)
 
+#define MPU6050_INT_ENABLE_MOTION           (1 << 6)
 #define MPU6050_INT_ENABLE_FIFO_OVERFLOW    (1 << 4)
 
+#define MPU6050_INT_STATUS_MOTION           (1 << 6)
+
+#define MPU6050_ACCEL_CONFIG_HPF_5HZ        (1 << 0)
+
+#define MPU6050_CONFIG_DLPF_188HZ           1
+#define MPU6050_SAMPLE_RATE_DLPF_HZ         1000    /* Sample rate divided by SMPLRT_DIV + 1 */
+#define MPU6050_FIFO_ACCL_FRAME_LENGTH      6       /* X, Y and Z */
+
+#define MPU6050_MOT_THR_LSB_MG              2       /* MOT_THR is in 2 mg, MOT_DUR in 1 ms */
+
 #define MPU6050_FIFO_CTRL_TEMP_EN       (1 << 7)
 #define MPU6050_FIFO_CTRL_GYLO_X        (1 << 6)
 #define MPU6050_FIFO_CTRL_GYLO_Y        (1 << 5)
@@ -61,10 +79,87 @@
 
 #define MPU6050_USER_CTRL_FIFO_EN       (1 << 6)
 #define MPU6050_USER_CTRL_FIFO_RESET    (1 << 2)
+#define MPU6050_USER_CTRL_SIG_COND_RESET    (1 << 0)
+
+#define MPU6050_FIFO_SIZE               1024
+#define MPU6050_FIFO_BURST_LENGTH       256     /* FIFO bytes read per I2C transaction */
+
+#define MPU6050_I2C_QUEUE_LENGTH        16      /* I2C transactions queued at once */
+#define MPU6050_RESET_DELAY_MS          10      /* After the device reset */
+#define MPU6050_SETTLE_DELAY_MS         10      /* After the high pass filter or the FIFO reset */
+#define MPU6050_REGISTER_COUNT          128     /* Registers shadowed in RAM */
+
+/*
+ * Q15 fixed point values are the raw readings, fractions of the full scale
+ * range in 1/32768, so no floating point is needed on the CM3.
+ */
+#define MPU6050_ACCL_FULL_SCALE_MG      2000
+#define MPU6050_GYRO_FULL_SCALE_DPS     250
+
+#define MPU6050_Q15_TO_MG(q)            (((int32_t)(q) * MPU6050_ACCL_FULL_SCALE_MG) >> 15)
+#define MPU6050_MG_TO_Q15(mg)           (((int32_t)(mg) << 15) / MPU6050_ACCL_FULL_SCALE_MG)
+#define MPU6050_Q15_TO_DPS(q)           (((int32_t)(q) * MPU6050_GYRO_FULL_SCALE_DPS) >> 15)
+
+/*
+ * Register writes queued to the I2C driver in callback mode and completed
+ * as one batch, with an optional read back of each register.
+ */
+typedef struct
+{
+    uint8_t address;
+    uint8_t value;
+}   MPU6050_REGISTER;
 
 bool    MPU6050_init(void);
+bool    MPU6050_writeSequence(const MPU6050_REGISTER* sequence, uint8_t count, bool verify);
+
+/*
+ * The sequences are written through a RAM shadow of the registers: a value
+ * already in its register is not written again, and the values of following
+ * registers are written in one burst. The I2C transactions saved are
+ * skipped + coalesced.
+ */
+typedef struct
+{
+    uint32_t    writes;         /* Register values asked for */
+    uint32_t    skipped;        /* Already in the register */
+    uint32_t    coalesced;      /* Written in the burst of the previous register */
+    uint32_t    transactions;   /* Write and read back transactions made */
+}   MPU6050_SHADOW_STATS;
+
+void    MPU6050_getShadowStats(MPU6050_SHADOW_STATS* stats);
 bool    MPU6050_readValue(uint8_t type, double* value);
+bool    MPU6050_readValueQ15(uint8_t type, int16_t* value);
+bool    MPU6050_fifoCount(uint16_t* count);
+bool    MPU6050_readFifoQ15(int16_t* values, uint16_t count);
+
+/*
+ * Capture frames of X, Y and Z accelerations at sampleRateHz through the FIFO,
+ * the calling thread sleeps while the window fills.
+ */
+bool    MPU6050_captureAccelQ15(int16_t* xyz, uint16_t frames, uint16_t sampleRateHz);
 bool    MPU6050_startMotionDetection(float _limit);
 
+/*
+ * Wake on motion: the sensor cycles in low power accelerometer mode and raises
+ * its interrupt pin when a high pass filtered axis exceeds the threshold for
+ * the duration. The callback is called from the pin interrupt, the MCU can
+ * stay in standby until then.
+ */
+typedef void (*MPU6050_MotionCallback)(void);
+
+bool    MPU6050_startWakeOnMotion(uint16_t thresholdMg, uint8_t durationMs, MPU6050_MotionCallback callback);
+void    MPU6050_stopWakeOnMotion(void);
+
+/*
+ * Stream X, Y and Z frames at sampleRateHz through the FIFO with the motion
+ * interrupt enabled. MPU6050_readStreamQ15() reads the whole frames in the
+ * FIFO, it must be called before the FIFO fills (170 frames). A FIFO that
+ * overflowed is reset, no frame is returned and overflowed is set.
+ */
+bool    MPU6050_startStream(uint16_t sampleRateHz, uint16_t thresholdMg, MPU6050_MotionCallback callback);
+uint16_t MPU6050_readStreamQ15(int16_t* xyz, uint16_t maxFrames, bool* overflowed);
+void    MPU6050_stopStream(void);
+
 
 #endif /* MPU6050_H_ */
@@ -0,0 +1,1036 @@
+/******************************************************************************
+
+ @file oad_client.c
+
+ @brief OAD Client
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Event.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/display/Display.h>
+
+#include "oad/native_oad/oad_client.h"
+#include "oad/native_oad/oad_protocol.h"
+#include "oad/native_oad/oad_storage.h"
+#include "oad/native_oad/oad_fountain.h"
+#include "oad/native_oad/oad_delta.h"
+#include "oad/native_oad/oad_compress.h"
+#include "oad/native_oad/oad_image_header.h"
+#include "oad/native_oad/oad_target.h"
+#include "oad/native_oad/ext_flash_layout.h"
+
+#include "easylink/EasyLink.h"
+#include "RadioProtocol.h"
+#include "NodeRadioTask.h"
+#include "NodeTask.h"
+#include "trace.h"
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+#define FW_VERSION "rfWsnNode v1.0"
+#define FW_VERSION_NUM 0x0100   /* FW_VERSION as the server reads it, patches are made against it */
+
+#define OADCLIENT_TASK_STACK_SIZE       1536
+#define OADCLIENT_TASK_PRIORITY         2
+
+#define OADCLIENT_EVENT_ALL             0xFFFFFFFF
+#define OADCLIENT_EVENT_PACKET          (uint32_t)(1 << 0)
+#define OADCLIENT_EVENT_ACK             (uint32_t)(1 << 1)
+
+/*!
+ Received OAD frames waiting for the client task, a block response is the
+ longest frame the client receives.
+ */
+#define OADCLIENT_RX_QUEUE_SIZE         8
+#define OADCLIENT_RX_FRAME_LEN          (OADProtocol_PACKET_TYPE_OAD_BLOCK_RSP_LEN)
+
+/*!
+ Offsets of the length and the image type in an image header.
+ */
+#define OADCLIENT_IMG_HDR_LEN_OFFSET    6
+#define OADCLIENT_IMG_HDR_TYPE_OFFSET   14
+
+/*!
+ Fountain symbols waiting to be decoded are kept in the Stack image region,
+ a node has no Stack image.
+ */
+#define OADCLIENT_FOUNTAIN_SYMBOL_PAGE  (EFL_ADDR_FOUNTAIN_SYMBOLS / EFL_PAGE_SIZE)
+
+#if (OADClient_FOUNTAIN_MAX_SYMBOLS * OAD_BLOCK_SIZE) > EFL_SIZE_FOUNTAIN_SYMBOLS
+#error "OADClient_FOUNTAIN_MAX_SYMBOLS do not fit in the fountain symbol region"
+#endif
+
+/*!
+ The blocks of a delta patch or compressed image are kept in the delta region
+ as they come, the patcher or decompressor takes them in order from there.
+ */
+#define OADCLIENT_STAGE_PAGE            (EFL_ADDR_IMAGE_DELTA / EFL_PAGE_SIZE)
+#define OADCLIENT_STAGE_PAGES           (EFL_SIZE_IMAGE_DELTA / EFL_PAGE_SIZE)
+#define OADCLIENT_STAGE_MAX_BLOCKS      (EFL_SIZE_IMAGE_DELTA / OAD_BLOCK_SIZE)
+
+#if OADCLIENT_STAGE_PAGES > 32
+#error "OADCLIENT_STAGE_PAGES do not fit in oadStageErasedPages"
+#endif
+
+/***** Variable declarations *****/
+static Task_Params oadClientTaskParams;
+Task_Struct oadClientTask;    /* Not static so you can see in ROV */
+static uint8_t oadClientTaskStack[OADCLIENT_TASK_STACK_SIZE];
+Event_Struct oadClientEvent;  /* Not static so you can see in ROV */
+static Event_Handle oadClientEventHandle;
+
+/* Clock for the next push ack */
+Clock_Struct oadAckClock;     /* not static so you can see in ROV */
+static Clock_Handle oadAckClockHandle;
+
+/* Display driver handle of the node task */
+extern Display_Handle hDisplaySerial;
+
+/*!
+ Received OAD frames, written by the radio task and read by the client task.
+ */
+static uint8_t oadRxQueue[OADCLIENT_RX_QUEUE_SIZE][OADCLIENT_RX_FRAME_LEN];
+static volatile uint8_t oadRxQueueHead = 0;
+static volatile uint8_t oadRxQueueTail = 0;
+
+/*!
+ Buffer of the message being sent, a FW version response is the longest.
+ */
+static uint8_t oadTxBuffer[OADProtocol_PACKET_TYPE_FW_VERSION_RSP_LEN];
+
+/*!
+ Download variables.
+ */
+static uint8_t concentratorAddress = RADIO_CONCENTRATOR_ADDRESS;
+static bool oadInProgress = false;
+static bool oadImageReady = false;
+static uint8_t oadImgId = 0;
+static uint16_t oadNumBlocks = 0;
+static uint16_t oadBase = 0;            /* First block missing */
+static uint16_t oadNewBlocks = 0;       /* Blocks received since the last push ack */
+static uint8_t oadIdleAcks = 0;
+static uint8_t oadRetries = 0;
+static uint8_t oadDataSharePct = OADClient_DATA_SHARE_PCT;
+
+/*!
+ Fountain decoder of a broadcast download.
+ */
+static bool oadFountain = false;
+static OADFountain_Decoder_t oadDecoder;
+static uint8_t oadDecodedBitmap[(OADClient_FOUNTAIN_MAX_BLOCKS + 7) / 8];
+static OADFountain_Symbol_t oadSymbols[OADClient_FOUNTAIN_MAX_SYMBOLS];
+
+/*!
+ Format of a download whose blocks are not the image, OADProtocol_IMG_ID_DELTA
+ or OADProtocol_IMG_ID_COMPRESSED, 0 for an image. The patcher rebuilds the
+ new image from the running one, the decompressor from the compressed image.
+ One download runs at a time, they share their RAM.
+ */
+static uint8_t oadFormat = 0;
+static union {
+    OADDelta_Patcher_t patcher;
+    OADCompress_Decompressor_t decompressor;
+} oadUnpack;
+static uint8_t oadStageBitmap[(OADCLIENT_STAGE_MAX_BLOCKS + 7) / 8];
+static uint32_t oadStageErasedPages = 0;
+
+/*! The rejection of the download of oadImgId is sent again until it is acknowledged */
+static bool oadRejected = false;
+
+/******************************************************************************
+ Local function prototypes
+ *****************************************************************************/
+
+static void oadClientTaskFunction(UArg arg0, UArg arg1);
+static void oadAckClockCallback(UArg arg0);
+static void oadPacketCallback(uint8_t* data, uint8_t length);
+static void oadProcessRxQueue(void);
+static void oadSendPushAck(void);
+static void oadAbort(void);
+static void oadFinish(void);
+static void oadSendFountainStatus(void);
+static void oadFountainFinish(void);
+static bool oadFountainReadBlock(uint16_t blockNum, uint8_t *pBlock);
+static bool oadFountainWriteBlock(uint16_t blockNum, uint8_t *pBlock);
+static bool oadFountainReadSymbol(uint16_t slot, uint8_t *pSymbol);
+static bool oadFountainWriteSymbol(uint16_t slot, uint8_t *pSymbol);
+static bool oadBlockPresent(uint16_t blockNum);
+static void oadStageStore(uint16_t blockNum, uint8_t *pBlock);
+static void oadStageApply(void);
+static bool oadUnpackPush(uint8_t *pBlock, bool *pComplete);
+static void oadUnpackReject(void);
+static void oadSendReject(void);
+static bool oadUnpackWriteBlock(uint16_t blockNum, uint8_t *pBlock);
+#ifdef OAD_IMG_E
+static bool oadPatchReadBase(uint32_t offset, uint8_t *pBuf, uint16_t len);
+#endif
+
+static void fwVersionReqCb(void* pSrcAddr);
+static void oadImgIdentifyReqCb(void* pSrcAddr, uint8_t imgId, uint8_t *imgMetaData);
+static void oadBlockRspCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint8_t *blkData);
+static void oadFountainSymbolCb(void* pSrcAddr, uint8_t imgId, uint16_t symbolId, uint8_t *symbolData);
+
+static void* oadRadioAccessAllocMsg(uint32_t msgLen);
+static OADProtocol_Status_t oadRadioAccessPacketSend(void* pDstAddr, uint8_t *pMsg, uint32_t msgLen);
+
+/******************************************************************************
+ Callback tables
+ *****************************************************************************/
+
+static OADProtocol_RadioAccessFxns_t  oadRadioAccessFxns =
+    {
+      oadRadioAccessAllocMsg,
+      oadRadioAccessPacketSend
+    };
+
+static OADProtocol_MsgCBs_t oadMsgCallbacks =
+    {
+      /*! Incoming FW Req */
+      fwVersionReqCb,
+      /*! Incoming FW Version Rsp */
+      NULL,
+      /*! Incoming Image Identify Req */
+      oadImgIdentifyReqCb,
+      /*! Incoming Image Identify Rsp */
+      NULL,
+      /*! Incoming OAD Block Req */
+      NULL,
+      /*! Incoming OAD Block Rsp */
+      oadBlockRspCb,
+      /*! Incoming OAD Multi Block Req */
+      NULL,
+      /*! Incoming OAD Fountain Symbol */
+      oadFountainSymbolCb,
+      /*! Incoming OAD Fountain Status */
+      NULL,
+      /*! Incoming OAD Push Ack */
+      NULL,
+    };
+
+/******************************************************************************
+ Public Functions
+ *****************************************************************************/
+
+/*!
+ Initialize the OAD client.
+
+ Public function defined in oad_client.h
+ */
+void OADClient_init(void)
+{
+    /* Create event used to signal received frames and push acks */
+    Event_Params eventParam;
+    Event_Params_init(&eventParam);
+    Event_construct(&oadClientEvent, &eventParam);
+    oadClientEventHandle = Event_handle(&oadClientEvent);
+
+    /* Create clock object which paces the push acks */
+    Clock_Params clkParams;
+    Clock_Params_init(&clkParams);
+    clkParams.period = 0;
+    clkParams.startFlag = FALSE;
+    Clock_construct(&oadAckClock, oadAckClockCallback, 1, &clkParams);
+    oadAckClockHandle = Clock_handle(&oadAckClock);
+
+    /* Create the OAD client task */
+    Task_Params_init(&oadClientTaskParams);
+    oadClientTaskParams.stackSize = OADCLIENT_TASK_STACK_SIZE;
+    oadClientTaskParams.priority = OADCLIENT_TASK_PRIORITY;
+    oadClientTaskParams.stack = &oadClientTaskStack;
+    Task_construct(&oadClientTask, oadClientTaskFunction, &oadClientTaskParams, NULL);
+}
+
+/*!
+ Set the airtime share kept for the data uplink.
+
+ Public function defined in oad_client.h
+ */
+void OADClient_setDataShare(uint8_t pct)
+{
+    if(pct > OADClient_DATA_SHARE_MAX_PCT)
+    {
+        pct = OADClient_DATA_SHARE_MAX_PCT;
+    }
+
+    oadDataSharePct = pct;
+}
+
+/*!
+ Check if an image is being downloaded.
+
+ Public function defined in oad_client.h
+ */
+bool OADClient_inProgress(void)
+{
+    return oadInProgress;
+}
+
+/*!
+ Check if a complete image is stored.
+
+ Public function defined in oad_client.h
+ */
+bool OADClient_imageReady(void)
+{
+    return oadImageReady;
+}
+
+/******************************************************************************
+ Local Functions
+ *****************************************************************************/
+
+static void oadClientTaskFunction(UArg arg0, UArg arg1)
+{
+    OADProtocol_Params_t OADProtocol_params;
+    uint32_t events;
+
+    OADStorage_init();
+
+    OADProtocol_Params_init(&OADProtocol_params);
+    OADProtocol_params.pRadioAccessFxns = &oadRadioAccessFxns;
+    OADProtocol_params.pProtocolMsgCallbacks = &oadMsgCallbacks;
+    OADProtocol_open(&OADProtocol_params);
+
+    /* OAD frames follow the ACK of any node packet */
+    NodeRadioTask_registerOadPacketCallback(oadPacketCallback);
+
+    while (1)
+    {
+        events = Event_pend(oadClientEventHandle, 0, OADCLIENT_EVENT_ALL, BIOS_WAIT_FOREVER);
+
+        if (events & OADCLIENT_EVENT_PACKET)
+        {
+            oadProcessRxQueue();
+        }
+
+        if ((events & OADCLIENT_EVENT_ACK) && oadFountain)
+        {
+            oadSendFountainStatus();
+        }
+        else if ((events & OADCLIENT_EVENT_ACK) && oadRejected)
+        {
+            oadSendReject();
+        }
+        else if (events & OADCLIENT_EVENT_ACK)
+        {
+            oadSendPushAck();
+        }
+    }
+}
+
+/*!
+ * @brief      Queue an OAD frame received by the radio task
+ */
+static void oadPacketCallback(uint8_t* data, uint8_t length)
+{
+    uint8_t next = (oadRxQueueHead + 1) % OADCLIENT_RX_QUEUE_SIZE;
+
+    /* Drop the frame when the queue is full, a lost block is pushed again */
+    if ((next == oadRxQueueTail) || (length > OADCLIENT_RX_FRAME_LEN))
+    {
+        return;
+    }
+
+    memcpy(oadRxQueue[oadRxQueueHead], data, length);
+    oadRxQueueHead = next;
+
+    Event_post(oadClientEventHandle, OADCLIENT_EVENT_PACKET);
+}
+
+/*!
+ * @brief      Parse the queued OAD frames
+ */
+static void oadProcessRxQueue(void)
+{
+    while (oadRxQueueTail != oadRxQueueHead)
+    {
+        OADProtocol_ParseIncoming(&concentratorAddress, oadRxQueue[oadRxQueueTail]);
+        oadRxQueueTail = (oadRxQueueTail + 1) % OADCLIENT_RX_QUEUE_SIZE;
+    }
+}
+
+/*!
+ * @brief      Acknowledge the blocks received, the server pushes the blocks
+ *             missing after the ack
+ */
+static void oadSendPushAck(void)
+{
+    OADProtocol_Status_t status;
+    uint32_t bitmap = 0;
+    uint32_t startTicks;
+    uint32_t elapsedTicks;
+    uint32_t delayTicks;
+    uint8_t idx;
+
+    if (!oadInProgress)
+    {
+        return;
+    }
+
+    if (oadBase >= oadNumBlocks)
+    {
+        oadFinish();
+        return;
+    }
+
+    for (idx = 0; (idx < OADProtocol_PUSH_ACK_BITMAP_SIZE) && (oadBase + idx < oadNumBlocks); idx++)
+    {
+        if (oadBlockPresent(oadBase + idx))
+        {
+            bitmap |= (uint32_t)1 << idx;
+        }
+    }
+
+    /* The blocks pushed are received before the send returns */
+    oadNewBlocks = 0;
+    startTicks = Clock_getTicks();
+    status = OADProtocol_sendOadPushAck(&concentratorAddress, oadImgId, oadBase, bitmap);
+    elapsedTicks = Clock_getTicks() - startTicks;
+
+    oadProcessRxQueue();
+
+    if (status != OADProtocol_Status_Success)
+    {
+        oadRetries++;
+    }
+    else
+    {
+        oadRetries = 0;
+    }
+
+    if (oadNewBlocks == 0)
+    {
+        oadIdleAcks++;
+    }
+    else
+    {
+        oadIdleAcks = 0;
+    }
+
+    /* The download record is kept, the next identify request resumes it */
+    if ((oadRetries > OADClient_MAX_RETRIES) || (oadIdleAcks > OADClient_MAX_IDLE_ACKS))
+    {
+        oadAbort();
+        return;
+    }
+
+    /* Leave oadDataSharePct of the airtime to the data uplink */
+    delayTicks = elapsedTicks * oadDataSharePct / (100 - oadDataSharePct);
+
+    if ((oadNewBlocks == 0) &&
+        (delayTicks < OADProtocol_PUSH_ACK_INTERVAL * 1000 / Clock_tickPeriod))
+    {
+        delayTicks = OADProtocol_PUSH_ACK_INTERVAL * 1000 / Clock_tickPeriod;
+    }
+
+    Clock_stop(oadAckClockHandle);
+    Clock_setTimeout(oadAckClockHandle, (delayTicks > 0) ? delayTicks : 1);
+    Clock_start(oadAckClockHandle);
+}
+
+/*!
+ * @brief      Stop the download
+ */
+static void oadAbort(void)
+{
+    Clock_stop(oadAckClockHandle);
+    if (oadFountain)
+    {
+        NodeRadioTask_followBroadcast(false);
+        OADProtocol_sendOadFountainStatus(&concentratorAddress, oadImgId, OADProtocol_FOUNTAIN_STATUS_FAILED,
+                                          oadDecoder.decodedBlocks, oadDecoder.receivedSymbols);
+    }
+    oadInProgress = false;
+    OADStorage_close();
+
+    Trace_printf(hDisplaySerial, "OAD aborted at block %d of %d", oadBase, oadNumBlocks);
+}
+
+/*!
+ * @brief      Check the image and keep it in the external flash
+ */
+static void oadFinish(void)
+{
+    OADStorage_Status_t status;
+
+    /* Acknowledge the last block, the server ends the session */
+    if (oadFormat == 0)
+    {
+        OADProtocol_sendOadPushAck(&concentratorAddress, oadImgId, oadNumBlocks, 0);
+    }
+
+    oadInProgress = false;
+    status = OADStorage_imgFinalise();
+
+    /* A rebuilt image is checked first, the server sends the full image if it fails */
+    if ((oadFormat != 0) && (status == OADStorage_Status_Success))
+    {
+        OADProtocol_sendOadPushAck(&concentratorAddress, oadImgId, oadNumBlocks, 0);
+    }
+    else if (oadFormat != 0)
+    {
+        oadRetries = 0;
+        oadSendReject();
+    }
+
+    /* The image info marks the image for the BIM, a flat node image only stores it */
+    if (status == OADStorage_Status_Success)
+    {
+        oadImageReady = true;
+        Trace_printf(hDisplaySerial, "OAD complete, image stored");
+#ifdef OAD_IMG_E
+        NodeTask_installImage();
+#endif
+    }
+    else
+    {
+        Trace_printf(hDisplaySerial, "OAD CRC error");
+    }
+}
+
+/*!
+ * @brief      Report the decode progress of a broadcast download, the
+ *             download stops once no symbol came for a few reports
+ */
+static void oadSendFountainStatus(void)
+{
+    if (!oadInProgress)
+    {
+        return;
+    }
+
+    if (oadNewBlocks == 0)
+    {
+        oadIdleAcks++;
+    }
+    else
+    {
+        oadIdleAcks = 0;
+    }
+    oadNewBlocks = 0;
+
+    if (oadIdleAcks > OADProtocol_FOUNTAIN_MAX_IDLE)
+    {
+        oadAbort();
+        return;
+    }
+
+    OADProtocol_sendOadFountainStatus(&concentratorAddress, oadImgId, OADProtocol_FOUNTAIN_STATUS_IN_PROGRESS,
+                                      oadDecoder.decodedBlocks, oadDecoder.receivedSymbols);
+
+    Clock_stop(oadAckClockHandle);
+    Clock_setTimeout(oadAckClockHandle, OADProtocol_FOUNTAIN_STATUS_PERIOD * 1000 / Clock_tickPeriod);
+    Clock_start(oadAckClockHandle);
+}
+
+/*!
+ * @brief      Check the decoded image and keep it in the external flash
+ */
+static void oadFountainFinish(void)
+{
+    OADStorage_Status_t status;
+
+    Clock_stop(oadAckClockHandle);
+    NodeRadioTask_followBroadcast(false);
+
+    oadInProgress = false;
+    status = OADStorage_imgFinalise();
+
+    OADProtocol_sendOadFountainStatus(&concentratorAddress, oadImgId,
+                                      (status == OADStorage_Status_Success) ?
+                                          OADProtocol_FOUNTAIN_STATUS_COMPLETE : OADProtocol_FOUNTAIN_STATUS_FAILED,
+                                      oadDecoder.decodedBlocks, oadDecoder.receivedSymbols);
+
+    if (status == OADStorage_Status_Success)
+    {
+        oadImageReady = true;
+        Trace_printf(hDisplaySerial, "OAD decoded from %d symbols, image stored", oadDecoder.receivedSymbols);
+#ifdef OAD_IMG_E
+        NodeTask_installImage();
+#endif
+    }
+    else
+    {
+        Trace_printf(hDisplaySerial, "OAD CRC error");
+    }
+}
+
+static bool oadFountainReadBlock(uint16_t blockNum, uint8_t *pBlock)
+{
+    OADStorage_imgBlockRead(blockNum, pBlock);
+
+    return true;
+}
+
+static bool oadFountainWriteBlock(uint16_t blockNum, uint8_t *pBlock)
+{
+    OADStorage_imgBlockWrite(blockNum, pBlock);
+
+    return true;
+}
+
+static bool oadFountainReadSymbol(uint16_t slot, uint8_t *pSymbol)
+{
+    OADTarget_readFlash(OADCLIENT_FOUNTAIN_SYMBOL_PAGE, (uint32_t)slot * OAD_BLOCK_SIZE, pSymbol, OAD_BLOCK_SIZE);
+
+    return true;
+}
+
+/*!
+ * @brief      Store a symbol, the slots are written in order and each page
+ *             is erased before its first slot
+ */
+static bool oadFountainWriteSymbol(uint16_t slot, uint8_t *pSymbol)
+{
+    uint32_t offset = (uint32_t)slot * OAD_BLOCK_SIZE;
+
+    if ((offset % EFL_PAGE_SIZE) == 0)
+    {
+        OADTarget_eraseFlash(OADCLIENT_FOUNTAIN_SYMBOL_PAGE + offset / EFL_PAGE_SIZE);
+    }
+
+    OADTarget_writeFlash(OADCLIENT_FOUNTAIN_SYMBOL_PAGE, offset, pSymbol, OAD_BLOCK_SIZE);
+
+    return true;
+}
+
+/*!
+ * @brief      Check if a block of the download is stored, a staged block for
+ *             a patch or compressed image
+ */
+static bool oadBlockPresent(uint16_t blockNum)
+{
+    if (oadFormat != 0)
+    {
+        return (blockNum < OADCLIENT_STAGE_MAX_BLOCKS) &&
+               (oadStageBitmap[blockNum / 8] & (1 << (blockNum % 8)));
+    }
+
+    return OADStorage_imgBlockPresent(blockNum);
+}
+
+/*!
+ * @brief      Keep a block until the patcher or decompressor takes it, a page
+ *             is erased before its first block
+ */
+static void oadStageStore(uint16_t blockNum, uint8_t *pBlock)
+{
+    uint32_t offset = (uint32_t)blockNum * OAD_BLOCK_SIZE;
+    uint8_t page = offset / EFL_PAGE_SIZE;
+
+    if (!(oadStageErasedPages & ((uint32_t)1 << page)))
+    {
+        OADTarget_eraseFlash(OADCLIENT_STAGE_PAGE + page);
+        oadStageErasedPages |= (uint32_t)1 << page;
+    }
+
+    OADTarget_writeFlash(OADCLIENT_STAGE_PAGE, offset, pBlock, OAD_BLOCK_SIZE);
+    oadStageBitmap[blockNum / 8] |= 1 << (blockNum % 8);
+}
+
+/*!
+ * @brief      Rebuild the image from the staged blocks, in order from the
+ *             first one missing. The image header of the patch or compressed
+ *             image gives the blocks to download, the download then ends
+ *             with its last block.
+ */
+static void oadStageApply(void)
+{
+    uint8_t block[OAD_BLOCK_SIZE];
+    uint32_t stagedLen;
+    bool complete = false;
+
+    while ((oadBase < oadNumBlocks) && oadBlockPresent(oadBase))
+    {
+        OADTarget_readFlash(OADCLIENT_STAGE_PAGE, (uint32_t)oadBase * OAD_BLOCK_SIZE, block, OAD_BLOCK_SIZE);
+
+        if (oadBase == 0)
+        {
+            stagedLen = (uint32_t)OADTarget_BUILD_UINT16(block[OADCLIENT_IMG_HDR_LEN_OFFSET],
+                                                         block[OADCLIENT_IMG_HDR_LEN_OFFSET + 1]) * EFL_OAD_ADDR_RESOLUTION;
+            oadNumBlocks = (stagedLen + OAD_BLOCK_SIZE - 1) / OAD_BLOCK_SIZE;
+            if ((oadNumBlocks == 0) || (oadNumBlocks > OADCLIENT_STAGE_MAX_BLOCKS))
+            {
+                oadUnpackReject();
+                return;
+            }
+        }
+
+        /* The last block must leave the image complete */
+        if (!oadUnpackPush(block, &complete) || ((oadBase + 1 == oadNumBlocks) && !complete))
+        {
+            oadUnpackReject();
+            return;
+        }
+
+        oadBase++;
+    }
+}
+
+/*!
+ * @brief      Give the next staged block to the patcher or decompressor, the
+ *             blocks after the end of the image are padding
+ *
+ * @return     false if the image can not be rebuilt
+ */
+static bool oadUnpackPush(uint8_t *pBlock, bool *pComplete)
+{
+#ifdef OAD_IMG_E
+    if (oadFormat == OADProtocol_IMG_ID_DELTA)
+    {
+        if (oadUnpack.patcher.status == OADDelta_Status_InProgress)
+        {
+            OADDelta_patcherPush(&oadUnpack.patcher, pBlock, OAD_BLOCK_SIZE);
+        }
+
+        *pComplete = (oadUnpack.patcher.status == OADDelta_Status_Complete);
+        return *pComplete || (oadUnpack.patcher.status == OADDelta_Status_InProgress);
+    }
+#endif
+
+    if (oadUnpack.decompressor.status == OADCompress_Status_InProgress)
+    {
+        OADCompress_decompressorPush(&oadUnpack.decompressor, pBlock, OAD_BLOCK_SIZE);
+    }
+
+    *pComplete = (oadUnpack.decompressor.status == OADCompress_Status_Complete);
+    return *pComplete || (oadUnpack.decompressor.status == OADCompress_Status_InProgress);
+}
+
+/*!
+ * @brief      Stop a download that does not rebuild the image, the server
+ *             then sends the full image
+ */
+static void oadUnpackReject(void)
+{
+    Clock_stop(oadAckClockHandle);
+    oadInProgress = false;
+    OADStorage_imgDiscard();
+
+    Trace_printf(hDisplaySerial, "OAD %s rejected at block %d",
+                 (oadFormat == OADProtocol_IMG_ID_DELTA) ? "patch" : "compressed image", oadBase);
+
+    oadRetries = 0;
+    oadSendReject();
+}
+
+/*!
+ * @brief      Send the server the rejection of the download, it then sends
+ *             the full image
+ */
+static void oadSendReject(void)
+{
+    /* The server pushes no more blocks, only the send tells the rejection was lost */
+    if ((OADProtocol_sendOadIdentifyImgRsp(&concentratorAddress, oadImgId, 0, 0) == OADProtocol_Status_Success) ||
+        (++oadRetries > OADClient_MAX_RETRIES))
+    {
+        oadRejected = false;
+        return;
+    }
+
+    oadRejected = true;
+
+    Clock_stop(oadAckClockHandle);
+    Clock_setTimeout(oadAckClockHandle, OADProtocol_PUSH_ACK_INTERVAL * 1000 / Clock_tickPeriod);
+    Clock_start(oadAckClockHandle);
+}
+
+static bool oadUnpackWriteBlock(uint16_t blockNum, uint8_t *pBlock)
+{
+    OADStorage_imgBlockWrite(blockNum, pBlock);
+
+    return true;
+}
+
+#ifdef OAD_IMG_E
+static bool oadPatchReadBase(uint32_t offset, uint8_t *pBuf, uint16_t len)
+{
+    /* The copies stay within the image the patch was made against */
+    if (offset + len > oadUnpack.patcher.baseLen)
+    {
+        return false;
+    }
+
+    OADImageHeader_readImage(offset, pBuf, len);
+
+    return true;
+}
+#endif
+
+static void oadAckClockCallback(UArg arg0)
+{
+    Event_post(oadClientEventHandle, OADCLIENT_EVENT_ACK);
+}
+
+/******************************************************************************
+ OAD Protocol callbacks
+ *****************************************************************************/
+
+static void fwVersionReqCb(void* pSrcAddr)
+{
+    OADProtocol_sendFwVersionRsp(pSrcAddr, FW_VERSION);
+}
+
+static void oadImgIdentifyReqCb(void* pSrcAddr, uint8_t imgId, uint8_t *imgMetaData)
+{
+    uint16_t numBlocks = 0;
+    bool fountain = (imgId & OADProtocol_IMG_ID_FOUNTAIN) != 0;
+
+    /*
+     * The identify of a broadcast is repeated, a node following the
+     * broadcast or done with it keeps its state and only reports it
+     */
+    if (fountain && oadFountain && (imgId == oadImgId) && (oadInProgress || oadImageReady))
+    {
+        if (oadImageReady)
+        {
+            OADProtocol_sendOadFountainStatus(pSrcAddr, oadImgId, OADProtocol_FOUNTAIN_STATUS_COMPLETE,
+                                              oadDecoder.decodedBlocks, oadDecoder.receivedSymbols);
+        }
+        return;
+    }
+
+    Clock_stop(oadAckClockHandle);
+    if (oadInProgress)
+    {
+        if (oadFountain)
+        {
+            NodeRadioTask_followBroadcast(false);
+        }
+        oadInProgress = false;
+        OADStorage_close();
+    }
+    oadImageReady = false;
+    oadFountain = false;
+    oadFormat = 0;
+    oadRejected = false;
+
+    /*
+     * The blocks of patches and compressed images are not the image, they
+     * are taken in order and can not be decoded from a broadcast. A patch is
+     * applied to the running image, which a node built without OAD_IMG_E
+     * does not have in the image format. The server sends the full image
+     * when the node rejects either.
+     */
+#ifdef OAD_IMG_E
+    if (((imgId & (OADProtocol_IMG_ID_DELTA | OADProtocol_IMG_ID_COMPRESSED)) == 0) || !fountain)
+#else
+    if (((imgId & OADProtocol_IMG_ID_DELTA) == 0) &&
+        (((imgId & OADProtocol_IMG_ID_COMPRESSED) == 0) || !fountain))
+#endif
+    {
+        /* The server stores the node image as remote app, it is the app here */
+        if (imgMetaData[OADCLIENT_IMG_HDR_TYPE_OFFSET] == EFL_OAD_IMG_TYPE_REMOTE_APP)
+        {
+            imgMetaData[OADCLIENT_IMG_HDR_TYPE_OFFSET] = EFL_OAD_IMG_TYPE_APP;
+        }
+
+        numBlocks = OADStorage_imgIdentifyWrite(imgMetaData);
+    }
+
+    /* A broadcast image is decoded from the symbols the node can keep */
+    if (fountain && (numBlocks > OADClient_FOUNTAIN_MAX_BLOCKS))
+    {
+        OADStorage_close();
+        numBlocks = 0;
+    }
+
+    if ((numBlocks == 0) && fountain)
+    {
+        OADProtocol_sendOadFountainStatus(pSrcAddr, imgId, OADProtocol_FOUNTAIN_STATUS_FAILED, 0, 0);
+        return;
+    }
+    else if (numBlocks == 0)
+    {
+        OADProtocol_sendOadIdentifyImgRsp(pSrcAddr, imgId, 0, 0);
+        return;
+    }
+
+    if (fountain)
+    {
+        OADFountain_decoderInit(&oadDecoder, numBlocks, oadDecodedBitmap, oadSymbols, OADClient_FOUNTAIN_MAX_SYMBOLS,
+                                oadFountainReadBlock, oadFountainWriteBlock,
+                                oadFountainReadSymbol, oadFountainWriteSymbol);
+
+        oadImgId = imgId;
+        oadNumBlocks = numBlocks;
+        oadNewBlocks = 0;
+        oadIdleAcks = 0;
+        oadFountain = true;
+        oadInProgress = true;
+
+        /* The symbols come in the broadcast slots, the first status goes now */
+        NodeRadioTask_followBroadcast(true);
+
+        Trace_printf(hDisplaySerial, "OAD broadcast of %d blocks", oadNumBlocks);
+
+        Event_post(oadClientEventHandle, OADCLIENT_EVENT_ACK);
+        return;
+    }
+
+    oadImgId = imgId;
+    oadNumBlocks = numBlocks;
+    oadBase = OADStorage_imgResumeBlock();
+    oadNewBlocks = 0;
+    oadIdleAcks = 0;
+    oadRetries = 0;
+    oadInProgress = true;
+
+    /* A patch or compressed image starts over, the image blocks it rebuilds again are kept */
+    if (imgId & (OADProtocol_IMG_ID_DELTA | OADProtocol_IMG_ID_COMPRESSED))
+    {
+#ifdef OAD_IMG_E
+        if (imgId & OADProtocol_IMG_ID_DELTA)
+        {
+            OADDelta_patcherInit(&oadUnpack.patcher, FW_VERSION_NUM, oadPatchReadBase, oadUnpackWriteBlock);
+        }
+        else
+#endif
+        {
+            OADCompress_decompressorInit(&oadUnpack.decompressor, oadUnpackWriteBlock);
+        }
+        memset(oadStageBitmap, 0, sizeof(oadStageBitmap));
+        oadStageErasedPages = 0;
+
+        oadFormat = imgId & (OADProtocol_IMG_ID_DELTA | OADProtocol_IMG_ID_COMPRESSED);
+        oadNumBlocks = OADCLIENT_STAGE_MAX_BLOCKS;
+        oadBase = 0;
+
+        Trace_printf(hDisplaySerial, "OAD %s for an image of %d blocks",
+                     (oadFormat == OADProtocol_IMG_ID_DELTA) ? "patch" : "compressed image", numBlocks);
+    }
+
+    OADProtocol_sendOadIdentifyImgRsp(pSrcAddr, imgId, 1, oadBase);
+
+    Trace_printf(hDisplaySerial, "OAD Block: %d of %d", oadBase, oadNumBlocks);
+
+    Event_post(oadClientEventHandle, OADCLIENT_EVENT_ACK);
+}
+
+static void oadBlockRspCb(void* pSrcAddr, uint8_t imgId, uint16_t blockNum, uint8_t *blkData)
+{
+    if (!oadInProgress || (imgId != oadImgId) || (blockNum >= oadNumBlocks))
+    {
+        return;
+    }
+
+    if (oadFormat != 0)
+    {
+        if (!oadBlockPresent(blockNum))
+        {
+            oadStageStore(blockNum, blkData);
+            oadNewBlocks++;
+        }
+
+        oadStageApply();
+        return;
+    }
+
+    if (!OADStorage_imgBlockPresent(blockNum))
+    {
+        OADStorage_imgBlockWrite(blockNum, blkData);
+        oadNewBlocks++;
+    }
+
+    while ((oadBase < oadNumBlocks) && OADStorage_imgBlockPresent(oadBase))
+    {
+        oadBase++;
+    }
+}
+
+static void oadFountainSymbolCb(void* pSrcAddr, uint8_t imgId, uint16_t symbolId, uint8_t *symbolData)
+{
+    if (!oadInProgress || !oadFountain || (imgId != oadImgId))
+    {
+        return;
+    }
+
+    oadNewBlocks++;
+
+    if (OADFountain_decoderAddSymbol(&oadDecoder, symbolId, symbolData))
+    {
+        oadFountainFinish();
+    }
+}
+
+/******************************************************************************
+ Radio access functions
+ *****************************************************************************/
+
+/*!
+ * @brief      Radio access function for OAD module to get a message buffer
+ */
+static void* oadRadioAccessAllocMsg(uint32_t msgLen)
+{
+    /* One message is sent at a time, from the client task */
+    if (msgLen > sizeof(oadTxBuffer))
+    {
+        return NULL;
+    }
+
+    return oadTxBuffer;
+}
+
+/*!
+ * @brief      Radio access function for OAD module to send messages
+ */
+static OADProtocol_Status_t oadRadioAccessPacketSend(void* pDstAddr, uint8_t *pMsg, uint32_t msgLen)
+{
+    /* The node only talks to the concentrator */
+    if (NodeRadioTask_sendOadData(pMsg, msgLen) == NodeRadioStatus_Success)
+    {
+        return OADProtocol_Status_Success;
+    }
+
+    return OADProtocol_Failed;
+}
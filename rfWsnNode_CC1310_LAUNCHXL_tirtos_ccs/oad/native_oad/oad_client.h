@@ -0,0 +1,128 @@
+/******************************************************************************
+
+ @file oad_client.h
+
+ @brief OAD Client Header
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+#ifndef OADClient_H
+#define OADClient_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "oad/native_oad/oad_protocol.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @brief Background image download
+ *
+ *  The client answers the FW version and image identify requests of the OAD
+ *  server and receives the image in push mode from its own low priority
+ *  task. The OAD frames follow the ACK of a node packet, the radio task
+ *  receiving them while the ACK has RADIO_PACKET_OPTIONS_FRAME_PENDING set.
+ *  Each push ack takes some airtime of its own, the next push ack is delayed
+ *  so that the download leaves OADClient_DATA_SHARE_PCT of the airtime to the
+ *  data uplink of the node.
+ *
+ *  An image identify with OADProtocol_IMG_ID_FOUNTAIN set starts a broadcast
+ *  download instead. The radio task then listens in the broadcast slots of
+ *  the concentrator while it is idle, and the client stores the fountain
+ *  symbols in the external flash until the decoder releases the blocks. The
+ *  client reports its progress every OADProtocol_FOUNTAIN_STATUS_PERIOD ms
+ *  and stops after OADProtocol_FOUNTAIN_MAX_IDLE reports without a symbol.
+ *
+ *  A node built with OAD_IMG_E also accepts a delta patch, an image identify
+ *  with OADProtocol_IMG_ID_DELTA set. The patch blocks are pushed like image
+ *  blocks and kept in the delta region, and the patcher applies them in order
+ *  to the running image to rebuild the new image in the download area. A
+ *  compressed image, OADProtocol_IMG_ID_COMPRESSED set, is kept there the
+ *  same way and decompressed in order into the download area. A patch or
+ *  compressed image that does not rebuild the image, or whose image fails
+ *  the CRC check, is rejected and the server sends the full image.
+ *
+ *  Once the image is complete and its CRC checked it stays in the external
+ *  flash, marked for the BIM. A node built with OAD_IMG_E then resets and
+ *  the BIM installs it, a flat node image only keeps it.
+ */
+#define OADClient_DATA_SHARE_PCT        50  ///< Default airtime share kept for the data uplink
+#define OADClient_DATA_SHARE_MAX_PCT    90  ///< Highest airtime share kept for the data uplink
+#define OADClient_MAX_IDLE_ACKS         OADProtocol_PUSH_MAX_IDLE_ACKS ///< Push acks without a new block before abort
+#define OADClient_MAX_RETRIES           OADProtocol_MAX_RETRIES ///< Push acks failing in a row before abort
+#define OADClient_FOUNTAIN_MAX_SYMBOLS  640 ///< Fountain symbols stored for the decoder
+#define OADClient_FOUNTAIN_MAX_BLOCKS   (OADClient_FOUNTAIN_MAX_SYMBOLS * 10 / 11) ///< Largest image in blocks a broadcast download accepts
+
+ /** @brief  Function to initialize the OAD client and create its task
+ *
+ */
+extern void OADClient_init(void);
+
+ /** @brief  Function to set the airtime share kept for the data uplink
+ *          during a download
+ *
+ *  @param  pct         Share in %, at most OADClient_DATA_SHARE_MAX_PCT
+ */
+extern void OADClient_setDataShare(uint8_t pct);
+
+/** @brief  Function to check if an image is being downloaded
+*
+*  @return true if a download is in progress
+*/
+extern bool OADClient_inProgress(void);
+
+/** @brief  Function to check if a complete image is stored
+*
+*  @return true if an image was downloaded and its CRC checked
+*/
+extern bool OADClient_imageReady(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OADClient_H */
@@ -0,0 +1,114 @@
+/******************************************************************************
+
+ @file oad_image_header.c
+
+ @brief OAD image header of the node application
+
+ Group: CMCU LPRF
+ Target Device: cc13x0
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016-2019, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stdint.h>
+#include <string.h>
+
+#include "oad/native_oad/oad_image_header.h"
+#include "oad/native_oad/oad_target.h"
+#include "oad/native_oad/ext_flash_layout.h"
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+/*
+ * Built for the off-chip OAD BIM only. The image tool of the SDK fills in the
+ * CRC and the length, the BIM copies an image from the external flash to the
+ * address in the header once its CRC checks out and starts it after the
+ * header.
+ */
+#ifdef OAD_IMG_E
+
+#define OAD_IMAGE_VERSION       0x0001
+#define OAD_IMAGE_START         0x1000
+
+typedef struct
+{
+    uint16_t crc[2];                ///< CRC of the image and its shadow
+    OADTarget_ImgHdr_t hdr;
+} OADImageHeader_t;
+
+/******************************************************************************
+ Global variables
+ *****************************************************************************/
+
+#pragma DATA_SECTION(oadImageHeader, ".imgHdr")
+#pragma RETAIN(oadImageHeader)
+const OADImageHeader_t oadImageHeader =
+{
+    { 0xFFFF, 0xFFFF },
+    {
+        OAD_IMAGE_VERSION,
+        0xFFFF,                                     ///< Length in 4 byte words, filled in by the tool
+        { 'E', 'E', 'E', 'E' },
+        {
+            OADTarget_LO_UINT16(OAD_IMAGE_START / EFL_OAD_ADDR_RESOLUTION),
+            OADTarget_HI_UINT16(OAD_IMAGE_START / EFL_OAD_ADDR_RESOLUTION),
+            EFL_OAD_IMG_TYPE_APP,
+            0xFF
+        }
+    }
+};
+
+/******************************************************************************
+ Public Functions
+ *****************************************************************************/
+
+/*!
+ Read the running image.
+
+ Public function defined in oad_image_header.h
+ */
+void OADImageHeader_readImage(uint32_t offset, uint8_t *pBuf, uint16_t len)
+{
+    memcpy(pBuf, (const uint8_t *)OAD_IMAGE_START + offset, len);
+}
+
+#endif /* OAD_IMG_E */
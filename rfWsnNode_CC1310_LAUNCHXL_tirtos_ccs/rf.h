@@ -12,11 +12,16 @@
 
 #define RF_SPI_CMD_GET_CONFIG               0x41
 #define RF_SPI_CMD_SET_CONFIG               0x42
+#define RF_SPI_CMD_GET_STATUS               0x43
 
 #define RF_SPI_CMD_START_AUTO_TRANSFER      0x81
 #define RF_SPI_CMD_STOP_AUTO_TRANSFER       0x82
 #define RF_SPI_CMD_START_MOTION_DETECTION   0x83
 #define RF_SPI_CMD_STOP_MOTION_DETECTION    0x84
+#define RF_SPI_CMD_START_FEATURE_EXTRACTION 0x85
+#define RF_SPI_CMD_STOP_FEATURE_EXTRACTION  0x86
+#define RF_SPI_CMD_START_BURST_CAPTURE      0x87
+#define RF_SPI_CMD_STOP_BURST_CAPTURE       0x88
 
 #define RF_SPI_CMD_DUMMY                    0x5A
 
@@ -48,6 +48,7 @@
 #include "NodeTask.h"
 #include "SpiSlave.h"
 #include "mpu6050.h"
+#include "oad/native_oad/oad_client.h"
 /*
  *  ======== main ========
  */
@@ -61,6 +62,7 @@ int main(void)
     NodeRadioTask_init();
     NodeTask_init();
     SpiSlave_init();
+    OADClient_init();
 
     /* Start BIOS */
     BIOS_start();
@@ -0,0 +1,285 @@
+/*
+ * vibration.c
+ *
+ *  Fixed point vibration features: RMS, peak to peak, crest factor and
+ *  the band RMS of a radix-2 FFT, all in Q15 so the CM3 needs no FPU.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "vibration.h"
+#include "mpu6050.h"
+
+#define VIBRATION_FFT_SIZE          VIBRATION_WINDOW_SIZE
+#define VIBRATION_BINS_PER_BAND     ((VIBRATION_FFT_SIZE / 2) / VIBRATION_NUM_BANDS)
+
+/* sin(2 * pi * k / VIBRATION_FFT_SIZE) in Q15, a quarter period */
+static  const int16_t   sineTable[VIBRATION_FFT_SIZE / 4 + 1] =
+{
+         0,   1608,   3212,   4808,   6393,   7962,   9512,  11039,
+     12540,  14010,  15447,  16846,  18205,  19520,  20788,  22006,
+     23170,  24279,  25330,  26320,  27246,  28106,  28899,  29622,
+     30274,  30853,  31357,  31786,  32138,  32413,  32610,  32729,
+     32767,
+};
+
+static  int16_t     window_[VIBRATION_WINDOW_SIZE * VIBRATION_NUM_AXES];
+static  int16_t     re_[VIBRATION_FFT_SIZE];
+static  int16_t     im_[VIBRATION_FFT_SIZE];
+
+static  int16_t     Vibration_sin(uint16_t k);
+static  uint16_t    Vibration_sqrt(uint32_t value);
+static  void        Vibration_fft(int16_t* re, int16_t* im);
+static  void        Vibration_extractAxis(const int16_t* xyz, uint8_t axis, VIBRATION_AXIS_FEATURES* features);
+
+bool    Vibration_capture(VIBRATION_FEATURES* features)
+{
+    if (!MPU6050_captureAccelQ15(window_, VIBRATION_WINDOW_SIZE, VIBRATION_SAMPLE_RATE_HZ))
+    {
+        return  false;
+    }
+
+    Vibration_extract(window_, features);
+
+    return  true;
+}
+
+void    Vibration_extract(const int16_t* xyz, VIBRATION_FEATURES* features)
+{
+    uint8_t axis;
+
+    for(axis = 0 ; axis < VIBRATION_NUM_AXES ; axis++)
+    {
+        Vibration_extractAxis(xyz, axis, &features->axis[axis]);
+    }
+}
+
+uint32_t    Vibration_encode(const VIBRATION_FEATURES* features, uint8_t* buffer, uint32_t maxLength)
+{
+    uint32_t    length = 0;
+    uint8_t     axis;
+    uint8_t     band;
+
+    if (maxLength < VIBRATION_FEATURES_LENGTH)
+    {
+        return  0;
+    }
+
+    buffer[length++] = (VIBRATION_SAMPLE_RATE_HZ >> 8) & 0xFF;
+    buffer[length++] = VIBRATION_SAMPLE_RATE_HZ & 0xFF;
+    buffer[length++] = VIBRATION_WINDOW_SIZE & 0xFF;
+    buffer[length++] = VIBRATION_NUM_BANDS;
+
+    for(axis = 0 ; axis < VIBRATION_NUM_AXES ; axis++)
+    {
+        const VIBRATION_AXIS_FEATURES*  axisFeatures = &features->axis[axis];
+
+        buffer[length++] = (axisFeatures->rms >> 8) & 0xFF;
+        buffer[length++] = axisFeatures->rms & 0xFF;
+        buffer[length++] = (axisFeatures->peakToPeak >> 8) & 0xFF;
+        buffer[length++] = axisFeatures->peakToPeak & 0xFF;
+        buffer[length++] = (axisFeatures->crestFactor >> 8) & 0xFF;
+        buffer[length++] = axisFeatures->crestFactor & 0xFF;
+
+        for(band = 0 ; band < VIBRATION_NUM_BANDS ; band++)
+        {
+            buffer[length++] = (axisFeatures->bands[band] >> 8) & 0xFF;
+            buffer[length++] = axisFeatures->bands[band] & 0xFF;
+        }
+    }
+
+    return  length;
+}
+
+static void Vibration_extractAxis(const int16_t* xyz, uint8_t axis, VIBRATION_AXIS_FEATURES* features)
+{
+    int32_t     sum = 0;
+    int32_t     mean;
+    int32_t     value;
+    int32_t     peak = 0;
+    int16_t     min = INT16_MAX;
+    int16_t     max = INT16_MIN;
+    uint64_t    energy = 0;
+    uint64_t    bandEnergy;
+    uint32_t    meanSquare;
+    uint16_t    i;
+    uint8_t     band;
+
+    for(i = 0 ; i < VIBRATION_WINDOW_SIZE ; i++)
+    {
+        int16_t sample = xyz[i * VIBRATION_NUM_AXES + axis];
+
+        sum += sample;
+        if (sample < min)
+        {
+            min = sample;
+        }
+        if (sample > max)
+        {
+            max = sample;
+        }
+    }
+
+    mean = sum / VIBRATION_WINDOW_SIZE;
+
+    for(i = 0 ; i < VIBRATION_WINDOW_SIZE ; i++)
+    {
+        value = xyz[i * VIBRATION_NUM_AXES + axis] - mean;
+
+        energy += (uint64_t)((int64_t)value * value);
+        if ((value > peak) || (-value > peak))
+        {
+            peak = (value < 0) ? -value : value;
+        }
+
+        /* Halved so that the deviation fits in 16 bits */
+        re_[i] = (int16_t)(value >> 1);
+        im_[i] = 0;
+    }
+
+    energy /= VIBRATION_WINDOW_SIZE;
+    meanSquare = (energy > UINT32_MAX) ? UINT32_MAX : (uint32_t)energy;
+
+    features->rms = Vibration_sqrt(meanSquare);
+    features->peakToPeak = (uint16_t)((int32_t)max - min);
+    if (features->rms == 0)
+    {
+        features->crestFactor = 0;
+    }
+    else
+    {
+        value = (peak << 8) / features->rms;
+        features->crestFactor = (value > UINT16_MAX) ? UINT16_MAX : (uint16_t)value;
+    }
+
+    Vibration_fft(re_, im_);
+
+    /*
+     * The bins are scaled by 1 / (2 * VIBRATION_FFT_SIZE), the RMS of the
+     * signal in a band is sqrt(8 * energy of its positive frequency bins).
+     */
+    for(band = 0 ; band < VIBRATION_NUM_BANDS ; band++)
+    {
+        bandEnergy = 0;
+        for(i = band * VIBRATION_BINS_PER_BAND ; i < (band + 1) * VIBRATION_BINS_PER_BAND ; i++)
+        {
+            /* Skip the DC bin, the mean is removed */
+            if (i != 0)
+            {
+                bandEnergy += (uint64_t)((int32_t)re_[i] * re_[i]) + (uint64_t)((int32_t)im_[i] * im_[i]);
+            }
+        }
+
+        bandEnergy *= 8;
+        features->bands[band] = Vibration_sqrt((bandEnergy > UINT32_MAX) ? UINT32_MAX : (uint32_t)bandEnergy);
+    }
+}
+
+static int16_t  Vibration_sin(uint16_t k)
+{
+    k %= VIBRATION_FFT_SIZE;
+
+    if (k <= VIBRATION_FFT_SIZE / 4)
+    {
+        return  sineTable[k];
+    }
+    else if (k <= VIBRATION_FFT_SIZE / 2)
+    {
+        return  sineTable[VIBRATION_FFT_SIZE / 2 - k];
+    }
+    else if (k <= VIBRATION_FFT_SIZE * 3 / 4)
+    {
+        return  -sineTable[k - VIBRATION_FFT_SIZE / 2];
+    }
+
+    return  -sineTable[VIBRATION_FFT_SIZE - k];
+}
+
+/*
+ * In place radix-2 decimation in time FFT, each stage halves the values so the
+ * result is scaled by 1 / VIBRATION_FFT_SIZE and cannot overflow.
+ */
+static void Vibration_fft(int16_t* re, int16_t* im)
+{
+    uint16_t    i;
+    uint16_t    j;
+    uint16_t    k;
+    uint16_t    bit;
+    uint16_t    half;
+    uint16_t    step;
+    int16_t     swap;
+
+    for(i = 1, j = 0 ; i < VIBRATION_FFT_SIZE ; i++)
+    {
+        for(bit = VIBRATION_FFT_SIZE >> 1 ; j & bit ; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j)
+        {
+            swap = re[i];
+            re[i] = re[j];
+            re[j] = swap;
+            swap = im[i];
+            im[i] = im[j];
+            im[j] = swap;
+        }
+    }
+
+    for(half = 1 ; half < VIBRATION_FFT_SIZE ; half <<= 1)
+    {
+        step = VIBRATION_FFT_SIZE / (half * 2);
+
+        for(k = 0 ; k < half ; k++)
+        {
+            int32_t wr = Vibration_sin(k * step + VIBRATION_FFT_SIZE / 4);
+            int32_t wi = -Vibration_sin(k * step);
+
+            for(i = k ; i < VIBRATION_FFT_SIZE ; i += half * 2)
+            {
+                int32_t tr;
+                int32_t ti;
+
+                j = i + half;
+                tr = (wr * re[j] - wi * im[j]) >> 15;
+                ti = (wr * im[j] + wi * re[j]) >> 15;
+
+                re[j] = (int16_t)((re[i] - tr) >> 1);
+                im[j] = (int16_t)((im[i] - ti) >> 1);
+                re[i] = (int16_t)((re[i] + tr) >> 1);
+                im[i] = (int16_t)((im[i] + ti) >> 1);
+            }
+        }
+    }
+}
+
+static uint16_t Vibration_sqrt(uint32_t value)
+{
+    uint32_t    root = 0;
+    uint32_t    bit = (uint32_t)1 << 30;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return  (uint16_t)root;
+}
@@ -0,0 +1,52 @@
+/*
+ * vibration.h
+ *
+ *  Vibration features computed on the node from a window of MPU6050
+ *  accelerations, in place of the raw samples.
+ */
+
+#ifndef VIBRATION_H_
+#define VIBRATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VIBRATION_NUM_AXES          3
+#define VIBRATION_WINDOW_SIZE       128     /* Frames per window, power of 2, at most 170 in the FIFO */
+#define VIBRATION_SAMPLE_RATE_HZ    500
+#define VIBRATION_NUM_BANDS         8       /* Bands of equal width between DC and Nyquist */
+
+/* Encoded length of the features */
+#define VIBRATION_FEATURES_LENGTH   (4 + VIBRATION_NUM_AXES * (3 + VIBRATION_NUM_BANDS) * 2)
+
+/*
+ * Features of one axis, the mean (gravity) removed. Amplitudes are Q15
+ * fractions of the accelerometer full scale range, see MPU6050_Q15_TO_MG().
+ */
+typedef struct
+{
+    uint16_t    rms;
+    uint16_t    peakToPeak;
+    uint16_t    crestFactor;                    /* Peak / RMS, Q8.8 */
+    uint16_t    bands[VIBRATION_NUM_BANDS];     /* RMS in the band, square root of the band energy */
+}   VIBRATION_AXIS_FEATURES;
+
+typedef struct
+{
+    VIBRATION_AXIS_FEATURES axis[VIBRATION_NUM_AXES];
+}   VIBRATION_FEATURES;
+
+/* Capture a window from the MPU6050 and extract its features */
+bool        Vibration_capture(VIBRATION_FEATURES* features);
+
+/* Extract the features of a window of VIBRATION_WINDOW_SIZE X, Y and Z frames */
+void        Vibration_extract(const int16_t* xyz, VIBRATION_FEATURES* features);
+
+/*
+ * Encode the features big endian: sample rate, window size, number of bands,
+ * then RMS, peak to peak, crest factor and bands of each axis.
+ * Returns the length, 0 if the buffer is too short.
+ */
+uint32_t    Vibration_encode(const VIBRATION_FEATURES* features, uint8_t* buffer, uint32_t maxLength);
+
+#endif /* VIBRATION_H_ */
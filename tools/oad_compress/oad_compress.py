@@ -0,0 +1,277 @@
+#!/usr/bin/env python
+"""
+Compress a node OAD image for a smaller over the air transfer.
+
+The compressed image is decompressed by the node as the blocks arrive (see
+oad_compress.h for the format). It is itself an OAD image of type
+EFL_OAD_IMG_TYPE_COMPRESSED with the version of the image, so it is loaded into
+the concentrator external flash with oad_write_bin.py next to the uncompressed
+image, which stays for the nodes that reject it.
+
+Usage: python oad_compress.py image.bin compressed.bin
+"""
+import struct
+import sys
+
+MAGIC = 0x43525A4C  # "LZRC"
+IMG_TYPE_COMPRESSED = 7
+
+WINDOW_SIZE = 2048
+MIN_MATCH = 2
+MIN_NEW_MATCH = 3
+LEN_BITS = 8
+MAX_MATCH = MIN_MATCH + (1 << LEN_BITS) - 1
+DIST_SLOT_BITS = 5
+MAX_CANDIDATES = 64
+
+PROB_BITS = 11
+PROB_MOVE_BITS = 5
+PROB_INIT = 1 << (PROB_BITS - 1)
+RANGE_TOP = 1 << 24
+
+PROB_IS_MATCH = 0
+PROB_IS_REP = 2
+PROB_LITERAL = 4
+PROB_LEN = PROB_LITERAL + 0x100
+PROB_DIST_SLOT = PROB_LEN + (1 << LEN_BITS)
+NUM_PROBS = PROB_DIST_SLOT + (1 << DIST_SLOT_BITS)
+
+
+def crc16(data):
+    """CRC over an image as calculated by crcCalcDL in oad_storage.c"""
+    crc = 0
+    for byte in bytearray(data) + bytearray(2):
+        for _ in range(8):
+            msb = crc & 0x8000
+            crc = (crc << 1) & 0xFFFF
+            if byte & 0x80:
+                crc |= 1
+            if msb:
+                crc ^= 0x1021
+            byte = (byte << 1) & 0xFF
+    return crc
+
+
+def image_len(img):
+    """Image length in bytes from the header"""
+    return struct.unpack_from('<H', img, 6)[0] * 4
+
+
+class RangeEncoder(object):
+    def __init__(self):
+        self.low = 0
+        self.range = 0xFFFFFFFF
+        self.cache = 0
+        self.cache_size = 1
+        self.out = bytearray()
+        self.probs = [PROB_INIT] * NUM_PROBS
+
+    def _shift_low(self):
+        if self.low < 0xFF000000 or self.low >= (1 << 32):
+            carry = self.low >> 32
+            temp = self.cache
+            while True:
+                self.out.append((temp + carry) & 0xFF)
+                temp = 0xFF
+                self.cache_size -= 1
+                if self.cache_size == 0:
+                    break
+            self.cache = (self.low >> 24) & 0xFF
+        self.cache_size += 1
+        self.low = (self.low & 0x00FFFFFF) << 8
+
+    def _normalize(self):
+        while self.range < RANGE_TOP:
+            self.range <<= 8
+            self._shift_low()
+
+    def bit(self, prob, bit):
+        p = self.probs[prob]
+        bound = (self.range >> PROB_BITS) * p
+        if bit == 0:
+            self.range = bound
+            self.probs[prob] = p + (((1 << PROB_BITS) - p) >> PROB_MOVE_BITS)
+        else:
+            self.low += bound
+            self.range -= bound
+            self.probs[prob] = p - (p >> PROB_MOVE_BITS)
+        self._normalize()
+
+    def tree(self, probs, num_bits, value):
+        node = 1
+        for i in reversed(range(num_bits)):
+            bit = (value >> i) & 1
+            self.bit(probs + node, bit)
+            node = (node << 1) | bit
+
+    def direct(self, num_bits, value):
+        for i in reversed(range(num_bits)):
+            self.range >>= 1
+            if (value >> i) & 1:
+                self.low += self.range
+            self._normalize()
+
+    def flush(self):
+        for _ in range(5):
+            self._shift_low()
+        return self.out
+
+
+class RangeDecoder(object):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 5
+        self.range = 0xFFFFFFFF
+        self.code = struct.unpack_from('>I', data, 1)[0]
+        self.probs = [PROB_INIT] * NUM_PROBS
+
+    def _normalize(self):
+        if self.range < RANGE_TOP:
+            self.range = (self.range << 8) & 0xFFFFFFFF
+            byte = self.data[self.pos] if self.pos < len(self.data) else 0
+            self.code = ((self.code << 8) | byte) & 0xFFFFFFFF
+            self.pos += 1
+
+    def bit(self, prob):
+        p = self.probs[prob]
+        bound = (self.range >> PROB_BITS) * p
+        if self.code < bound:
+            self.range = bound
+            self.probs[prob] = p + (((1 << PROB_BITS) - p) >> PROB_MOVE_BITS)
+            bit = 0
+        else:
+            self.range -= bound
+            self.code -= bound
+            self.probs[prob] = p - (p >> PROB_MOVE_BITS)
+            bit = 1
+        self._normalize()
+        return bit
+
+    def tree(self, probs, num_bits):
+        node = 1
+        for _ in range(num_bits):
+            node = (node << 1) | self.bit(probs + node)
+        return node - (1 << num_bits)
+
+    def direct(self, num_bits):
+        value = 0
+        for _ in range(num_bits):
+            self.range >>= 1
+            value <<= 1
+            if self.code >= self.range:
+                self.code -= self.range
+                value |= 1
+            self._normalize()
+        return value
+
+
+def match_len(data, src, n):
+    length = 0
+    while (n + length < len(data) and length < MAX_MATCH and
+           data[src + length] == data[n + length]):
+        length += 1
+    return length
+
+
+def compress(data):
+    enc = RangeEncoder()
+    index = {}
+    prev_match = 0
+    rep = 0
+    n = 0
+
+    while n < len(data):
+        best_dist, best_len = 0, 0
+        for src in reversed(index.get(data[n:n + MIN_NEW_MATCH], [])[-MAX_CANDIDATES:]):
+            if n - src > WINDOW_SIZE:
+                break
+            length = match_len(data, src, n)
+            if length > best_len:
+                best_dist, best_len = n - src, length
+
+        rep_len = match_len(data, n - rep, n) if 0 < rep <= min(n, WINDOW_SIZE) else 0
+
+        if rep_len >= MIN_MATCH and rep_len + 1 >= best_len:
+            enc.bit(PROB_IS_MATCH + prev_match, 1)
+            enc.bit(PROB_IS_REP + prev_match, 1)
+            enc.tree(PROB_LEN, LEN_BITS, rep_len - MIN_MATCH)
+            length = rep_len
+            prev_match = 1
+        elif best_len >= MIN_NEW_MATCH:
+            dist_bits = best_dist.bit_length()
+            enc.bit(PROB_IS_MATCH + prev_match, 1)
+            enc.bit(PROB_IS_REP + prev_match, 0)
+            enc.tree(PROB_LEN, LEN_BITS, best_len - MIN_MATCH)
+            enc.tree(PROB_DIST_SLOT, DIST_SLOT_BITS, dist_bits)
+            enc.direct(dist_bits - 1, best_dist - (1 << (dist_bits - 1)))
+            rep = best_dist
+            length = best_len
+            prev_match = 1
+        else:
+            enc.bit(PROB_IS_MATCH + prev_match, 0)
+            enc.tree(PROB_LITERAL, 8, data[n])
+            length = 1
+            prev_match = 0
+
+        for i in range(n, n + length):
+            index.setdefault(data[i:i + MIN_NEW_MATCH], []).append(i)
+        n += length
+
+    return enc.flush()
+
+
+def decompress(img):
+    """Reference decompressor, used to check the compressed image"""
+    out = bytearray()
+    out_len = image_len(img[16:32])
+    dec = RangeDecoder(img[36:image_len(img)])
+    prev_match = 0
+    rep = 0
+    while len(out) < out_len:
+        if not dec.bit(PROB_IS_MATCH + prev_match):
+            out.append(dec.tree(PROB_LITERAL, 8))
+            prev_match = 0
+            continue
+        is_rep = dec.bit(PROB_IS_REP + prev_match)
+        length = dec.tree(PROB_LEN, LEN_BITS) + MIN_MATCH
+        if not is_rep:
+            dist_bits = dec.tree(PROB_DIST_SLOT, DIST_SLOT_BITS)
+            rep = (1 << (dist_bits - 1)) | dec.direct(dist_bits - 1)
+        if rep == 0 or rep > min(len(out), WINDOW_SIZE):
+            raise ValueError('bad distance %d' % rep)
+        for _ in range(length):
+            out.append(out[-rep])
+        prev_match = 1
+    return bytes(out)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+
+    img = open(sys.argv[1], 'rb').read()
+    img = img[:image_len(img)]
+
+    body = bytearray(img[:16])
+    body += struct.pack('<I', MAGIC)
+    body += compress(img)
+
+    # Compressed image header, taking version, uid and address from the image
+    comp = bytearray(img[:16])
+    comp[0:4] = b'\xff\xff\xff\xff'
+    comp[14] = IMG_TYPE_COMPRESSED
+    comp[15] = 0xFF
+    comp += body
+    comp += b'\xff' * (-len(comp) % 4)
+    struct.pack_into('<H', comp, 6, len(comp) // 4)
+    struct.pack_into('<H', comp, 0, crc16(comp[4:]))
+
+    if decompress(comp) != img:
+        sys.exit('compression check failed')
+
+    open(sys.argv[2], 'wb').write(comp)
+    print('%d bytes -> %d bytes (%d%%)' % (len(img), len(comp), 100 * len(comp) // len(img)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,113 @@
+/*
+ * Host round trip test of the compressed image transfer.
+ *
+ * Feeds a compressed image made by oad_compress.py to the same decompressor
+ * as the target, in pieces of the given size as blocks would arrive over the
+ * air, and checks the decompressed blocks against the original image.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -DOAD_BLOCK_SIZE=64 \
+ *       -I common \
+ *       tools/oad_compress/oad_compress_test.c \
+ *       common/oad/native_oad/oad_compress.c \
+ *       -o oad_compress_test
+ *
+ * Usage: oad_compress_test image.bin compressed.bin [pieceSize]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oad/native_oad/oad_compress.h"
+
+#define TEST_MAX_IMAGE      (256 * 1024)
+
+static uint8_t image[TEST_MAX_IMAGE];
+static uint8_t compressed[TEST_MAX_IMAGE + OAD_BLOCK_SIZE];
+static uint8_t output[TEST_MAX_IMAGE + OAD_BLOCK_SIZE];
+static uint32_t outputLen = 0;
+
+static OADCompress_Decompressor_t decomp;
+
+static bool outputWrite(uint16_t blockNum, uint8_t *pBlock)
+{
+    if((uint32_t)(blockNum + 1) * OAD_BLOCK_SIZE > sizeof(output))
+    {
+        return false;
+    }
+
+    memcpy(&output[blockNum * OAD_BLOCK_SIZE], pBlock, OAD_BLOCK_SIZE);
+    outputLen = (uint32_t)(blockNum + 1) * OAD_BLOCK_SIZE;
+    return true;
+}
+
+static long readFile(const char *name, uint8_t *pBuf, long maxLen)
+{
+    FILE *f = fopen(name, "rb");
+    long len;
+
+    if(f == NULL)
+    {
+        return -1;
+    }
+
+    len = (long)fread(pBuf, 1, maxLen, f);
+    fclose(f);
+    return len;
+}
+
+int main(int argc, char *argv[])
+{
+    long imageLen;
+    long compLen;
+    uint32_t pieceSize;
+    uint32_t offset;
+    OADCompress_Status_t status = OADCompress_Status_InProgress;
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "Usage: %s image.bin compressed.bin [pieceSize]\n", argv[0]);
+        return 2;
+    }
+
+    imageLen = readFile(argv[1], image, TEST_MAX_IMAGE);
+    compLen = readFile(argv[2], compressed, TEST_MAX_IMAGE);
+    pieceSize = (argc > 3) ? atoi(argv[3]) : OAD_BLOCK_SIZE;
+
+    if((imageLen <= 0) || (compLen <= 0) || (pieceSize == 0))
+    {
+        fprintf(stderr, "cannot read images\n");
+        return 2;
+    }
+
+    /* the last block is padded over the air */
+    memset(&compressed[compLen], 0xFF, sizeof(compressed) - compLen);
+    compLen = ((compLen + OAD_BLOCK_SIZE - 1) / OAD_BLOCK_SIZE) * OAD_BLOCK_SIZE;
+
+    OADCompress_decompressorInit(&decomp, outputWrite);
+
+    for(offset = 0; (offset < (uint32_t)compLen) && (status == OADCompress_Status_InProgress); offset += pieceSize)
+    {
+        uint32_t len = ((uint32_t)compLen - offset < pieceSize) ? (uint32_t)compLen - offset : pieceSize;
+
+        status = OADCompress_decompressorPush(&decomp, &compressed[offset], (uint16_t)len);
+    }
+
+    printf("%ld bytes compressed to %ld, decompressor state %u bytes\n",
+           imageLen, compLen, (unsigned int)sizeof(decomp));
+
+    if(status != OADCompress_Status_Complete)
+    {
+        printf("FAIL: status %d after %u bytes\n", status, offset);
+        return 1;
+    }
+
+    if((outputLen < (uint32_t)imageLen) || (memcmp(output, image, imageLen) != 0))
+    {
+        printf("FAIL: image mismatch\n");
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,164 @@
+#!/usr/bin/env python
+"""
+Create a delta patch between two node OAD images.
+
+The patch rebuilds new.bin on a node running old.bin (see oad_delta.h for the
+format). It is itself an OAD image of type EFL_OAD_IMG_TYPE_DELTA, so it is
+loaded into the concentrator external flash with oad_write_bin.py like a full
+image.
+
+Usage: python oad_delta.py old.bin new.bin patch.bin
+"""
+import struct
+import sys
+
+IMG_TYPE_DELTA = 6
+
+OP_LITERAL_MAX = 0x7F
+OP_COPY = 0x80
+OP_COPY_NEXT = 0x81
+OP_END = 0xFF
+
+MIN_MATCH = 8
+MAX_CANDIDATES = 64
+MAX_COPY = 0xFFFF
+
+
+def crc16(data):
+    """CRC over an image as calculated by crcCalcDL in oad_storage.c"""
+    crc = 0
+    for byte in bytearray(data) + bytearray(2):
+        for _ in range(8):
+            msb = crc & 0x8000
+            crc = (crc << 1) & 0xFFFF
+            if byte & 0x80:
+                crc |= 1
+            if msb:
+                crc ^= 0x1021
+            byte = (byte << 1) & 0xFF
+    return crc
+
+
+def image_len(img):
+    """Image length in bytes from the header"""
+    return struct.unpack_from('<H', img, 6)[0] * 4
+
+
+def match_len(old, o, new, n):
+    length = 0
+    while (o + length < len(old) and n + length < len(new) and
+           old[o + length] == new[n + length] and length < MAX_COPY):
+        length += 1
+    return length
+
+
+def diff(old, new):
+    index = {}
+    for o in range(len(old) - MIN_MATCH + 1):
+        index.setdefault(old[o:o + MIN_MATCH], []).append(o)
+
+    ops = bytearray()
+    literal = bytearray()
+    next_copy = None
+    n = 0
+
+    def flush_literal():
+        for i in range(0, len(literal), OP_LITERAL_MAX + 1):
+            chunk = literal[i:i + OP_LITERAL_MAX + 1]
+            ops.append(len(chunk) - 1)
+            ops.extend(chunk)
+        del literal[:]
+
+    while n < len(new):
+        best_off, best_len = None, 0
+
+        # Prefer continuing where the last copy ended
+        if next_copy is not None:
+            length = match_len(old, next_copy, new, n)
+            if length >= 3:
+                best_off, best_len = next_copy, length
+
+        for o in index.get(new[n:n + MIN_MATCH], [])[:MAX_CANDIDATES]:
+            length = match_len(old, o, new, n)
+            if length > best_len + 3:
+                best_off, best_len = o, length
+
+        if best_len >= MIN_MATCH or (best_off == next_copy and best_len >= 3):
+            flush_literal()
+            if best_off == next_copy:
+                ops.extend(struct.pack('<BH', OP_COPY_NEXT, best_len))
+            else:
+                ops.extend(struct.pack('<BHBH', OP_COPY, best_off & 0xFFFF,
+                                       best_off >> 16, best_len))
+            next_copy = best_off + best_len
+            n += best_len
+        else:
+            literal.append(new[n])
+            n += 1
+
+    flush_literal()
+    ops.append(OP_END)
+    return ops
+
+
+def apply(old, patch):
+    """Reference patcher, used to check the generated patch"""
+    new_len = image_len(patch[16:32])
+    out = bytearray()
+    p = 36
+    copy = 0
+    while len(out) < new_len:
+        op = patch[p]
+        p += 1
+        if op <= OP_LITERAL_MAX:
+            out += patch[p:p + op + 1]
+            p += op + 1
+        elif op in (OP_COPY, OP_COPY_NEXT):
+            if op == OP_COPY:
+                lo, hi, length = struct.unpack_from('<HBH', patch, p)
+                copy = lo | (hi << 16)
+                p += 5
+            else:
+                length = struct.unpack_from('<H', patch, p)[0]
+                p += 2
+            out += old[copy:copy + length]
+            copy += length
+        else:
+            raise ValueError('bad op 0x%02x' % op)
+    return bytes(out)
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+
+    old = open(sys.argv[1], 'rb').read()
+    new = open(sys.argv[2], 'rb').read()
+    old = old[:image_len(old)]
+    new = new[:image_len(new)]
+
+    base_ver = struct.unpack_from('<H', old, 4)[0]
+    body = bytearray(new[:16])
+    body += struct.pack('<HH', base_ver, len(old) // 4)
+    body += diff(old, new)
+
+    # Patch image header, taking version, uid and address from the new image
+    patch = bytearray(new[:16])
+    patch[0:4] = b'\xff\xff\xff\xff'
+    patch[14] = IMG_TYPE_DELTA
+    patch[15] = 0xFF
+    patch += body
+    patch += b'\xff' * (-len(patch) % 4)
+    struct.pack_into('<H', patch, 6, len(patch) // 4)
+    struct.pack_into('<H', patch, 0, crc16(patch[4:]))
+
+    if apply(old, patch) != new:
+        sys.exit('patch check failed')
+
+    open(sys.argv[3], 'wb').write(patch)
+    print('base v%04x, %d bytes -> patch %d bytes (%d%% of %d)' %
+          (base_ver, len(old), len(patch), 100 * len(patch) // len(new), len(new)))
+
+
+if __name__ == '__main__':
+    main()
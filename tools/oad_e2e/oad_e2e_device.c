@@ -0,0 +1,601 @@
+/*
+ * Device stand-in of the OAD end-to-end test, built into the library of each
+ * device: EasyLink on the simulated air, the external flash in RAM and the
+ * drivers the node and the OAD server open.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/Power.h>
+#include <ti/drivers/UART.h>
+#include <ti/display/Display.h>
+
+#include <ti/devices/DeviceFamily.h>
+#include DeviceFamily_constructPath(driverlib/flash.h)
+#include DeviceFamily_constructPath(driverlib/trng.h)
+#include DeviceFamily_constructPath(driverlib/aon_batmon.h)
+#include DeviceFamily_constructPath(driverlib/sys_ctrl.h)
+#include DeviceFamily_constructPath(driverlib/cpu.h)
+
+#include "Board.h"
+#include "easylink/EasyLink.h"
+#include "extflash/ExtFlash.h"
+
+#include "oad_e2e_sim.h"
+#include "oad_e2e_device.h"
+
+#define DEVICE_EXT_FLASH_SIZE   (512 * 1024)
+#define DEVICE_PIN_COUNT        32
+#define DEVICE_RSSI_DBM         (-60)
+
+static OadE2e_DeviceConfig deviceConfig;
+static OadE2e_Radio deviceRadio;
+
+/* EasyLink */
+static EasyLink_ReceiveCb rxCb;
+static EasyLink_RxPacket rxPacket;
+static uint32_t rxTimeoutRat = 0;
+static uint32_t frequency = 868000000;
+static int8_t rfPowerDbm = 14;
+
+static RF_TxPowerTable_Entry txPowerTable[] =
+{
+    { .power = 0,  .value = { .rawValue = 0x0041, .paType = RF_TxPowerTable_DefaultPA } },
+    { .power = 10, .value = { .rawValue = 0x0C4D, .paType = RF_TxPowerTable_DefaultPA } },
+    { .power = 12, .value = { .rawValue = 0x1C60, .paType = RF_TxPowerTable_DefaultPA } },
+    { .power = 14, .value = { .rawValue = 0xA73F, .paType = RF_TxPowerTable_DefaultPA } },
+    RF_TxPowerTable_TERMINATION_ENTRY
+};
+
+EasyLink_RfSetting EasyLink_supportedPhys[] =
+{
+    { .EasyLink_phyType = EasyLink_Phy_Custom, .RF_pTxPowerTable = txPowerTable, .RF_txPowerTableSize = 5 },
+    { .EasyLink_phyType = EasyLink_Phy_50kbps2gfsk, .RF_pTxPowerTable = txPowerTable, .RF_txPowerTableSize = 5 },
+    { .EasyLink_phyType = EasyLink_Phy_5kbpsSlLr, .RF_pTxPowerTable = txPowerTable, .RF_txPowerTableSize = 5 },
+};
+
+const uint8_t EasyLink_numSupportedPhys = sizeof(EasyLink_supportedPhys) / sizeof(EasyLink_RfSetting);
+
+/* External flash */
+static uint8_t extFlash[DEVICE_EXT_FLASH_SIZE];
+
+/* Pins, the buttons are pulled up */
+static uint8_t pinInput[DEVICE_PIN_COUNT];
+static uint8_t pinOutput[DEVICE_PIN_COUNT];
+static PIN_IntCb pinCb;
+static PIN_Handle pinCbHandle;
+
+/* Display */
+struct Display_Config {
+    int dummy;
+};
+static struct Display_Config displayConfig;
+
+static void radioRxDone(OadE2e_Radio *radio, const uint8_t *frame, uint8_t len);
+
+/******************************************************************************
+ Test interface
+ *****************************************************************************/
+
+void OadE2eDevice_init(const OadE2e_DeviceConfig *config)
+{
+    memcpy(&deviceConfig, config, sizeof(deviceConfig));
+    memset(extFlash, 0xFF, sizeof(extFlash));
+    memset(pinInput, 1, sizeof(pinInput));
+
+    deviceRadio.name = deviceConfig.name;
+    deviceRadio.lossPct = deviceConfig.lossPct;
+    deviceRadio.rxDone = radioRxDone;
+    OadE2e_airRegister(&deviceRadio);
+}
+
+const OadE2e_DeviceConfig* OadE2eDevice_config(void)
+{
+    return &deviceConfig;
+}
+
+uint8_t* OadE2eDevice_extFlash(void)
+{
+    return extFlash;
+}
+
+void OadE2eDevice_pressButtons(bool button0, bool button1)
+{
+    PIN_Id pinId = button0 ? Board_PIN_BUTTON0 : Board_PIN_BUTTON1;
+
+    pinInput[Board_PIN_BUTTON0] = !button0;
+    pinInput[Board_PIN_BUTTON1] = !button1;
+
+    if(pinCb != NULL)
+    {
+        pinCb(pinCbHandle, pinId);
+    }
+
+    pinInput[Board_PIN_BUTTON0] = 1;
+    pinInput[Board_PIN_BUTTON1] = 1;
+}
+
+/******************************************************************************
+ EasyLink
+ *****************************************************************************/
+
+void EasyLink_Params_init(EasyLink_Params *params)
+{
+    memset(params, 0, sizeof(EasyLink_Params));
+    params->ui32ModType = EasyLink_Phy_50kbps2gfsk;
+}
+
+EasyLink_Status EasyLink_init(EasyLink_Params *params)
+{
+    (void)params;
+
+    OadE2e_airAbort(&deviceRadio);
+    deviceRadio.numAddrFilter = 0;
+    rfPowerDbm = 14;
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_getAbsTime(uint32_t *pui32AbsTime)
+{
+    *pui32AbsTime = (uint32_t)EasyLink_us_To_RadioTime(OadE2e_nowUs());
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_getRssi(int8_t *pi8Rssi)
+{
+    *pi8Rssi = DEVICE_RSSI_DBM;
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_transmit(EasyLink_TxPacket *txPacket)
+{
+    uint8_t frame[OADE2E_MAX_FRAME_LEN];
+    uint64_t startUs = 0;
+    uint32_t now;
+    int32_t delay;
+
+    if(deviceRadio.rxOn || deviceRadio.txOn)
+    {
+        return EasyLink_Status_Busy_Error;
+    }
+
+    if(txPacket->len > EASYLINK_MAX_DATA_LENGTH)
+    {
+        return EasyLink_Status_Param_Error;
+    }
+
+    /* A scheduled start in the past is sent at once */
+    if(txPacket->absTime != 0)
+    {
+        EasyLink_getAbsTime(&now);
+        delay = (int32_t)(txPacket->absTime - now);
+        if(delay > 0)
+        {
+            startUs = OadE2e_nowUs() + (uint32_t)delay / 4;
+        }
+    }
+
+    frame[0] = txPacket->dstAddr[0];
+    memcpy(&frame[1], txPacket->payload, txPacket->len);
+    OadE2e_airTransmit(&deviceRadio, frame, txPacket->len + 1, startUs);
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_receiveAsync(EasyLink_ReceiveCb cb, uint32_t absTime)
+{
+    (void)absTime;
+
+    if(deviceRadio.rxOn || deviceRadio.txOn)
+    {
+        return EasyLink_Status_Busy_Error;
+    }
+
+    rxCb = cb;
+    OadE2e_airReceive(&deviceRadio, rxTimeoutRat / 4);
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_abort(void)
+{
+    bool wasOn = deviceRadio.rxOn;
+
+    OadE2e_airAbort(&deviceRadio);
+    if(wasOn && (rxCb != NULL))
+    {
+        memset(&rxPacket, 0, sizeof(rxPacket));
+        rxCb(&rxPacket, EasyLink_Status_Aborted);
+    }
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_enableRxAddrFilter(uint8_t* pui8AddrFilterTable, uint8_t ui8AddrSize, uint8_t ui8NumAddrs)
+{
+    uint8_t i;
+
+    if((ui8AddrSize != 1) || (ui8NumAddrs > OADE2E_MAX_ADDR_FILTER))
+    {
+        return EasyLink_Status_Param_Error;
+    }
+
+    for(i = 0; (pui8AddrFilterTable != NULL) && (i < ui8NumAddrs); i++)
+    {
+        deviceRadio.addrFilter[i] = pui8AddrFilterTable[i];
+    }
+    deviceRadio.numAddrFilter = (pui8AddrFilterTable != NULL) ? ui8NumAddrs : 0;
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_setFrequency(uint32_t ui32Frequency)
+{
+    frequency = ui32Frequency;
+
+    return EasyLink_Status_Success;
+}
+
+uint32_t EasyLink_getFrequency(void)
+{
+    return frequency;
+}
+
+EasyLink_Status EasyLink_setRfPower(int8_t i8TxPowerDbm)
+{
+    rfPowerDbm = i8TxPowerDbm;
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_getRfPower(int8_t *pi8TxPowerDbm)
+{
+    *pi8TxPowerDbm = rfPowerDbm;
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_setCtrl(EasyLink_CtrlOption Ctrl, uint32_t ui32Value)
+{
+    if(Ctrl == EasyLink_Ctrl_AsyncRx_TimeOut)
+    {
+        rxTimeoutRat = ui32Value;
+    }
+
+    return EasyLink_Status_Success;
+}
+
+EasyLink_Status EasyLink_getCtrl(EasyLink_CtrlOption Ctrl, uint32_t* pui32Value)
+{
+    *pui32Value = (Ctrl == EasyLink_Ctrl_AsyncRx_TimeOut) ? rxTimeoutRat : 0;
+
+    return EasyLink_Status_Success;
+}
+
+/* From the air, in interrupt context */
+static void radioRxDone(OadE2e_Radio *radio, const uint8_t *frame, uint8_t len)
+{
+    memset(&rxPacket, 0, sizeof(rxPacket));
+
+    if(frame == NULL)
+    {
+        if(rxCb != NULL)
+        {
+            rxCb(&rxPacket, EasyLink_Status_Rx_Timeout);
+        }
+        return;
+    }
+
+    rxPacket.dstAddr[0] = frame[0];
+    rxPacket.rssi = DEVICE_RSSI_DBM;
+    rxPacket.absTime = (uint32_t)EasyLink_us_To_RadioTime(radio->rxSyncUs);
+    rxPacket.len = len - 1;
+    memcpy(rxPacket.payload, &frame[1], len - 1);
+
+    if(rxCb != NULL)
+    {
+        rxCb(&rxPacket, EasyLink_Status_Success);
+    }
+}
+
+/******************************************************************************
+ External flash
+ *****************************************************************************/
+
+bool ExtFlash_open(void)
+{
+    return true;
+}
+
+bool ExtFlash_close(void)
+{
+    return true;
+}
+
+bool ExtFlash_read(size_t offset, size_t length, uint8_t *buf)
+{
+    if((offset > DEVICE_EXT_FLASH_SIZE) || (length > DEVICE_EXT_FLASH_SIZE - offset))
+    {
+        return false;
+    }
+
+    memcpy(buf, &extFlash[offset], length);
+
+    return true;
+}
+
+bool ExtFlash_erase(size_t offset, size_t length)
+{
+    size_t start = offset & ~(size_t)(EXT_FLASH_PAGE_SIZE - 1);
+    size_t end = (offset + length + EXT_FLASH_PAGE_SIZE - 1) & ~(size_t)(EXT_FLASH_PAGE_SIZE - 1);
+
+    if(end > DEVICE_EXT_FLASH_SIZE)
+    {
+        return false;
+    }
+
+    memset(&extFlash[start], 0xFF, end - start);
+
+    return true;
+}
+
+/* Programming only clears bits, as the flash does */
+bool ExtFlash_write(size_t offset, size_t length, const uint8_t *buf)
+{
+    size_t i;
+
+    if((offset > DEVICE_EXT_FLASH_SIZE) || (length > DEVICE_EXT_FLASH_SIZE - offset))
+    {
+        return false;
+    }
+
+    for(i = 0; i < length; i++)
+    {
+        extFlash[offset + i] &= buf[i];
+    }
+
+    return true;
+}
+
+uint32_t FlashSectorSizeGet(void)
+{
+    return 4096;
+}
+
+/******************************************************************************
+ Drivers
+ *****************************************************************************/
+
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config pinList[])
+{
+    uint8_t i;
+
+    for(i = 0; PIN_ID(pinList[i]) != PIN_TERMINATE; i++)
+    {
+        if(PIN_ID(pinList[i]) < DEVICE_PIN_COUNT)
+        {
+            pinOutput[PIN_ID(pinList[i])] = (pinList[i] & PIN_GPIO_HIGH) ? 1 : 0;
+        }
+    }
+
+    return state;
+}
+
+void PIN_close(PIN_Handle handle)
+{
+    (void)handle;
+}
+
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t val)
+{
+    (void)handle;
+
+    if(pinId < DEVICE_PIN_COUNT)
+    {
+        pinOutput[pinId] = val ? 1 : 0;
+    }
+
+    return 0;
+}
+
+uint32_t PIN_getOutputValue(PIN_Id pinId)
+{
+    return (pinId < DEVICE_PIN_COUNT) ? pinOutput[pinId] : 0;
+}
+
+uint32_t PIN_getInputValue(PIN_Id pinId)
+{
+    return (pinId < DEVICE_PIN_COUNT) ? pinInput[pinId] : 1;
+}
+
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callback)
+{
+    pinCbHandle = handle;
+    pinCb = callback;
+
+    return 0;
+}
+
+int Power_setDependency(unsigned int resourceId)
+{
+    (void)resourceId;
+
+    return 0;
+}
+
+int Power_releaseDependency(unsigned int resourceId)
+{
+    (void)resourceId;
+
+    return 0;
+}
+
+void TRNGEnable(void)
+{
+}
+
+void TRNGDisable(void)
+{
+}
+
+uint32_t TRNGStatusGet(void)
+{
+    return TRNG_NUMBER_READY;
+}
+
+uint32_t TRNGNumberGet(uint32_t word)
+{
+    (void)word;
+
+    return deviceConfig.address;
+}
+
+void AONBatMonEnable(void)
+{
+}
+
+uint32_t AONBatMonBatteryVoltageGet(void)
+{
+    /* 3.0 V in the 3.8 fixed point format */
+    return 3 << 8;
+}
+
+int32_t AONBatMonTemperatureGetDegC(void)
+{
+    return 25;
+}
+
+void SysCtrlSystemReset(void)
+{
+    OadE2e_log(deviceConfig.name, "system reset");
+}
+
+void CPUdelay(uint32_t count)
+{
+    (void)count;
+}
+
+void UART_Params_init(UART_Params *params)
+{
+    memset(params, 0, sizeof(UART_Params));
+}
+
+UART_Handle UART_open(unsigned int index, UART_Params *params)
+{
+    (void)index;
+    (void)params;
+
+    return NULL;
+}
+
+void UART_close(UART_Handle handle)
+{
+    (void)handle;
+}
+
+int UART_read(UART_Handle handle, void *buffer, size_t size)
+{
+    (void)handle;
+
+    memset(buffer, 0xFF, size);
+
+    return 0;
+}
+
+int UART_write(UART_Handle handle, const void *buffer, size_t size)
+{
+    (void)handle;
+    (void)buffer;
+    (void)size;
+
+    return 0;
+}
+
+void UART_readCancel(UART_Handle handle)
+{
+    (void)handle;
+}
+
+void Display_init(void)
+{
+}
+
+void Display_Params_init(Display_Params *params)
+{
+    params->lineClearMode = DISPLAY_CLEAR_NONE;
+}
+
+Display_Handle Display_open(uint32_t id, Display_Params *params)
+{
+    (void)id;
+    (void)params;
+
+    return &displayConfig;
+}
+
+void Display_close(Display_Handle handle)
+{
+    (void)handle;
+}
+
+void Display_clear(Display_Handle handle)
+{
+    (void)handle;
+}
+
+int Display_control(Display_Handle handle, unsigned int cmd, void *arg)
+{
+    (void)handle;
+    (void)cmd;
+    (void)arg;
+
+    return 0;
+}
+
+void Display_printf(Display_Handle handle, uint8_t line, uint8_t column, const char *fmt, ...)
+{
+    char text[256];
+    va_list va;
+
+    (void)handle;
+    (void)line;
+    (void)column;
+
+    if(!deviceConfig.verbose)
+    {
+        return;
+    }
+
+    va_start(va, fmt);
+    vsnprintf(text, sizeof(text), fmt, va);
+    va_end(va);
+
+    OadE2e_log(deviceConfig.name, "%s", text);
+}
+
+void System_abort(const char *str)
+{
+    OadE2e_log(deviceConfig.name, "System_abort: %s", str);
+    exit(2);
+}
+
+int System_sprintf(char *buf, const char *fmt, ...)
+{
+    va_list va;
+    int len;
+
+    va_start(va, fmt);
+    len = vsprintf(buf, fmt, va);
+    va_end(va);
+
+    return len;
+}
@@ -0,0 +1,32 @@
+/*
+ * Device stand-in of the OAD end-to-end test, see oad_e2e_device.c.
+ */
+#ifndef OADE2E_DEVICE_H
+#define OADE2E_DEVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "oad_e2e_sim.h"
+
+/*!
+ Put the radio of the device on the air and erase its external flash.
+ */
+extern void OadE2eDevice_init(const OadE2e_DeviceConfig *config);
+
+/*!
+ Configuration the device was started with.
+ */
+extern const OadE2e_DeviceConfig* OadE2eDevice_config(void);
+
+/*!
+ Contents of the external flash.
+ */
+extern uint8_t* OadE2eDevice_extFlash(void);
+
+/*!
+ Press the buttons held down together and release them.
+ */
+extern void OadE2eDevice_pressButtons(bool button0, bool button1);
+
+#endif /* OADE2E_DEVICE_H */
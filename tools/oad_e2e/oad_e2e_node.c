@@ -0,0 +1,130 @@
+/*
+ * Node of the OAD end-to-end test: the node radio task and the OAD client of
+ * rfWsnNode, with a stand-in of the node task sending data packets.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/drivers/PIN.h>
+#include <ti/display/Display.h>
+
+#include "NodeTask.h"
+#include "NodeRadioTask.h"
+#include "battery.h"
+#include "trace.h"
+#include "oad/native_oad/oad_client.h"
+#include "oad/native_oad/oad_image_header.h"
+
+#include "oad_e2e_sim.h"
+#include "oad_e2e_device.h"
+
+#define NODE_TASK_PRIORITY      1
+#define NODE_DATA_PERIOD_MS     500
+#define NODE_DATA_LENGTH        10
+#define NODE_DATA_OFFSET_MS     37      ///< Per address, nodes do not send in step
+
+Display_Handle hDisplaySerial;
+PIN_Handle ledPinHandle;
+
+static Task_Struct nodeTask;
+static bool imageInstalled = false;
+static uint16_t resumeBlock = 0;
+
+static void nodeTaskFunction(UArg arg0, UArg arg1)
+{
+    uint8_t data[NODE_DATA_LENGTH];
+    uint8_t sequence = 0;
+
+    Task_sleep((OadE2eDevice_config()->address % 10) * NODE_DATA_OFFSET_MS * 1000 / Clock_tickPeriod);
+
+    while(1)
+    {
+        Task_sleep(NODE_DATA_PERIOD_MS * 1000 / Clock_tickPeriod);
+
+        memset(data, sequence++, sizeof(data));
+        NodeRadioTask_sendRawData(data, sizeof(data));
+    }
+}
+
+void OadE2eNode_start(const OadE2e_DeviceConfig *config)
+{
+    Task_Params taskParams;
+    Display_Params params;
+
+    OadE2eDevice_init(config);
+
+    Display_Params_init(&params);
+    hDisplaySerial = Display_open(Display_Type_UART, &params);
+
+    NodeRadioTask_init();
+    OADClient_init();
+
+    Task_Params_init(&taskParams);
+    taskParams.priority = NODE_TASK_PRIORITY;
+    Task_construct(&nodeTask, nodeTaskFunction, &taskParams, NULL);
+}
+
+bool OadE2eNode_imageInstalled(void)
+{
+    return imageInstalled;
+}
+
+/* First block of the last download the OAD client started, from its display output */
+uint16_t OadE2eNode_resumeBlock(void)
+{
+    return resumeBlock;
+}
+
+/******************************************************************************
+ Node task
+ *****************************************************************************/
+
+void NodeTask_installImage(void)
+{
+    /* The node would reset into the BIM here */
+    imageInstalled = true;
+    OadE2e_log(OadE2eDevice_config()->name, "install image");
+}
+
+/* The running image, erased flash past its end */
+void OADImageHeader_readImage(uint32_t offset, uint8_t *pBuf, uint16_t len)
+{
+    const OadE2e_DeviceConfig *config = OadE2eDevice_config();
+    uint16_t idx;
+
+    for(idx = 0; idx < len; idx++)
+    {
+        pBuf[idx] = (offset + idx < config->runningImageLen) ? config->runningImage[offset + idx] : 0xFF;
+    }
+}
+
+uint32_t NodeTask_getNetworkTime(void)
+{
+    return Clock_getTicks() * Clock_tickPeriod / 1000;
+}
+
+uint16_t Battery_getVoltageMv(void)
+{
+    return 3000;
+}
+
+void Trace_printf(Display_Handle handle, char *fmt, ...)
+{
+    char text[256];
+    va_list va;
+
+    (void)handle;
+
+    va_start(va, fmt);
+    vsnprintf(text, sizeof(text), fmt, va);
+    va_end(va);
+
+    sscanf(text, "OAD Block: %hu of", &resumeBlock);
+
+    OadE2e_log(OadE2eDevice_config()->name, "%s", text);
+}
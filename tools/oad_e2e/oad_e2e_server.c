@@ -0,0 +1,69 @@
+/*
+ * OAD server of the OAD end-to-end test: the concentrator task, the radio
+ * task and the OAD server of rfWsnConcentratorOadServer. The node image is
+ * stored as the remote app image, as the UART upload would store it.
+ */
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+
+#include "ConcentratorRadioTask.h"
+#include "ConcentratorTask.h"
+#include "oad/native_oad/oad_storage.h"
+
+#include "oad_e2e_sim.h"
+#include "oad_e2e_device.h"
+
+#define SERVER_IMG_HDR_LEN      16
+
+/* Store an image as the UART upload would, in the region of its image type */
+static void storeImage(const uint8_t *image, uint32_t imageLen)
+{
+    uint8_t imgHdr[SERVER_IMG_HDR_LEN];
+    uint8_t block[OAD_BLOCK_SIZE];
+    uint16_t numBlocks;
+    uint16_t blockNum;
+    uint32_t offset;
+
+    memcpy(imgHdr, image, SERVER_IMG_HDR_LEN);
+
+    numBlocks = OADStorage_imgIdentifyWrite(imgHdr);
+    if(numBlocks == 0)
+    {
+        System_abort("Image rejected");
+    }
+
+    for(blockNum = 0; blockNum < numBlocks; blockNum++)
+    {
+        offset = (uint32_t)blockNum * OAD_BLOCK_SIZE;
+        memset(block, 0xFF, sizeof(block));
+        memcpy(block, &image[offset],
+               (imageLen - offset < OAD_BLOCK_SIZE) ? (imageLen - offset) : OAD_BLOCK_SIZE);
+        OADStorage_imgBlockWrite(blockNum, block);
+    }
+
+    if(OADStorage_imgFinalise() != OADStorage_Status_Success)
+    {
+        System_abort("Image CRC error");
+    }
+}
+
+void OadE2eServer_start(const OadE2e_DeviceConfig *config)
+{
+    OadE2eDevice_init(config);
+
+    OADStorage_init();
+    storeImage(config->image, config->imageLen);
+    if(config->patch != NULL)
+    {
+        storeImage(config->patch, config->patchLen);
+    }
+    if(config->compressed != NULL)
+    {
+        storeImage(config->compressed, config->compressedLen);
+    }
+
+    ConcentratorRadioTask_init();
+    ConcentratorTask_init();
+}
@@ -0,0 +1,94 @@
+/*
+ * Simulated air and log of the OAD end-to-end test.
+ *
+ * The test program runs the tasks and clocks of both devices and carries the
+ * frames between their radios. Each device library reaches it through these
+ * functions, the EasyLink stand-in of oad_e2e_device.c being the only user of
+ * the air.
+ */
+#ifndef OADE2E_SIM_H
+#define OADE2E_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OADE2E_MAX_FRAME_LEN        130     ///< Address byte and EasyLink payload
+#define OADE2E_MAX_ADDR_FILTER      4
+
+/*!
+ Radio of a device on the simulated air.
+ */
+typedef struct OadE2e_Radio {
+    const char *name;
+    uint8_t lossPct;                        ///< Frames this radio misses, in %
+    uint8_t addrFilter[OADE2E_MAX_ADDR_FILTER];
+    uint8_t numAddrFilter;                  ///< 0 receives every address
+    /*! Called at the end of a frame received, or with frame NULL at the RX timeout */
+    void (*rxDone)(struct OadE2e_Radio *radio, const uint8_t *frame, uint8_t len);
+
+    /* State of the air, kept by the test */
+    bool rxOn;
+    bool rxSync;                            ///< A frame started while in RX
+    uint64_t rxStartUs;
+    uint64_t rxSyncUs;                      ///< Sync word of the last frame received
+    uint64_t rxTimeoutUs;                   ///< 0 for no timeout
+    int rxTimer;
+    bool txOn;
+} OadE2e_Radio;
+
+/*!
+ Configuration a device library is started with.
+ */
+typedef struct {
+    const char *name;
+    uint8_t address;                        ///< Node address, drawn by its TRNG
+    uint8_t lossPct;
+    bool verbose;                           ///< Log the display output
+    const uint8_t *image;                   ///< Image the OAD server offers
+    uint32_t imageLen;
+    const uint8_t *patch;                   ///< Delta patch the OAD server holds, NULL for none
+    uint32_t patchLen;
+    const uint8_t *compressed;              ///< Compressed image the OAD server holds, NULL for none
+    uint32_t compressedLen;
+    const uint8_t *runningImage;            ///< Image the node runs, the base of a patch
+    uint32_t runningImageLen;
+} OadE2e_DeviceConfig;
+
+/*!
+ Start function each device library exports, it creates the tasks.
+ */
+typedef void (*OadE2e_StartFxn)(const OadE2e_DeviceConfig *config);
+
+/*!
+ Simulated time in us.
+ */
+extern uint64_t OadE2e_nowUs(void);
+
+/*!
+ Put a radio on the air.
+ */
+extern void OadE2e_airRegister(OadE2e_Radio *radio);
+
+/*!
+ Transmit a frame, its first byte the destination address. The frame starts
+ at startUs, or after the TX turnaround when that has passed. Blocks the
+ calling task until the frame is sent.
+ */
+extern void OadE2e_airTransmit(OadE2e_Radio *radio, const uint8_t *frame, uint8_t len, uint64_t startUs);
+
+/*!
+ Start a single receive, ended by a frame or after timeoutUs, 0 for none.
+ */
+extern void OadE2e_airReceive(OadE2e_Radio *radio, uint64_t timeoutUs);
+
+/*!
+ Stop a receive without a callback.
+ */
+extern void OadE2e_airAbort(OadE2e_Radio *radio);
+
+/*!
+ Log a line with the simulated time and the name of the device.
+ */
+extern void OadE2e_log(const char *name, const char *fmt, ...);
+
+#endif /* OADE2E_SIM_H */
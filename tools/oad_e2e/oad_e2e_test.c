@@ -0,0 +1,1705 @@
+/*
+ * End-to-end test of a node image download from the OAD server.
+ *
+ * The concentrator of rfWsnConcentratorOadServer and the node of rfWsnNode
+ * run their own radio, OAD server and OAD client code, each built into a
+ * library with the stand-ins of oad_e2e_device.c. This program runs the
+ * tasks and clocks of both on simulated time, one task at a time by
+ * priority as TI-RTOS does, and carries the frames between the two radios at
+ * the 50 kbps airtime, with collisions and a random frame loss.
+ *
+ * The server is loaded with a random node image. Once the node is known to
+ * the concentrator, the test presses the buttons of the "Update node FW"
+ * action. The test passes when the node has checked the image, written its
+ * image information for the BIM and asked to install it, with the image in
+ * its external flash as sent, and when it got the blocks in push mode, with
+ * push acks and no block request.
+ *
+ * With -d the node runs an image of the FW version it reports, and the new
+ * image differs from it in TEST_DELTA_CHANGES places. The server holds a
+ * delta patch between the two, and the test asks the node for its FW
+ * version before the update. The test passes when the node has rebuilt the
+ * new image from the patch, with fewer blocks sent than the image has.
+ *
+ * With -z the image repeats pieces of itself and the server also holds it
+ * compressed. The test passes when the node has decompressed the image, with
+ * fewer blocks sent than the image has. With -Z the compressed stream is
+ * broken instead, and the test passes when the node rejected it and was sent
+ * the uncompressed image.
+ *
+ * With -b the test runs TEST_BROADCAST_NODES nodes, each loaded from its own
+ * copy of oad_e2e_node.so, and presses the buttons of the "Broadcast node FW"
+ * action instead. The loss of the nodes is spread from 0 up to lossPercent.
+ * The image is TEST_BROADCAST_KBYTES unless given, the degree distribution of
+ * the fountain code is made for images of several hundred blocks.
+ * The test passes when every node has installed the image as sent, decoded
+ * from the fountain symbols of the broadcast, with every broadcast frame
+ * sent at the start of a broadcast slot and no push ack or block request.
+ *
+ * Build from the repository root:
+ *   N=rfWsnNode_CC1310_LAUNCHXL_tirtos_ccs
+ *   S=rfWsnConcentratorOadServer_CC1310_LAUNCHXL_tirtos_ccs
+ *   C=common/oad/native_oad
+ *   gcc -O1 -g -shared -fPIC -Wl,-Bsymbolic \
+ *       -DOAD_BLOCK_SIZE=64 -DOAD_READ_CACHE_SIZE=128 -DOAD_IMG_E \
+ *       -I tools/oad_e2e/stubs -I $N -I common \
+ *       tools/oad_e2e/oad_e2e_node.c tools/oad_e2e/oad_e2e_device.c \
+ *       $N/NodeRadioTask.c $N/energy.c $N/crc16.c \
+ *       $N/oad/native_oad/oad_client.c $C/oad_protocol.c $C/oad_storage.c \
+ *       $C/oad_target_external_flash.c $C/oad_fountain.c $C/oad_delta.c \
+ *       $C/oad_compress.c \
+ *       -o oad_e2e_node.so
+ *   gcc -O1 -g -shared -fPIC -Wl,-Bsymbolic -DOAD_BLOCK_SIZE=64 \
+ *       -I tools/oad_e2e/stubs -I $S -I common \
+ *       tools/oad_e2e/oad_e2e_server.c tools/oad_e2e/oad_e2e_device.c \
+ *       $S/ConcentratorRadioTask.c $S/ConcentratorTask.c \
+ *       $S/oad/native_oad/oad_server.c $C/oad_protocol.c $C/oad_storage.c \
+ *       $C/oad_target_external_flash.c $C/oad_fountain.c $C/oad_delta.c \
+ *       $C/oad_compress.c \
+ *       -o oad_e2e_server.so
+ *   gcc -O1 -g -rdynamic -I tools/oad_e2e/stubs -I common \
+ *       tools/oad_e2e/oad_e2e_test.c -ldl -o oad_e2e_test
+ *
+ * Usage: oad_e2e_test [lossPercent] [seed] [imageKBytes] [-r] [-b] [-d] [-z|-Z] [-v]
+ *
+ * The loss applies to the frames each radio receives. The node gives up the
+ * download when more than about 25% of them are lost, the test then fails.
+ *
+ * With -r the link goes down once the node has stored half of the image,
+ * until both ends have given up the download, and the update is then
+ * started again. The node must resume it from its download record, at or
+ * after the whole program pages it had stored, instead of from block 0. It
+ * applies to the push update of the full image only.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <dlfcn.h>
+#include <ucontext.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Event.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "oad/native_oad/ext_flash_layout.h"
+#include "oad/native_oad/oad_protocol.h"
+#include "oad/native_oad/oad_delta.h"
+#include "oad/native_oad/oad_compress.h"
+
+#include "oad_e2e_sim.h"
+
+#define SIM_MAX_TASKS           16
+#define SIM_MAX_TIMERS          128
+#define SIM_MAX_WAITERS         4
+#define SIM_MAX_RADIOS          (1 + TEST_BROADCAST_NODES)
+#define SIM_MAX_FRAMES          8
+#define SIM_TASK_STACK_SIZE     (256 * 1024)
+
+#define SIM_US_PER_BYTE         160     ///< 50 kbps
+#define SIM_FRAME_OVERHEAD      11      ///< Preamble, sync word, length and CRC bytes
+#define SIM_TX_TURNAROUND_US    200     ///< From an immediate TX command to the preamble
+#define SIM_SYNC_BYTES          8       ///< Preamble and sync word, the time stamp of a frame follows them
+#define SIM_MAX_FRAME_US        ((OADE2E_MAX_FRAME_LEN + SIM_FRAME_OVERHEAD) * SIM_US_PER_BYTE)
+
+#define TEST_NODE_ADDRESS       0x42
+#define TEST_CONCENTRATOR_NAME  "concentrator"
+#define TEST_NODE_NAME          "node"
+#define TEST_JOIN_TIME_US       3000000
+#define TEST_TIMEOUT_US         600000000ULL
+#define TEST_IMG_VER            0x0102
+#define TEST_BLOCK_SIZE         64      ///< OAD_BLOCK_SIZE of the device builds
+#define TEST_IMG_ADDR           (0x1000 / EFL_OAD_ADDR_RESOLUTION)
+#define TEST_CONCENTRATOR_ADDR  0x00
+#define TEST_PACKET_TYPE_OFFSET 2       ///< Address, source address, packet type
+#define TEST_PACKET_TYPE_OAD    3       ///< RADIO_PACKET_TYPE_OAD_PACKET
+#define TEST_OAD_TYPE_OFFSET    5       ///< After the options and length
+#define TEST_PAGE_BLOCKS        (256 / TEST_BLOCK_SIZE)  ///< Blocks of an OAD_FLASH_PROGRAM_SIZE page
+#define TEST_OUTAGE_US          30000000
+#define TEST_BROADCAST_NODES    3
+#define TEST_BROADCAST_ADDR     0xFF    ///< RADIO_BROADCAST_ADDRESS
+#define TEST_BROADCAST_SLOT_US  100000  ///< RADIO_BROADCAST_SLOT_MS
+#define TEST_BROADCAST_KBYTES   32
+#define TEST_BASE_IMG_VER       0x0100  ///< "rfWsnNode v1.0" the node reports
+#define TEST_DELTA_CHANGES      4
+#define TEST_DELTA_CHANGE_LEN   200
+#define TEST_DELTA_MIN_COPY     8       ///< Shortest run of unchanged bytes copied from the base
+#define TEST_REPEAT_LEN         32      ///< Piece of a compressible image repeated from before
+#define TEST_REPEAT_DIST        32      ///< Pieces back a repeated piece is taken from, at most
+#define TEST_LZ_MIN_NEW_MATCH   3       ///< Shortest match at a new distance
+#define TEST_LZ_MAX_MATCH       (OADCompress_MIN_MATCH + (1 << OADCompress_LEN_BITS) - 1)
+#define TEST_LZ_RANGE_TOP       (1UL << 24)
+
+/******************************************************************************
+ Kernel
+ *****************************************************************************/
+
+typedef enum {
+    SimTask_Ready,
+    SimTask_Blocked,
+    SimTask_Done
+} SimTaskState;
+
+typedef struct {
+    ucontext_t ctx;
+    Task_FuncPtr fxn;
+    UArg arg0;
+    UArg arg1;
+    Int priority;
+    SimTaskState state;
+    uint64_t readySeq;
+    int timer;
+    bool timedOut;
+} SimTask;
+
+typedef struct {
+    bool active;
+    uint64_t whenUs;
+    uint64_t seq;
+    void (*fxn)(void *arg);
+    void *arg;
+} SimTimer;
+
+typedef struct {
+    UInt posted;
+    SimTask *waiter[SIM_MAX_WAITERS];
+} SimEvent;
+
+typedef struct {
+    Int count;
+    Semaphore_Mode mode;
+    SimTask *waiter[SIM_MAX_WAITERS];
+} SimSemaphore;
+
+typedef struct {
+    Clock_FuncPtr fxn;
+    UArg arg;
+    UInt32 timeout;
+    UInt32 period;
+    int timer;
+} SimClock;
+
+static uint64_t nowUs = 0;
+static uint64_t seqCounter = 0;
+static SimTask *tasks[SIM_MAX_TASKS];
+static int numTasks = 0;
+static SimTask *currentTask = NULL;
+static ucontext_t schedulerCtx;
+static UInt taskDisabled = FALSE;
+static SimTimer timers[SIM_MAX_TIMERS];
+
+static int timerStart(uint64_t whenUs, void (*fxn)(void *arg), void *arg)
+{
+    int idx;
+
+    for(idx = 0; idx < SIM_MAX_TIMERS; idx++)
+    {
+        if(!timers[idx].active)
+        {
+            timers[idx].active = true;
+            timers[idx].whenUs = whenUs;
+            timers[idx].seq = ++seqCounter;
+            timers[idx].fxn = fxn;
+            timers[idx].arg = arg;
+            return idx;
+        }
+    }
+
+    fprintf(stderr, "out of timers\n");
+    exit(2);
+}
+
+static void timerStop(int idx)
+{
+    if(idx >= 0)
+    {
+        timers[idx].active = false;
+    }
+}
+
+static int timerNext(void)
+{
+    int next = -1;
+    int idx;
+
+    for(idx = 0; idx < SIM_MAX_TIMERS; idx++)
+    {
+        if(timers[idx].active &&
+           ((next < 0) || (timers[idx].whenUs < timers[next].whenUs) ||
+            ((timers[idx].whenUs == timers[next].whenUs) && (timers[idx].seq < timers[next].seq))))
+        {
+            next = idx;
+        }
+    }
+
+    return next;
+}
+
+static SimTask* readyTask(void)
+{
+    SimTask *next = NULL;
+    int idx;
+
+    for(idx = 0; idx < numTasks; idx++)
+    {
+        if((tasks[idx]->state == SimTask_Ready) &&
+           ((next == NULL) || (tasks[idx]->priority > next->priority) ||
+            ((tasks[idx]->priority == next->priority) && (tasks[idx]->readySeq < next->readySeq))))
+        {
+            next = tasks[idx];
+        }
+    }
+
+    return next;
+}
+
+static void makeReady(SimTask *task)
+{
+    if(task->state == SimTask_Blocked)
+    {
+        task->state = SimTask_Ready;
+        task->readySeq = ++seqCounter;
+        timerStop(task->timer);
+        task->timer = -1;
+    }
+}
+
+static void switchToScheduler(void)
+{
+    swapcontext(&currentTask->ctx, &schedulerCtx);
+}
+
+/* A task of higher priority made ready by the running task runs first */
+static void checkPreempt(void)
+{
+    SimTask *next;
+
+    if((currentTask == NULL) || taskDisabled)
+    {
+        return;
+    }
+
+    next = readyTask();
+    if((next != NULL) && (next->priority > currentTask->priority))
+    {
+        switchToScheduler();
+    }
+}
+
+static void blockTimeout(void *arg)
+{
+    SimTask *task = arg;
+
+    task->timer = -1;
+    task->timedOut = true;
+    makeReady(task);
+}
+
+/* Block the running task until made ready, false on the timeout */
+static bool blockCurrent(UInt32 timeoutTicks)
+{
+    SimTask *task = currentTask;
+
+    if(task == NULL)
+    {
+        fprintf(stderr, "blocking call outside of a task\n");
+        exit(2);
+    }
+
+    task->state = SimTask_Blocked;
+    task->timedOut = false;
+    if(timeoutTicks != BIOS_WAIT_FOREVER)
+    {
+        task->timer = timerStart(nowUs + (uint64_t)timeoutTicks * Clock_tickPeriod, blockTimeout, task);
+    }
+
+    switchToScheduler();
+
+    return !task->timedOut;
+}
+
+static void addWaiter(SimTask **waiter)
+{
+    int idx;
+
+    for(idx = 0; idx < SIM_MAX_WAITERS; idx++)
+    {
+        if(waiter[idx] == NULL)
+        {
+            waiter[idx] = currentTask;
+            return;
+        }
+    }
+
+    fprintf(stderr, "out of waiters\n");
+    exit(2);
+}
+
+static void removeWaiter(SimTask **waiter)
+{
+    int idx;
+
+    for(idx = 0; idx < SIM_MAX_WAITERS; idx++)
+    {
+        if(waiter[idx] == currentTask)
+        {
+            waiter[idx] = NULL;
+        }
+    }
+}
+
+static void taskEntry(void)
+{
+    SimTask *task = currentTask;
+
+    task->fxn(task->arg0, task->arg1);
+    task->state = SimTask_Done;
+    switchToScheduler();
+}
+
+/* Run the tasks and clocks until done or the time */
+static void runUntil(uint64_t endUs, bool (*done)(void))
+{
+    SimTask *task;
+    int idx;
+
+    while((done == NULL) || !done())
+    {
+        task = readyTask();
+        if(task != NULL)
+        {
+            currentTask = task;
+            swapcontext(&schedulerCtx, &task->ctx);
+            currentTask = NULL;
+            continue;
+        }
+
+        idx = timerNext();
+        if((idx < 0) || (timers[idx].whenUs > endUs))
+        {
+            nowUs = endUs;
+            return;
+        }
+
+        /* The timer callback runs as an interrupt */
+        if(timers[idx].whenUs > nowUs)
+        {
+            nowUs = timers[idx].whenUs;
+        }
+        timers[idx].active = false;
+        timers[idx].fxn(timers[idx].arg);
+    }
+}
+
+void Task_Params_init(Task_Params *params)
+{
+    memset(params, 0, sizeof(Task_Params));
+    params->priority = 1;
+}
+
+void Task_construct(Task_Struct *task, Task_FuncPtr fxn, const Task_Params *params, void *eb)
+{
+    SimTask *simTask = calloc(1, sizeof(SimTask));
+    (void)eb;
+
+    if(numTasks >= SIM_MAX_TASKS)
+    {
+        fprintf(stderr, "out of tasks\n");
+        exit(2);
+    }
+
+    /* The stacks sized for the target are too small here */
+    getcontext(&simTask->ctx);
+    simTask->ctx.uc_stack.ss_sp = malloc(SIM_TASK_STACK_SIZE);
+    simTask->ctx.uc_stack.ss_size = SIM_TASK_STACK_SIZE;
+    simTask->ctx.uc_link = NULL;
+    makecontext(&simTask->ctx, taskEntry, 0);
+
+    simTask->fxn = fxn;
+    simTask->arg0 = params->arg0;
+    simTask->arg1 = params->arg1;
+    simTask->priority = params->priority;
+    simTask->state = SimTask_Ready;
+    simTask->readySeq = ++seqCounter;
+    simTask->timer = -1;
+
+    task->opaque[0] = (UArg)simTask;
+    tasks[numTasks++] = simTask;
+}
+
+void Task_sleep(UInt32 ticks)
+{
+    blockCurrent(ticks);
+}
+
+void Task_yield(void)
+{
+    currentTask->readySeq = ++seqCounter;
+    switchToScheduler();
+}
+
+UInt Task_disable(void)
+{
+    UInt key = taskDisabled;
+
+    taskDisabled = TRUE;
+
+    return key;
+}
+
+void Task_restore(UInt key)
+{
+    taskDisabled = key;
+    checkPreempt();
+}
+
+UInt Hwi_disable(void)
+{
+    /* Interrupts only run between tasks */
+    return 0;
+}
+
+void Hwi_restore(UInt key)
+{
+    (void)key;
+}
+
+void Event_Params_init(Event_Params *params)
+{
+    memset(params, 0, sizeof(Event_Params));
+}
+
+void Event_construct(Event_Struct *event, const Event_Params *params)
+{
+    (void)params;
+
+    event->opaque[0] = (UArg)calloc(1, sizeof(SimEvent));
+}
+
+Event_Handle Event_handle(Event_Struct *event)
+{
+    return event;
+}
+
+void Event_post(Event_Handle handle, UInt eventMask)
+{
+    SimEvent *event = (SimEvent*)handle->opaque[0];
+    int idx;
+
+    event->posted |= eventMask;
+    for(idx = 0; idx < SIM_MAX_WAITERS; idx++)
+    {
+        if(event->waiter[idx] != NULL)
+        {
+            makeReady(event->waiter[idx]);
+        }
+    }
+
+    checkPreempt();
+}
+
+UInt Event_pend(Event_Handle handle, UInt andMask, UInt orMask, UInt32 timeout)
+{
+    SimEvent *event = (SimEvent*)handle->opaque[0];
+    UInt events;
+    (void)andMask;
+
+    while(1)
+    {
+        events = event->posted & orMask;
+        if(events != 0)
+        {
+            event->posted &= ~events;
+            return events;
+        }
+
+        if(timeout == BIOS_NO_WAIT)
+        {
+            return 0;
+        }
+
+        addWaiter(event->waiter);
+        if(!blockCurrent(timeout))
+        {
+            removeWaiter(event->waiter);
+            return 0;
+        }
+        removeWaiter(event->waiter);
+    }
+}
+
+UInt Event_getPostedEvents(Event_Handle handle)
+{
+    return ((SimEvent*)handle->opaque[0])->posted;
+}
+
+void Semaphore_Params_init(Semaphore_Params *params)
+{
+    params->mode = Semaphore_Mode_COUNTING;
+}
+
+void Semaphore_construct(Semaphore_Struct *sem, Int count, const Semaphore_Params *params)
+{
+    SimSemaphore *simSem = calloc(1, sizeof(SimSemaphore));
+
+    simSem->count = count;
+    simSem->mode = (params != NULL) ? params->mode : Semaphore_Mode_COUNTING;
+    sem->opaque[0] = (UArg)simSem;
+}
+
+Semaphore_Handle Semaphore_handle(Semaphore_Struct *sem)
+{
+    return sem;
+}
+
+Bool Semaphore_pend(Semaphore_Handle handle, UInt32 timeout)
+{
+    SimSemaphore *sem = (SimSemaphore*)handle->opaque[0];
+
+    while(sem->count == 0)
+    {
+        if(timeout == BIOS_NO_WAIT)
+        {
+            return FALSE;
+        }
+
+        addWaiter(sem->waiter);
+        if(!blockCurrent(timeout))
+        {
+            removeWaiter(sem->waiter);
+            return FALSE;
+        }
+        removeWaiter(sem->waiter);
+    }
+
+    sem->count--;
+
+    return TRUE;
+}
+
+void Semaphore_post(Semaphore_Handle handle)
+{
+    SimSemaphore *sem = (SimSemaphore*)handle->opaque[0];
+    int idx;
+
+    if((sem->mode == Semaphore_Mode_COUNTING) || (sem->count == 0))
+    {
+        sem->count++;
+    }
+
+    for(idx = 0; idx < SIM_MAX_WAITERS; idx++)
+    {
+        if(sem->waiter[idx] != NULL)
+        {
+            makeReady(sem->waiter[idx]);
+            break;
+        }
+    }
+
+    checkPreempt();
+}
+
+Int Semaphore_getCount(Semaphore_Handle handle)
+{
+    return ((SimSemaphore*)handle->opaque[0])->count;
+}
+
+static void clockExpired(void *arg)
+{
+    SimClock *clock = arg;
+
+    clock->timer = -1;
+    if(clock->period != 0)
+    {
+        clock->timer = timerStart(nowUs + (uint64_t)clock->period * Clock_tickPeriod, clockExpired, clock);
+    }
+
+    clock->fxn(clock->arg);
+}
+
+void Clock_Params_init(Clock_Params *params)
+{
+    memset(params, 0, sizeof(Clock_Params));
+}
+
+void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn, UInt32 timeout, const Clock_Params *params)
+{
+    SimClock *simClock = calloc(1, sizeof(SimClock));
+
+    simClock->fxn = fxn;
+    simClock->arg = params->arg;
+    simClock->timeout = timeout;
+    simClock->period = params->period;
+    simClock->timer = -1;
+    clock->opaque[0] = (UArg)simClock;
+
+    if(params->startFlag)
+    {
+        Clock_start(clock);
+    }
+}
+
+Clock_Handle Clock_handle(Clock_Struct *clock)
+{
+    return clock;
+}
+
+void Clock_start(Clock_Handle handle)
+{
+    SimClock *clock = (SimClock*)handle->opaque[0];
+    UInt32 timeout = (clock->timeout != 0) ? clock->timeout : 1;
+
+    timerStop(clock->timer);
+    clock->timer = timerStart(nowUs + (uint64_t)timeout * Clock_tickPeriod, clockExpired, clock);
+}
+
+void Clock_stop(Clock_Handle handle)
+{
+    SimClock *clock = (SimClock*)handle->opaque[0];
+
+    timerStop(clock->timer);
+    clock->timer = -1;
+}
+
+void Clock_setTimeout(Clock_Handle handle, UInt32 timeout)
+{
+    ((SimClock*)handle->opaque[0])->timeout = timeout;
+}
+
+void Clock_setPeriod(Clock_Handle handle, UInt32 period)
+{
+    ((SimClock*)handle->opaque[0])->period = period;
+}
+
+UInt32 Clock_getTimeout(Clock_Handle handle)
+{
+    return ((SimClock*)handle->opaque[0])->timeout;
+}
+
+Bool Clock_isActive(Clock_Handle handle)
+{
+    return ((SimClock*)handle->opaque[0])->timer >= 0;
+}
+
+UInt32 Clock_getTicks(void)
+{
+    return (UInt32)(nowUs / Clock_tickPeriod);
+}
+
+/******************************************************************************
+ Air
+ *****************************************************************************/
+
+typedef struct {
+    bool used;
+    bool ended;
+    OadE2e_Radio *sender;
+    SimTask *task;
+    uint8_t data[OADE2E_MAX_FRAME_LEN];
+    uint8_t len;
+    uint64_t startUs;
+    uint64_t endUs;
+} SimFrame;
+
+static OadE2e_Radio *radios[SIM_MAX_RADIOS];
+static int numRadios = 0;
+static SimFrame frames[SIM_MAX_FRAMES];
+static uint32_t framesSent = 0;
+static uint32_t framesLost = 0;
+static uint32_t framesCollided = 0;
+static uint32_t oadUplinks[OADProtocol_PACKET_TYPE_OAD_PUSH_ACK + 1];
+static uint32_t broadcastSymbols = 0;
+static uint32_t blockRsps = 0;
+static uint32_t broadcastOffSlot = 0;
+
+uint64_t OadE2e_nowUs(void)
+{
+    return nowUs;
+}
+
+void OadE2e_airRegister(OadE2e_Radio *radio)
+{
+    radio->rxTimer = -1;
+    radios[numRadios++] = radio;
+}
+
+static bool frameCollides(SimFrame *frame)
+{
+    int idx;
+
+    for(idx = 0; idx < SIM_MAX_FRAMES; idx++)
+    {
+        if((&frames[idx] != frame) && frames[idx].used &&
+           (frames[idx].startUs < frame->endUs) && (frame->startUs < frames[idx].endUs))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool addrAccepted(OadE2e_Radio *radio, uint8_t addr)
+{
+    uint8_t idx;
+
+    if(radio->numAddrFilter == 0)
+    {
+        return true;
+    }
+
+    for(idx = 0; idx < radio->numAddrFilter; idx++)
+    {
+        if(radio->addrFilter[idx] == addr)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void rxStop(OadE2e_Radio *radio)
+{
+    radio->rxOn = false;
+    radio->rxSync = false;
+    timerStop(radio->rxTimer);
+    radio->rxTimer = -1;
+}
+
+/* A radio that found a frame only times out once the frame is over */
+static void rxTimeout(void *arg)
+{
+    OadE2e_Radio *radio = arg;
+    int idx;
+
+    radio->rxTimer = -1;
+
+    for(idx = 0; idx < SIM_MAX_FRAMES; idx++)
+    {
+        if(frames[idx].used && !frames[idx].ended && (frames[idx].sender != radio) &&
+           (frames[idx].startUs >= radio->rxStartUs) && (frames[idx].startUs <= nowUs))
+        {
+            radio->rxSync = true;
+            return;
+        }
+    }
+
+    rxStop(radio);
+    radio->rxDone(radio, NULL, 0);
+}
+
+static void frameEnd(void *arg)
+{
+    SimFrame *frame = arg;
+    OadE2e_Radio *radio;
+    bool collided = frameCollides(frame);
+    int idx;
+
+    framesSent++;
+    if(collided)
+    {
+        framesCollided++;
+    }
+
+    /* Broadcast frames, the concentrator starts them on its broadcast slots */
+    if(frame->data[0] == TEST_BROADCAST_ADDR)
+    {
+        if((frame->len > TEST_OAD_TYPE_OFFSET) &&
+           (frame->data[TEST_OAD_TYPE_OFFSET] == OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_SYMBOL))
+        {
+            broadcastSymbols++;
+        }
+        if((frame->startUs % TEST_BROADCAST_SLOT_US) != 0)
+        {
+            broadcastOffSlot++;
+        }
+    }
+
+    /* Image or patch blocks sent to the node */
+    if((frame->data[0] != TEST_CONCENTRATOR_ADDR) && (frame->data[0] != TEST_BROADCAST_ADDR) &&
+       (frame->len > TEST_OAD_TYPE_OFFSET) &&
+       (frame->data[TEST_PACKET_TYPE_OFFSET] == TEST_PACKET_TYPE_OAD) &&
+       (frame->data[TEST_OAD_TYPE_OFFSET] == OADProtocol_PACKET_TYPE_OAD_BLOCK_RSP))
+    {
+        blockRsps++;
+    }
+
+    /* OAD messages of the node, by type */
+    if((frame->data[0] == TEST_CONCENTRATOR_ADDR) && (frame->len > TEST_OAD_TYPE_OFFSET) &&
+       (frame->data[TEST_PACKET_TYPE_OFFSET] == TEST_PACKET_TYPE_OAD) &&
+       (frame->data[TEST_OAD_TYPE_OFFSET] <= OADProtocol_PACKET_TYPE_OAD_PUSH_ACK))
+    {
+        oadUplinks[frame->data[TEST_OAD_TYPE_OFFSET]]++;
+    }
+
+    for(idx = 0; idx < numRadios; idx++)
+    {
+        radio = radios[idx];
+        if((radio == frame->sender) || !radio->rxOn || (radio->rxStartUs > frame->startUs))
+        {
+            continue;
+        }
+
+        if(!collided && addrAccepted(radio, frame->data[0]))
+        {
+            if((rand() % 100) >= radio->lossPct)
+            {
+                rxStop(radio);
+                radio->rxSyncUs = frame->startUs + SIM_SYNC_BYTES * SIM_US_PER_BYTE;
+                radio->rxDone(radio, frame->data, frame->len);
+                continue;
+            }
+            framesLost++;
+        }
+
+        /* The timeout that passed during the frame */
+        if(radio->rxSync && (radio->rxTimer < 0))
+        {
+            rxStop(radio);
+            radio->rxDone(radio, NULL, 0);
+        }
+    }
+
+    frame->ended = true;
+    frame->sender->txOn = false;
+    makeReady(frame->task);
+}
+
+void OadE2e_airTransmit(OadE2e_Radio *radio, const uint8_t *data, uint8_t len, uint64_t startUs)
+{
+    SimFrame *frame = NULL;
+    int idx;
+
+    for(idx = 0; idx < SIM_MAX_FRAMES; idx++)
+    {
+        /* An ended frame is kept for the collision check of the frames it overlaps */
+        if(!frames[idx].used ||
+           (frames[idx].ended && (frames[idx].endUs + SIM_MAX_FRAME_US < nowUs)))
+        {
+            frame = &frames[idx];
+            break;
+        }
+    }
+
+    if((frame == NULL) || (currentTask == NULL))
+    {
+        fprintf(stderr, "transmit failed\n");
+        exit(2);
+    }
+
+    if(startUs < nowUs + SIM_TX_TURNAROUND_US)
+    {
+        startUs = nowUs + SIM_TX_TURNAROUND_US;
+    }
+
+    frame->used = true;
+    frame->ended = false;
+    frame->sender = radio;
+    frame->task = currentTask;
+    memcpy(frame->data, data, len);
+    frame->len = len;
+    frame->startUs = startUs;
+    frame->endUs = startUs + (uint64_t)(len + SIM_FRAME_OVERHEAD) * SIM_US_PER_BYTE;
+
+    radio->txOn = true;
+    timerStart(frame->endUs, frameEnd, frame);
+
+    blockCurrent(BIOS_WAIT_FOREVER);
+}
+
+void OadE2e_airReceive(OadE2e_Radio *radio, uint64_t timeoutUs)
+{
+    rxStop(radio);
+
+    radio->rxOn = true;
+    radio->rxStartUs = nowUs;
+    radio->rxTimeoutUs = timeoutUs;
+    if(timeoutUs != 0)
+    {
+        radio->rxTimer = timerStart(nowUs + timeoutUs, rxTimeout, radio);
+    }
+}
+
+void OadE2e_airAbort(OadE2e_Radio *radio)
+{
+    rxStop(radio);
+}
+
+void OadE2e_log(const char *name, const char *fmt, ...)
+{
+    va_list va;
+
+    printf("[%4u.%06u] %-12s ", (unsigned)(nowUs / 1000000), (unsigned)(nowUs % 1000000), name);
+    va_start(va, fmt);
+    vprintf(fmt, va);
+    va_end(va);
+    printf("\n");
+}
+
+/******************************************************************************
+ Test
+ *****************************************************************************/
+
+static int numNodes = 1;
+static bool (*nodeImageInstalled[TEST_BROADCAST_NODES])(void);
+static uint8_t* (*nodeExtFlash[TEST_BROADCAST_NODES])(void);
+static const uint8_t *testImage;
+static uint32_t testImageLen;
+static uint16_t blocksStored;
+
+static bool transferDone(void)
+{
+    int idx;
+
+    for(idx = 0; idx < numNodes; idx++)
+    {
+        if(!nodeImageInstalled[idx]())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* The blocks in the node flash from the first one, as sent */
+static bool halfStored(void)
+{
+    const uint8_t *flash = nodeExtFlash[0]();
+    uint32_t offset;
+
+    blocksStored = 0;
+    for(offset = 0; offset + TEST_BLOCK_SIZE <= testImageLen; offset += TEST_BLOCK_SIZE)
+    {
+        if(memcmp(&flash[EFL_ADDR_IMAGE_APP + offset], &testImage[offset], TEST_BLOCK_SIZE) != 0)
+        {
+            break;
+        }
+        blocksStored++;
+    }
+
+    return blocksStored >= testImageLen / TEST_BLOCK_SIZE / 2;
+}
+
+static void setLoss(uint8_t lossPct)
+{
+    int idx;
+
+    for(idx = 0; idx < numRadios; idx++)
+    {
+        radios[idx]->lossPct = lossPct;
+    }
+}
+
+static uint16_t imageCrc16(uint16_t crc, uint8_t val)
+{
+    uint8_t cnt;
+
+    for(cnt = 0; cnt < 8; cnt++, val <<= 1)
+    {
+        uint8_t msb = (crc & 0x8000) ? 1 : 0;
+
+        crc <<= 1;
+        if(val & 0x80)
+        {
+            crc |= 0x0001;
+        }
+        if(msb)
+        {
+            crc ^= 0x1021;
+        }
+    }
+
+    return crc;
+}
+
+/* Image header and its CRC as the BIM checks it */
+static uint16_t setImageHeader(uint8_t *image, uint32_t len, uint16_t ver, uint8_t imgType)
+{
+    uint16_t crc = 0;
+    uint32_t i;
+
+    image[2] = 0xFF;
+    image[3] = 0xFF;
+    image[4] = ver & 0xFF;
+    image[5] = ver >> 8;
+    image[6] = (len / EFL_OAD_ADDR_RESOLUTION) & 0xFF;
+    image[7] = (len / EFL_OAD_ADDR_RESOLUTION) >> 8;
+    memcpy(&image[8], "E2E ", 4);
+    image[12] = TEST_IMG_ADDR & 0xFF;
+    image[13] = TEST_IMG_ADDR >> 8;
+    image[14] = imgType;
+    image[15] = 0xFF;
+
+    for(i = 4; i < len; i++)
+    {
+        crc = imageCrc16(crc, image[i]);
+    }
+    crc = imageCrc16(crc, 0);
+    crc = imageCrc16(crc, 0);
+
+    image[0] = crc & 0xFF;
+    image[1] = crc >> 8;
+
+    return crc;
+}
+
+/* Random image with the header of a remote app */
+static uint16_t makeImage(uint8_t *image, uint32_t len)
+{
+    uint32_t i;
+
+    for(i = 0; i < len; i++)
+    {
+        image[i] = rand();
+    }
+
+    return setImageHeader(image, len, TEST_IMG_VER, EFL_OAD_IMG_TYPE_REMOTE_APP);
+}
+
+/* Unchanged bytes from offset on, up to the longest copy */
+static uint32_t unchangedLen(const uint8_t *base, const uint8_t *image, uint32_t offset, uint32_t len)
+{
+    uint32_t run = 0;
+
+    while((offset + run < len) && (run < 0xFFFF) && (base[offset + run] == image[offset + run]))
+    {
+        run++;
+    }
+
+    return run;
+}
+
+/* Range encoder of the compressed image stream, as in oad_compress.py */
+typedef struct {
+    uint64_t low;
+    uint32_t range;
+    uint8_t cache;
+    uint32_t cacheSize;
+    uint8_t *out;
+    uint32_t outLen;
+    uint16_t probs[OADCompress_NUM_PROBS];
+} TestRangeEncoder;
+
+static void rcShiftLow(TestRangeEncoder *rc)
+{
+    uint8_t carry;
+    uint8_t temp;
+
+    if((rc->low < 0xFF000000) || (rc->low >= (1ULL << 32)))
+    {
+        carry = rc->low >> 32;
+        temp = rc->cache;
+        do
+        {
+            rc->out[rc->outLen++] = temp + carry;
+            temp = 0xFF;
+        } while(--rc->cacheSize != 0);
+        rc->cache = (rc->low >> 24) & 0xFF;
+    }
+    rc->cacheSize++;
+    rc->low = (rc->low & 0x00FFFFFF) << 8;
+}
+
+static void rcNormalize(TestRangeEncoder *rc)
+{
+    while(rc->range < TEST_LZ_RANGE_TOP)
+    {
+        rc->range <<= 8;
+        rcShiftLow(rc);
+    }
+}
+
+static void rcBit(TestRangeEncoder *rc, uint16_t prob, uint8_t bit)
+{
+    uint16_t p = rc->probs[prob];
+    uint32_t bound = (rc->range >> OADCompress_PROB_BITS) * p;
+
+    if(bit == 0)
+    {
+        rc->range = bound;
+        rc->probs[prob] = p + (((1 << OADCompress_PROB_BITS) - p) >> OADCompress_PROB_MOVE_BITS);
+    }
+    else
+    {
+        rc->low += bound;
+        rc->range -= bound;
+        rc->probs[prob] = p - (p >> OADCompress_PROB_MOVE_BITS);
+    }
+    rcNormalize(rc);
+}
+
+static void rcTree(TestRangeEncoder *rc, uint16_t probs, uint8_t numBits, uint16_t value)
+{
+    uint16_t node = 1;
+    uint8_t bit;
+
+    while(numBits--)
+    {
+        bit = (value >> numBits) & 1;
+        rcBit(rc, probs + node, bit);
+        node = (node << 1) | bit;
+    }
+}
+
+static void rcDirect(TestRangeEncoder *rc, uint8_t numBits, uint16_t value)
+{
+    while(numBits--)
+    {
+        rc->range >>= 1;
+        if((value >> numBits) & 1)
+        {
+            rc->low += rc->range;
+        }
+        rcNormalize(rc);
+    }
+}
+
+static uint32_t lzMatchLen(const uint8_t *data, uint32_t len, uint32_t src, uint32_t n)
+{
+    uint32_t matchLen = 0;
+
+    while((n + matchLen < len) && (matchLen < TEST_LZ_MAX_MATCH) && (data[src + matchLen] == data[n + matchLen]))
+    {
+        matchLen++;
+    }
+
+    return matchLen;
+}
+
+/*
+ * Compressed image in the format of oad_compress.h, greedy matching. A
+ * broken stream has a byte of its middle changed. Returns the length.
+ */
+static uint32_t compressImage(const uint8_t *image, uint32_t len, uint8_t *lzImage, bool broken)
+{
+    static TestRangeEncoder rc;
+    uint32_t lzLen;
+    uint32_t bestLen;
+    uint32_t bestDist;
+    uint32_t repLen;
+    uint32_t matchLen;
+    uint32_t dist;
+    uint32_t rep = 0;
+    uint32_t n = 0;
+    uint8_t prevMatch = 0;
+    uint8_t distBits;
+
+    memset(&rc, 0, sizeof(rc));
+    rc.range = 0xFFFFFFFF;
+    rc.cacheSize = 1;
+    rc.out = &lzImage[OADCompress_STREAM_OSET];
+    for(dist = 0; dist < OADCompress_NUM_PROBS; dist++)
+    {
+        rc.probs[dist] = 1 << (OADCompress_PROB_BITS - 1);
+    }
+
+    while(n < len)
+    {
+        bestLen = 0;
+        bestDist = 0;
+        for(dist = 1; (dist <= OADCompress_WINDOW_SIZE) && (dist <= n); dist++)
+        {
+            matchLen = lzMatchLen(image, len, n - dist, n);
+            if(matchLen > bestLen)
+            {
+                bestLen = matchLen;
+                bestDist = dist;
+            }
+        }
+
+        repLen = ((rep > 0) && (rep <= n)) ? lzMatchLen(image, len, n - rep, n) : 0;
+
+        if((repLen >= OADCompress_MIN_MATCH) && (repLen + 1 >= bestLen))
+        {
+            rcBit(&rc, OADCompress_PROB_IS_MATCH + prevMatch, 1);
+            rcBit(&rc, OADCompress_PROB_IS_REP + prevMatch, 1);
+            rcTree(&rc, OADCompress_PROB_LEN, OADCompress_LEN_BITS, repLen - OADCompress_MIN_MATCH);
+            n += repLen;
+            prevMatch = 1;
+        }
+        else if(bestLen >= TEST_LZ_MIN_NEW_MATCH)
+        {
+            for(distBits = 0; (bestDist >> distBits) != 0; distBits++)
+            {
+            }
+            rcBit(&rc, OADCompress_PROB_IS_MATCH + prevMatch, 1);
+            rcBit(&rc, OADCompress_PROB_IS_REP + prevMatch, 0);
+            rcTree(&rc, OADCompress_PROB_LEN, OADCompress_LEN_BITS, bestLen - OADCompress_MIN_MATCH);
+            rcTree(&rc, OADCompress_PROB_DIST_SLOT, OADCompress_DIST_SLOT_BITS, distBits);
+            rcDirect(&rc, distBits - 1, bestDist - (1 << (distBits - 1)));
+            rep = bestDist;
+            n += bestLen;
+            prevMatch = 1;
+        }
+        else
+        {
+            rcBit(&rc, OADCompress_PROB_IS_MATCH + prevMatch, 0);
+            rcTree(&rc, OADCompress_PROB_LITERAL, 8, image[n]);
+            n++;
+            prevMatch = 0;
+        }
+    }
+
+    for(dist = 0; dist < 5; dist++)
+    {
+        rcShiftLow(&rc);
+    }
+
+    if(broken)
+    {
+        rc.out[rc.outLen / 2] ^= 0x5A;
+    }
+
+    memcpy(&lzImage[OADCompress_IMG_INFO_OSET], image, 16);
+    lzImage[OADCompress_MAGIC_OSET] = OADCompress_MAGIC & 0xFF;
+    lzImage[OADCompress_MAGIC_OSET + 1] = (OADCompress_MAGIC >> 8) & 0xFF;
+    lzImage[OADCompress_MAGIC_OSET + 2] = (OADCompress_MAGIC >> 16) & 0xFF;
+    lzImage[OADCompress_MAGIC_OSET + 3] = OADCompress_MAGIC >> 24;
+
+    lzLen = OADCompress_STREAM_OSET + rc.outLen;
+    while(lzLen % EFL_OAD_ADDR_RESOLUTION)
+    {
+        lzImage[lzLen++] = 0xFF;
+    }
+
+    /* The compressed image is stored as an image of its own, with the version it holds */
+    setImageHeader(lzImage, lzLen, TEST_IMG_VER, EFL_OAD_IMG_TYPE_COMPRESSED);
+
+    return lzLen;
+}
+
+/*
+ * Delta patch from base to image, of the same length, in the format of
+ * oad_delta.h: unchanged runs are copied from the base, the rest are
+ * literals. Returns the patch length.
+ */
+static uint32_t makePatch(const uint8_t *base, const uint8_t *image, uint32_t len, uint8_t *patch)
+{
+    uint32_t patchLen = OADDelta_OPS_OSET;
+    uint32_t offset = 0;
+    uint32_t run;
+    uint32_t lit;
+
+    memcpy(&patch[OADDelta_NEW_IMG_INFO_OSET], image, 16);
+    patch[OADDelta_BASE_VER_OSET] = TEST_BASE_IMG_VER & 0xFF;
+    patch[OADDelta_BASE_VER_OSET + 1] = TEST_BASE_IMG_VER >> 8;
+    patch[OADDelta_BASE_LEN_OSET] = (len / EFL_OAD_ADDR_RESOLUTION) & 0xFF;
+    patch[OADDelta_BASE_LEN_OSET + 1] = (len / EFL_OAD_ADDR_RESOLUTION) >> 8;
+
+    while(offset < len)
+    {
+        run = unchangedLen(base, image, offset, len);
+        if(run >= TEST_DELTA_MIN_COPY)
+        {
+            patch[patchLen++] = OADDelta_OP_COPY;
+            patch[patchLen++] = offset & 0xFF;
+            patch[patchLen++] = (offset >> 8) & 0xFF;
+            patch[patchLen++] = offset >> 16;
+            patch[patchLen++] = run & 0xFF;
+            patch[patchLen++] = run >> 8;
+            offset += run;
+            continue;
+        }
+
+        for(lit = 1; (lit <= OADDelta_OP_LITERAL_MAX) && (offset + lit < len) &&
+                     (unchangedLen(base, image, offset + lit, len) < TEST_DELTA_MIN_COPY); lit++)
+        {
+        }
+        patch[patchLen++] = lit - 1;
+        memcpy(&patch[patchLen], &image[offset], lit);
+        patchLen += lit;
+        offset += lit;
+    }
+
+    patch[patchLen++] = OADDelta_OP_END;
+    while(patchLen % EFL_OAD_ADDR_RESOLUTION)
+    {
+        patch[patchLen++] = 0xFF;
+    }
+
+    /* The patch is stored as an image of its own, with the version it builds */
+    setImageHeader(patch, patchLen, TEST_IMG_VER, EFL_OAD_IMG_TYPE_DELTA);
+
+    return patchLen;
+}
+
+/* A library is loaded once, each further node gets a copy of its own */
+static void copyFile(const char *from, const char *to)
+{
+    char buf[4096];
+    size_t len;
+    FILE *in = fopen(from, "rb");
+    FILE *out = fopen(to, "wb");
+
+    if((in == NULL) || (out == NULL))
+    {
+        fprintf(stderr, "cannot copy %s to %s\n", from, to);
+        exit(2);
+    }
+
+    while((len = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+        fwrite(buf, 1, len, out);
+    }
+
+    fclose(in);
+    fclose(out);
+}
+
+static void* loadDevice(const char *path)
+{
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+
+    if(handle == NULL)
+    {
+        fprintf(stderr, "%s\n", dlerror());
+        exit(2);
+    }
+
+    return handle;
+}
+
+static void* deviceSymbol(void *handle, const char *name)
+{
+    void *sym = dlsym(handle, name);
+
+    if(sym == NULL)
+    {
+        fprintf(stderr, "%s\n", dlerror());
+        exit(2);
+    }
+
+    return sym;
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t lossPct = 0;
+    unsigned int seed = 1;
+    uint32_t imageLen = 0;
+    bool verbose = false;
+    bool resume = false;
+    bool broadcast = false;
+    bool delta = false;
+    bool compressed = false;
+    bool brokenStream = false;
+    int argNum = 0;
+    int i;
+
+    OadE2e_DeviceConfig serverConfig = {0};
+    OadE2e_DeviceConfig nodeConfig[TEST_BROADCAST_NODES] = {{0}};
+    char nodeName[TEST_BROADCAST_NODES][16];
+    char nodePath[64];
+    void *server;
+    void *node;
+    void (*pressButtons)(bool button0, bool button1);
+    uint8_t (*serverNumSessions)(void);
+    uint16_t (*nodeResumeBlock)(void) = NULL;
+    uint8_t *image;
+    uint8_t *baseImage = NULL;
+    uint8_t *patch = NULL;
+    uint32_t patchLen = 0;
+    uint8_t *lzImage = NULL;
+    uint32_t lzImageLen = 0;
+    uint8_t *flash;
+    ExtImageInfo_t info;
+    uint16_t crc;
+    uint64_t transferUs;
+    int failed = 0;
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-v") == 0)
+        {
+            verbose = true;
+            continue;
+        }
+        if(strcmp(argv[i], "-r") == 0)
+        {
+            resume = true;
+            continue;
+        }
+        if((strcmp(argv[i], "-z") == 0) || (strcmp(argv[i], "-Z") == 0))
+        {
+            compressed = true;
+            brokenStream = (argv[i][1] == 'Z');
+            continue;
+        }
+        if(strcmp(argv[i], "-d") == 0)
+        {
+            delta = true;
+            continue;
+        }
+        if(strcmp(argv[i], "-b") == 0)
+        {
+            broadcast = true;
+            numNodes = TEST_BROADCAST_NODES;
+            continue;
+        }
+
+        switch(argNum++)
+        {
+        case 0:
+            lossPct = atoi(argv[i]);
+            break;
+        case 1:
+            seed = atoi(argv[i]);
+            break;
+        case 2:
+            imageLen = atoi(argv[i]) * 1024;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if(imageLen == 0)
+    {
+        imageLen = (broadcast ? TEST_BROADCAST_KBYTES : 8) * 1024;
+    }
+
+    srand(seed);
+    image = malloc(imageLen);
+    crc = makeImage(image, imageLen);
+    testImage = image;
+    testImageLen = imageLen;
+
+    /* The new image changes a few places of the running one */
+    if(delta)
+    {
+        baseImage = malloc(imageLen);
+        memcpy(baseImage, image, imageLen);
+        setImageHeader(baseImage, imageLen, TEST_BASE_IMG_VER, EFL_OAD_IMG_TYPE_APP);
+
+        for(i = 0; i < TEST_DELTA_CHANGES; i++)
+        {
+            uint32_t offset = 16 + rand() % (imageLen - 16 - TEST_DELTA_CHANGE_LEN);
+            uint32_t idx;
+
+            for(idx = 0; idx < TEST_DELTA_CHANGE_LEN; idx++)
+            {
+                baseImage[offset + idx] = rand();
+            }
+        }
+
+        patch = malloc(imageLen * 2 + OADDelta_OPS_OSET);
+        patchLen = makePatch(baseImage, image, imageLen, patch);
+        resume = false;
+    }
+
+    /* Most pieces of the image repeat an earlier one */
+    if(compressed)
+    {
+        uint32_t offset;
+
+        for(offset = TEST_REPEAT_LEN * TEST_REPEAT_DIST; offset + TEST_REPEAT_LEN <= imageLen; offset += TEST_REPEAT_LEN)
+        {
+            if(rand() % 4 != 0)
+            {
+                memcpy(&image[offset], &image[offset - TEST_REPEAT_LEN * (1 + rand() % TEST_REPEAT_DIST)],
+                       TEST_REPEAT_LEN);
+            }
+        }
+        crc = setImageHeader(image, imageLen, TEST_IMG_VER, EFL_OAD_IMG_TYPE_REMOTE_APP);
+
+        lzImage = malloc(imageLen * 2 + OADCompress_STREAM_OSET);
+        lzImageLen = compressImage(image, imageLen, lzImage, brokenStream);
+        resume = false;
+    }
+
+    server = loadDevice("./oad_e2e_server.so");
+    pressButtons = deviceSymbol(server, "OadE2eDevice_pressButtons");
+    serverNumSessions = deviceSymbol(server, "OADServer_getNumSessions");
+
+    serverConfig.name = TEST_CONCENTRATOR_NAME;
+    serverConfig.lossPct = lossPct;
+    serverConfig.verbose = verbose;
+    serverConfig.image = image;
+    serverConfig.imageLen = imageLen;
+    serverConfig.patch = patch;
+    serverConfig.patchLen = patchLen;
+    serverConfig.compressed = lzImage;
+    serverConfig.compressedLen = lzImageLen;
+    ((OadE2e_StartFxn)deviceSymbol(server, "OadE2eServer_start"))(&serverConfig);
+
+    for(i = 0; i < numNodes; i++)
+    {
+        if(i == 0)
+        {
+            snprintf(nodePath, sizeof(nodePath), "./oad_e2e_node.so");
+            snprintf(nodeName[i], sizeof(nodeName[i]), "%s", TEST_NODE_NAME);
+        }
+        else
+        {
+            snprintf(nodePath, sizeof(nodePath), "./oad_e2e_node_%d.so", i);
+            snprintf(nodeName[i], sizeof(nodeName[i]), "%s%d", TEST_NODE_NAME, i);
+            copyFile("./oad_e2e_node.so", nodePath);
+        }
+
+        node = loadDevice(nodePath);
+        nodeExtFlash[i] = deviceSymbol(node, "OadE2eDevice_extFlash");
+        nodeImageInstalled[i] = deviceSymbol(node, "OadE2eNode_imageInstalled");
+        if(i == 0)
+        {
+            nodeResumeBlock = deviceSymbol(node, "OadE2eNode_resumeBlock");
+        }
+
+        nodeConfig[i].name = nodeName[i];
+        nodeConfig[i].address = TEST_NODE_ADDRESS + i;
+        nodeConfig[i].lossPct = (numNodes > 1) ? lossPct * i / (numNodes - 1) : lossPct;
+        nodeConfig[i].verbose = verbose;
+        nodeConfig[i].runningImage = baseImage;
+        nodeConfig[i].runningImageLen = baseImage ? imageLen : 0;
+        ((OadE2e_StartFxn)deviceSymbol(node, "OadE2eNode_start"))(&nodeConfig[i]);
+    }
+
+    /* The nodes become known with their first data packet */
+    runUntil(TEST_JOIN_TIME_US, NULL);
+
+    if(broadcast)
+    {
+        /* Select "Broadcast node FW" and start it */
+        OadE2e_log("test", "broadcast node FW to %d nodes, %u blocks, up to %u%% loss",
+                   numNodes, imageLen / TEST_BLOCK_SIZE, lossPct);
+        pressButtons(false, true);
+        pressButtons(false, true);
+        pressButtons(false, true);
+        pressButtons(true, true);
+        resume = false;
+    }
+    else if(delta)
+    {
+        /* Select "FW version req", the server picks the patch from the answer */
+        OadE2e_log("test", "update node FW with a patch of %u blocks, %u blocks in the image, %u%% loss",
+                   (patchLen + TEST_BLOCK_SIZE - 1) / TEST_BLOCK_SIZE, imageLen / TEST_BLOCK_SIZE, lossPct);
+        pressButtons(false, true);
+        pressButtons(true, true);
+        runUntil(nowUs + TEST_JOIN_TIME_US, NULL);
+
+        /* Then "Update node FW" */
+        pressButtons(false, true);
+        pressButtons(true, true);
+    }
+    else
+    {
+        /* Select "Update node FW" and start it on the first node */
+        if(compressed)
+        {
+            OadE2e_log("test", "compressed image of %u blocks%s", (lzImageLen + TEST_BLOCK_SIZE - 1) / TEST_BLOCK_SIZE,
+                       brokenStream ? ", broken" : "");
+        }
+        OadE2e_log("test", "update node FW, %u blocks, %u%% loss", imageLen / TEST_BLOCK_SIZE, lossPct);
+        pressButtons(false, true);
+        pressButtons(false, true);
+        pressButtons(true, true);
+    }
+
+    if(resume)
+    {
+        runUntil(TEST_TIMEOUT_US, halfStored);
+        OadE2e_log("test", "link down, %u blocks stored", blocksStored);
+        setLoss(100);
+        runUntil(nowUs + TEST_OUTAGE_US, NULL);
+        setLoss(lossPct);
+
+        if(serverNumSessions() != 0)
+        {
+            printf("FAIL: the server session did not time out\n");
+            failed = 1;
+        }
+
+        /* Select the node again, the action only follows a single press */
+        OadE2e_log("test", "link up, update node FW again");
+        pressButtons(true, false);
+        pressButtons(true, true);
+    }
+
+    runUntil(TEST_TIMEOUT_US, transferDone);
+    transferUs = nowUs - TEST_JOIN_TIME_US;
+    OadE2e_log("test", "frames %u, lost %u, collided %u", framesSent, framesLost, framesCollided);
+    OadE2e_log("test", "node block requests %u, push acks %u",
+               oadUplinks[OADProtocol_PACKET_TYPE_OAD_BLOCK_REQ] + oadUplinks[OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ],
+               oadUplinks[OADProtocol_PACKET_TYPE_OAD_PUSH_ACK]);
+    if(broadcast)
+    {
+        OadE2e_log("test", "broadcast symbols %u, fountain status %u, off slot %u", broadcastSymbols,
+                   oadUplinks[OADProtocol_PACKET_TYPE_OAD_FOUNTAIN_STATUS], broadcastOffSlot);
+    }
+
+    /* The session ends with the last push ack */
+    runUntil(nowUs + 1000000, NULL);
+
+    for(i = 0; i < numNodes; i++)
+    {
+        flash = nodeExtFlash[i]();
+        memcpy(&info, &flash[EFL_IMAGE_INFO_ADDR_APP], sizeof(info));
+
+        if(!nodeImageInstalled[i]())
+        {
+            printf("FAIL: %s did not install the image\n", nodeName[i]);
+            failed = 1;
+        }
+        if(memcmp(&flash[EFL_ADDR_IMAGE_APP], image, imageLen) != 0)
+        {
+            printf("FAIL: the image in the flash of %s differs\n", nodeName[i]);
+            failed = 1;
+        }
+        if((info.crc[0] != crc) || (info.crc[1] != crc) || (info.ver != TEST_IMG_VER) ||
+           (info.len != imageLen / EFL_OAD_ADDR_RESOLUTION) || (info.addr != TEST_IMG_ADDR) ||
+           (info.imgType != EFL_OAD_IMG_TYPE_APP))
+        {
+            printf("FAIL: image information of %s crc %04x/%04x ver %04x len %u addr %04x type %u\n",
+                   nodeName[i], info.crc[0], info.crc[1], info.ver, info.len, info.addr, info.imgType);
+            failed = 1;
+        }
+    }
+    if(broadcast && ((broadcastSymbols == 0) || (oadUplinks[OADProtocol_PACKET_TYPE_OAD_PUSH_ACK] != 0)))
+    {
+        printf("FAIL: the nodes did not decode the image from the broadcast\n");
+        failed = 1;
+    }
+    if((delta || (compressed && !brokenStream)) && (blockRsps >= imageLen / TEST_BLOCK_SIZE))
+    {
+        printf("FAIL: %u blocks were sent, the image has %u\n", blockRsps, imageLen / TEST_BLOCK_SIZE);
+        failed = 1;
+    }
+    if(brokenStream && (blockRsps < imageLen / TEST_BLOCK_SIZE))
+    {
+        printf("FAIL: the node was not sent the uncompressed image\n");
+        failed = 1;
+    }
+    if(broadcastOffSlot != 0)
+    {
+        printf("FAIL: %u broadcast frames started off their slot\n", broadcastOffSlot);
+        failed = 1;
+    }
+    if(serverNumSessions() != 0)
+    {
+        printf("FAIL: the server session did not end\n");
+        failed = 1;
+    }
+    if((oadUplinks[OADProtocol_PACKET_TYPE_OAD_BLOCK_REQ] != 0) ||
+       (oadUplinks[OADProtocol_PACKET_TYPE_OAD_MULTI_BLOCK_REQ] != 0))
+    {
+        printf("FAIL: the node requested blocks instead of acknowledging pushed blocks\n");
+        failed = 1;
+    }
+    /* The download record follows the program pages */
+    if(resume && (nodeResumeBlock() < blocksStored - blocksStored % TEST_PAGE_BLOCKS))
+    {
+        printf("FAIL: the node resumed at block %u, %u were stored\n", nodeResumeBlock(), blocksStored);
+        failed = 1;
+    }
+
+    printf("%s: %u bytes in %u.%03u s\n", failed ? "FAIL" : "PASS", imageLen,
+           (unsigned)(transferUs / 1000000), (unsigned)(transferUs / 1000 % 1000));
+
+    return failed;
+}
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in of the device family header, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_DEVICEFAMILY_H
+#define OADE2E_DEVICEFAMILY_H
+
+#define DeviceFamily_CC13X0
+#define DeviceFamily_constructPath(x)   <ti/devices/cc13x0/x>
+
+#endif /* OADE2E_DEVICEFAMILY_H */
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in of driverlib aon_batmon, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_AON_BATMON_H
+#define OADE2E_AON_BATMON_H
+
+#include <stdint.h>
+
+extern void AONBatMonEnable(void);
+extern uint32_t AONBatMonBatteryVoltageGet(void);
+extern int32_t AONBatMonTemperatureGetDegC(void);
+
+#endif /* OADE2E_AON_BATMON_H */
@@ -0,0 +1,11 @@
+/*
+ * Host stand-in of driverlib cpu, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_CPU_H
+#define OADE2E_CPU_H
+
+#include <stdint.h>
+
+extern void CPUdelay(uint32_t count);
+
+#endif /* OADE2E_CPU_H */
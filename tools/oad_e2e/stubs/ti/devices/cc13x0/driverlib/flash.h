@@ -0,0 +1,11 @@
+/*
+ * Host stand-in of driverlib flash, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_FLASH_H
+#define OADE2E_FLASH_H
+
+#include <stdint.h>
+
+extern uint32_t FlashSectorSizeGet(void);
+
+#endif /* OADE2E_FLASH_H */
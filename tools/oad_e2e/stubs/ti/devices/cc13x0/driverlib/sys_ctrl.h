@@ -0,0 +1,9 @@
+/*
+ * Host stand-in of driverlib sys_ctrl, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_SYS_CTRL_H
+#define OADE2E_SYS_CTRL_H
+
+extern void SysCtrlSystemReset(void);
+
+#endif /* OADE2E_SYS_CTRL_H */
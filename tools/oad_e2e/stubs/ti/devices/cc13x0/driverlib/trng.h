@@ -0,0 +1,19 @@
+/*
+ * Host stand-in of driverlib trng, for the OAD end-to-end test. The number
+ * is the node address the test picks.
+ */
+#ifndef OADE2E_TRNG_H
+#define OADE2E_TRNG_H
+
+#include <stdint.h>
+
+#define TRNG_NUMBER_READY   0x00000001
+#define TRNG_LOW_WORD       1
+#define TRNG_HI_WORD        2
+
+extern void TRNGEnable(void);
+extern void TRNGDisable(void);
+extern uint32_t TRNGStatusGet(void);
+extern uint32_t TRNGNumberGet(uint32_t word);
+
+#endif /* OADE2E_TRNG_H */
@@ -0,0 +1,40 @@
+/*
+ * Host stand-in of the Display driver, for the OAD end-to-end test. Output
+ * goes to the test log when it is verbose.
+ */
+#ifndef OADE2E_DISPLAY_H
+#define OADE2E_DISPLAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct Display_Config *Display_Handle;
+
+typedef enum {
+    DISPLAY_CLEAR_NONE,
+    DISPLAY_CLEAR_LEFT,
+    DISPLAY_CLEAR_RIGHT,
+    DISPLAY_CLEAR_BOTH
+} Display_LineClearMode;
+
+typedef struct {
+    Display_LineClearMode lineClearMode;
+} Display_Params;
+
+#define Display_Type_UART               (1 << 0)
+#define Display_Type_LCD                (1 << 1)
+
+#define DISPLAY_CMD_TRANSPORT_CLOSE     1
+#define DISPLAY_CMD_TRANSPORT_OPEN      2
+
+extern void Display_init(void);
+extern void Display_Params_init(Display_Params *params);
+extern Display_Handle Display_open(uint32_t id, Display_Params *params);
+extern void Display_close(Display_Handle handle);
+extern void Display_clear(Display_Handle handle);
+extern int Display_control(Display_Handle handle, unsigned int cmd, void *arg);
+extern void Display_printf(Display_Handle handle, uint8_t line, uint8_t column, const char *fmt, ...);
+
+#define Display_print0(handle, line, col, fmt) Display_printf(handle, line, col, fmt)
+
+#endif /* OADE2E_DISPLAY_H */
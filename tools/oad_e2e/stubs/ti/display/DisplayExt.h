@@ -0,0 +1,9 @@
+/*
+ * Host stand-in of the Display driver extensions, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_DISPLAYEXT_H
+#define OADE2E_DISPLAYEXT_H
+
+#include <ti/display/Display.h>
+
+#endif /* OADE2E_DISPLAYEXT_H */
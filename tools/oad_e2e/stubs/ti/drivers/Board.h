@@ -0,0 +1,11 @@
+/*
+ * Host stand-in of the TI driver board header, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_TI_DRIVERS_BOARD_H
+#define OADE2E_TI_DRIVERS_BOARD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#endif /* OADE2E_TI_DRIVERS_BOARD_H */
@@ -0,0 +1,42 @@
+/*
+ * Host stand-in of the PIN driver, for the OAD end-to-end test. The pins are
+ * kept by oad_e2e_device.c, the test presses the buttons through it.
+ */
+#ifndef OADE2E_PIN_H
+#define OADE2E_PIN_H
+
+#include <stdint.h>
+
+typedef uint32_t PIN_Config;
+typedef uint8_t PIN_Id;
+typedef struct {
+    int dummy;
+} PIN_State;
+typedef PIN_State *PIN_Handle;
+typedef void (*PIN_IntCb)(PIN_Handle handle, PIN_Id pinId);
+
+#define PIN_ID(x)               ((x) & 0xFF)
+#define PIN_TERMINATE           0xFE
+#define PIN_UNASSIGNED          0xFF
+
+#define PIN_GPIO_OUTPUT_EN      (1 << 8)
+#define PIN_GPIO_LOW            (1 << 9)
+#define PIN_GPIO_HIGH           (1 << 10)
+#define PIN_PUSHPULL            (1 << 11)
+#define PIN_DRVSTR_MIN          (1 << 12)
+#define PIN_DRVSTR_MED          (1 << 13)
+#define PIN_DRVSTR_MAX          (1 << 14)
+#define PIN_INPUT_EN            (1 << 15)
+#define PIN_PULLUP              (1 << 16)
+#define PIN_NOPULL              (1 << 17)
+#define PIN_IRQ_NEGEDGE         (1 << 18)
+#define PIN_IRQ_DIS             (1 << 19)
+
+extern PIN_Handle PIN_open(PIN_State *state, const PIN_Config pinList[]);
+extern void PIN_close(PIN_Handle handle);
+extern int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t val);
+extern uint32_t PIN_getOutputValue(PIN_Id pinId);
+extern uint32_t PIN_getInputValue(PIN_Id pinId);
+extern int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callback);
+
+#endif /* OADE2E_PIN_H */
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in of the Power driver, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_POWER_H
+#define OADE2E_POWER_H
+
+#include <stdint.h>
+
+extern int Power_setDependency(unsigned int resourceId);
+extern int Power_releaseDependency(unsigned int resourceId);
+
+#endif /* OADE2E_POWER_H */
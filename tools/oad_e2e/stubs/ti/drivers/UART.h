@@ -0,0 +1,42 @@
+/*
+ * Host stand-in of the UART driver, for the OAD end-to-end test. No image is
+ * uploaded over the UART, the test loads the server flash directly.
+ */
+#ifndef OADE2E_UART_H
+#define OADE2E_UART_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct UART_Config *UART_Handle;
+typedef void (*UART_Callback)(UART_Handle handle, void *buf, size_t count);
+
+typedef enum { UART_MODE_BLOCKING, UART_MODE_CALLBACK } UART_Mode;
+typedef enum { UART_RETURN_PARTIAL, UART_RETURN_FULL } UART_ReturnMode;
+typedef enum { UART_DATA_BINARY, UART_DATA_TEXT } UART_DataMode;
+typedef enum { UART_ECHO_OFF, UART_ECHO_ON } UART_Echo;
+
+#define UART_WAIT_FOREVER   (~(uint32_t)0)
+
+typedef struct {
+    UART_Mode readMode;
+    UART_Mode writeMode;
+    uint32_t readTimeout;
+    uint32_t writeTimeout;
+    UART_Callback readCallback;
+    UART_Callback writeCallback;
+    UART_ReturnMode readReturnMode;
+    UART_DataMode readDataMode;
+    UART_DataMode writeDataMode;
+    UART_Echo readEcho;
+    uint32_t baudRate;
+} UART_Params;
+
+extern void UART_Params_init(UART_Params *params);
+extern UART_Handle UART_open(unsigned int index, UART_Params *params);
+extern void UART_close(UART_Handle handle);
+extern int UART_read(UART_Handle handle, void *buffer, size_t size);
+extern int UART_write(UART_Handle handle, const void *buffer, size_t size);
+extern void UART_readCancel(UART_Handle handle);
+
+#endif /* OADE2E_UART_H */
@@ -0,0 +1,9 @@
+/*
+ * Host stand-in of the CC26XX power resources, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_POWERCC26XX_H
+#define OADE2E_POWERCC26XX_H
+
+#define PowerCC26XX_PERIPH_TRNG     5
+
+#endif /* OADE2E_POWERCC26XX_H */
@@ -0,0 +1,46 @@
+/*
+ * Host stand-in of the RF driver types EasyLink.h refers to, for the OAD
+ * end-to-end test.
+ */
+#ifndef OADE2E_RF_H
+#define OADE2E_RF_H
+
+#include <stdint.h>
+
+typedef void *RF_Handle;
+typedef uint64_t RF_EventMask;
+typedef uint32_t RF_ClientEventMask;
+typedef enum { RF_ClientEventPowerUpFinished = 1 } RF_ClientEvent;
+typedef void (*RF_ClientCallback)(RF_Handle h, RF_ClientEvent event, void *arg);
+
+typedef struct { int dummy; } RF_Mode;
+typedef struct { int dummy; } rfc_CMD_PROP_RADIO_DIV_SETUP_t;
+typedef struct { int dummy; } rfc_CMD_PROP_RADIO_SETUP_t;
+typedef struct { int dummy; } rfc_CMD_FS_t;
+typedef struct { int dummy; } rfc_CMD_PROP_TX_t;
+typedef struct { int dummy; } rfc_CMD_PROP_TX_ADV_t;
+typedef struct { int dummy; } rfc_CMD_PROP_RX_ADV_t;
+
+typedef enum {
+    RF_TxPowerTable_DefaultPA = 0,
+    RF_TxPowerTable_HighPA = 1
+} RF_TxPowerTable_PAType;
+
+typedef struct {
+    uint32_t rawValue:22;
+    uint32_t __dummy:9;
+    uint32_t paType:1;
+} RF_TxPowerTable_Value;
+
+typedef struct {
+    int8_t power;
+    RF_TxPowerTable_Value value;
+} RF_TxPowerTable_Entry;
+
+#define RF_TxPowerTable_INVALID_DBM     127
+#define RF_TxPowerTable_DEFAULT_PA_ENTRY(bias, gain, boost, coefficient) \
+    { .rawValue = ((bias) << 0) | ((gain) << 6) | ((boost) << 8) | ((coefficient) << 9), .paType = RF_TxPowerTable_DefaultPA }
+#define RF_TxPowerTable_TERMINATION_ENTRY \
+    { .power = RF_TxPowerTable_INVALID_DBM, .value = { .rawValue = 0, .paType = RF_TxPowerTable_DefaultPA } }
+
+#endif /* OADE2E_RF_H */
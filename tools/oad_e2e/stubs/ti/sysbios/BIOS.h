@@ -0,0 +1,12 @@
+/*
+ * Host stand-in of the SYS/BIOS module, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_BIOS_H
+#define OADE2E_BIOS_H
+
+#include <xdc/std.h>
+
+#define BIOS_WAIT_FOREVER   (~(UInt32)0)
+#define BIOS_NO_WAIT        0
+
+#endif /* OADE2E_BIOS_H */
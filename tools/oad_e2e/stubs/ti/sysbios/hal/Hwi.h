@@ -0,0 +1,13 @@
+/*
+ * Host stand-in of ti.sysbios.hal.Hwi. Callbacks of the OAD end-to-end test
+ * never interrupt a task, so these only keep the key.
+ */
+#ifndef OADE2E_HWI_H
+#define OADE2E_HWI_H
+
+#include <xdc/std.h>
+
+extern UInt Hwi_disable(void);
+extern void Hwi_restore(UInt key);
+
+#endif /* OADE2E_HWI_H */
@@ -0,0 +1,37 @@
+/*
+ * Host stand-in of ti.sysbios.knl.Clock on the simulated time of the OAD
+ * end-to-end test. The objects are kept by the simulation.
+ */
+#ifndef OADE2E_CLOCK_H
+#define OADE2E_CLOCK_H
+
+#include <xdc/std.h>
+
+/* Tick period in us, as configured in the kernel project */
+#define Clock_tickPeriod    10
+
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+typedef struct {
+    UArg opaque[8];
+} Clock_Struct;
+typedef Clock_Struct *Clock_Handle;
+
+typedef struct {
+    UInt32 period;
+    Bool startFlag;
+    UArg arg;
+} Clock_Params;
+
+extern void Clock_Params_init(Clock_Params *params);
+extern void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn, UInt32 timeout, const Clock_Params *params);
+extern Clock_Handle Clock_handle(Clock_Struct *clock);
+extern void Clock_start(Clock_Handle handle);
+extern void Clock_stop(Clock_Handle handle);
+extern void Clock_setTimeout(Clock_Handle handle, UInt32 timeout);
+extern void Clock_setPeriod(Clock_Handle handle, UInt32 period);
+extern UInt32 Clock_getTimeout(Clock_Handle handle);
+extern Bool Clock_isActive(Clock_Handle handle);
+extern UInt32 Clock_getTicks(void);
+
+#endif /* OADE2E_CLOCK_H */
@@ -0,0 +1,27 @@
+/*
+ * Host stand-in of ti.sysbios.knl.Event, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_EVENT_H
+#define OADE2E_EVENT_H
+
+#include <xdc/std.h>
+
+#define Event_Id_NONE   0
+
+typedef struct {
+    UArg opaque[4];
+} Event_Struct;
+typedef Event_Struct *Event_Handle;
+
+typedef struct {
+    Int dummy;
+} Event_Params;
+
+extern void Event_Params_init(Event_Params *params);
+extern void Event_construct(Event_Struct *event, const Event_Params *params);
+extern Event_Handle Event_handle(Event_Struct *event);
+extern void Event_post(Event_Handle handle, UInt eventMask);
+extern UInt Event_pend(Event_Handle handle, UInt andMask, UInt orMask, UInt32 timeout);
+extern UInt Event_getPostedEvents(Event_Handle handle);
+
+#endif /* OADE2E_EVENT_H */
@@ -0,0 +1,30 @@
+/*
+ * Host stand-in of ti.sysbios.knl.Semaphore, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_SEMAPHORE_H
+#define OADE2E_SEMAPHORE_H
+
+#include <xdc/std.h>
+
+typedef enum {
+    Semaphore_Mode_COUNTING,
+    Semaphore_Mode_BINARY
+} Semaphore_Mode;
+
+typedef struct {
+    UArg opaque[12];
+} Semaphore_Struct;
+typedef Semaphore_Struct *Semaphore_Handle;
+
+typedef struct {
+    Semaphore_Mode mode;
+} Semaphore_Params;
+
+extern void Semaphore_Params_init(Semaphore_Params *params);
+extern void Semaphore_construct(Semaphore_Struct *sem, Int count, const Semaphore_Params *params);
+extern Semaphore_Handle Semaphore_handle(Semaphore_Struct *sem);
+extern Bool Semaphore_pend(Semaphore_Handle handle, UInt32 timeout);
+extern void Semaphore_post(Semaphore_Handle handle);
+extern Int Semaphore_getCount(Semaphore_Handle handle);
+
+#endif /* OADE2E_SEMAPHORE_H */
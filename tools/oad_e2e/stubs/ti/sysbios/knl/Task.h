@@ -0,0 +1,32 @@
+/*
+ * Host stand-in of ti.sysbios.knl.Task, the tasks of the OAD end-to-end test
+ * run as coroutines of the simulation.
+ */
+#ifndef OADE2E_TASK_H
+#define OADE2E_TASK_H
+
+#include <xdc/std.h>
+
+typedef void (*Task_FuncPtr)(UArg arg0, UArg arg1);
+
+typedef struct {
+    UArg opaque[4];
+} Task_Struct;
+typedef Task_Struct *Task_Handle;
+
+typedef struct {
+    UArg arg0;
+    UArg arg1;
+    Int priority;
+    Ptr stack;
+    size_t stackSize;
+} Task_Params;
+
+extern void Task_Params_init(Task_Params *params);
+extern void Task_construct(Task_Struct *task, Task_FuncPtr fxn, const Task_Params *params, void *eb);
+extern void Task_sleep(UInt32 ticks);
+extern void Task_yield(void);
+extern UInt Task_disable(void);
+extern void Task_restore(UInt key);
+
+#endif /* OADE2E_TASK_H */
@@ -0,0 +1,7 @@
+/*
+ * Host stand-in of the XDC memory module, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_XDC_MEMORY_H
+#define OADE2E_XDC_MEMORY_H
+
+#endif /* OADE2E_XDC_MEMORY_H */
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in of xdc.runtime.System, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_XDC_SYSTEM_H
+#define OADE2E_XDC_SYSTEM_H
+
+#include <xdc/std.h>
+
+extern void System_abort(const char *str);
+extern int System_sprintf(char *buf, const char *fmt, ...);
+
+#endif /* OADE2E_XDC_SYSTEM_H */
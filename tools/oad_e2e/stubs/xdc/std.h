@@ -0,0 +1,33 @@
+/*
+ * Host stand-in of the XDC base types, for the OAD end-to-end test.
+ */
+#ifndef OADE2E_XDC_STD_H
+#define OADE2E_XDC_STD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uintptr_t       UArg;
+typedef int             Int;
+typedef unsigned int    UInt;
+typedef uint8_t         UInt8;
+typedef uint16_t        UInt16;
+typedef uint32_t        UInt32;
+typedef int8_t          Int8;
+typedef int16_t         Int16;
+typedef int32_t         Int32;
+typedef bool            Bool;
+typedef char            Char;
+typedef char            xdc_Char;
+typedef void            Void;
+typedef void *          Ptr;
+
+#ifndef TRUE
+#define TRUE            1
+#endif
+#ifndef FALSE
+#define FALSE           0
+#endif
+
+#endif /* OADE2E_XDC_STD_H */
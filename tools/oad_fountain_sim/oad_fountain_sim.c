@@ -0,0 +1,164 @@
+/*
+ * Host simulation of the fountain coded broadcast OAD.
+ *
+ * The server encodes symbols of a random image and broadcasts them to a
+ * number of nodes, each losing packets at its own random rate. Every node runs
+ * the same decoder as the target and the simulation reports how many symbols
+ * each node needed and checks the decoded image.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -DOAD_BLOCK_SIZE=64 \
+ *       -I common \
+ *       tools/oad_fountain_sim/oad_fountain_sim.c \
+ *       common/oad/native_oad/oad_fountain.c \
+ *       -o oad_fountain_sim
+ *
+ * Usage: oad_fountain_sim [numBlocks] [numNodes] [maxLossPercent] [seed]
+ *                         [maxStoredSymbols]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oad/native_oad/oad_fountain.h"
+
+#define SIM_MAX_BLOCKS      2048
+#define SIM_MAX_NODES       64
+#define SIM_MAX_SYMBOLS     (SIM_MAX_BLOCKS + SIM_MAX_BLOCKS / 2)
+
+/* Symbols sent before giving up, relative to the image size */
+#define SIM_MAX_OVERHEAD    3
+
+static uint8_t image[SIM_MAX_BLOCKS][OAD_BLOCK_SIZE];
+
+static uint8_t nodeImage[SIM_MAX_BLOCKS][OAD_BLOCK_SIZE];
+static uint8_t nodeDecoded[SIM_MAX_BLOCKS / 8];
+static OADFountain_Symbol_t nodeSymbols[SIM_MAX_SYMBOLS];
+static uint8_t nodeSymbolData[SIM_MAX_SYMBOLS][OAD_BLOCK_SIZE];
+
+static bool imageRead(uint16_t blockNum, uint8_t *pBlock)
+{
+    memcpy(pBlock, image[blockNum], OAD_BLOCK_SIZE);
+    return true;
+}
+
+static bool nodeRead(uint16_t blockNum, uint8_t *pBlock)
+{
+    memcpy(pBlock, nodeImage[blockNum], OAD_BLOCK_SIZE);
+    return true;
+}
+
+static bool nodeWrite(uint16_t blockNum, uint8_t *pBlock)
+{
+    memcpy(nodeImage[blockNum], pBlock, OAD_BLOCK_SIZE);
+    return true;
+}
+
+static bool nodeSymbolRead(uint16_t slot, uint8_t *pData)
+{
+    memcpy(pData, nodeSymbolData[slot], OAD_BLOCK_SIZE);
+    return true;
+}
+
+static bool nodeSymbolWrite(uint16_t slot, uint8_t *pData)
+{
+    memcpy(nodeSymbolData[slot], pData, OAD_BLOCK_SIZE);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    uint16_t numBlocks = (argc > 1) ? atoi(argv[1]) : 1024;
+    uint16_t numNodes = (argc > 2) ? atoi(argv[2]) : 16;
+    uint16_t maxLoss = (argc > 3) ? atoi(argv[3]) : 30;
+    unsigned int seed = (argc > 4) ? atoi(argv[4]) : 1;
+    uint16_t storedSymbols = (argc > 5) ? atoi(argv[5]) : SIM_MAX_SYMBOLS;
+    uint32_t maxSymbols;
+    uint32_t worst = 0;
+    uint32_t total = 0;
+    uint16_t node;
+    int failed = 0;
+    uint8_t symbol[OAD_BLOCK_SIZE];
+
+    if((numBlocks == 0) || (numBlocks > SIM_MAX_BLOCKS) ||
+       (numNodes == 0) || (numNodes > SIM_MAX_NODES) || (maxLoss >= 100) ||
+       (storedSymbols == 0) || (storedSymbols > SIM_MAX_SYMBOLS))
+    {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+
+    srand(seed);
+    for(uint32_t i = 0; i < sizeof(image); i++)
+    {
+        ((uint8_t *)image)[i] = rand();
+    }
+
+    maxSymbols = (uint32_t)numBlocks * SIM_MAX_OVERHEAD;
+
+    printf("%u blocks, %u nodes, loss 0-%u%%\n", numBlocks, numNodes, maxLoss);
+
+    /*
+     * The symbol stream is the same for every node, so decode the nodes one
+     * after the other with their own loss pattern.
+     */
+    for(node = 0; node < numNodes; node++)
+    {
+        OADFountain_Decoder_t decoder;
+        uint16_t loss = rand() % (maxLoss + 1);
+        uint32_t sent;
+        uint32_t received = 0;
+        bool done = false;
+
+        memset(nodeImage, 0, sizeof(nodeImage));
+        OADFountain_decoderInit(&decoder, numBlocks, nodeDecoded, nodeSymbols,
+                                storedSymbols, nodeRead, nodeWrite,
+                                nodeSymbolRead, nodeSymbolWrite);
+
+        for(sent = 0; (sent < maxSymbols) && !done; sent++)
+        {
+            if((uint16_t)(rand() % 100) < loss)
+            {
+                continue;
+            }
+
+            OADFountain_encode(sent, numBlocks, imageRead, symbol);
+            received++;
+            done = OADFountain_decoderAddSymbol(&decoder, sent, symbol);
+        }
+
+        if(done && (memcmp(nodeImage, image, (size_t)numBlocks * OAD_BLOCK_SIZE) != 0))
+        {
+            printf("node %2u: decoded image mismatch\n", node);
+            failed = 1;
+            continue;
+        }
+
+        if(!done)
+        {
+            printf("node %2u: loss %2u%%, %u of %u blocks after %u symbols\n",
+                   node, loss, decoder.decodedBlocks, numBlocks, sent);
+            failed = 1;
+            continue;
+        }
+
+        printf("node %2u: loss %2u%%, %5u sent, %5u received, %5u stored, overhead %3u%%\n",
+               node, loss, sent, received, decoder.numSymbols,
+               (unsigned int)((received * 100) / numBlocks) - 100);
+
+        total += received;
+        if(sent > worst)
+        {
+            worst = sent;
+        }
+    }
+
+    if(!failed)
+    {
+        printf("mean reception overhead %u%%, broadcast complete after %u symbols (%u%%)\n",
+               (unsigned int)((total * 100) / ((uint32_t)numBlocks * numNodes)) - 100,
+               worst, (unsigned int)((worst * 100) / numBlocks));
+    }
+
+    return failed;
+}
@@ -0,0 +1,142 @@
+#!/usr/bin/env python
+"""
+Upload a node OAD image to the concentrator external flash over the UART.
+
+Uses the windowed upload of the concentrator (see OADServer_UART_MAGIC in
+oad_server.h): the blocks are streamed at a higher baud rate a window at a
+time and the concentrator acknowledges each window with a bitmap, so only
+lost blocks are sent again. Select the `Update available FW` action on the
+concentrator before running the script.
+
+Usage: python oad_uart_upload.py [--baud 921600] port image.bin
+"""
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+MAGIC = 0x5744414F  # "OADW"
+INITIAL_BAUD = 115200
+
+REQ = 0xA5
+DONE = 0x5A
+SERVER_FRAME_LEN = 5
+
+HELLO_RSP_LEN = 12
+TIMEOUT = 2.0
+
+STATUS = {0: 'success', 1: 'failed', 2: 'CRC error', 3: 'flash error'}
+
+
+class UploadError(Exception):
+    pass
+
+
+def image_len(img):
+    """Image length in bytes from the header"""
+    return struct.unpack_from('<H', img, 6)[0] * 4
+
+
+def block_frame(img, block_num, block_size):
+    """Block number, block and XOR of the frame bytes"""
+    data = img[block_num * block_size:(block_num + 1) * block_size]
+    frame = bytearray(struct.pack('<H', block_num))
+    frame += data + b'\xff' * (block_size - len(data))
+    check = 0
+    for byte in frame:
+        check ^= byte
+    frame.append(check)
+    return frame
+
+
+def read_server_frame(port, deadline):
+    """Next REQ or DONE frame, skipping bytes received before the baud switch"""
+    while time.time() < deadline:
+        sync = port.read(1)
+        if len(sync) == 1 and sync[0] in (REQ, DONE):
+            rest = port.read(SERVER_FRAME_LEN - 1)
+            if len(rest) == SERVER_FRAME_LEN - 1:
+                return sync[0], bytearray(rest)
+    raise UploadError('no response from the concentrator')
+
+
+def upload(port, img, baud, log=print):
+    """Upload img through the open port, returns the statistics"""
+    port.baudrate = INITIAL_BAUD
+    port.timeout = TIMEOUT
+    port.reset_input_buffer()
+
+    hello = struct.pack('<II', MAGIC, baud) + b'\xff' * 8
+    port.write(hello + img[:16])
+
+    rsp = bytearray(port.read(HELLO_RSP_LEN))
+    if len(rsp) != HELLO_RSP_LEN or struct.unpack_from('<I', rsp)[0] != MAGIC:
+        raise UploadError('concentrator does not support windowed upload, use oad_write_bin.py')
+
+    baud, num_blocks, window, block_size = struct.unpack_from('<IHBB', rsp, 4)
+    if num_blocks == 0:
+        raise UploadError('image header rejected')
+    log('%d blocks of %d bytes at %d baud, window %d' % (num_blocks, block_size, baud, window))
+
+    port.baudrate = baud
+    port.timeout = 0.1
+
+    start = time.time()
+    sent = 0
+    windows = 0
+    while True:
+        frame_type, payload = read_server_frame(port, time.time() + TIMEOUT)
+        if frame_type == DONE:
+            break
+
+        base, bitmap = struct.unpack_from('<HH', payload)
+        frames = bytearray()
+        for i in range(window):
+            if base + i < num_blocks and not bitmap & (1 << i):
+                frames += block_frame(img, base + i, block_size)
+                sent += 1
+        port.write(frames)
+        windows += 1
+
+    elapsed = time.time() - start
+    status = payload[0]
+    return {
+        'status': status,
+        'blocks': num_blocks,
+        'sent': sent,
+        'windows': windows,
+        'elapsed': elapsed,
+        'rate': num_blocks * block_size / elapsed if elapsed > 0 else 0,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('--baud', type=int, default=921600, help='baud rate to ask for')
+    parser.add_argument('port')
+    parser.add_argument('image')
+    args = parser.parse_args()
+
+    img = open(args.image, 'rb').read()
+    img = img[:image_len(img)]
+
+    port = serial.Serial(args.port, INITIAL_BAUD)
+    try:
+        stats = upload(port, img, args.baud)
+    except UploadError as e:
+        sys.exit(str(e))
+    finally:
+        port.close()
+
+    print('%d bytes in %.2f s, %.1f kB/s, %d blocks resent, %d windows' %
+          (len(img), stats['elapsed'], stats['rate'] / 1024,
+           stats['sent'] - stats['blocks'], stats['windows']))
+    print('image check: %s' % STATUS.get(stats['status'], stats['status']))
+    if stats['status'] != 0:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()